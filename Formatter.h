@@ -542,6 +542,35 @@ public:
         m_bLittleEndian = FALSE;
     }
 
+    ////////////////////////////////////////////////////////////////////////////
+    //Get_Memory_Usage - bytes used by formatter, its arguments list and buffer
+    //(buffer may be shared by several formatters)
+    size_t Get_Memory_Usage(tBOOL i_bWith_Buffer = TRUE) const
+    {
+        size_t      l_szReturn = sizeof(CFormatter);
+        const sArg *l_pArg     = m_pArgHead;
+
+        while (l_pArg)
+        {
+            l_szReturn += sizeof(sArg);
+            l_szReturn += l_pArg->szPrefix * sizeof(tXCHAR);
+
+            if (l_pArg->pDouble)
+            {
+                l_szReturn += (strlen(l_pArg->pDouble) + 1) * sizeof(tXCHAR);
+            }
+
+            l_pArg = l_pArg->pNext;
+        }
+
+        if ((m_pBuffer) && (i_bWith_Buffer))
+        {
+            l_szReturn += sizeof(sBuffer) + m_pBuffer->szBuffer * sizeof(tXCHAR);
+        }
+
+        return l_szReturn;
+    }
+
 #define FORMAT_SIGN\
     if (l_bMinus) {*l_pIter++ = TM('-');}\
     else if (l_pArg->bFlagSign) {*l_pIter++ = TM('+');}\
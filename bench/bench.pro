@@ -0,0 +1,35 @@
+QT += core gui
+
+TARGET = p7dbench
+TEMPLATE = app
+
+CONFIG  += console c++14 release
+CONFIG  -= app_bundle
+
+INCLUDEPATH += ..
+
+# the memory baseline is committed next to the sources
+DEFINES += P7_BENCH_DIR=\\\"$$PWD\\\"
+
+SOURCES  += main.cpp \
+            ../p7d_model.cpp
+
+HEADERS  += ../Formatter.h \
+            ../GTypes.h \
+            ../p7Structs.h \
+            ../importer.h \
+            ../p7d_arena.h \
+            ../p7d_block_deque.h \
+            ../p7d_rates.h \
+            ../p7d_sequence.h \
+            ../p7d_lru_cache.h \
+            ../p7d_time_index.h \
+            ../p7d_catalog.h \
+            ../p7d_keywords.h \
+            ../p7d_scanner.h \
+            ../p7d_summary.h \
+            ../p7d_telemetry.h \
+            ../p7d_thread_lanes.h \
+            ../p7d_latency.h \
+            ../p7d_generator.h \
+            ../p7d_model.h
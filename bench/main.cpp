@@ -0,0 +1,1442 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                             /
+// 2022 (c) Ragnar Lodbrok                                                     /
+//                                                                             /
+// This library is free software; you can redistribute it and/or               /
+// modify it under the terms of the GNU Lesser General Public                  /
+// License as published by the Free Software Foundation; either                /
+// version 3.0 of the License, or (at your option) any later version.          /
+//                                                                             /
+// This library is distributed in the hope that it will be useful,             /
+// but WITHOUT ANY WARRANTY; without even the implied warranty of              /
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU           /
+// Lesser General Public License for more details.                             /
+//                                                                             /
+// You should have received a copy of the GNU Lesser General Public            /
+// License along with this library.                                            /
+//                                                                             /
+////////////////////////////////////////////////////////////////////////////////
+
+// p7dbench - importer, formatter and model benchmarks.
+//
+// Every benchmark prints one JSON object per line to stdout:
+//   {"bench":"<name>","ops":N,"ns_per_op":X,"ops_per_s":Y,"mb_per_s":Z}
+// Each one is repeated --repeat times and the fastest run is reported,
+// so results of two commits built on the same host can be diffed.
+//
+// --memory imports a generated dump once and checks bytes per row of
+// p7DumpData::memoryReport() and peak RSS per row against the baseline
+// committed next to this file (bench/memory_baseline.txt, rewritten only
+// by --update-baseline), exit code is 2 if any of them has grown and 1
+// if there is no baseline.
+//
+// --check runs behavioural checks of the analyses on generated dumps
+// with known contents instead of the benchmarks, one JSON object per
+// check ({"check":"<name>","ok":true|false}, --filter applies), the
+// exit code is 1 if any of them fails.
+
+#include <QGuiApplication>
+#include <QElapsedTimer>
+#include <QDir>
+#include <QFile>
+#include <QTextStream>
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "importer.h"
+#include "p7d_catalog.h"
+#include "p7d_summary.h"
+#include "p7d_thread_lanes.h"
+#include "p7d_latency.h"
+#include "p7d_model.h"
+#include "p7d_generator.h"
+
+namespace p7 {
+
+struct BenchOptions
+{
+    uint64_t rows = 500000;
+    int repeat = 3;
+    std::string filter;
+
+    bool memory = false;
+    QString memoryBaseline = P7_BENCH_DIR "/memory_baseline.txt";
+    bool updateBaseline = false;
+
+    bool check = false;
+};
+
+struct BenchResult
+{
+    uint64_t ops = 0;   // operations done in one run
+    uint64_t bytes = 0; // bytes processed in one run, 0 if not applicable
+};
+
+class p7ImporterBench
+{
+public:
+
+    explicit p7ImporterBench(const BenchOptions & options)
+        : _options(options)
+    {}
+
+    int run()
+    {
+        printMeta();
+
+        if (_options.memory) {
+            return runMemory();
+        }
+
+        if (_options.check) {
+            return runChecks();
+        }
+
+        if (!prepareDump()) {
+            return 1;
+        }
+
+        benchFraming();
+        benchReadData();
+        benchDescriptions();
+        benchFormatter();
+        benchTimeConversion();
+        benchImport();
+        benchModelScroll();
+
+        QFile::remove(_dumpPath);
+
+        return 0;
+    }
+
+private:
+
+    // Runs fn `repeat` times, reports the fastest run
+    void measure(const std::string & name,
+                 const std::function<BenchResult()> & fn)
+    {
+        if (!_options.filter.empty()
+                && name.find(_options.filter) == std::string::npos) {
+            return;
+        }
+
+        qint64 bestNs = -1;
+        BenchResult result;
+
+        for (int i = 0; i < _options.repeat; ++i) {
+            QElapsedTimer timer;
+            timer.start();
+            result = fn();
+            qint64 ns = timer.nsecsElapsed();
+            if (bestNs < 0 || ns < bestNs) {
+                bestNs = ns;
+            }
+        }
+
+        if (bestNs <= 0) {
+            bestNs = 1;
+        }
+
+        double seconds = (double)bestNs / 1e9;
+
+        printf("{\"bench\":\"%s\",\"ops\":%llu,\"ns_per_op\":%.2f,"
+               "\"ops_per_s\":%.0f",
+               name.c_str(),
+               (unsigned long long)result.ops,
+               result.ops ? (double)bestNs / (double)result.ops : 0.0,
+               (double)result.ops / seconds);
+        if (result.bytes) {
+            printf(",\"mb_per_s\":%.2f",
+                   (double)result.bytes / (1024.0 * 1024.0) / seconds);
+        }
+        printf("}\n");
+        fflush(stdout);
+    }
+
+    void printMeta()
+    {
+        printf("{\"meta\":{\"rows\":%llu,\"repeat\":%d,\"qt\":\"%s\","
+               "\"compiler\":\"%s\"}}\n",
+               (unsigned long long)_options.rows,
+               _options.repeat,
+               QT_VERSION_STR,
+#if defined(__VERSION__)
+               __VERSION__
+#else
+               "unknown"
+#endif
+               );
+    }
+
+    bool generateDump()
+    {
+        _dumpPath = QDir::temp().filePath("p7dbench.p7d");
+
+        p7DumpGeneratorOptions options;
+        options.rows = _options.rows;
+        options.seed = 42;
+
+        p7DumpGenerator generator(options);
+        if (!generator.generate(_dumpPath.toStdString())) {
+            fprintf(stderr, "Failed to generate %s\n",
+                    qPrintable(_dumpPath));
+            return false;
+        }
+
+        return true;
+    }
+
+    bool prepareDump()
+    {
+        if (!generateDump()) {
+            return false;
+        }
+
+        QFile file(_dumpPath);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return false;
+        }
+        _dump = file.readAll();
+
+        return true;
+    }
+
+    // Chunk of packets which processPacket() skips (EP7TRACE_TYPE_VERB),
+    // so only the framing loop itself is measured
+    static std::vector<uint8_t> framingChunk(size_t packetsCount)
+    {
+        std::vector<uint8_t> chunk(packetsCount * sizeof(sP7Trace_Data));
+
+        for (size_t i = 0; i < packetsCount; ++i) {
+            sP7Trace_Data * packet
+                = (sP7Trace_Data *)(chunk.data() + i * sizeof(sP7Trace_Data));
+            packet->sCommon.dwType = EP7USER_TYPE_TRACE;
+            packet->sCommon.dwSubType = EP7TRACE_TYPE_VERB;
+            packet->sCommon.dwSize = sizeof(sP7Trace_Data);
+        }
+
+        return chunk;
+    }
+
+    void benchFraming()
+    {
+        const size_t packetsCount = 64 * 1024 / sizeof(sP7Trace_Data);
+        std::vector<uint8_t> chunk = framingChunk(packetsCount);
+
+        measure("framing.processDataChunk", [&]() {
+            p7DumpImporter importer;
+            p7StreamData stream;
+            BenchResult result;
+            for (int i = 0; i < 64; ++i) {
+                importer.processDataChunk(chunk.data(), chunk.size(), stream);
+                result.ops += packetsCount;
+                result.bytes += chunk.size();
+            }
+            return result;
+        });
+    }
+
+    void benchReadData()
+    {
+        // Whole file of skipped packets: readData() + processDataChunk()
+        const size_t packetsCount = 16 * 1024 / sizeof(sP7Trace_Data);
+        std::vector<uint8_t> chunk = framingChunk(packetsCount);
+
+        std::vector<uint8_t> buffer;
+        const int chunksCount = 2048;
+        for (int i = 0; i < chunksCount; ++i) {
+            sH_User_Data header;
+            header.dwSize = (uint32_t)(sizeof(header) + chunk.size());
+            header.dwChannel_ID = 0;
+            const uint8_t * bytes = (const uint8_t *)&header;
+            buffer.insert(buffer.end(), bytes, bytes + sizeof(header));
+            buffer.insert(buffer.end(), chunk.begin(), chunk.end());
+        }
+
+        measure("framing.readData", [&]() {
+            p7DumpImporter importer;
+            p7DumpData data;
+            importer._allDataBuffer = buffer;
+            importer._szData_Offs = 0;
+            importer.readData(data);
+
+            BenchResult result;
+            result.ops = packetsCount * chunksCount;
+            result.bytes = buffer.size();
+            return result;
+        });
+    }
+
+    // Collects packets of given subtype from the generated dump
+    std::vector<QByteArray> dumpPackets(uint32_t subType, size_t maxCount)
+    {
+        std::vector<QByteArray> packets;
+
+        size_t offs = sizeof(sP7File_Header);
+        while (offs + sizeof(sH_User_Data) <= (size_t)_dump.size()
+               && packets.size() < maxCount) {
+            const sH_User_Data * chunk
+                = (const sH_User_Data *)(_dump.constData() + offs);
+            if (chunk->dwSize < sizeof(sH_User_Data)
+                    || offs + chunk->dwSize > (size_t)_dump.size()) {
+                break;
+            }
+
+            size_t packetOffs = offs + sizeof(sH_User_Data);
+            while (packetOffs < offs + chunk->dwSize) {
+                const sP7Ext_Header * packet
+                    = (const sP7Ext_Header *)(_dump.constData() + packetOffs);
+                if (!packet->dwSize) {
+                    break;
+                }
+                if (packet->dwSubType == subType) {
+                    packets.push_back(QByteArray(_dump.constData() + packetOffs,
+                                                 (int)packet->dwSize));
+                }
+                packetOffs += packet->dwSize;
+            }
+
+            offs += chunk->dwSize;
+        }
+
+        return packets;
+    }
+
+    void benchDescriptions()
+    {
+        std::vector<QByteArray> packets
+            = dumpPackets(EP7TRACE_TYPE_DESC, 100000);
+        if (packets.empty()) {
+            return;
+        }
+
+        uint64_t bytes = 0;
+        for (const QByteArray & packet : packets) {
+            bytes += packet.size();
+        }
+
+        measure("import.processDescPacket", [&]() {
+            p7DumpImporter importer;
+            p7StreamData stream;
+            for (QByteArray & packet : packets) {
+                importer.processDescPacket(
+                    (sP7Ext_Header *)packet.data(), stream);
+            }
+
+            BenchResult result;
+            result.ops = packets.size();
+            result.bytes = bytes;
+            return result;
+        });
+    }
+
+    struct FormatterCase
+    {
+        const char * name;
+        const char * format;
+        sP7Trace_Arg arg;
+        std::vector<uint8_t> value;
+    };
+
+    template<typename T>
+    static std::vector<uint8_t> valueBytes(T value)
+    {
+        const uint8_t * bytes = (const uint8_t *)&value;
+        return std::vector<uint8_t>(bytes, bytes + sizeof(T));
+    }
+
+    static std::vector<uint8_t> utf8Bytes(const char * text)
+    {
+        return std::vector<uint8_t>(text, text + strlen(text) + 1);
+    }
+
+    static std::vector<uint8_t> utf16Bytes(const char * text)
+    {
+        std::vector<uint8_t> bytes;
+        for (const char * c = text; ; ++c) {
+            bytes.push_back((uint8_t)*c);
+            bytes.push_back(0);
+            if (!*c) {
+                break;
+            }
+        }
+        return bytes;
+    }
+
+    void benchFormatter()
+    {
+        const char * text = "connection to 192.168.0.1 has been closed";
+
+        std::vector<FormatterCase> cases = {
+            {"int32",   "value %d",    {P7TRACE_ARG_TYPE_INT32, 4},
+                valueBytes<int32_t>(-123456789)},
+            {"int64",   "value %lld",  {P7TRACE_ARG_TYPE_INT64, 8},
+                valueBytes<int64_t>(-1234567890123ll)},
+            {"uint32",  "value %u",    {P7TRACE_ARG_TYPE_INT32, 4},
+                valueBytes<uint32_t>(3123456789u)},
+            {"hex",     "value %08X",  {P7TRACE_ARG_TYPE_INT32, 4},
+                valueBytes<uint32_t>(0xDEADBEEF)},
+            {"octal",   "value %o",    {P7TRACE_ARG_TYPE_INT32, 4},
+                valueBytes<uint32_t>(0777)},
+            {"binary",  "value %b",    {P7TRACE_ARG_TYPE_INT32, 4},
+                valueBytes<uint32_t>(0xA5A5)},
+            {"double",  "value %.3f",  {P7TRACE_ARG_TYPE_DOUBLE, 8},
+                valueBytes<double>(3.14159265)},
+            {"char",    "value %c",    {P7TRACE_ARG_TYPE_CHAR, 4},
+                valueBytes<int32_t>('x')},
+            {"char16",  "value %lc",   {P7TRACE_ARG_TYPE_CHAR16, 4},
+                valueBytes<int32_t>(0x44F)},
+            {"char32",  "value %lc",   {P7TRACE_ARG_TYPE_CHAR32, 4},
+                valueBytes<int32_t>(0x1F600)},
+            {"pointer", "value %p",    {P7TRACE_ARG_TYPE_PVOID, 8},
+                valueBytes<uint64_t>(0x7FFF12345678ull)},
+            {"intmax",  "value %jd",   {P7TRACE_ARG_TYPE_INTMAX, 8},
+                valueBytes<int64_t>(-42)},
+            {"stra",    "value %hs",   {P7TRACE_ARG_TYPE_STRA, 0},
+                utf8Bytes(text)},
+            {"ustr8",   "value %s",    {P7TRACE_ARG_TYPE_USTR8, 0},
+                utf8Bytes(text)},
+            {"ustr16",  "value %ls",   {P7TRACE_ARG_TYPE_USTR16, 0},
+                utf16Bytes(text)},
+        };
+
+        const size_t bufferSize = 0x2000;
+        std::vector<tXCHAR> buffer(bufferSize);
+
+        for (FormatterCase & c : cases) {
+            CFormatter formatter(c.format, &c.arg, 1);
+
+            measure(std::string("formatter.") + c.name, [&]() {
+                const uint64_t count = 200000;
+                for (uint64_t i = 0; i < count; ++i) {
+                    formatter.Format(buffer.data(), bufferSize,
+                                     c.value.data());
+                }
+
+                BenchResult result;
+                result.ops = count;
+                return result;
+            });
+        }
+    }
+
+    void benchTimeConversion()
+    {
+        const uint64_t count = 1000000;
+        const uint64_t start = p7DumpGenerator::startTime100Ns();
+
+        measure("time.unpackDateTime", [&]() {
+            qint64 sum = 0;
+            for (uint64_t i = 0; i < count; ++i) {
+                QDateTime time = unpackDateTime(start + i * 1237ull);
+                sum += time.time().msec();
+            }
+            _sink += sum;
+
+            BenchResult result;
+            result.ops = count;
+            return result;
+        });
+
+        // What processDataPacket() does per row
+        measure("time.timerToDateTime", [&]() {
+            const uint64_t timerValue = 1000000ull;
+            const uint64_t timerFrequency = 10000000ull;
+            qint64 sum = 0;
+            for (uint64_t i = 0; i < count; ++i) {
+                const uint64_t timestamp
+                    = timerToTimestamp(start, timerValue, timerFrequency,
+                                       timerValue + i * 2000ull);
+                QDateTime time = unpackDateTime(timestamp);
+                sum += time.time().msec();
+            }
+            _sink += sum;
+
+            BenchResult result;
+            result.ops = count;
+            return result;
+        });
+    }
+
+    void benchImport()
+    {
+        measure("import.buffer", [&]() {
+            p7DumpImporter importer;
+            p7DumpData data = importer.import(_dump);
+
+            BenchResult result;
+            result.ops = data.traceDataCount();
+            result.bytes = _dump.size();
+            return result;
+        });
+
+        measure("import.file", [&]() {
+            p7DumpImporter importer;
+            p7DumpData data = importer.import(_dumpPath.toStdString());
+
+            BenchResult result;
+            result.ops = data.traceDataCount();
+            result.bytes = _dump.size();
+            return result;
+        });
+
+        // The same file four times: parallel import and merge of files
+        measure("import.files", [&]() {
+            p7DumpImporter importer;
+            p7DumpData data = importer.importFiles(
+                        std::vector<std::string>(4, _dumpPath.toStdString()));
+
+            BenchResult result;
+            result.ops = data.traceDataCount();
+            result.bytes = (uint64_t)_dump.size() * 4;
+            return result;
+        });
+
+        // Catalog entry: packet headers and the time index, no decoding
+        measure("catalog.scanDump", [&]() {
+            p7CatalogEntry entry;
+            p7DumpCatalog::scanDump(_dumpPath, entry);
+
+            BenchResult result;
+            result.ops = entry.rows;
+            result.bytes = _dump.size();
+            return result;
+        });
+
+        // Overview: counters of packet headers, nothing is formatted
+        measure("summary.scan", [&]() {
+            p7DumpSummary summary;
+            p7DumpSummary::scan(_dumpPath.toStdString(), summary);
+
+            BenchResult result;
+            result.ops = summary.rows;
+            result.bytes = _dump.size();
+            return result;
+        });
+
+        // Keyword filters of the catalog: the dump is decoded in parts
+        measure("catalog.indexKeywords", [&]() {
+            p7CatalogEntry entry;
+            p7DumpCatalog::scanDump(_dumpPath, entry);
+            p7DumpCatalog::indexKeywords(_dumpPath, entry);
+
+            BenchResult result;
+            result.ops = entry.rows;
+            result.bytes = _dump.size();
+            return result;
+        });
+
+        // Jump to time: binary search over blocks of the merged view index
+        // and a scan of one block
+        {
+            p7DumpImporter importer;
+            p7DumpData data = importer.import(_dump);
+            const size_t rows = data.traceDataCount();
+
+            measure("index.rowAtTime", [&]() {
+                BenchResult result;
+                uint64_t sum = 0;
+                if (rows) {
+                    const uint64_t first = data.traceDataAt(0).timestamp;
+                    const uint64_t span
+                            = data.traceDataAt(rows - 1).timestamp - first + 1;
+                    for (uint64_t i = 0; i < 10000; ++i) {
+                        sum += data.rowAtTime(first + span * i / 10000);
+                        result.ops++;
+                    }
+                }
+                _sink += (qint64)sum;
+                return result;
+            });
+
+            // Rate timeline repaints of 2000 pixels at growing zoom, cost
+            // follows the pixels, not the rows
+            measure("rates.query", [&]() {
+                BenchResult result;
+                const p7RateHistogram & rates = data.stream(0).rates();
+                std::vector<double> counts;
+                for (uint64_t zoom = 1; zoom <= 1000; zoom *= 10) {
+                    const uint64_t span = (rates.lastTime()
+                                           - rates.firstTime()) / zoom + 1;
+                    for (int i = 0; i < 100; ++i) {
+                        counts.assign(counts.size(), 0.0);
+                        rates.query(rates.firstTime(),
+                                    rates.firstTime() + span, 2000, counts);
+                        result.ops++;
+                    }
+                }
+                _sink += (qint64)counts[0];
+                return result;
+            });
+
+            // Swimlanes: the index of rows by thread built when the view is
+            // opened, ops are rows
+            p7ThreadLanes lanes;
+            measure("lanes.update", [&]() {
+                lanes.clear();
+                lanes.update(data);
+
+                BenchResult result;
+                result.ops = rows;
+                return result;
+            });
+
+            // Swimlane frames of 2000 pixels over all lanes at growing zoom
+            measure("lanes.query", [&]() {
+                BenchResult result;
+                std::vector<p7LaneBin> bins;
+                uint64_t sum = 0;
+                for (const p7ThreadLane * lane : lanes.lanes()) {
+                    if (lane->times.empty()) {
+                        continue;
+                    }
+                    const uint64_t first = lane->times.front();
+                    for (uint64_t zoom = 1; zoom <= 1000; zoom *= 10) {
+                        const uint64_t span = (lane->times.back() - first)
+                                / zoom + 1;
+                        for (int i = 0; i < 10; ++i) {
+                            lane->query(first, first + span, 2000, bins);
+                            sum += bins[0].rows;
+                            result.ops++;
+                        }
+                    }
+                }
+                _sink += (qint64)sum;
+                return result;
+            });
+
+            // Begin/end pairing of two trace IDs by their first argument,
+            // ops are all rows scanned
+            measure("latency.analyze", [&]() {
+                p7LatencySettings settings;
+                settings.beginId = 0;
+                settings.endId = 1;
+                settings.keyArgument = 1;
+                const p7LatencyReport report
+                        = p7LatencyReport::analyze(data, settings);
+                _sink += (qint64)report.spans.size()
+                        + (qint64)report.unmatchedBegins;
+
+                BenchResult result;
+                result.ops = rows;
+                return result;
+            });
+        }
+
+        // Sequence numbers as packets are decoded, a gap per 1000 of them;
+        // ops are packets
+        measure("sequence.check", [&]() {
+            const uint32_t count = 10000000;
+            p7SequenceCheck check;
+            uint32_t sequence = 0;
+            for (uint32_t i = 0; i < count; ++i) {
+                sequence += (i % 1000) ? 1 : 3;
+                check.addPacket(sequence, i);
+            }
+            check.flush();
+            _sink += (qint64)check.missing();
+
+            BenchResult result;
+            result.ops = count;
+            return result;
+        });
+
+        // Most rows are skipped by the header check, ops are all rows
+        measure("import.filtered", [&]() {
+            p7ImportFilter filter;
+            filter.minLevel = EP7TRACE_LEVEL_ERROR;
+
+            p7DumpImporter importer;
+            importer.setFilter(filter);
+            p7DumpData data = importer.import(_dump);
+
+            BenchResult result;
+            result.ops = data.traceDataCount()
+                    + data.importStats().rowsFiltered;
+            result.bytes = _dump.size();
+            return result;
+        });
+    }
+
+    void benchModelScroll()
+    {
+        P7DumpModel model;
+        {
+            p7DumpImporter importer;
+            model.setDumpData(importer.import(_dump));
+        }
+
+        const int rowsCount = model.rowCount();
+        const int columnsCount = model.columnCount();
+        const int visibleRows = 50;
+        const int scrollStep = 40;
+        if (rowsCount <= visibleRows) {
+            return;
+        }
+
+        // One "frame" asks every visible cell for text and background,
+        // like QTableView does on repaint
+        measure("model.scroll", [&]() {
+            BenchResult result;
+            qint64 sum = 0;
+            for (int top = 0; top + visibleRows < rowsCount;
+                 top += scrollStep) {
+                for (int row = top; row < top + visibleRows; ++row) {
+                    for (int column = 0; column < columnsCount; ++column) {
+                        QModelIndex index = model.index(row, column);
+                        QVariant text = model.data(index, Qt::DisplayRole);
+                        QVariant background
+                            = model.data(index, Qt::BackgroundRole);
+                        sum += text.isValid() + background.isValid();
+                        result.ops += 2;
+                    }
+                }
+            }
+            _sink += sum;
+            return result;
+        });
+
+        // Hover, selection and expose events repaint the same rows, cells
+        // come from the display cache
+        measure("model.repaint", [&]() {
+            BenchResult result;
+            qint64 sum = 0;
+            for (int frame = 0; frame < 1000; ++frame) {
+                for (int row = 0; row < visibleRows; ++row) {
+                    for (int column = 0; column < columnsCount; ++column) {
+                        QModelIndex index = model.index(row, column);
+                        QVariant text = model.data(index, Qt::DisplayRole);
+                        QVariant background
+                            = model.data(index, Qt::BackgroundRole);
+                        sum += text.isValid() + background.isValid();
+                        result.ops += 2;
+                    }
+                }
+            }
+            _sink += sum;
+            return result;
+        });
+    }
+
+    // VmRSS, VmHWM... from /proc/self/status in bytes, 0 if unavailable
+    static uint64_t procStatusBytes(const char * key)
+    {
+        FILE * file = fopen("/proc/self/status", "r");
+        if (!file) {
+            return 0;
+        }
+
+        uint64_t value = 0;
+        char line[256];
+        size_t keyLength = strlen(key);
+        while (fgets(line, sizeof(line), file)) {
+            if (strncmp(line, key, keyLength) == 0 && line[keyLength] == ':') {
+                value = strtoull(line + keyLength + 1, nullptr, 10) * 1024;
+                break;
+            }
+        }
+
+        fclose(file);
+        return value;
+    }
+
+    // rows: of the dump the baseline was measured with, fixed costs
+    // per dump make bytes per row depend on it
+    static bool readBaseline(const QString & path,
+                             uint64_t & rows,
+                             double & bytesPerRow, double & peakPerRow)
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            return false;
+        }
+
+        QTextStream stream(&file);
+        while (!stream.atEnd()) {
+            QStringList parts = stream.readLine().split(' ');
+            if (parts.size() != 2) {
+                continue;
+            }
+            if (parts[0] == "rows") {
+                rows = parts[1].toULongLong();
+            } else if (parts[0] == "bytes_per_row") {
+                bytesPerRow = parts[1].toDouble();
+            } else if (parts[0] == "peak_rss_per_row") {
+                peakPerRow = parts[1].toDouble();
+            }
+        }
+
+        return bytesPerRow > 0;
+    }
+
+    static bool writeBaseline(const QString & path,
+                              uint64_t rows,
+                              double bytesPerRow, double peakPerRow)
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate
+                       | QIODevice::Text)) {
+            return false;
+        }
+
+        QTextStream stream(&file);
+        stream << "# p7dbench --memory, refresh with --update-baseline\n"
+               << "rows " << rows << "\n"
+               << "bytes_per_row " << QString::number(bytesPerRow, 'f', 2)
+               << "\n"
+               << "peak_rss_per_row " << QString::number(peakPerRow, 'f', 2)
+               << "\n";
+
+        return true;
+    }
+
+    int runMemory()
+    {
+        uint64_t baseRows = 0;
+        double baseBytesPerRow = 0.0;
+        double basePeakPerRow = 0.0;
+
+        if (!_options.updateBaseline) {
+            if (!readBaseline(_options.memoryBaseline, baseRows,
+                              baseBytesPerRow, basePeakPerRow)) {
+                fprintf(stderr, "No memory baseline in %s, make one with"
+                        " --update-baseline and commit it\n",
+                        qPrintable(_options.memoryBaseline));
+                return 1;
+            }
+            if (baseRows) {
+                _options.rows = baseRows;
+            }
+        }
+
+        // Generator streams to the file, it doesn't affect peak RSS
+        if (!generateDump()) {
+            return 1;
+        }
+
+        uint64_t rssBefore = procStatusBytes("VmRSS");
+
+        p7DumpImporter importer;
+        p7DumpData data = importer.import(_dumpPath.toStdString());
+
+        uint64_t peak = procStatusBytes("VmHWM");
+        p7MemoryReport report = data.memoryReport();
+
+        QFile::remove(_dumpPath);
+
+        if (!report.rows) {
+            fprintf(stderr, "Nothing imported\n");
+            return 1;
+        }
+
+        double bytesPerRow = report.bytesPerRow(report.total());
+        double peakPerRow = peak > rssBefore
+                ? (double)(peak - rssBefore) / (double)report.rows
+                : 0.0;
+
+        printf("{\"bench\":\"memory.import\",\"rows\":%llu,"
+               "\"bytes_per_row\":%.2f,\"peak_rss_per_row\":%.2f,"
+               "\"trace_rows\":%llu,\"message_strings\":%llu,"
+               "\"descriptions\":%llu,\"formatters\":%llu,"
+               "\"threads_and_modules\":%llu,\"indexes\":%llu,"
+               "\"arena_unused\":%llu}\n",
+               (unsigned long long)report.rows,
+               bytesPerRow,
+               peakPerRow,
+               (unsigned long long)report.traceRows,
+               (unsigned long long)report.messageStrings,
+               (unsigned long long)report.descriptions,
+               (unsigned long long)report.formatters,
+               (unsigned long long)report.threadsAndModules,
+               (unsigned long long)report.indexes,
+               (unsigned long long)report.arenaUnused);
+
+        if (_options.updateBaseline) {
+            if (!writeBaseline(_options.memoryBaseline, report.rows,
+                               bytesPerRow, peakPerRow)) {
+                fprintf(stderr, "Failed to write %s\n",
+                        qPrintable(_options.memoryBaseline));
+                return 1;
+            }
+            fprintf(stderr, "Memory baseline saved to %s\n",
+                    qPrintable(_options.memoryBaseline));
+            return 0;
+        }
+
+        // report is exact, RSS is noisy and not checked without a value
+        // measured on the host
+        bool failed = false;
+        if (bytesPerRow > baseBytesPerRow * 1.01) {
+            fprintf(stderr, "bytes/row grew: %.2f -> %.2f\n",
+                    baseBytesPerRow, bytesPerRow);
+            failed = true;
+        }
+        if (basePeakPerRow > 0 && peakPerRow > basePeakPerRow * 1.05) {
+            fprintf(stderr, "peak RSS/row grew: %.2f -> %.2f\n",
+                    basePeakPerRow, peakPerRow);
+            failed = true;
+        }
+
+        return failed ? 2 : 0;
+    }
+
+    // Reports a check, failures are told on stderr by the check itself
+    bool check(const std::string & name, const std::function<bool()> & fn)
+    {
+        if (!_options.filter.empty()
+                && name.find(_options.filter) == std::string::npos) {
+            return true;
+        }
+
+        const bool ok = fn();
+        printf("{\"check\":\"%s\",\"ok\":%s}\n",
+               name.c_str(), ok ? "true" : "false");
+        fflush(stdout);
+        return ok;
+    }
+
+    static bool expect(bool condition, const char * what)
+    {
+        if (!condition) {
+            fprintf(stderr, "check failed: %s\n", what);
+        }
+        return condition;
+    }
+
+    static bool generateFile(const QString & path,
+                             const p7DumpGeneratorOptions & options)
+    {
+        p7DumpGenerator generator(options);
+        if (!generator.generate(path.toStdString())) {
+            fprintf(stderr, "Failed to generate %s\n", qPrintable(path));
+            return false;
+        }
+        return true;
+    }
+
+    int runChecks()
+    {
+        bool ok = true;
+        ok = check("catalog.roundTrip", [this]() {
+            return checkCatalog();
+        }) && ok;
+        ok = check("latency.blocks", [this]() {
+            return checkLatency();
+        }) && ok;
+        ok = check("sequence.generated", [this]() {
+            return checkGeneratedSequences();
+        }) && ok;
+        ok = check("sequence.events", [this]() {
+            return checkSequenceEvents();
+        }) && ok;
+        ok = check("view.indexOf", [this]() {
+            return checkViewIndex();
+        }) && ok;
+        ok = check("time.beforeInfo", [this]() {
+            return checkTimerToTimestamp();
+        }) && ok;
+
+        return ok ? 0 : 1;
+    }
+
+    // channels may come in another order
+    static bool sameIndexes(const std::vector<p7ChannelTimeIndex> & left,
+                            const std::vector<p7ChannelTimeIndex> & right)
+    {
+        if (left.size() != right.size()) {
+            return false;
+        }
+
+        for (const p7ChannelTimeIndex & channel : left) {
+            auto other = std::find_if(right.begin(), right.end(),
+                                      [&](const p7ChannelTimeIndex & index) {
+                return index.channelId == channel.channelId;
+            });
+            if (other == right.end()) {
+                return false;
+            }
+
+            const std::deque<p7TimeBlock> & a = channel.index.blocks();
+            const std::deque<p7TimeBlock> & b = other->index.blocks();
+            if (a.size() != b.size()) {
+                return false;
+            }
+            for (size_t j = 0; j < a.size(); ++j) {
+                if (    (a[j].firstRow != b[j].firstRow)
+                     || (a[j].rows != b[j].rows)
+                     || (a[j].metadata != b[j].metadata)
+                     || (a[j].minTime != b[j].minTime)
+                     || (a[j].maxTime != b[j].maxTime)
+                     || (a[j].maxTimeSoFar != b[j].maxTimeSoFar)
+                     || (a[j].fileOffset != b[j].fileOffset)
+                     || (a[j].fileEnd != b[j].fileEnd)
+                   )
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    static bool sameSummaries(const p7CatalogEntry & left,
+                              const p7CatalogEntry & right)
+    {
+        if (    (left.fileName != right.fileName)
+             || (left.fileSize != right.fileSize)
+             || (left.modified != right.modified)
+             || (left.hostName != right.hostName)
+             || (left.processName != right.processName)
+             || (left.processId != right.processId)
+             || (left.processStartTime != right.processStartTime)
+             || (left.fromTime != right.fromTime)
+             || (left.toTime != right.toTime)
+             || (left.rows != right.rows)
+           )
+        {
+            return false;
+        }
+        for (int i = 0; i < EP7TRACE_LEVEL_COUNT; ++i) {
+            if (left.levelRows[i] != right.levelRows[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Two dumps scanned into a catalog: the time indexes of the scan are
+    // those of an import, the saved catalog loads back the same, and one
+    // cut short loses the entries whose indexes were cut
+    bool checkCatalog()
+    {
+        QStringList files;
+        for (uint64_t i = 0; i < 2; ++i) {
+            p7DumpGeneratorOptions options;
+            options.rows = 150000 + i * 50000;
+            options.channels = 2 + (uint32_t)i;
+            options.seed = 7 + i;
+            files << QDir::temp().filePath(
+                         QString("p7dcheck%1.p7d").arg(i));
+            if (!generateFile(files.back(), options)) {
+                return false;
+            }
+        }
+        const QString catalogPath = QDir::temp().filePath("p7dcheck.p7dc");
+        const QString cutPath = QDir::temp().filePath("p7dcheck_cut.p7dc");
+
+        bool ok = true;
+        p7DumpCatalog catalog;
+        ok = expect(catalog.update(files) == 2, "both dumps scanned") && ok;
+        ok = expect(catalog.save(catalogPath), "catalog saved") && ok;
+
+        for (const p7CatalogEntry & entry : catalog.entries()) {
+            p7DumpImporter importer;
+            const p7DumpData data
+                    = importer.import(entry.fileName.toStdString());
+            ok = expect(entry.rows == data.traceDataCount(),
+                        "rows of a scan are those of an import") && ok;
+            ok = expect(sameIndexes(catalog.timeIndexes(entry),
+                                    data.timeIndexes()),
+                        "time index of a scan is that of an import") && ok;
+        }
+
+        p7DumpCatalog loaded;
+        ok = expect(loaded.load(catalogPath), "catalog loaded") && ok;
+        ok = expect(loaded.entries().size() == catalog.entries().size(),
+                    "all entries loaded") && ok;
+        for (size_t i = 0; ok && i < loaded.entries().size(); ++i) {
+            const p7CatalogEntry & entry = catalog.entries()[i];
+            const p7CatalogEntry & copy = loaded.entries()[i];
+            ok = expect(sameSummaries(entry, copy),
+                        "loaded summary is the saved one") && ok;
+            ok = expect(sameIndexes(catalog.timeIndexes(entry),
+                                    loaded.timeIndexes(copy)),
+                        "loaded time index is the saved one") && ok;
+            ok = expect(loaded.find(entry.fileName) == &copy,
+                        "unchanged dump is found") && ok;
+        }
+
+        // indexes follow the summaries, the last one loses its end
+        QFile file(catalogPath);
+        QFile cut(cutPath);
+        if (    (file.open(QIODevice::ReadOnly))
+             && (cut.open(QIODevice::WriteOnly | QIODevice::Truncate))
+           )
+        {
+            const QByteArray bytes = file.readAll();
+            cut.write(bytes.left(bytes.size() - 1));
+        }
+        file.close();
+        cut.close();
+
+        p7DumpCatalog truncated;
+        ok = expect(truncated.load(cutPath), "cut catalog loaded") && ok;
+        ok = expect(truncated.entries().size() + 1 == catalog.entries().size(),
+                    "entry with a cut index dropped") && ok;
+        for (const p7CatalogEntry & entry : truncated.entries()) {
+            ok = expect(!truncated.timeIndexes(entry).empty(),
+                        "kept entry has its index") && ok;
+        }
+
+        for (const QString & path : files) {
+            QFile::remove(path);
+        }
+        QFile::remove(catalogPath);
+        QFile::remove(cutPath);
+
+        return ok;
+    }
+
+    // Begin/end pairing of p7LatencyReport::analyze() (blocks paired in
+    // parallel, then joined) against one pass over every stream, on a
+    // dump of few trace IDs: many spans cross blocks of rows
+    bool checkLatency()
+    {
+        p7DumpGeneratorOptions options;
+        options.rows = 300000;
+        options.channels = 2;
+        options.descriptions = 4;
+        options.threads = 4;
+        options.seed = 11;
+
+        const QString path = QDir::temp().filePath("p7dcheck.p7d");
+        if (!generateFile(path, options)) {
+            return false;
+        }
+        p7DumpImporter importer;
+        const p7DumpData data = importer.import(path.toStdString());
+        QFile::remove(path);
+
+        bool ok = true;
+        bool crossing = false;
+        for (bool sameThread : {true, false}) {
+            p7LatencySettings settings;
+            settings.beginId = 0;
+            settings.endId = 1;
+            settings.sameThread = sameThread;
+            const p7LatencyReport report
+                    = p7LatencyReport::analyze(data, settings);
+
+            // stream, begin and end row numbers, duration
+            typedef std::tuple<uint32_t, uint64_t, uint64_t, uint64_t> Span;
+            std::vector<Span> expected;
+            uint64_t unmatchedBegins = 0;
+            uint64_t unmatchedEnds = 0;
+
+            for (uint32_t i = 0; i < data.streamsCount(); ++i) {
+                const p7StreamData & stream = data.stream(i);
+                // open begin by thread (by 0 for any thread)
+                std::map<uint32_t, size_t> open;
+                for (size_t row = 0; row < stream.traceDataCount(); ++row) {
+                    const p7TraceDataInfo & info = stream.traceDataAt(row);
+                    const uint32_t key = sameThread ? info.threadId : 0;
+                    auto begin = open.find(key);
+                    if (info.id == settings.beginId) {
+                        unmatchedBegins += begin != open.end() ? 1 : 0;
+                        open[key] = row;
+                    } else if (info.id != settings.endId) {
+                        continue;
+                    } else if (begin == open.end()) {
+                        ++unmatchedEnds;
+                    } else {
+                        const p7TraceDataInfo & first
+                                = stream.traceDataAt(begin->second);
+                        expected.emplace_back(
+                                    i,
+                                    stream.firstRowNumber() + begin->second,
+                                    stream.firstRowNumber() + row,
+                                    info.timestamp - first.timestamp);
+                        crossing = crossing
+                                || (begin->second / p7LatencyReport::blockRows()
+                                    != row / p7LatencyReport::blockRows());
+                        open.erase(begin);
+                    }
+                }
+                unmatchedBegins += open.size();
+            }
+
+            std::vector<Span> spans;
+            for (const p7LatencySpan & span : report.spans) {
+                spans.emplace_back(span.stream, span.beginNumber,
+                                   span.endNumber, span.duration);
+            }
+            std::sort(spans.begin(), spans.end());
+            std::sort(expected.begin(), expected.end());
+
+            ok = expect(spans == expected,
+                        "spans are those of one pass") && ok;
+            ok = expect(report.unmatchedBegins == unmatchedBegins,
+                        "unmatched begins are those of one pass") && ok;
+            ok = expect(report.unmatchedEnds == unmatchedEnds,
+                        "unmatched ends are those of one pass") && ok;
+        }
+
+        return expect(crossing, "spans cross blocks of rows") && ok;
+    }
+
+    // Gaps the generator left in sequence numbers are found by the import
+    bool checkGeneratedSequences()
+    {
+        p7DumpGeneratorOptions options;
+        options.rows = 200000;
+        options.channels = 3;
+        options.dropsPerMille = 20;
+        options.seed = 13;
+
+        const QString path = QDir::temp().filePath("p7dcheck.p7d");
+        p7DumpGenerator generator(options);
+        if (!generator.generate(path.toStdString())) {
+            fprintf(stderr, "Failed to generate %s\n", qPrintable(path));
+            return false;
+        }
+        p7DumpImporter importer;
+        const p7DumpData data = importer.import(path.toStdString());
+        QFile::remove(path);
+
+        uint64_t packets = 0;
+        uint64_t gaps = 0;
+        uint64_t missing = 0;
+        uint64_t others = 0;
+        for (size_t i = 0; i < data.streamsCount(); ++i) {
+            const p7SequenceCheck & sequences = data.stream(i).sequences();
+            packets += sequences.packets();
+            gaps += sequences.gaps();
+            missing += sequences.missing();
+            others += sequences.duplicates() + sequences.reordered()
+                    + sequences.restarts();
+        }
+
+        bool ok = true;
+        ok = expect(generator.sequenceGaps() > 0, "gaps generated") && ok;
+        ok = expect(packets == generator.rowsWritten(),
+                    "every packet checked") && ok;
+        ok = expect(gaps == generator.sequenceGaps(),
+                    "gaps found are those generated") && ok;
+        ok = expect(missing == generator.sequencesDropped(),
+                    "numbers missing are those dropped") && ok;
+        ok = expect(!others, "no other anomalies") && ok;
+        return ok;
+    }
+
+    // Known numbers fed to p7SequenceCheck: a gap whose number comes
+    // late, duplicates, a restart, and gaps after the event list is full
+    bool checkSequenceEvents()
+    {
+        bool ok = true;
+        uint64_t row = 0;
+
+        p7SequenceCheck check;
+        for (uint32_t sequence = 0; sequence < 10; ++sequence) {
+            check.addPacket(sequence, row++);
+        }
+        for (uint32_t sequence = 12; sequence < 20; ++sequence) {
+            check.addPacket(sequence, row++);  // 10 and 11 missing
+        }
+        check.addPacket(15, row++);            // duplicate
+        check.addPacket(10, row++);            // late
+        check.addPacket(30, row++);            // 20..29 missing
+        check.addPacket(30, row++);            // duplicate
+        check.addPacket(30 + (1u << 25), row++);
+        check.addPacket(31 + (1u << 25), row++);
+        check.flush();
+
+        ok = expect(check.packets() == row, "every packet checked") && ok;
+        ok = expect(check.gaps() == 2, "two gaps") && ok;
+        ok = expect(check.missing() == 11, "11 numbers missing") && ok;
+        ok = expect(check.duplicates() == 2, "two duplicates") && ok;
+        ok = expect(check.reordered() == 1, "one late number") && ok;
+        ok = expect(check.restarts() == 1, "one restart") && ok;
+        ok = expect(check.events().size() == 6, "every event kept") && ok;
+        ok = expect(    (!check.events().empty())
+                     && (check.events().front().kind == p7SequenceEvent::Gap)
+                     && (check.events().front().missing() == 1),
+                    "late number taken from its gap") && ok;
+        ok = expect(check.hasGapAt(10) && !check.hasGapAt(11),
+                    "gap at the row after it") && ok;
+
+        // late numbers of a gap which is counted only are no duplicates
+        p7SequenceCheck full;
+        row = 0;
+        full.addPacket(0, row++);
+        for (size_t i = 0; i < p7SequenceCheck::maxEvents(); ++i) {
+            full.addPacket(0, row++);
+        }
+        full.addPacket(5, row++);              // 1..4 missing
+        for (uint32_t sequence = 1; sequence < 5; ++sequence) {
+            full.addPacket(sequence, row++);
+        }
+        full.flush();
+
+        ok = expect(full.events().size() == p7SequenceCheck::maxEvents(),
+                    "events kept up to maxEvents()") && ok;
+        ok = expect(full.duplicates() == p7SequenceCheck::maxEvents(),
+                    "duplicates of the full list counted") && ok;
+        ok = expect(full.gaps() == 1, "gap after the full list") && ok;
+        ok = expect(full.reordered() == 4, "its numbers came late") && ok;
+        ok = expect(full.missing() == 0, "nothing missing") && ok;
+        ok = expect(full.eventsOmitted() == 5, "events omitted") && ok;
+        return ok;
+    }
+
+    // Every row of every stream is found in the merged view, also after
+    // the oldest rows are dropped in part of a block
+    bool checkViewIndex()
+    {
+        p7DumpGeneratorOptions options;
+        options.rows = 100000;
+        options.channels = 3;
+        options.seed = 5;
+
+        const QString path = QDir::temp().filePath("p7dcheck.p7d");
+        if (!generateFile(path, options)) {
+            return false;
+        }
+        p7DumpImporter importer;
+        p7DumpData data = importer.import(path.toStdString());
+        QFile::remove(path);
+
+        auto allFound = [&data]() {
+            for (size_t i = 0; i < data.streamsCount(); ++i) {
+                const p7StreamData & stream = data.stream(i);
+                for (uint64_t number = stream.firstRowNumber();
+                     number < stream.endRowNumber();
+                     ++number) {
+                    uint64_t found = 0;
+                    const size_t index = data.viewIndexOf(i, number);
+                    if (    (index >= data.traceDataCount())
+                         || (data.streamIndexAt(index, found) != i)
+                         || (found != number)
+                       )
+                    {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        };
+
+        bool ok = expect(data.streamsCount() == 3, "three streams");
+        ok = expect(allFound(), "rows found in the view") && ok;
+        data.dropOldestRows(5000);
+        ok = expect(allFound(), "rows found after a partial block") && ok;
+        data.dropOldestRows(3 * p7BlockDeque<p7RowRef>::blockSize() + 7);
+        ok = expect(allFound(), "rows found after whole blocks") && ok;
+        ok = expect(data.viewIndexOf(0, data.stream(0).firstRowNumber() - 1)
+                        == data.traceDataCount(),
+                    "dropped row not found") && ok;
+        return ok;
+    }
+
+    // Rows written a bit before the Info packet and rows with no time
+    bool checkTimerToTimestamp()
+    {
+        const uint64_t start = 132000000000000000ull;
+        const uint64_t frequency = 10000000ull; // one tick is 100ns
+        bool ok = true;
+
+        ok = expect(timerToTimestamp(start, 5000, frequency, 5100)
+                        == start + 100,
+                    "row after the Info packet") && ok;
+        ok = expect(timerToTimestamp(start, 5000, frequency, 4900)
+                        == start - 100,
+                    "row before the Info packet is earlier") && ok;
+        ok = expect(timerToTimestamp(start, 5000, 0, 5100) == UINT64_MAX,
+                    "no time before the Info packet") && ok;
+        ok = expect(timerToTimestamp(100, UINT64_MAX, frequency, 0)
+                        == UINT64_MAX,
+                    "no time far before the dump") && ok;
+
+        // rows with no time keep their place but no time range
+        p7TimeIndex index;
+        index.addRow(0, p7TimeIndex::noTime());
+        index.addRow(1, start + 10);
+        index.addRow(2, p7TimeIndex::noTime());
+        index.addRow(3, start + 20);
+        const uint64_t times[] = {
+            p7TimeIndex::noTime(), start + 10, p7TimeIndex::noTime(), start + 20
+        };
+        auto rowTime = [&times](uint64_t row) {
+            return times[row];
+        };
+        ok = expect(    (index.blocks().size() == 1)
+                     && (index.blocks().front().rows == 4)
+                     && (index.blocks().front().minTime == start + 10)
+                     && (index.blocks().front().maxTime == start + 20),
+                    "time index range of timed rows") && ok;
+        ok = expect(index.rowAtTime(start + 11, 0, 4, rowTime) == 3,
+                    "rows with no time are not found by time") && ok;
+        ok = expect(index.rowAtTime(start + 21, 0, 4, rowTime) == 4,
+                    "no row after the last time") && ok;
+
+        p7StreamData stream;
+        p7TraceDataInfo row;
+        row.timestamp = p7TimeIndex::noTime();
+        stream.addNewTraceData(p7TraceDataInfo(row));
+        row.timestamp = start;
+        stream.addNewTraceData(std::move(row));
+        ok = expect(stream.rates().rows() == 1,
+                    "rows with no time are not in the rates") && ok;
+        ok = expect(    (stream.traceIdStats().size() == 1)
+                     && (stream.traceIdStats().front().rows == 2)
+                     && (stream.traceIdStats().front().firstTime == start),
+                    "trace ID times of timed rows") && ok;
+        return ok;
+    }
+
+    BenchOptions _options;
+    QString _dumpPath;
+    QByteArray _dump;
+    qint64 _sink = 0; // keeps results alive
+};
+
+} // namespace p7
+
+int main(int argc, char *argv[])
+{
+    // P7DumpModel asks QGuiApplication for palette
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QGuiApplication app(argc, argv);
+
+    p7::BenchOptions options;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const char * value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+        if (arg == "--rows" && value) {
+            options.rows = strtoull(value, nullptr, 10);
+            ++i;
+        } else if (arg == "--repeat" && value) {
+            options.repeat = qMax(1, atoi(value));
+            ++i;
+        } else if (arg == "--filter" && value) {
+            options.filter = value;
+            ++i;
+        } else if (arg == "--memory") {
+            options.memory = true;
+        } else if (arg == "--memory-baseline" && value) {
+            options.memoryBaseline = QString::fromLocal8Bit(value);
+            ++i;
+        } else if (arg == "--update-baseline") {
+            options.updateBaseline = true;
+        } else if (arg == "--check") {
+            options.check = true;
+        } else {
+            printf("Usage: p7dbench [--rows N] [--repeat N] [--filter name]\n"
+                   "       p7dbench --memory [--rows N]"
+                   " [--memory-baseline file] [--update-baseline]\n"
+                   "       p7dbench --check [--filter name]\n");
+            return arg == "-h" || arg == "--help" ? 0 : 1;
+        }
+    }
+
+    p7::p7ImporterBench bench(options);
+
+    return bench.run();
+}
@@ -23,11 +23,24 @@
 
 #include <QDebug>
 #include <QDateTime>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <atomic>
+#include <deque>
 #include <iostream>
 #include <string>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include "Formatter.h"
 #include "p7Structs.h"
+#include "p7d_arena.h"
+#include "p7d_block_deque.h"
+#include "p7d_rates.h"
+#include "p7d_sequence.h"
+#include "p7d_telemetry.h"
+#include "p7d_time_index.h"
 
 namespace p7 {
 
@@ -73,7 +86,7 @@ struct stTrace
 };
 
 
-static QString traceLevelAsString(const eP7Trace_Level level)
+static inline QString traceLevelAsString(const eP7Trace_Level level)
 {
     switch (level) {
     case EP7TRACE_LEVEL_TRACE:
@@ -93,9 +106,13 @@ static QString traceLevelAsString(const eP7Trace_Level level)
     }
 }
 
-static QDateTime unpackDateTime(uint64_t datetime)
+static inline QDateTime unpackDateTime(uint64_t datetime)
 {
-    if (datetime == 0) {
+    // no time, see timerToTimestamp()
+    if (    (datetime == 0)
+         || (datetime == UINT64_MAX)
+       )
+    {
         return QDateTime();
     }
 
@@ -112,7 +129,14 @@ static QDateTime unpackDateTime(uint64_t datetime)
     datetime -= TIME_OFFSET_1601_1970;
 
     time_t  l_llTime = datetime / TIME_SEC_100NS;
-    tm     *l_pTime  = localtime(&l_llTime);
+    tm      l_sTime;
+
+    // streams are decoded in parallel, localtime() is not reentrant
+#ifdef Q_OS_WIN
+    tm     *l_pTime  = localtime_s(&l_sTime, &l_llTime) ? nullptr : &l_sTime;
+#else
+    tm     *l_pTime  = localtime_r(&l_llTime, &l_sTime);
+#endif
 
     if (l_pTime) {
         uint32_t rYear         = 1900 + l_pTime->tm_year;
@@ -132,10 +156,358 @@ static QDateTime unpackDateTime(uint64_t datetime)
     return QDateTime();
 }
 
+// Inverse of unpackDateTime(), local time to 100ns since 1601 (UTC)
+static inline uint64_t packDateTime(const QDateTime & dateTime)
+{
+    if (!dateTime.isValid()) {
+        return 0;
+    }
+
+    const uint64_t TIME_MLSC_100NS = 10000ull;
+    const uint64_t TIME_OFFSET_1601_1970 = 116444736000000000ULL;
+
+    return (uint64_t)dateTime.toMSecsSinceEpoch() * TIME_MLSC_100NS
+            + TIME_OFFSET_1601_1970;
+}
+
+// Timer value of a row to 100ns intervals since January 1, 1601 by the
+// Info packet of its stream: startTime was taken at timerValue. Rows
+// written a bit before the Info packet get earlier times. UINT64_MAX if
+// the row has no usable time.
+static inline uint64_t timerToTimestamp(uint64_t startTime,
+                                        uint64_t timerValue,
+                                        uint64_t timerFrequency,
+                                        uint64_t timer)
+{
+    // no Info packet yet
+    if (!timerFrequency) {
+        return UINT64_MAX;
+    }
+
+    const double ticks = timer >= timerValue
+            ? (double)(timer - timerValue)
+            : -(double)(timerValue - timer);
+    const double timeOffset = ticks * 10000000.0 / (double)timerFrequency;
+
+    // a timer far out of the dump
+    if (    (!(timeOffset < (double)(UINT64_MAX - startTime)))
+         || (!(timeOffset > -(double)startTime))
+       )
+    {
+        return UINT64_MAX;
+    }
+
+    return timeOffset < 0.0
+            ? startTime - (uint64_t)-timeOffset
+            : startTime + (uint64_t)timeOffset;
+}
+
+static inline QString traceTypeAsString(const uint32_t type)
+{
+    switch (type) {
+    case EP7TRACE_TYPE_INFO:
+        return "Info";
+    case EP7TRACE_TYPE_DESC:
+        return "Description";
+    case EP7TRACE_TYPE_DATA:
+        return "Data";
+    case EP7TRACE_TYPE_VERB:
+        return "Verbosity";
+    case EP7TRACE_TYPE_CLOSE:
+        return "Close";
+    case EP7TRACE_TYPE_THREAD_START:
+        return "Thread start";
+    case EP7TRACE_TYPE_THREAD_STOP:
+        return "Thread stop";
+    case EP7TRACE_TYPE_MODULE:
+        return "Module";
+    case EP7TRACE_TYPE_DELETE:
+        return "Delete";
+    case EP7TRACE_TYPE_UTC_OFFS:
+        return "UTC offset";
+    default:
+        return QString("Type %1").arg(type);
+    }
+}
+
+// Counters and phase timings collected during import
+struct p7ImportStats
+{
+    uint64_t bytesRead = 0;
+    // sH_User_Data packets per channel
+    uint64_t userPackets[USER_PACKET_CHANNEL_ID_MAX_SIZE] = {};
+    // trace stream packets per eP7Trace_Type
+    uint64_t tracePackets[EP7TRACE_TYPE_MAX] = {};
+
+    uint64_t descriptions = 0;
+    uint64_t threads = 0;
+    uint64_t modules = 0;
+
+    uint64_t noFormatter = 0;   // "No formatter found"
+    uint64_t formatFailed = 0;  // "Unable to format the message"
+
+    uint64_t streams = 0;       // trace streams, decoded in parallel
+    uint64_t telemetryStreams = 0;
+    uint64_t telemetryCounters = 0;
+    uint64_t telemetrySamples = 0;
+
+    uint64_t rowsDropped = 0;   // oldest rows over p7RetentionBudget
+    uint64_t rowsFiltered = 0;  // data packets skipped by p7ImportFilter
+
+    // Decoding is timed per chunk; formatting and time conversion are
+    // timed for one row in timingSampleRows() and scaled, a clock read
+    // costs about as much as a row
+    qint64 totalNs = 0;
+    qint64 framingNs = 0;        // readData(), chunk lists, LOD pyramids
+    qint64 decodeNs = 0;         // packet handlers except two below
+    qint64 formattingNs = 0;     // CFormatter::Format() + message QString
+    qint64 timeConversionNs = 0; // timer -> QDateTime
+
+    static constexpr uint64_t timingSampleRows()
+    {
+        return 64;
+    }
+    qint64 mergeNs = 0;          // time ordered view of all streams
+    qint64 telemetryNs = 0;      // telemetry samples + LOD pyramids
+
+    uint64_t userPacketsCount() const
+    {
+        uint64_t count = 0;
+        for (uint64_t packets : userPackets) {
+            count += packets;
+        }
+        return count;
+    }
+
+    // Sums counters and timings of a stream into dump statistics
+    void add(const p7ImportStats & other)
+    {
+        for (int i = 0; i < EP7TRACE_TYPE_MAX; ++i) {
+            tracePackets[i] += other.tracePackets[i];
+        }
+
+        descriptions += other.descriptions;
+        threads += other.threads;
+        modules += other.modules;
+        noFormatter += other.noFormatter;
+        formatFailed += other.formatFailed;
+        rowsFiltered += other.rowsFiltered;
+
+        framingNs += other.framingNs;
+        decodeNs += other.decodeNs;
+        formattingNs += other.formattingNs;
+        timeConversionNs += other.timeConversionNs;
+    }
+};
+
+static inline QString importStatsAsString(const p7ImportStats & stats)
+{
+    auto ms = [](qint64 ns) {
+        return QString::number((double)ns / 1e6, 'f', 1) + " ms";
+    };
+
+    double seconds = (double)stats.totalNs / 1e9;
+    double mbPerSec = seconds > 0
+            ? (double)stats.bytesRead / (1024.0 * 1024.0) / seconds
+            : 0.0;
+
+    QString text;
+    text += QString("Bytes read: %1 (%2 MB/s)\n")
+            .arg(stats.bytesRead)
+            .arg(mbPerSec, 0, 'f', 1);
+
+    text += "User packets per channel:\n";
+    for (int i = 0; i < USER_PACKET_CHANNEL_ID_MAX_SIZE; ++i) {
+        if (stats.userPackets[i]) {
+            text += QString("  #%1: %2\n").arg(i).arg(stats.userPackets[i]);
+        }
+    }
+
+    text += "Trace packets per type:\n";
+    for (int i = 0; i < EP7TRACE_TYPE_MAX; ++i) {
+        if (stats.tracePackets[i]) {
+            text += QString("  %1: %2\n")
+                    .arg(traceTypeAsString(i))
+                    .arg(stats.tracePackets[i]);
+        }
+    }
+
+    text += QString("Trace streams: %1\n").arg(stats.streams);
+    if (stats.telemetryStreams) {
+        text += QString("Telemetry streams: %1, counters: %2, samples: %3\n")
+                .arg(stats.telemetryStreams)
+                .arg(stats.telemetryCounters)
+                .arg(stats.telemetrySamples);
+    }
+    text += QString("Descriptions: %1\n").arg(stats.descriptions);
+    text += QString("Threads: %1\n").arg(stats.threads);
+    text += QString("Modules: %1\n").arg(stats.modules);
+    text += QString("No formatter found: %1\n").arg(stats.noFormatter);
+    text += QString("Unable to format the message: %1\n")
+            .arg(stats.formatFailed);
+    if (stats.rowsDropped) {
+        text += QString("Oldest rows dropped: %1\n").arg(stats.rowsDropped);
+    }
+    if (stats.rowsFiltered) {
+        text += QString("Rows filtered out at import: %1\n")
+                .arg(stats.rowsFiltered);
+    }
+
+    text += QString("Total time: %1\n").arg(ms(stats.totalNs));
+    text += QString("  framing: %1\n").arg(ms(stats.framingNs));
+    text += QString("  decoding: %1\n").arg(ms(stats.decodeNs));
+    text += QString("  formatting: %1 (sampled)\n")
+            .arg(ms(stats.formattingNs));
+    text += QString("  time conversion: %1 (sampled)\n")
+            .arg(ms(stats.timeConversionNs));
+    text += QString("  merge: %1\n").arg(ms(stats.mergeNs));
+    if (stats.telemetryStreams) {
+        text += QString("  telemetry: %1\n").arg(ms(stats.telemetryNs));
+    }
+    if (stats.streams + stats.telemetryStreams > 1) {
+        text += "Framing, decoding, formatting and time conversion are summed"
+                " over streams decoded in parallel\n";
+    }
+
+    return text;
+}
+
+// Memory used by a loaded dump, per component, in bytes
+struct p7MemoryReport
+{
+    uint64_t rows = 0;
+
+    uint64_t traceRows = 0;         // p7TraceDataInfo array
+    uint64_t messageStrings = 0;    // p7TraceDataInfo::message
+    uint64_t descriptions = 0;      // p7DescriptionInfo with packet buffers
+    uint64_t formatters = 0;        // CFormatter, arguments lists, sBuffer
+    uint64_t threadsAndModules = 0; // thread and module maps
+    uint64_t indexes = 0;           // id lookup tables
+    uint64_t arenaUnused = 0;       // reserved but not used metadata arena
+    uint64_t telemetry = 0;         // telemetry samples and LOD pyramids
+
+    uint64_t total() const
+    {
+        return traceRows + messageStrings + descriptions + formatters
+                + threadsAndModules + indexes + arenaUnused + telemetry;
+    }
+
+    double bytesPerRow(uint64_t bytes) const
+    {
+        return rows ? (double)bytes / (double)rows : 0.0;
+    }
+};
+
+static inline QString memoryReportAsString(const p7MemoryReport & report)
+{
+    auto line = [&report](const char * name, uint64_t bytes) {
+        return QString("%1: %2 bytes (%3 bytes/row)\n")
+                .arg(name)
+                .arg(bytes)
+                .arg(report.bytesPerRow(bytes), 0, 'f', 1);
+    };
+
+    QString text = QString("Rows: %1\n").arg(report.rows);
+    text += line("Trace rows", report.traceRows);
+    text += line("Message strings", report.messageStrings);
+    text += line("Descriptions", report.descriptions);
+    text += line("Formatters", report.formatters);
+    text += line("Threads and modules", report.threadsAndModules);
+    text += line("Indexes", report.indexes);
+    text += line("Arena unused", report.arenaUnused);
+    text += line("Telemetry", report.telemetry);
+    text += line("Total", report.total());
+
+    return text;
+}
+
+// Seek with 64-bit offsets, long of fseek() is 32 bits on Windows
+static inline bool seekFile(FILE * file, int64_t offset, int origin = SEEK_SET)
+{
+#if defined(_WIN32) || defined(_WIN64)
+    return _fseeki64(file, offset, origin) == 0;
+#else
+    return fseeko(file, (off_t)offset, origin) == 0;
+#endif
+}
+
+// Size of an open file, its position is kept
+static inline uint64_t fileSize(FILE * file)
+{
+#if defined(_WIN32) || defined(_WIN64)
+    const int64_t position = _ftelli64(file);
+    _fseeki64(file, 0, SEEK_END);
+    const int64_t size = _ftelli64(file);
+    _fseeki64(file, position, SEEK_SET);
+#else
+    const off_t position = ftello(file);
+    fseeko(file, 0, SEEK_END);
+    const off_t size = ftello(file);
+    fseeko(file, position, SEEK_SET);
+#endif
+    return size > 0 ? (uint64_t)size : 0;
+}
+
+// Heap bytes of QString data, 0 for empty (shared) strings
+static inline size_t stringHeapSize(const QString & string)
+{
+    if (string.isEmpty()) {
+        return 0;
+    }
+
+    return sizeof(QArrayData) + (string.capacity() + 1) * sizeof(QChar);
+}
+
+// std::map node: red-black tree links + value
+template<typename Map>
+static inline size_t mapHeapSize(const Map & map)
+{
+    const size_t nodeLinksSize = 4 * sizeof(void *);
+    return map.size() * (nodeLinksSize + sizeof(typename Map::value_type));
+}
+
 struct p7ThreadInfo
 {
     uint32_t id = 0;
     QString name;
+    // lifetime in stream timer ticks, thread ids are reused after stop
+    uint64_t startTimer = 0;
+    uint64_t stopTimer = UINT64_MAX;
+};
+
+// All threads which had the same id, ordered by start timer
+struct p7ThreadIntervals
+{
+    std::vector<p7ThreadInfo> threads;
+
+    // hit: index of the thread found for the previous row, the decoder
+    // keeps it as rows come in timer order; set to the one found
+    const p7ThreadInfo * find(uint64_t timer, size_t & hit) const
+    {
+        if (threads.empty()) {
+            return nullptr;
+        }
+
+        if (    (hit < threads.size())
+             && (threads[hit].startTimer <= timer)
+             && (timer <= threads[hit].stopTimer)
+             && (    hit + 1 == threads.size()
+                  || timer < threads[hit + 1].startTimer)
+           )
+        {
+            return &threads[hit];
+        }
+
+        // last thread started before timer, or the first one for rows
+        // which come before any start
+        auto it = std::upper_bound(threads.begin(), threads.end(), timer,
+                    [](uint64_t value, const p7ThreadInfo & thread) {
+                        return value < thread.startTimer;
+                    });
+        hit = (it == threads.begin()) ? 0 : (it - threads.begin()) - 1;
+
+        return &threads[hit];
+    }
 };
 
 struct p7ModuleInfo
@@ -160,10 +532,14 @@ struct p7DescriptionInfo
 
     sP7Trace_Arg *m_pArgs = nullptr; // pointer inside buffer
 
-    std::vector<unsigned char> buffer;
+    // packet copy, UTF-8 format and formatter live in p7DumpData arena
+    unsigned char * buffer = nullptr;
     uint32_t bufferSize = 0;
 
-    std::vector<char> format;
+    char * format = nullptr;
+    uint32_t formatSize = 0;
+
+    CFormatter * formatter = nullptr;
 };
 
 struct p7TraceDataInfo // ~= struct stTrace
@@ -172,8 +548,10 @@ struct p7TraceDataInfo // ~= struct stTrace
     uint16_t id = 0;
     uint32_t sequence = 0;
     uint8_t processorNumber = 0;
+    uint8_t channelId = 0;
     uint32_t moduleId = 0;
     uint32_t threadId = 0;
+    uint64_t timestamp = 0; // 100ns intervals since January 1, 1601 (UTC)
     QDateTime time;
     uint16_t line = 0;
     QString filename;
@@ -183,18 +561,86 @@ struct p7TraceDataInfo // ~= struct stTrace
     QString moduleName;
 };
 
-class p7DumpData
+// Rows of one trace ID (description) of a stream, counted as rows are
+// added; rows dropped by retention stay counted
+struct p7TraceIdStats
+{
+    uint64_t rows = 0;
+    // the earliest and the latest row with a time, 100ns since 1601;
+    // firstTime > lastTime if there is none
+    uint64_t firstTime = UINT64_MAX;
+    uint64_t lastTime = 0;
+    eP7Trace_Level level = EP7TRACE_LEVEL_COUNT; // of the latest row
+
+    // rows per second over the time span, rows if it is shorter
+    double rate() const
+    {
+        if (firstTime > lastTime) {
+            return (double)rows;
+        }
+        const double seconds = (double)(lastTime - firstTime) / 1e7;
+        return seconds >= 1.0 ? (double)rows / seconds : (double)rows;
+    }
+};
+
+// One trace stream (dwChannel_ID) of a dump with its own descriptions,
+// modules, threads and timer. Move-only, like p7DumpData.
+class p7StreamData
 {
 public:
 
-    p7DumpData()
+    explicit p7StreamData(uint8_t channelId = 0)
+        : _channelId(channelId)
+        , _arena(new p7Arena())
+    {}
+
+    p7StreamData(const p7StreamData &) = delete;
+    p7StreamData & operator=(const p7StreamData &) = delete;
+
+    p7StreamData(p7StreamData &&) = default;
+    p7StreamData & operator=(p7StreamData &&) = default;
+
+    uint8_t channelId() const
     {
-        memset(&_header, 0, sizeof(_header));
+        return _channelId;
     }
 
-    sP7File_Header & header()
+    QString name() const
     {
-        return _header;
+        return _name;
+    }
+
+    void setName(const QString & name)
+    {
+        _name = name;
+    }
+
+    // File of the dump the stream was read from, see p7DumpData::addFile()
+    uint32_t fileIndex() const
+    {
+        return _fileIndex;
+    }
+
+    void setFileIndex(uint32_t fileIndex)
+    {
+        _fileIndex = fileIndex;
+    }
+
+    // Per-stream metadata allocator, freed in one shot with the stream
+    p7Arena & arena()
+    {
+        return *_arena;
+    }
+
+    // Scratch buffer shared by all formatters of the stream
+    CFormatter::sBuffer * formatterBuffer()
+    {
+        if (!_formatterBuffer) {
+            _formatterBuffer = std::shared_ptr<CFormatter::sBuffer>(
+                new CFormatter::sBuffer(8192),
+                [](CFormatter::sBuffer * buffer) { buffer->Release(); });
+        }
+        return _formatterBuffer.get();
     }
 
     uint64_t timerValue() const {
@@ -213,52 +659,116 @@ public:
         _qwTimer_Frequency = timerFrequency;
     }
 
-    QString hostName() const
-    {
-        return QString::fromUtf16((const char16_t *)_header.pHost_Name);
+    // Time of the Info packet (timerValue() was taken at this moment),
+    // 100ns intervals since January 1, 1601 (UTC)
+    uint64_t startTime100Ns() const {
+        return _qwStart_Time;
     }
 
-    QString processName() const
+    void setStartTime100Ns(uint64_t startTime) {
+        _qwStart_Time = startTime;
+    }
+
+    void addNewThread(const p7ThreadInfo & thread)
     {
-        return QString::fromUtf16((const char16_t *)_header.pProcess_Name);
+        std::vector<p7ThreadInfo> & threads = _threads[thread.id].threads;
+
+        auto it = std::upper_bound(threads.begin(), threads.end(), thread,
+                    [](const p7ThreadInfo & left, const p7ThreadInfo & right) {
+                        return left.startTimer < right.startTimer;
+                    });
+
+        // previous thread with this id is dead once the id is reused
+        if (it != threads.begin() && (it - 1)->stopTimer > thread.startTimer) {
+            (it - 1)->stopTimer = thread.startTimer;
+        }
+
+        // and the new one is dead once a later thread reuses it
+        it = threads.insert(it, thread);
+        if (it + 1 != threads.end() && it->stopTimer > (it + 1)->startTimer) {
+            it->stopTimer = (it + 1)->startTimer;
+        }
+        ++_metadataRevision;
     }
 
-    QDateTime processDateTime() const
+    void stopThread(uint32_t id, uint64_t stopTimer)
     {
-        uint64_t l_qwTime
-                = ((uint64_t)(_header.dwProcess_Start_Time_Hi) << 32)
-                + (uint64_t)_header.dwProcess_Start_Time_Lo;
+        auto it = _threads.find(id);
+        if (it == _threads.end()) {
+            return;
+        }
 
-        return unpackDateTime(l_qwTime);
+        // the last thread started before stop
+        std::vector<p7ThreadInfo> & threads = it->second.threads;
+        for (auto thread = threads.rbegin(); thread != threads.rend(); ++thread) {
+            if (thread->startTimer <= stopTimer) {
+                thread->stopTimer = stopTimer;
+                break;
+            }
+        }
+        ++_metadataRevision;
     }
 
-    uint64_t processStartTime100Ns() const
+    // Thread with the id which was alive at timer, O(log n) of threads
+    // with the same id and O(1) for consecutive rows of one thread, see
+    // p7ThreadIntervals::find() for hit
+    inline const p7ThreadInfo & threadById(uint32_t id,
+                                           uint64_t timer,
+                                           size_t & hit) const
     {
-        return ((uint64_t)(_header.dwProcess_Start_Time_Hi) << 32)
-                + (uint64_t)_header.dwProcess_Start_Time_Lo;
+        auto it = _threads.find(id);
+        if (it != _threads.end()) {
+            const p7ThreadInfo * thread = it->second.find(timer, hit);
+            if (thread) {
+                return *thread;
+            }
+        }
+
+        return _unknownThread;
     }
 
-    void addNewThread(const p7ThreadInfo & thread)
+    // Thread table: threads by id, several ones if the id was reused
+    const std::map<uint32_t, p7ThreadIntervals> & threads() const
     {
-        _threads[thread.id] = thread;
+        return _threads;
     }
 
+    // The last thread started with the id
     inline const p7ThreadInfo & threadById(uint32_t id) const
     {
-        // TODO: seems we can have multiple threads with the same id when thread
-        // stopped
-
         auto it = _threads.find(id);
-        if (it != _threads.end()) {
-            return it->second;
-        } else {
-            return _unknownThread;
+        if (it != _threads.end() && !it->second.threads.empty()) {
+            return it->second.threads.back();
         }
+
+        return _unknownThread;
     }
 
     void addNewModule(const p7ModuleInfo & module)
     {
         _modules[module.id] = module;
+        ++_metadataRevision;
+    }
+
+    const std::map<uint16_t, p7ModuleInfo> & modules() const
+    {
+        return _modules;
+    }
+
+    // Threads and modules of the stream decoded on another thread, see
+    // p7DumpData::appendBatch()
+    void setThreadsAndModules(std::map<uint32_t, p7ThreadIntervals> && threads,
+                              std::map<uint16_t, p7ModuleInfo> && modules)
+    {
+        _threads = std::move(threads);
+        _modules = std::move(modules);
+        ++_metadataRevision;
+    }
+
+    // Changes of threads and modules so far, see p7DumpData::rowsSince()
+    uint64_t metadataRevision() const
+    {
+        return _metadataRevision;
     }
 
     inline const p7ModuleInfo & moduleById(uint16_t id) const
@@ -271,24 +781,132 @@ public:
         }
     }
 
+    // desc must be allocated in arena()
     void addNewDescription(p7DescriptionInfo * desc)
     {
-        _descriptions[desc->id] = std::shared_ptr<p7DescriptionInfo>(desc);
+        if (desc->id >= _descriptions.size()) {
+            _descriptions.resize((size_t)desc->id + 1, nullptr);
+        }
+        _descriptions[desc->id] = desc;
     }
 
     inline p7DescriptionInfo * descriptionById(uint16_t id) const
     {
-        auto it = _descriptions.find(id);
-        if (it != _descriptions.end()) {
-            return it->second.get();
-        } else {
-            return nullptr;
+        return id < _descriptions.size() ? _descriptions[id] : nullptr;
+    }
+
+    // Descriptions by id, nullptr for ids not described
+    const std::vector<p7DescriptionInfo *> & descriptions() const
+    {
+        return _descriptions;
+    }
+
+    CFormatter * formatterById(uint16_t id) const
+    {
+        p7DescriptionInfo * desc = descriptionById(id);
+        return desc ? desc->formatter : nullptr;
+    }
+
+    // chunkOffset: file offset of the row's sH_User_Data, see timeIndex()
+    void addNewTraceData(p7TraceDataInfo && data,
+                         uint64_t chunkOffset = p7TimeIndex::noFile())
+    {
+        _timeIndex.addRow(_traceData.endNumber(), data.timestamp, chunkOffset);
+
+        const size_t bytes = rowBytes(data);
+        const size_t block = (_traceData.frontOffset() + _traceData.size())
+                / p7BlockDeque<p7TraceDataInfo>::blockSize();
+        if (block == _blocksBytes.size()) {
+            _blocksBytes.push_back(0);
         }
+        _blocksBytes[block] += bytes;
+        _rowsBytes += bytes;
+
+        if (data.id >= _traceIdStats.size()) {
+            _traceIdStats.resize((size_t)data.id + 1);
+        }
+        p7TraceIdStats & stats = _traceIdStats[data.id];
+        stats.rows++;
+        stats.level = data.verbosity;
+
+        // rows with no time (see timerToTimestamp()) are not in the rates
+        if (data.timestamp != p7TimeIndex::noTime()) {
+            stats.firstTime = (std::min)(stats.firstTime, data.timestamp);
+            stats.lastTime = (std::max)(stats.lastTime, data.timestamp);
+            _rates.addRow(data.timestamp, data.verbosity);
+            _bursts.addRow(data.timestamp);
+        }
+
+        _traceData.push_back(std::move(data));
+    }
+
+    // Rows per trace ID (index), see P7DumpModel's trace ID view
+    const std::vector<p7TraceIdStats> & traceIdStats() const
+    {
+        return _traceIdStats;
+    }
+
+    // Rows per time bucket and level and bursts of the rate, counted as
+    // rows are added; rows dropped by retention stay counted
+    p7RateHistogram & rates()
+    {
+        return _rates;
+    }
+
+    const p7RateHistogram & rates() const
+    {
+        return _rates;
+    }
+
+    p7BurstDetector & bursts()
+    {
+        return _bursts;
+    }
+
+    const p7BurstDetector & bursts() const
+    {
+        return _bursts;
+    }
+
+    // Gaps, duplicates and reorderings of sequence numbers of the
+    // stream's packets, imported or not
+    p7SequenceCheck & sequences()
+    {
+        return _sequences;
+    }
+
+    const p7SequenceCheck & sequences() const
+    {
+        return _sequences;
+    }
+
+    p7TimeIndex & timeIndex()
+    {
+        return _timeIndex;
+    }
+
+    const p7TimeIndex & timeIndex() const
+    {
+        return _timeIndex;
+    }
+
+    // Index of the first row at or after time (100ns since 1601),
+    // traceDataCount() if there is none
+    size_t rowAtTime(uint64_t time) const
+    {
+        const uint64_t row = _timeIndex.rowAtTime(
+                    time, firstRowNumber(), endRowNumber(),
+                    [this](uint64_t number) {
+                        return _traceData[number - firstRowNumber()].timestamp;
+                    });
+        return (size_t)(row - firstRowNumber());
     }
 
-    void addNewTraceData(const p7TraceDataInfo & data)
+    // Drops spare capacity of the last rows block once import is done
+    void shrinkToFit()
     {
-        _traceData.push_back(data);
+        _traceData.shrinkToFit();
+        _rates.shrinkToFit();
     }
 
     size_t traceDataCount() const
@@ -301,88 +919,1547 @@ public:
         return _traceData[index];
     }
 
-    void addNewFormatter(CFormatter * formatter, uint16_t id)
+    // Rows are also numbered from the first one ever added, numbers don't
+    // change when the oldest rows are dropped
+    uint64_t firstRowNumber() const
     {
-        _formatters[id] = std::shared_ptr<CFormatter>(formatter);
+        return _traceData.firstNumber();
     }
 
-    CFormatter * formatterById(uint16_t id) const
+    uint64_t endRowNumber() const
     {
-        auto it = _formatters.find(id);
-        if (it != _formatters.end()) {
-            return it->second.get();
-        } else {
-            return nullptr;
+        return _traceData.endNumber();
+    }
+
+    // Index of a row number truncated to 32 bits, see p7RowRef
+    size_t rowIndex(uint32_t number) const
+    {
+        return (uint32_t)(number - (uint32_t)_traceData.firstNumber());
+    }
+
+    // Dropped rows still held by the oldest block of rows
+    size_t droppedRowsInBlock() const
+    {
+        return _traceData.frontOffset();
+    }
+
+    // Rows (with messages) in memory, descriptions etc. are not included
+    size_t rowsBytes() const
+    {
+        return _rowsBytes;
+    }
+
+    // Retention: count oldest rows are dropped, blocks of rows are freed
+    // once all their rows are dropped. Descriptions, threads and modules
+    // are kept, new rows still refer to them.
+    void dropOldestRows(size_t count)
+    {
+        count = (std::min)(count, _traceData.size());
+
+        // bytes of whole blocks are summed, rows of the block which is
+        // dropped in part are counted one by one
+        const size_t blockSize = p7BlockDeque<p7TraceDataInfo>::blockSize();
+        const size_t offset = _traceData.frontOffset();
+        const size_t blocks = (offset + count) / blockSize;
+        for (size_t i = 0; i < blocks; ++i) {
+            _rowsBytes -= _blocksBytes.front();
+            _blocksBytes.pop_front();
+        }
+        for (size_t i = blocks ? blocks * blockSize - offset : 0;
+             i < count;
+             ++i) {
+            const size_t bytes = rowBytes(_traceData[i]);
+            _rowsBytes -= bytes;
+            _blocksBytes.front() -= bytes;
         }
+
+        _traceData.popFront(count);
+        _timeIndex.dropRowsBefore(_traceData.firstNumber());
     }
 
-private:
+    p7ImportStats & importStats()
+    {
+        return _importStats;
+    }
 
-    std::map<uint32_t, p7ThreadInfo> _threads;
-    std::map<uint16_t, p7ModuleInfo> _modules;
-    std::map<uint16_t, std::shared_ptr<p7DescriptionInfo>> _descriptions;
-    std::map<uint16_t, std::shared_ptr<CFormatter>> _formatters;
-    std::vector<p7TraceDataInfo> _traceData;
+    const p7ImportStats & importStats() const
+    {
+        return _importStats;
+    }
 
-    p7ModuleInfo _unknownModule;
-    p7ThreadInfo _unknownThread;
+    // Adds memory used by the stream to report
+    void addToMemoryReport(p7MemoryReport & report) const
+    {
+        report.rows += _traceData.size();
 
-    sP7File_Header _header;
+        // filename, function, thread and module names of a row are shared
+        // with descriptions, threads and modules, only message is unique
+        report.traceRows += _traceData.capacity() * sizeof(p7TraceDataInfo);
+        for (size_t i = 0; i < _traceData.size(); ++i) {
+            report.messageStrings += stringHeapSize(_traceData[i].message);
+        }
+
+        for (const p7DescriptionInfo * desc : _descriptions) {
+            if (!desc) {
+                continue;
+            }
+
+            report.descriptions += sizeof(p7DescriptionInfo)
+                    + desc->bufferSize
+                    + desc->formatSize
+                    + stringHeapSize(desc->filename)
+                    + stringHeapSize(desc->function);
+
+            if (desc->formatter) {
+                report.formatters += desc->formatter->Get_Memory_Usage(FALSE);
+            }
+        }
+
+        if (_formatterBuffer) {
+            report.formatters += sizeof(CFormatter::sBuffer)
+                    + _formatterBuffer->szBuffer * sizeof(tXCHAR);
+        }
+
+        report.threadsAndModules += mapHeapSize(_threads) + mapHeapSize(_modules);
+        for (const auto & it : _threads) {
+            report.threadsAndModules
+                    += it.second.threads.capacity() * sizeof(p7ThreadInfo);
+            for (const p7ThreadInfo & thread : it.second.threads) {
+                report.threadsAndModules += stringHeapSize(thread.name);
+            }
+        }
+        for (const auto & it : _modules) {
+            report.threadsAndModules += stringHeapSize(it.second.name);
+        }
+
+        report.indexes += _traceIdStats.capacity() * sizeof(p7TraceIdStats)
+                + _rates.memoryUsage() + _bursts.memoryUsage()
+                + _sequences.memoryUsage();
+        report.indexes += _descriptions.capacity() * sizeof(p7DescriptionInfo *)
+                + _timeIndex.memoryUsage()
+                + _blocksBytes.size() * sizeof(size_t);
+
+        if (_arena && _arena->bytesReserved() > _arena->bytesUsed()) {
+            report.arenaUnused += _arena->bytesReserved() - _arena->bytesUsed();
+        }
+    }
+
+private:
+
+    static size_t rowBytes(const p7TraceDataInfo & row)
+    {
+        return sizeof(p7TraceDataInfo) + stringHeapSize(row.message);
+    }
+
+    uint8_t _channelId = 0;
+    uint32_t _fileIndex = 0;
+    QString _name;
+
+    std::map<uint32_t, p7ThreadIntervals> _threads;
+    std::map<uint16_t, p7ModuleInfo> _modules;
+    std::vector<p7DescriptionInfo *> _descriptions; // by id, in _arena
+    p7BlockDeque<p7TraceDataInfo> _traceData;
+    p7TimeIndex _timeIndex;
+    std::vector<p7TraceIdStats> _traceIdStats; // by id
+    p7RateHistogram _rates;
+    p7BurstDetector _bursts;
+    p7SequenceCheck _sequences;
+    uint64_t _metadataRevision = 0;
+    size_t _rowsBytes = 0;
+    std::deque<size_t> _blocksBytes; // rows bytes of blocks of _traceData
+
+    std::shared_ptr<CFormatter::sBuffer> _formatterBuffer;
+    std::unique_ptr<p7Arena> _arena;
+
+    p7ModuleInfo _unknownModule;
+    p7ThreadInfo _unknownThread;
+
+    //Hi resolution timer value, we get this value when we retrieve current time.
+    //using difference between this value and timer value for every trace we can
+    //calculate time of the trace event with hi resolution
+    uint64_t       _qwTimer_Value = 0;
+    //timer's count heartbeats in second
+    uint64_t       _qwTimer_Frequency = 0;
+    uint64_t       _qwStart_Time = 0;
+
+    p7ImportStats _importStats;
+};
+
+// Description of a sP7Trace_Format packet with its formatter, allocated
+// in the arena of the stream; the stream doesn't get it yet
+static inline p7DescriptionInfo * newDescription(const sP7Trace_Format * packet,
+                                                 p7StreamData & data)
+{
+    p7Arena & arena = data.arena();
+
+    p7DescriptionInfo * desc = arena.create<p7DescriptionInfo>();
+
+    desc->id = packet->wID;
+    desc->line = packet->wLine;
+    desc->moduleId = packet->wModuleID;
+    desc->argsLen = packet->wArgs_Len;
+
+    desc->bufferSize = packet->sCommon.dwSize;
+
+    tWCHAR *l_pFormat = nullptr;
+
+    if (desc->bufferSize) {
+        desc->buffer = (unsigned char *)arena.copy(
+                    packet, desc->bufferSize, alignof(uint64_t));
+        desc->m_pArgs
+                = (sP7Trace_Arg*)(desc->buffer + sizeof(sP7Trace_Format));
+
+        l_pFormat = (tWCHAR *)(desc->m_pArgs + desc->argsLen);
+        size_t l_szLen  = Get_UTF16_Length(l_pFormat) + 1;
+
+        // UTF-8 may need up to 3 bytes per UTF-16 code unit
+        desc->formatSize = (uint32_t)(l_szLen * 3);
+        desc->format = (char *)arena.allocate(desc->formatSize, 1);
+        Convert_UTF16_To_UTF8(l_pFormat, desc->format, desc->formatSize);
+
+        tXCHAR * m_pFile_Path = (char*)(l_pFormat + l_szLen);
+        tXCHAR * m_pFile_Name = nullptr;
+
+        if ((m_pFile_Name = strrchr(m_pFile_Path, '/'))) {
+            m_pFile_Name ++;
+        } else {
+            m_pFile_Name = m_pFile_Path;
+        };
+
+        char * pFunction = (char*)(m_pFile_Path + strlen(m_pFile_Path) + 1);
+        desc->function = QString::fromUtf8(pFunction);
+        desc->filename = QString::fromUtf8(m_pFile_Name);
+    }
+
+    if (desc->format) {
+        desc->formatter = arena.create<CFormatter>(
+                (const char *)desc->format,
+                desc->m_pArgs,
+                (size_t)desc->argsLen,
+                data.formatterBuffer());
+    }
+
+    return desc;
+}
+
+// Row of the merged view: stream index in p7DumpData and row number in
+// the stream, low 32 bits are enough while a stream keeps less than 4G rows
+struct p7RowRef
+{
+    uint32_t stream = 0;
+    uint32_t row = 0;
+};
+
+// Limits of rows kept in memory (follow and live modes), 0 - no limit.
+// The oldest rows are dropped when the budget is exceeded.
+struct p7RetentionBudget
+{
+    size_t maxRows = 0;
+    size_t maxBytes = 0; // see p7DumpData::rowsBytes()
+
+    bool isLimited() const
+    {
+        return maxRows || maxBytes;
+    }
+};
+
+// Rows to import, the rest is skipped before it is decoded. Empty lists
+// allow everything. Level, threads, IDs and the time window are checked
+// against the sP7Trace_Data header; modules are resolved once per trace
+// ID through its description.
+struct p7ImportFilter
+{
+    eP7Trace_Level minLevel = EP7TRACE_LEVEL_TRACE;
+    std::vector<QString> modules;   // names or ids
+    std::vector<uint32_t> threads;  // dwThreadID
+    std::vector<uint16_t> traceIds; // wID of descriptions
+    uint64_t fromTime = 0;          // 100ns since 1601 (UTC), 0 - open
+    uint64_t toTime = 0;            // excluded, 0 - open
+    // whole words all of which the message has, see p7Keywords; checked
+    // after formatting, blocks of a cataloged file without them are not
+    // read at all (p7DumpImporter::importTimeRange())
+    std::vector<QString> keywords;
+
+    bool hasTimeWindow() const
+    {
+        return fromTime || toTime;
+    }
+
+    // Blocks of a file can be skipped by its catalog index
+    bool skipsBlocks() const
+    {
+        return hasTimeWindow() || !keywords.empty();
+    }
+
+    bool isEmpty() const
+    {
+        return  (minLevel == EP7TRACE_LEVEL_TRACE)
+             && (modules.empty())
+             && (threads.empty())
+             && (traceIds.empty())
+             && (!hasTimeWindow())
+             && (keywords.empty());
+    }
+};
+
+// File of a dump combined from several files, see p7DumpData::addFile()
+struct p7DumpFile
+{
+    QString fileName;
+    sP7File_Header header;
+
+    QString processName() const
+    {
+        return QString::fromUtf16((const char16_t *)header.pProcess_Name);
+    }
+};
+
+// Rows of a dump added since the previous batch by stream index, copies
+// sharing their strings with the rows, with what views need besides rows:
+// threads and modules if they changed, new descriptions as their
+// packets, sequence checks, timers and new telemetry samples. See
+// p7DumpData::rowsSince()
+struct p7RowsBatch
+{
+    struct Stream
+    {
+        uint8_t channelId = 0;
+        QString name;
+        std::vector<p7TraceDataInfo> rows;
+
+        bool metadata = false; // threads and modules below are set
+        std::map<uint32_t, p7ThreadIntervals> threads;
+        std::map<uint16_t, p7ModuleInfo> modules;
+        std::vector<std::vector<uint8_t>> descriptions; // sP7Trace_Format
+
+        p7SequenceCheck sequences;
+        p7BurstSettings burstSettings;
+        p7ImportStats importStats;
+        uint64_t timerValue = 0;
+        uint64_t timerFrequency = 0;
+        uint64_t startTime = 0;
+    };
+
+    struct Series
+    {
+        uint16_t id = 0;
+        bool enabled = true;
+        double min = 0.0;
+        double max = 0.0;
+        double alarmMin = std::numeric_limits<double>::quiet_NaN();
+        double alarmMax = std::numeric_limits<double>::quiet_NaN();
+        QString name;
+        std::vector<uint64_t> timestamps;
+        std::vector<double> values;
+    };
+
+    struct Telemetry
+    {
+        uint8_t channelId = 0;
+        uint32_t version = 1;
+        QString name;
+        uint64_t timerValue = 0;
+        uint64_t timerFrequency = 0;
+        uint64_t startTime = 0;
+        std::vector<Series> series;
+    };
+
+    sP7File_Header header;
+    std::vector<Stream> streams;
+    std::vector<Telemetry> telemetry;
+    p7ImportStats importStats;
+};
+
+// What batches of p7DumpData::rowsSince() have copied so far
+struct p7BatchCursor
+{
+    std::vector<uint64_t> ends; // end row numbers by stream
+    std::vector<uint64_t> revisions; // p7StreamData::metadataRevision()
+    // by stream and id, a description sent again gets a new address
+    std::vector<std::vector<const p7DescriptionInfo *>> descriptions;
+    std::vector<std::vector<size_t>> samples; // by telemetry stream, series
+};
+
+// Imported dump: file header and trace streams. Rows of all streams are
+// available as one view ordered by time. Move-only: rows, descriptions and
+// the arenas they live in are handed over without copying; a moved-from
+// dump may only be assigned to or destroyed.
+class p7DumpData
+{
+public:
+
+    p7DumpData()
+    {
+        memset(&_header, 0, sizeof(_header));
+    }
+
+    p7DumpData(const p7DumpData &) = delete;
+    p7DumpData & operator=(const p7DumpData &) = delete;
+
+    p7DumpData(p7DumpData &&) = default;
+    p7DumpData & operator=(p7DumpData &&) = default;
+
+    sP7File_Header & header()
+    {
+        return _header;
+    }
+
+    QString hostName() const
+    {
+        return QString::fromUtf16((const char16_t *)_header.pHost_Name);
+    }
+
+    QString processName() const
+    {
+        return QString::fromUtf16((const char16_t *)_header.pProcess_Name);
+    }
+
+    QDateTime processDateTime() const
+    {
+        uint64_t l_qwTime
+                = ((uint64_t)(_header.dwProcess_Start_Time_Hi) << 32)
+                + (uint64_t)_header.dwProcess_Start_Time_Lo;
+
+        return unpackDateTime(l_qwTime);
+    }
+
+    uint64_t processStartTime100Ns() const
+    {
+        return ((uint64_t)(_header.dwProcess_Start_Time_Hi) << 32)
+                + (uint64_t)_header.dwProcess_Start_Time_Lo;
+    }
+
+    p7StreamData & addStream(uint8_t channelId)
+    {
+        _streams.emplace_back(new p7StreamData(channelId));
+        return *_streams.back();
+    }
+
+    size_t streamsCount() const
+    {
+        return _streams.size();
+    }
+
+    p7StreamData & stream(size_t index)
+    {
+        return *_streams[index];
+    }
+
+    const p7StreamData & stream(size_t index) const
+    {
+        return *_streams[index];
+    }
+
+    p7TelemetryStream & addTelemetryStream(uint8_t channelId, uint32_t version)
+    {
+        _telemetry.emplace_back(new p7TelemetryStream(channelId, version));
+        return *_telemetry.back();
+    }
+
+    size_t telemetryStreamsCount() const
+    {
+        return _telemetry.size();
+    }
+
+    const p7TelemetryStream & telemetryStream(size_t index) const
+    {
+        return *_telemetry[index];
+    }
+
+    // Rotated dumps of one incident: streams and telemetry of file are
+    // moved into this dump, every stream keeps its own descriptions,
+    // modules and threads (trace IDs of other processes collide). Rows
+    // are not copied, the merged view refers to them, see mergeStreams().
+    // The first file gives the header.
+    void addFile(const QString & fileName, p7DumpData && file)
+    {
+        if (_files.empty()) {
+            _header = file._header;
+        }
+
+        const uint32_t fileIndex = (uint32_t)_files.size();
+        _files.push_back({fileName, file._header});
+
+        for (auto & stream : file._streams) {
+            stream->setFileIndex(fileIndex);
+            _streams.push_back(std::move(stream));
+        }
+        for (auto & telemetry : file._telemetry) {
+            _telemetry.push_back(std::move(telemetry));
+        }
+        file._streams.clear();
+        file._telemetry.clear();
+
+        // timings are summed like those of streams decoded in parallel
+        const p7ImportStats & stats = file._importStats;
+        _importStats.add(stats);
+        _importStats.bytesRead += stats.bytesRead;
+        for (int i = 0; i < USER_PACKET_CHANNEL_ID_MAX_SIZE; ++i) {
+            _importStats.userPackets[i] += stats.userPackets[i];
+        }
+        _importStats.telemetryCounters += stats.telemetryCounters;
+        _importStats.telemetrySamples += stats.telemetrySamples;
+        _importStats.telemetryNs += stats.telemetryNs;
+        _importStats.totalNs += stats.totalNs;
+        _importStats.streams = _streams.size();
+        _importStats.telemetryStreams = _telemetry.size();
+    }
+
+    // Files combined by addFile(), empty for a dump of one file or source
+    const std::vector<p7DumpFile> & files() const
+    {
+        return _files;
+    }
+
+    // File of a row of the view, see files()
+    size_t fileIndexAt(size_t index) const
+    {
+        if (_streams.size() == 1) {
+            return _streams.front()->fileIndex();
+        }
+
+        return _streams[_merged[index].stream]->fileIndex();
+    }
+
+    // Stream of a row of the view and the row's number in the stream
+    size_t streamIndexAt(size_t index, uint64_t & number) const
+    {
+        if (_streams.size() == 1) {
+            number = _streams.front()->firstRowNumber() + index;
+            return 0;
+        }
+
+        const p7RowRef & ref = _merged[index];
+        const p7StreamData & stream = *_streams[ref.stream];
+        number = stream.firstRowNumber() + stream.rowIndex(ref.row);
+        return ref.stream;
+    }
+
+    // Rows of all streams ordered by timestamp, rows of one stream keep
+    // their order. Called by the importer once streams are decoded; in
+    // follow mode only rows added since the previous call are merged and
+    // appended, rows already in the view never move. A new stream makes
+    // the view built again. Only rows before the time before are merged,
+    // the others wait for the next call (see mergeTimeLimit()).
+    void mergeStreams(uint64_t before = UINT64_MAX)
+    {
+        if (_streams.size() < 2) {
+            _merged.clear();
+            _merged.shrinkToFit();
+            _mergedIndex.clear();
+            _mergedBlockStarts.clear();
+            _mergedEnd.clear();
+            return;
+        }
+
+        if (_mergedEnd.size() != _streams.size()) {
+            // numbered as if the view had all rows from the start: the
+            // same numbers as with all streams there at once
+            uint64_t dropped = 0;
+            _mergedEnd.resize(_streams.size());
+            for (size_t i = 0; i < _streams.size(); ++i) {
+                _mergedEnd[i] = _streams[i]->firstRowNumber();
+                dropped += _mergedEnd[i];
+            }
+            _merged.clear(dropped);
+            _mergedIndex.clear();
+            _mergedBlockStarts.clear();
+        }
+
+        // k-way merge, heap of the next row of every stream
+        auto later = [this](const p7RowRef & left, const p7RowRef & right) {
+            uint64_t leftTime = streamRow(left).timestamp;
+            uint64_t rightTime = streamRow(right).timestamp;
+            if (leftTime != rightTime) {
+                return leftTime > rightTime;
+            }
+            return left.stream > right.stream;
+        };
+
+        auto isMerged = [&](const p7RowRef & ref) {
+            const p7StreamData & stream = *_streams[ref.stream];
+            return (stream.rowIndex(ref.row) < stream.traceDataCount())
+                && (streamRow(ref).timestamp < before);
+        };
+
+        std::vector<p7RowRef> heads;
+        for (uint32_t i = 0; i < _streams.size(); ++i) {
+            const p7RowRef head = {i, (uint32_t)_mergedEnd[i]};
+            if (    (_mergedEnd[i] < _streams[i]->endRowNumber())
+                 && (isMerged(head))
+               )
+            {
+                heads.push_back(head);
+            }
+        }
+        std::make_heap(heads.begin(), heads.end(), later);
+
+        while (!heads.empty()) {
+            std::pop_heap(heads.begin(), heads.end(), later);
+            p7RowRef & next = heads.back();
+            const size_t block = (_merged.frontOffset() + _merged.size())
+                    / p7BlockDeque<p7RowRef>::blockSize();
+            if (block == _mergedBlockStarts.size()) {
+                _mergedBlockStarts.push_back(_mergedEnd);
+            }
+            _merged.push_back(next);
+            _mergedIndex.addRow(_merged.endNumber() - 1,
+                                streamRow(next).timestamp);
+
+            ++next.row;
+            ++_mergedEnd[next.stream];
+            if (isMerged(next)) {
+                std::push_heap(heads.begin(), heads.end(), later);
+            } else {
+                heads.pop_back();
+            }
+        }
+    }
+
+    // Time every stream has reached: the earliest of the timestamps of
+    // their last rows. Streams decoded in parts (a file loaded in
+    // batches) may only add rows from it on, rows before it can be
+    // merged in their final order. Streams without rows don't count.
+    uint64_t mergeTimeLimit() const
+    {
+        uint64_t limit = UINT64_MAX;
+        for (const auto & stream : _streams) {
+            const size_t count = stream->traceDataCount();
+            if (count) {
+                limit = (std::min)(limit,
+                                   stream->traceDataAt(count - 1).timestamp);
+            }
+        }
+        return limit;
+    }
+
+    // A dump decoded on another thread is shown while it grows: what was
+    // added to it since the previous call (cursor, updated) is copied for
+    // appendBatch() of the dump views show
+    p7RowsBatch rowsSince(p7BatchCursor & cursor) const
+    {
+        p7RowsBatch batch;
+        batch.header = _header;
+        batch.importStats = _importStats;
+        cursor.ends.resize(_streams.size(), 0);
+        cursor.revisions.resize(_streams.size(), 0);
+        cursor.descriptions.resize(_streams.size());
+
+        for (size_t i = 0; i < _streams.size(); ++i) {
+            const p7StreamData & stream = *_streams[i];
+            batch.streams.emplace_back();
+            p7RowsBatch::Stream & rows = batch.streams.back();
+            rows.channelId = stream.channelId();
+            rows.name = stream.name();
+
+            const uint64_t first = (std::max)(cursor.ends[i],
+                                              stream.firstRowNumber());
+            rows.rows.reserve((size_t)(stream.endRowNumber() - first));
+            for (uint64_t number = first;
+                 number < stream.endRowNumber();
+                 ++number) {
+                rows.rows.push_back(stream.traceDataAt(
+                                        stream.rowIndex((uint32_t)number)));
+            }
+            cursor.ends[i] = stream.endRowNumber();
+
+            // revision 0 is a stream with no threads and modules yet
+            if (stream.metadataRevision() != cursor.revisions[i]) {
+                rows.metadata = true;
+                rows.threads = stream.threads();
+                rows.modules = stream.modules();
+                cursor.revisions[i] = stream.metadataRevision();
+            }
+
+            const std::vector<p7DescriptionInfo *> & descriptions
+                    = stream.descriptions();
+            std::vector<const p7DescriptionInfo *> & sent
+                    = cursor.descriptions[i];
+            sent.resize(descriptions.size(), nullptr);
+            for (size_t id = 0; id < descriptions.size(); ++id) {
+                const p7DescriptionInfo * desc = descriptions[id];
+                if (desc && desc != sent[id] && desc->buffer) {
+                    rows.descriptions.emplace_back(
+                                desc->buffer, desc->buffer + desc->bufferSize);
+                    sent[id] = desc;
+                }
+            }
+
+            rows.sequences = stream.sequences();
+            rows.burstSettings = stream.bursts().settings();
+            rows.importStats = stream.importStats();
+            rows.timerValue = stream.timerValue();
+            rows.timerFrequency = stream.timerFrequency();
+            rows.startTime = stream.startTime100Ns();
+        }
+
+        cursor.samples.resize(_telemetry.size());
+        for (size_t i = 0; i < _telemetry.size(); ++i) {
+            const p7TelemetryStream & telemetry = *_telemetry[i];
+            batch.telemetry.emplace_back();
+            p7RowsBatch::Telemetry & samples = batch.telemetry.back();
+            samples.channelId = telemetry.channelId();
+            samples.version = telemetry.version();
+            samples.name = telemetry.name();
+            samples.timerValue = telemetry.timerValue();
+            samples.timerFrequency = telemetry.timerFrequency();
+            samples.startTime = telemetry.startTime100Ns();
+
+            std::vector<size_t> & sent = cursor.samples[i];
+            sent.resize(telemetry.seriesCount(), 0);
+            for (size_t j = 0; j < telemetry.seriesCount(); ++j) {
+                const p7TelemetrySeries & series = telemetry.seriesAt(j);
+                samples.series.emplace_back();
+                p7RowsBatch::Series & copy = samples.series.back();
+                copy.id = series.id;
+                copy.enabled = series.enabled;
+                copy.min = series.min;
+                copy.max = series.max;
+                copy.alarmMin = series.alarmMin;
+                copy.alarmMax = series.alarmMax;
+                copy.name = series.name;
+                for (size_t k = sent[j]; k < series.samplesCount(); ++k) {
+                    copy.timestamps.push_back(series.timestampAt(k));
+                    copy.values.push_back(series.valueAt(k));
+                }
+                sent[j] = series.samplesCount();
+            }
+        }
+
+        return batch;
+    }
+
+    // A dump which only feeds rowsSince() (live ingestion) frees rows
+    // and telemetry samples copied by it, the decoder needs neither
+    void dropCopied(p7BatchCursor & cursor)
+    {
+        for (size_t i = 0; i < _streams.size() && i < cursor.ends.size(); ++i) {
+            p7StreamData & stream = *_streams[i];
+            if (cursor.ends[i] > stream.firstRowNumber()) {
+                stream.dropOldestRows(
+                            (size_t)(cursor.ends[i] - stream.firstRowNumber()));
+            }
+        }
+
+        for (size_t i = 0; i < _telemetry.size() && i < cursor.samples.size();
+             ++i) {
+            std::vector<size_t> & sent = cursor.samples[i];
+            for (size_t j = 0; j < sent.size(); ++j) {
+                p7TelemetrySeries & series = _telemetry[i]->seriesAt(j);
+                if (sent[j] == series.samplesCount()) {
+                    series.clearSamples();
+                    sent[j] = 0;
+                }
+            }
+        }
+    }
+
+    // Adds rows of a batch of rowsSince() to streams of the same index,
+    // new streams are added in their order, and takes the rest of the
+    // batch. Rows are merged up to mergeTimeLimit() if inOrder, as a file
+    // decoded in batches merges them, or all of them as importChunks()
+    // does.
+    void appendBatch(p7RowsBatch && batch, bool inOrder = true)
+    {
+        _header = batch.header;
+
+        // retention of this dump drops rows of its own
+        const uint64_t rowsDropped = _importStats.rowsDropped;
+        _importStats = batch.importStats;
+        _importStats.rowsDropped = rowsDropped;
+
+        for (size_t i = 0; i < batch.streams.size(); ++i) {
+            p7RowsBatch::Stream & rows = batch.streams[i];
+            if (i == _streams.size()) {
+                addStream(rows.channelId).bursts().setSettings(
+                            rows.burstSettings);
+            }
+
+            p7StreamData & stream = *_streams[i];
+            stream.setName(rows.name);
+            stream.setTimerValue(rows.timerValue);
+            stream.setTimerFrequency(rows.timerFrequency);
+            stream.setStartTime100Ns(rows.startTime);
+            if (rows.metadata) {
+                stream.setThreadsAndModules(std::move(rows.threads),
+                                            std::move(rows.modules));
+            }
+            for (const std::vector<uint8_t> & packet : rows.descriptions) {
+                stream.addNewDescription(newDescription(
+                        (const sP7Trace_Format *)packet.data(), stream));
+            }
+            stream.sequences() = std::move(rows.sequences);
+            stream.importStats() = rows.importStats;
+
+            for (p7TraceDataInfo & row : rows.rows) {
+                stream.addNewTraceData(std::move(row));
+            }
+        }
+
+        for (size_t i = 0; i < batch.telemetry.size(); ++i) {
+            p7RowsBatch::Telemetry & samples = batch.telemetry[i];
+            if (i == _telemetry.size()) {
+                addTelemetryStream(samples.channelId, samples.version);
+            }
+
+            p7TelemetryStream & telemetry = *_telemetry[i];
+            telemetry.setName(samples.name);
+            telemetry.setTimerValue(samples.timerValue);
+            telemetry.setTimerFrequency(samples.timerFrequency);
+            telemetry.setStartTime100Ns(samples.startTime);
+            for (const p7RowsBatch::Series & copy : samples.series) {
+                p7TelemetrySeries & series = telemetry.addSeries(copy.id);
+                series.enabled = copy.enabled;
+                series.min = copy.min;
+                series.max = copy.max;
+                series.alarmMin = copy.alarmMin;
+                series.alarmMax = copy.alarmMax;
+                series.name = copy.name;
+                for (size_t k = 0; k < copy.values.size(); ++k) {
+                    series.append(copy.timestamps[k], copy.values[k]);
+                }
+            }
+            telemetry.buildLod();
+        }
+
+        mergeStreams(inOrder ? mergeTimeLimit() : UINT64_MAX);
+    }
+
+    // Number of the first row of the view, it grows as the oldest rows
+    // are dropped
+    uint64_t firstRowNumber() const
+    {
+        if (_streams.size() == 1) {
+            return _streams.front()->firstRowNumber();
+        }
+        return _merged.firstNumber();
+    }
+
+    // Drops spare capacity of rows, the merged view and telemetry once
+    // import is done
+    void shrinkToFit()
+    {
+        for (auto & stream : _streams) {
+            stream->shrinkToFit();
+        }
+        _merged.shrinkToFit();
+        for (auto & telemetry : _telemetry) {
+            telemetry->shrinkToFit();
+        }
+    }
+
+    size_t traceDataCount() const
+    {
+        if (_streams.size() == 1) {
+            return _streams.front()->traceDataCount();
+        }
+        return _merged.size();
+    }
+
+    const p7TraceDataInfo & traceDataAt(size_t index) const
+    {
+        if (_streams.size() == 1) {
+            return _streams.front()->traceDataAt(index);
+        }
+
+        return streamRow(_merged[index]);
+    }
+
+    // Index of the first row of the view at or after time (100ns since
+    // 1601), traceDataCount() if there is none
+    size_t rowAtTime(uint64_t time) const
+    {
+        if (_streams.size() == 1) {
+            return _streams.front()->rowAtTime(time);
+        }
+
+        const uint64_t row = _mergedIndex.rowAtTime(
+                    time, _merged.firstNumber(), _merged.endNumber(),
+                    [this](uint64_t number) {
+                        return streamRow(
+                            _merged[number - _merged.firstNumber()]).timestamp;
+                    });
+        return (size_t)(row - _merged.firstNumber());
+    }
+
+    // File ranges of rows of every trace channel, for
+    // p7DumpImporter::importTimeRange() on the same file later; a dump
+    // of one file only
+    std::vector<p7ChannelTimeIndex> timeIndexes() const
+    {
+        std::vector<p7ChannelTimeIndex> indexes;
+        for (const auto & stream : _streams) {
+            p7ChannelTimeIndex channel;
+            channel.channelId = stream->channelId();
+            channel.index = stream->timeIndex();
+            indexes.push_back(std::move(channel));
+        }
+        return indexes;
+    }
+
+    // Rows of the view (and the view itself) in memory
+    size_t rowsBytes() const
+    {
+        size_t bytes = _merged.size() * sizeof(p7RowRef);
+        for (const auto & stream : _streams) {
+            bytes += stream->rowsBytes();
+        }
+        return bytes;
+    }
+
+    // Number of the oldest rows of the view to drop to get under budget,
+    // rounded up to whole blocks so memory is freed at once and drops
+    // don't happen on every appended batch
+    size_t rowsOverBudget(const p7RetentionBudget & budget) const
+    {
+        const size_t rows = traceDataCount();
+        if (!rows) {
+            return 0;
+        }
+
+        size_t drop = 0;
+        if (budget.maxRows && rows > budget.maxRows) {
+            drop = rows - budget.maxRows;
+        }
+
+        if (budget.maxBytes) {
+            const size_t bytes = rowsBytes();
+            if (bytes > budget.maxBytes) {
+                // rows are dropped oldest first, average size is close enough
+                size_t byBytes = (size_t)((double)(bytes - budget.maxBytes)
+                                          * (double)rows / (double)bytes) + 1;
+                drop = (std::max)(drop, byBytes);
+            }
+        }
+
+        if (!drop) {
+            return 0;
+        }
+
+        const size_t blockSize = p7BlockDeque<p7RowRef>::blockSize();
+        const size_t offset = _streams.size() == 1
+                ? _streams.front()->droppedRowsInBlock()
+                : _merged.frontOffset();
+        drop = (offset + drop + blockSize - 1) / blockSize * blockSize
+                - offset;
+
+        return (std::min)(drop, rows);
+    }
+
+    // Rows of a stream among count oldest rows of the view
+    size_t streamRowsAmongOldest(size_t stream, size_t count) const
+    {
+        if (_streams.size() == 1) {
+            return (std::min)(count, traceDataCount());
+        }
+
+        std::vector<size_t> streamRows;
+        countOldestRows((std::min)(count, _merged.size()), streamRows);
+        return streamRows[stream];
+    }
+
+    // Drops count oldest rows of the view. The merged view holds the
+    // oldest rows of every stream, so each stream drops its oldest rows
+    // too and row numbers in the rest of the view stay valid.
+    void dropOldestRows(size_t count)
+    {
+        count = (std::min)(count, traceDataCount());
+        if (!count) {
+            return;
+        }
+
+        if (_streams.size() == 1) {
+            _streams.front()->dropOldestRows(count);
+        } else {
+            std::vector<size_t> streamRows;
+            countOldestRows(count, streamRows);
+
+            // starts of whole blocks are freed with them, the block which
+            // is dropped in part starts at the rows left
+            const size_t blocks = (_merged.frontOffset() + count)
+                    / p7BlockDeque<p7RowRef>::blockSize();
+            _mergedBlockStarts.erase(_mergedBlockStarts.begin(),
+                                     _mergedBlockStarts.begin()
+                                         + (ptrdiff_t)blocks);
+
+            _merged.popFront(count);
+            _mergedIndex.dropRowsBefore(_merged.firstNumber());
+            for (size_t i = 0; i < _streams.size(); ++i) {
+                _streams[i]->dropOldestRows(streamRows[i]);
+                if (!_mergedBlockStarts.empty()) {
+                    _mergedBlockStarts.front()[i]
+                            = _streams[i]->firstRowNumber();
+                }
+            }
+        }
+
+        _importStats.rowsDropped += count;
+    }
+
+    // Counters of the whole dump, decoding counters and timings are
+    // summed over streams
+    p7ImportStats & importStats()
+    {
+        return _importStats;
+    }
+
+    const p7ImportStats & importStats() const
+    {
+        return _importStats;
+    }
+
+    // Index in the view of a row of a stream (its number), for links
+    // from other views; traceDataCount() if it isn't there any more
+    size_t viewIndexOf(size_t stream, uint64_t number) const
+    {
+        const p7StreamData & streamData = *_streams[stream];
+        if (    (number < streamData.firstRowNumber())
+             || (number >= streamData.endRowNumber())
+           )
+        {
+            return traceDataCount();
+        }
+
+        const size_t index = (size_t)(number - streamData.firstRowNumber());
+        if (_streams.size() == 1) {
+            return index;
+        }
+
+        if (number >= _mergedEnd[stream]) {
+            return traceDataCount(); // not merged yet
+        }
+
+        // rows of a stream keep their order in the view: the last block
+        // which starts at or before the row has it, then the row is
+        // counted among the block's rows of the stream
+        auto block = std::upper_bound(
+                    _mergedBlockStarts.begin(), _mergedBlockStarts.end(),
+                    number,
+                    [stream](uint64_t value,
+                             const std::vector<uint64_t> & starts) {
+                        return value < starts[stream];
+                    }) - 1;
+
+        const size_t blockSize = p7BlockDeque<p7RowRef>::blockSize();
+        const size_t offset = _merged.frontOffset();
+        const size_t blockIndex = (size_t)(block - _mergedBlockStarts.begin());
+        const size_t first = blockIndex ? blockIndex * blockSize - offset : 0;
+        const size_t end = (std::min)((blockIndex + 1) * blockSize - offset,
+                                      _merged.size());
+        uint64_t skip = number - (*block)[stream];
+        for (size_t i = first; i < end; ++i) {
+            if (_merged[i].stream == stream && !skip--) {
+                return i;
+            }
+        }
+
+        return traceDataCount();
+    }
+
+    p7MemoryReport memoryReport() const
+    {
+        p7MemoryReport report;
+
+        for (const auto & stream : _streams) {
+            stream->addToMemoryReport(report);
+        }
+
+        report.indexes += _merged.capacity() * sizeof(p7RowRef)
+                + _mergedIndex.memoryUsage()
+                + _streams.capacity() * sizeof(void *)
+                + _mergedEnd.capacity() * sizeof(uint64_t)
+                + _mergedBlockStarts.size() * _streams.size() * sizeof(uint64_t)
+                + _files.capacity() * sizeof(p7DumpFile);
+
+        for (const auto & telemetry : _telemetry) {
+            report.telemetry += telemetry->memoryUsage();
+        }
+
+        return report;
+    }
+
+private:
+
+    const p7TraceDataInfo & streamRow(const p7RowRef & ref) const
+    {
+        const p7StreamData & stream = *_streams[ref.stream];
+        return stream.traceDataAt(stream.rowIndex(ref.row));
+    }
+
+    // Rows of every stream among count oldest rows of the merged view:
+    // from the start of the block of the first row left, plus rows of
+    // that block before it one by one
+    void countOldestRows(size_t count, std::vector<size_t> & streamRows) const
+    {
+        streamRows.assign(_streams.size(), 0);
+
+        const size_t blockSize = p7BlockDeque<p7RowRef>::blockSize();
+        const size_t offset = _merged.frontOffset();
+        const size_t blocks = (offset + count) / blockSize;
+        for (size_t i = 0; i < _streams.size(); ++i) {
+            const uint64_t start = blocks < _mergedBlockStarts.size()
+                    ? _mergedBlockStarts[blocks][i]
+                    : _mergedEnd[i];
+            streamRows[i] = (size_t)(start - _streams[i]->firstRowNumber());
+        }
+        for (size_t i = blocks ? blocks * blockSize - offset : 0;
+             i < count;
+             ++i) {
+            ++streamRows[_merged[i].stream];
+        }
+    }
+
+    std::vector<std::unique_ptr<p7StreamData>> _streams;
+    p7BlockDeque<p7RowRef> _merged; // empty for a single stream
+    p7TimeIndex _mergedIndex;
+    // by block of _merged: number of the first row of every stream at or
+    // after the block's first row in memory
+    std::deque<std::vector<uint64_t>> _mergedBlockStarts;
+    std::vector<uint64_t> _mergedEnd; // next row number to merge by stream
+    std::vector<std::unique_ptr<p7TelemetryStream>> _telemetry;
+
+    sP7File_Header _header;
+    std::vector<p7DumpFile> _files;
+
+    p7ImportStats _importStats;
+};
+
+// Sequence checks of the streams of a dump, a line per stream
+static inline QString sequenceChecksAsString(const p7DumpData & data)
+{
+    QString text;
+    for (size_t i = 0; i < data.streamsCount(); ++i) {
+        const p7SequenceCheck & check = data.stream(i).sequences();
+        text += QString("%1: %2\n")
+                .arg(data.stream(i).name())
+                .arg(check.packets() ? sequenceCheckAsString(check)
+                                     : QString("not checked"));
+    }
+    return text;
+}
+
+class p7DumpImporter
+{
+    // benchmarks call packet handlers directly, see bench/main.cpp
+    friend class p7ImporterBench;
+
+public:
+
+    p7DumpImporter()
+    {
+        _clock.start();
+    }
+
+    ~p7DumpImporter()
+    {
+        clear();
+    }
+
+    p7DumpData import(const std::string & fileName)
+    {
+
+        clear();
+
+        p7DumpData data;
+
+        _file = fopen(fileName.c_str(), "rb");
+
+        if (!_file) {
+            std::cerr << "Failed to open file";
+            return data;
+        }
+
+        const uint64_t size = fileSize(_file);
+        if (size > (uint64_t)SIZE_MAX) {
+            std::cerr << "File is too big";
+            return data;
+        }
+        _allDataBuffer.resize((size_t)size);
+
+        _szData_Size = fread(_allDataBuffer.data(),
+                                       sizeof(uint8_t),
+                                       (size_t)size, _file);
+        if (_szData_Size != (size_t)size) {
+            // what was read is imported, the rest is cut like a truncated file
+            std::cerr << "Failed to read the whole file";
+            _allDataBuffer.resize(_szData_Size);
+        }
+        _bufferRanges.emplace_back(0, 0);
+
+        return importBufferToData(data);
+    }
+
+    p7DumpData import(const QByteArray &fileContent)
+    {
+        clear();
+
+        p7DumpData data;
+
+        _allDataBuffer.resize(fileContent.size());
+        memcpy(_allDataBuffer.data(), fileContent.data(), fileContent.size());
+        _szData_Size = fileContent.size();
+        _bufferRanges.emplace_back(0, 0);
+
+        return importBufferToData(data);
+
+    }
+
+    // Follow mode: decodes what was appended to the file since import()
+    // or the previous call into data (the same dump). Nothing is parsed
+    // twice: reading starts at the first chunk which wasn't complete last
+    // time. At most maxBytes (but at least one chunk) are read per call,
+    // see pendingBytes(). Returns false if the file can't be read or it
+    // has been truncated (rotated), then the dump has to be imported anew.
+    bool importAppended(const std::string & fileName,
+                        p7DumpData & data,
+                        size_t maxBytes = 16 * 1024 * 1024)
+    {
+        FILE * file = fopen(fileName.c_str(), "rb");
+        if (!file) {
+            return false;
+        }
+
+        const uint64_t fileSize = p7::fileSize(file);
+
+        if (fileSize < _qwFile_Offs) {
+            fclose(file);
+            return false;
+        }
+
+        _qwFile_Size = fileSize;
+
+        // the file was empty or shorter than its header so far
+        if (_qwFile_Offs < sizeof(sP7File_Header)) {
+            if (fileSize < sizeof(sP7File_Header)) {
+                fclose(file);
+                return true;
+            }
+
+            if (    (fread(&data.header(), sizeof(sP7File_Header), 1, file) != 1)
+                 || (P7_DAMP_FILE_MARKER_V1 != data.header().qwMarker)
+               )
+            {
+                std::cerr << "Header is corrupted";
+                fclose(file);
+                return false;
+            }
+
+            _qwFile_Offs = sizeof(sP7File_Header);
+        }
+
+        uint64_t available = fileSize - _qwFile_Offs;
+        size_t toRead = (size_t)std::min<uint64_t>(available, maxBytes);
+
+        // the first chunk may be bigger than maxBytes
+        sH_User_Data l_sHeader;
+        const bool seeked = seekFile(file, (int64_t)_qwFile_Offs);
+        if (    (seeked)
+             && (available >= sizeof(l_sHeader))
+             && (fread(&l_sHeader, sizeof(l_sHeader), 1, file) == 1)
+             && (l_sHeader.dwSize > toRead)
+             && (l_sHeader.dwSize <= available)
+           )
+        {
+            toRead = l_sHeader.dwSize;
+        }
+
+        _allDataBuffer.resize(toRead);
+        _szData_Size = seekFile(file, (int64_t)_qwFile_Offs)
+                ? fread(_allDataBuffer.data(), 1, toRead, file)
+                : 0;
+        _allDataBuffer.resize(_szData_Size);
+        fclose(file);
+
+        _bufferRanges.assign(1, std::make_pair((size_t)0, _qwFile_Offs));
+
+        _szData_Offs = 0;
+        readData(data);
+
+        _qwFile_Offs += _szData_Offs;
+
+        return true;
+    }
+
+    // Imports rows of [from, to) only (100ns since 1601, to = 0 - open).
+    // Only parts of the file with such rows or with packets rows need
+    // (descriptions, threads...) are read, as told by the time index of
+    // an earlier unfiltered import of the file, see
+    // p7DumpData::timeIndexes(). With keywords in the filter blocks whose
+    // keyword filters (p7DumpCatalog) don't have them are not read either.
+    // Telemetry is decoded from these parts only. Without file ranges in
+    // the index the whole file is read.
+    p7DumpData importTimeRange(const std::string & fileName,
+                               const std::vector<p7ChannelTimeIndex> & indexes,
+                               uint64_t from,
+                               uint64_t to)
+    {
+        clear();
+
+        p7DumpData data;
+
+        FILE * file = fopen(fileName.c_str(), "rb");
+        if (!file) {
+            std::cerr << "Failed to open file";
+            return data;
+        }
+
+        const uint64_t fileSize = p7::fileSize(file);
+
+        if (    (fileSize < sizeof(sP7File_Header))
+             || (fread(&data.header(), sizeof(sP7File_Header), 1, file) != 1)
+             || (P7_DAMP_FILE_MARKER_V1 != data.header().qwMarker)
+           )
+        {
+            std::cerr << "Header is corrupted";
+            fclose(file);
+            return data;
+        }
+
+        // the window narrows the time window of the filter, if any
+        const p7ImportFilter filter = _filter;
+        p7ImportFilter window = filter;
+        window.fromTime = (std::max)(filter.fromTime, from);
+        window.toTime = (filter.toTime && to)
+                ? (std::min)(filter.toTime, to)
+                : (filter.toTime ? filter.toTime : to);
+        setFilter(window);
+
+        std::vector<std::pair<uint64_t, uint64_t>> ranges
+                = timeRangeFileRanges(indexes,
+                                      sizeof(sP7File_Header),
+                                      fileSize,
+                                      window.fromTime,
+                                      window.toTime,
+                                      _keywordHashes);
+        if (ranges.empty()) {
+            ranges.emplace_back(sizeof(sP7File_Header), fileSize);
+        }
+
+        // numbers of skipped parts would be gaps
+        _checkSequences = (ranges.size() == 1)
+                && (ranges.front().first == sizeof(sP7File_Header))
+                && (ranges.front().second == fileSize);
+
+        size_t bytes = 0;
+        for (const auto & range : ranges) {
+            bytes += (size_t)(range.second - range.first);
+        }
+        _allDataBuffer.resize(bytes);
+
+        // ranges start at chunk boundaries, together they are chunks too
+        for (const auto & range : ranges) {
+            if (!seekFile(file, (int64_t)range.first)) {
+                break;
+            }
+            _bufferRanges.emplace_back(_szData_Size, range.first);
+            _szData_Size += fread(_allDataBuffer.data() + _szData_Size, 1,
+                                  (size_t)(range.second - range.first), file);
+        }
+        _allDataBuffer.resize(_szData_Size);
+        fclose(file);
+
+        readData(data);
+        finishImport(data);
+
+        setFilter(filter);
+        _checkSequences = true;
+
+        return data;
+    }
+
+    // Rotated dumps: files are imported in parallel, the filter applies to
+    // each of them, and combined into one dump ordered by time, see
+    // p7DumpData::addFile(). Files which can't be read are skipped.
+    p7DumpData importFiles(const std::vector<std::string> & fileNames)
+    {
+        clear();
+
+        QElapsedTimer clock;
+        clock.start();
+
+        std::vector<std::unique_ptr<p7DumpImporter>> importers;
+        for (size_t i = 0; i < fileNames.size(); ++i) {
+            importers.emplace_back(new p7DumpImporter());
+            importers.back()->setFilter(_filter);
+            importers.back()->setBurstSettings(_burstSettings);
+            // the combined dump is merged once, below
+            importers.back()->_mergeStreams = false;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_fileImportersMutex);
+            for (auto & importer : importers) {
+                _fileImporters.push_back(importer.get());
+            }
+        }
+
+        std::vector<p7DumpData> dumps(fileNames.size());
+
+        std::atomic<size_t> nextFile(0);
+        auto worker = [this, &fileNames, &importers, &dumps, &nextFile]() {
+            size_t file;
+            while ((file = nextFile++) < fileNames.size() && !_cancelled) {
+                dumps[file] = importers[file]->import(fileNames[file]);
+            }
+        };
+
+        // every file is decoded by its streams in parallel too
+        size_t threadsCount = std::min<size_t>(
+                    fileNames.size(),
+                    std::max(1u, std::thread::hardware_concurrency()));
+
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < threadsCount; ++i) {
+            threads.emplace_back(worker);
+        }
+
+        worker();
+
+        for (std::thread & thread : threads) {
+            thread.join();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_fileImportersMutex);
+            _fileImporters.clear();
+        }
+
+        p7DumpData data;
+        for (size_t i = 0; i < dumps.size(); ++i) {
+            if (P7_DAMP_FILE_MARKER_V1 == dumps[i].header().qwMarker) {
+                data.addFile(QString::fromStdString(fileNames[i]),
+                             std::move(dumps[i]));
+            }
+        }
+
+        p7ImportStats & stats = data.importStats();
+
+        const qint64 mergeStartNs = clock.nsecsElapsed();
+        data.mergeStreams();
+        data.shrinkToFit();
+        stats.mergeNs += clock.nsecsElapsed() - mergeStartNs;
+
+        // files were imported in parallel, the total is wall time
+        stats.totalNs = clock.nsecsElapsed();
+
+        return data;
+    }
 
-    //QString _streamName;
-    //Hi resolution timer value, we get this value when we retrieve current time.
-    //using difference between this value and timer value for every trace we can
-    //calculate time of the trace event with hi resolution
-    uint64_t       _qwTimer_Value = 0;
-    //timer's count heartbeats in second
-    uint64_t       _qwTimer_Frequency = 0;
-};
+    // Rows skipped at import by the following import() calls, lists
+    // don't need to be sorted
+    void setFilter(const p7ImportFilter & filter)
+    {
+        _filter = filter;
+        std::sort(_filter.threads.begin(), _filter.threads.end());
+        std::sort(_filter.traceIds.begin(), _filter.traceIds.end());
+        _filtering = !_filter.isEmpty();
+
+        std::string words;
+        for (const QString & keyword : _filter.keywords) {
+            words += keyword.toStdString();
+            words += ' ';
+        }
+        _keywordHashes = p7Keywords::wordHashes(words.data(), words.size());
 
-class p7DumpImporter
-{
-public:
+        for (p7StreamChunks & channel : _channels) {
+            channel.filterIds.clear();
+            channel.filterTimersValid = false;
+        }
+    }
 
-    ~p7DumpImporter()
+    const p7ImportFilter & filter() const
     {
-        clear();
+        return _filter;
     }
 
-    p7DumpData import(const std::string & fileName)
+    // Bursts of streams of the following import() calls
+    void setBurstSettings(const p7BurstSettings & settings)
     {
+        _burstSettings = settings;
+    }
 
-        clear();
+    const p7BurstSettings & burstSettings() const
+    {
+        return _burstSettings;
+    }
 
-        p7DumpData data;
+    // Import running on another thread: part of the current readData()
+    // decoded so far, 0..1
+    double progress() const
+    {
+        {
+            std::lock_guard<std::mutex> lock(_fileImportersMutex);
+            if (!_fileImporters.empty()) {
+                double progress = 0.0;
+                for (const p7DumpImporter * importer : _fileImporters) {
+                    progress += importer->progress();
+                }
+                return progress / (double)_fileImporters.size();
+            }
+        }
 
-        _file = fopen(fileName.c_str(), "rb");
+        const uint64_t total = _bytesToDecode;
+        return total ? (std::min)(1.0, (double)_bytesDecoded / (double)total)
+                     : 0.0;
+    }
 
-        if (!_file) {
-            std::cerr << "Failed to open file";
-            return data;
-        }
+    bool isCancelled() const
+    {
+        return _cancelled;
+    }
 
-        int fileSize = this->fileSize(_file);
-        _allDataBuffer.resize(fileSize);
+    // Stops import running on another thread as soon as possible, the
+    // dump is left partially decoded. The importer can't be used after.
+    void cancel()
+    {
+        _cancelled = true;
 
-        _szData_Size = fread(_allDataBuffer.data(),
-                                       sizeof(uint8_t),
-                                       fileSize, _file);
+        std::lock_guard<std::mutex> lock(_fileImportersMutex);
+        for (p7DumpImporter * importer : _fileImporters) {
+            importer->cancel();
+        }
+    }
 
-        return importBufferToData(data);
+    // Off: streams are decoded but not merged, for a dump which only
+    // feeds p7DumpData::rowsSince()
+    void setMergeStreams(bool merge)
+    {
+        _mergeStreams = merge;
     }
 
-    p7DumpData import(const QByteArray &fileContent)
+    // A file loaded by importAppended() in batches: the merged view only
+    // gets rows before p7DumpData::mergeTimeLimit(), rows are in the
+    // order of an import at once. Once the file is read the rest is
+    // merged by p7DumpData::mergeStreams() and the option turned off,
+    // or a quiet stream would hold back rows of the others.
+    void setMergeInOrder(bool inOrder)
     {
-        clear();
+        _mergeInOrder = inOrder;
+    }
 
-        p7DumpData data;
+    // Bytes of the file after the last complete chunk, as of the last
+    // importAppended(); includes the incomplete chunk at the end
+    uint64_t pendingBytes() const
+    {
+        return _qwFile_Size > _qwFile_Offs ? _qwFile_Size - _qwFile_Offs : 0;
+    }
 
-        _allDataBuffer.resize(fileContent.size());
-        memcpy(_allDataBuffer.data(), fileContent.data(), fileContent.size());
-        _szData_Size = fileContent.size();
+    // Live ingestion: decodes sH_User_Data chunks received from elsewhere
+    // (see P7ReplayReceiver) into data, continuing its streams. An
+    // incomplete chunk at the end is skipped. The buffer is swapped in
+    // and out, so both keep their capacity between calls.
+    void importChunks(std::vector<uint8_t> & chunks, p7DumpData & data)
+    {
+        _allDataBuffer.swap(chunks);
+        _szData_Size = _allDataBuffer.size();
+        _szData_Offs = 0;
+        _bufferRanges.clear();
 
-        return importBufferToData(data);
+        readData(data);
 
+        _allDataBuffer.swap(chunks);
+        _szData_Size = 0;
+        _szData_Offs = 0;
     }
 
 private:
@@ -391,7 +2468,7 @@ private:
     {
         if (sizeof(sP7File_Header) >= _szData_Size) {
             std::cerr << "File size less than header size should be";
-            return data;
+            return std::move(data);
         }
 
         memcpy(&data.header(), _allDataBuffer.data(), sizeof(data.header()));
@@ -405,15 +2482,16 @@ private:
 
             } else {
                 std::cerr << "Header is corrupted";
-                return data;
+                return std::move(data);
             }
         }
 
         _szData_Offs  = sizeof(sP7File_Header);
 
         readData(data);
+        finishImport(data);
 
-        return data;
+        return std::move(data);
     }
 
     void clear()
@@ -427,128 +2505,468 @@ private:
         _qwFile_Offs = 0;
         _qwFile_Size = 0;
         _szData_Size = 0;
+        _bufferRanges.clear();
+
+        for (p7StreamChunks & channel : _channels) {
+            channel = p7StreamChunks();
+        }
     }
 
-    int fileSize(FILE * file)
+    // Whole file is decoded, drop the file copy and spare capacity
+    void finishImport(p7DumpData & data)
     {
+        _qwFile_Offs = fileOffsetOf(_szData_Offs);
+        _qwFile_Size = fileOffsetOf(_szData_Size);
 
-        int pos = fseek(file, 0L, SEEK_CUR);
-        fseek(file, 0L, SEEK_END);
-        int size = ftell(file);
+        std::vector<uint8_t>().swap(_allDataBuffer);
+        _szData_Offs = 0;
+        _szData_Size = 0;
 
-        fseek(file, pos, SEEK_SET);
+        data.shrinkToFit();
+    }
 
-        return size;
+    // File offset of a byte of _allDataBuffer, p7TimeIndex::noFile() if
+    // the buffer is not from a file
+    uint64_t fileOffsetOf(size_t bufferOffs) const
+    {
+        auto range = std::upper_bound(
+                    _bufferRanges.begin(), _bufferRanges.end(), bufferOffs,
+                    [](size_t offs, const std::pair<size_t, uint64_t> & part) {
+                        return offs < part.first;
+                    });
+        if (range == _bufferRanges.begin()) {
+            return p7TimeIndex::noFile();
+        }
+        --range;
+        return range->second + (bufferOffs - range->first);
     }
 
+    // Channel of the dump: its stream and chunks to decode by the current
+    // readData() call, offsets and sizes in _allDataBuffer
+    struct p7StreamChunks
+    {
+        p7StreamData * stream = nullptr;
+        p7TelemetryStream * telemetry = nullptr;
+        bool skipped = false; // not supported stream type
+        std::vector<std::pair<size_t, size_t>> chunks;
+        p7ImportStats stats;  // of the current readData() call
+        qint64 decodeNs = 0;
+
+        // _filter resolved for the stream: passes by trace id (-1 - not
+        // resolved yet) and timers of the time window
+        std::vector<int8_t> filterIds;
+        bool filterTimersValid = false;
+        uint64_t filterFromTimer = 0;
+        uint64_t filterToTimer = UINT64_MAX;
+
+        // chunk being decoded, for p7StreamData::timeIndex()
+        uint64_t chunkOffset = p7TimeIndex::noFile();
+        bool chunkMetadata = false;
+
+        // thread of the previous row, see p7StreamData::threadById()
+        size_t threadHit = 0;
+    };
+
+    // Decodes complete sH_User_Data chunks of _allDataBuffer starting at
+    // _szData_Offs, which is left at the first incomplete chunk. Channels
+    // and their streams are kept in _channels, so the next call (follow
+    // mode) continues them.
     void readData(p7DumpData & data)
     {
+        p7ImportStats & stats = data.importStats();
+
+        _clock.start();
 
-        uint32_t firstTraceChannelID = static_cast<uint32_t>(-1);
-        std::map<uint32_t, uint8_t *> _streamsData; // start of all streams
+        const size_t startOffs = _szData_Offs;
+
+        // Split sH_User_Data chunks by channel, stream type is known from
+        // the first packet of the channel. Trace and telemetry streams are
+        // supported.
+        for (p7StreamChunks & channel : _channels) {
+            channel.chunks.clear();
+            channel.stats = p7ImportStats();
+            channel.decodeNs = 0;
+        }
 
         while(_szData_Offs + sizeof(sH_User_Data) <= _allDataBuffer.size())
         {
             sH_User_Data *l_pHeader = (sH_User_Data *)(_allDataBuffer.data()
                                                            + _szData_Offs);
 
-            if ((_szData_Offs + l_pHeader->dwSize) > _allDataBuffer.size()) {
+            if (    (l_pHeader->dwSize < sizeof(sH_User_Data))
+                 || ((_szData_Offs + l_pHeader->dwSize) > _allDataBuffer.size())
+               )
+            {
                 break;
             }
 
             uint32_t channelID = l_pHeader->dwChannel_ID;
-            auto streamStartIt = _streamsData.find(channelID);
-            if (streamStartIt == _streamsData.end()) {
-                _streamsData[channelID]
-                        = (uint8_t*)l_pHeader + sizeof(sH_User_Data);
-                streamStartIt = _streamsData.find(channelID);
-            }
+            stats.userPackets[channelID]++;
 
-            sP7Ext_Header * streamHeader = (sP7Ext_Header*)(streamStartIt->second);
-            eP7User_Type streamType = (eP7User_Type)streamHeader->dwType;
+            size_t chunkOffs = _szData_Offs + sizeof(sH_User_Data);
+            size_t chunkSize = l_pHeader->dwSize - sizeof(sH_User_Data);
 
-            // We support only trace streams at the moment
-            if (streamType == EP7USER_TYPE_TRACE) {
-                if (firstTraceChannelID == static_cast<uint32_t>(-1)) {
-                    firstTraceChannelID = channelID;
+            p7StreamChunks & stream = _channels[channelID];
+
+            if (    (!stream.stream)
+                 && (!stream.telemetry)
+                 && (!stream.skipped)
+                 && (chunkSize >= sizeof(sP7Ext_Header))
+               )
+            {
+                sP7Ext_Header * streamHeader
+                        = (sP7Ext_Header*)(_allDataBuffer.data() + chunkOffs);
+                eP7User_Type streamType = (eP7User_Type)streamHeader->dwType;
+
+                if (streamType == EP7USER_TYPE_TRACE) {
+                    stream.stream = &data.addStream((uint8_t)channelID);
+                    stream.stream->bursts().setSettings(_burstSettings);
+                } else if (streamType == EP7USER_TYPE_TELEMETRY_V1) {
+                    stream.telemetry
+                        = &data.addTelemetryStream((uint8_t)channelID, 1);
+                } else if (streamType == EP7USER_TYPE_TELEMETRY_V2) {
+                    stream.telemetry
+                        = &data.addTelemetryStream((uint8_t)channelID, 2);
+                } else {
+                    stream.skipped = true;
                 }
+            }
+
+            if (stream.stream || stream.telemetry) {
+                stream.chunks.emplace_back(chunkOffs, chunkSize);
+            }
+
+            _szData_Offs += l_pHeader->dwSize;
+        }
 
-                // process only first trace stream
-                if (channelID == firstTraceChannelID) {
+        stats.bytesRead += _szData_Offs - startOffs;
+        stats.framingNs += _clock.nsecsElapsed();
 
-                    QByteArray dataChunk(
-                          (const char *)(_allDataBuffer.data()
-                           + _szData_Offs
-                           + sizeof(sH_User_Data)),
-                           l_pHeader->dwSize - sizeof(sH_User_Data));
+        _bytesToDecode = _szData_Offs - startOffs;
+        _bytesDecoded = 0;
 
-                    processDataChunk(dataChunk, data);
-                }
+        std::vector<p7StreamChunks *> jobs;
+        for (p7StreamChunks & stream : _channels) {
+            if (!stream.chunks.empty()) {
+                jobs.push_back(&stream);
             }
+        }
 
-            _szData_Offs += l_pHeader->dwSize;
+        decodeStreams(jobs);
+
+        stats.telemetryCounters = 0;
+        stats.telemetrySamples = 0;
+        for (p7StreamChunks & stream : _channels) {
+            if (stream.stream) {
+                stats.add(stream.stats);
+            } else if (stream.telemetry) {
+                stats.telemetryNs += stream.decodeNs;
+                stats.telemetryCounters += stream.telemetry->seriesCount();
+                stats.telemetrySamples += stream.telemetry->samplesCount();
+            }
         }
+        stats.streams = data.streamsCount();
+        stats.telemetryStreams = data.telemetryStreamsCount();
+
+        if (_mergeStreams) {
+            qint64 mergeStartNs = _clock.nsecsElapsed();
+            data.mergeStreams(_mergeInOrder
+                              ? data.mergeTimeLimit()
+                              : UINT64_MAX);
+            stats.mergeNs += _clock.nsecsElapsed() - mergeStartNs;
+        }
+
+        stats.totalNs += _clock.nsecsElapsed();
     }
 
-    void processDataChunk(QByteArray dataChunk, p7DumpData & data)
+    // Streams are independent (own descriptions, formatters, arena), so
+    // every stream is decoded by one thread
+    void decodeStreams(std::vector<p7StreamChunks *> & jobs)
     {
-        //sP7Trace_Data * traceData = (sP7Trace_Data *)dataChunk.data();
+        if (jobs.size() == 1) {
+            decodeStream(*jobs.front());
+            return;
+        }
 
-        //qDebug() << "  wId" << traceData->wID;
-        //qDebug() << "  bLevel" << traceData->bLevel;
-        //qDebug() << "  bProcessor" << traceData->bProcessor;
-        //qDebug() << "  dwThreadID" << traceData->dwThreadID;
-        //qDebug() << "  dwSequence" << traceData->dwSequence;
-        //qDebug() << "  timer" << traceData->qwTimer;
+        std::atomic<size_t> nextJob(0);
+        auto worker = [this, &jobs, &nextJob]() {
+            size_t job;
+            while ((job = nextJob++) < jobs.size()) {
+                decodeStream(*jobs[job]);
+            }
+        };
 
-        eResult l_eReturn = eOk;
-        sP7Ext_Header *l_pHeader = NULL;
+        size_t threadsCount = std::min<size_t>(
+                    jobs.size(),
+                    std::max(1u, std::thread::hardware_concurrency()));
 
-        while (dataChunk.size() && (eOk == l_eReturn)) {
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < threadsCount; ++i) {
+            threads.emplace_back(worker);
+        }
 
-            l_pHeader = (sP7Ext_Header *)dataChunk.data();
+        worker();
 
-            //qDebug() << "  ** " << l_pHeader->dwType
-            //         << l_pHeader->dwSize
-            //         << dataChunk.size();
+        for (std::thread & thread : threads) {
+            thread.join();
+        }
+    }
 
-            if (    (EP7USER_TYPE_TRACE == l_pHeader->dwType)
-                 || (dataChunk.size() >= l_pHeader->dwSize)
-                )
-            {
-                l_eReturn = processPacket(l_pHeader, data);
+    void decodeStream(p7StreamChunks & job)
+    {
+        if (job.telemetry) {
+            decodeTelemetryStream(job);
+            return;
+        }
+
+        p7StreamData & stream = *job.stream;
+
+        // handlers count to the stream statistics, collect this call only
+        p7ImportStats total = stream.importStats();
+        p7ImportStats & stats = stream.importStats();
+        stats = p7ImportStats();
+
+        qint64 startNs = _clock.nsecsElapsed();
+
+        for (const auto & chunk : job.chunks) {
+            if (_cancelled) {
+                break;
+            }
+
+            job.chunkOffset = fileOffsetOf(chunk.first - sizeof(sH_User_Data));
+            job.chunkMetadata = false;
+
+            const qint64 chunkStartNs = _clock.nsecsElapsed();
+            processDataChunk(_allDataBuffer.data() + chunk.first,
+                             chunk.second,
+                             stream);
+            stats.decodeNs += _clock.nsecsElapsed() - chunkStartNs;
+
+            if (job.chunkOffset != p7TimeIndex::noFile()) {
+                stream.timeIndex().addChunk(
+                            job.chunkOffset,
+                            job.chunkOffset + sizeof(sH_User_Data) + chunk.second,
+                            job.chunkMetadata);
+            }
+
+            _bytesDecoded += chunk.second;
+        }
+
+        stream.rates().buildLod();
+        stream.sequences().flush();
+
+        // decodeNs is time of whole chunks, sampled parts are estimates
+        qint64 totalNs = _clock.nsecsElapsed() - startNs;
+        stats.framingNs += totalNs - stats.decodeNs;
+        stats.decodeNs = (std::max)(
+                    (qint64)0,
+                    stats.decodeNs - stats.formattingNs
+                        - stats.timeConversionNs);
+
+        job.stats = stats;
+        total.add(stats);
+        stats = total;
+    }
+
+    void decodeTelemetryStream(p7StreamChunks & job)
+    {
+        p7TelemetryStream & telemetry = *job.telemetry;
+
+        qint64 startNs = _clock.nsecsElapsed();
+
+        bool closed = false;
+        for (const auto & chunk : job.chunks) {
+            if (_cancelled) {
+                break;
+            }
+
+            _bytesDecoded += chunk.second;
+
+            const uint8_t * packet = _allDataBuffer.data() + chunk.first;
+            const uint8_t * end = packet + chunk.second;
+
+            while (!closed && packet + sizeof(sP7Ext_Header) <= end) {
+                const sP7Ext_Header * header = (const sP7Ext_Header *)packet;
+                if (    (header->dwSize < sizeof(sP7Ext_Header))
+                     || (packet + header->dwSize > end)
+                   )
+                {
+                    break;
+                }
+
+                closed = eErrorClosed
+                        == processTelemetryPacket(header, telemetry);
+
+                packet += header->dwSize;
+            }
+        }
+
+        telemetry.buildLod();
+
+        job.decodeNs += _clock.nsecsElapsed() - startNs;
+    }
+
+    // Names of telemetry packets may be not aligned (V2 counter)
+    static QString telemetryName(const void * name)
+    {
+        char16_t l_pName[P7TELEMETRY_COUNTER_NAME_LENGTH];
+        memcpy(l_pName, name, sizeof(l_pName));
+        l_pName[P7TELEMETRY_COUNTER_NAME_LENGTH - 1] = 0;
+        return QString::fromUtf16(l_pName);
+    }
+
+    eResult processTelemetryPacket(const sP7Ext_Header * i_pPacket,
+                                   p7TelemetryStream & telemetry)
+    {
+        const uint32_t size = i_pPacket->dwSize;
+        const bool v1 = telemetry.version() == 1;
+
+        switch (i_pPacket->dwSubType) {
+
+        case EP7TEL_TYPE_INFO: {
+            if (size < sizeof(sP7Tel_Info)) {
+                break;
+            }
+
+            const sP7Tel_Info * l_pInfo = (const sP7Tel_Info *)i_pPacket;
+            telemetry.setName(telemetryName(l_pInfo->pName));
+            telemetry.setStartTime100Ns(((uint64_t)l_pInfo->dwTime_Hi << 32)
+                                        + (uint64_t)l_pInfo->dwTime_Lo);
+            telemetry.setTimerValue(l_pInfo->qwTimer_Value);
+            telemetry.setTimerFrequency(l_pInfo->qwTimer_Frequency);
+            break;
+        }
+
+        case EP7TEL_TYPE_COUNTER: {
+            if (v1 && size >= sizeof(sP7Tel_Counter_v1)) {
+                const sP7Tel_Counter_v1 * l_pCounter
+                        = (const sP7Tel_Counter_v1 *)i_pPacket;
+                p7TelemetrySeries & series
+                        = telemetry.addSeries(l_pCounter->bID);
+                series.enabled = l_pCounter->bOn;
+                series.min = (double)l_pCounter->llMin;
+                series.max = (double)l_pCounter->llMax;
+                series.alarmMax = (double)l_pCounter->llAlarm;
+                series.name = telemetryName(l_pCounter->pName);
+            } else if (!v1 && size >= sizeof(sP7Tel_Counter_v2)) {
+                const sP7Tel_Counter_v2 * l_pCounter
+                        = (const sP7Tel_Counter_v2 *)i_pPacket;
+                p7TelemetrySeries & series
+                        = telemetry.addSeries(l_pCounter->wID);
+                series.enabled = l_pCounter->bOn;
+                series.min = l_pCounter->dbMin;
+                series.max = l_pCounter->dbMax;
+                series.alarmMin = l_pCounter->dbAlarmMin;
+                series.alarmMax = l_pCounter->dbAlarmMax;
+                series.name = telemetryName(l_pCounter->pName);
+            }
+            break;
+        }
+
+        case EP7TEL_TYPE_VALUE: {
+            uint16_t id = 0;
+            uint64_t timer = 0;
+            double value = 0.0;
+
+            if (v1 && size >= sizeof(sP7Tel_Value_v1)) {
+                const sP7Tel_Value_v1 * l_pValue
+                        = (const sP7Tel_Value_v1 *)i_pPacket;
+                id = l_pValue->bID;
+                timer = l_pValue->qwTimer;
+                value = (double)l_pValue->llValue;
+            } else if (!v1 && size >= sizeof(sP7Tel_Value_v2)) {
+                const sP7Tel_Value_v2 * l_pValue
+                        = (const sP7Tel_Value_v2 *)i_pPacket;
+                id = l_pValue->wID;
+                timer = l_pValue->qwTimer;
+                value = l_pValue->dbValue;
+            } else {
+                break;
             }
 
-            if (eErrorMissmatch != l_eReturn) {
-                dataChunk = dataChunk.mid(l_pHeader->dwSize);
+            p7TelemetrySeries * series = telemetry.seriesById(id);
+            if (!series) {
+                // sample before (or without) counter description
+                series = &telemetry.addSeries(id);
+            }
+            series->append(telemetry.timestamp(timer), value);
+            break;
+        }
+
+        case EP7TEL_TYPE_CLOSE:
+            return eErrorClosed;
+
+        default:
+            break;
+        }
+
+        return eOk;
+    }
+
+    // Packets are handled in place, a skipped (e.g. filtered out) packet
+    // costs its header check only
+    void processDataChunk(const uint8_t * chunk,
+                          size_t size,
+                          p7StreamData & stream)
+    {
+        eResult l_eReturn = eOk;
+        const uint8_t * end = chunk + size;
+
+        while ((chunk + sizeof(sP7Ext_Header) <= end) && (eOk == l_eReturn)) {
+
+            sP7Ext_Header * l_pHeader = (sP7Ext_Header *)chunk;
+
+            if (    (l_pHeader->dwSize < sizeof(sP7Ext_Header))
+                 || (chunk + l_pHeader->dwSize > end)
+               )
+            {
+                break;
             }
+
+            l_eReturn = processPacket(l_pHeader, stream);
+
+            chunk += l_pHeader->dwSize;
         }
     }
 
-    eResult processPacket(sP7Ext_Header * i_pPacket, p7DumpData & data)
+    eResult processPacket(sP7Ext_Header * i_pPacket, p7StreamData & data)
     {
         eResult l_eReturn = eOk;
 
         //qDebug() << " === subtype: " << i_pPacket->dwSubType;
 
+        data.importStats().tracePackets[i_pPacket->dwSubType]++;
+
+        // partial imports must read chunks with packets rows depend on
+        if (EP7TRACE_TYPE_DATA != i_pPacket->dwSubType) {
+            _channels[data.channelId()].chunkMetadata = true;
+        }
+
         if (EP7TRACE_TYPE_DATA == i_pPacket->dwSubType) {
 
             return processDataPacket(i_pPacket, data);
 
         } else if (EP7TRACE_TYPE_INFO == i_pPacket->dwSubType) {
 
+            _channels[data.channelId()].filterTimersValid = false;
             return processInfoPacket(i_pPacket, data);
 
         } else if (EP7TRACE_TYPE_THREAD_START == i_pPacket->dwSubType) {
 
             return processThreadStartPacket(i_pPacket, data);
 
+        } else if (EP7TRACE_TYPE_THREAD_STOP == i_pPacket->dwSubType) {
+
+            return processThreadStopPacket(i_pPacket, data);
+
         } else if (EP7TRACE_TYPE_MODULE == i_pPacket->dwSubType) {
 
+            _channels[data.channelId()].filterIds.clear();
             return processModulePacket(i_pPacket, data);
 
         } else if (EP7TRACE_TYPE_DESC == i_pPacket->dwSubType) {
 
+            _channels[data.channelId()].filterIds.clear();
             return processDescPacket(i_pPacket, data);
 
         } else if (EP7TRACE_TYPE_CLOSE == i_pPacket->dwSubType) {
@@ -559,18 +2977,30 @@ private:
         return l_eReturn;
     }
 
-    eResult processDataPacket(sP7Ext_Header * i_pPacket, p7DumpData & data)
+    eResult processDataPacket(sP7Ext_Header * i_pPacket, p7StreamData & data)
     {
         //qDebug() << "  -- EP7TRACE_TYPE_DATA";
 
         sP7Trace_Data *l_pTrace = (sP7Trace_Data*)i_pPacket;
 
+        // filtered out packets count too, the next imported row is marked
+        if (_checkSequences) {
+            data.sequences().addPacket(l_pTrace->dwSequence,
+                                       data.endRowNumber());
+        }
+
+        if (_filtering && !passesFilter(l_pTrace, data)) {
+            data.importStats().rowsFiltered++;
+            return eOk;
+        }
+
         p7TraceDataInfo traceData;
         traceData.id = l_pTrace->wID;
         traceData.verbosity = (eP7Trace_Level)l_pTrace->bLevel;
         traceData.processorNumber = l_pTrace->bProcessor;
         traceData.sequence = l_pTrace->dwSequence;
         traceData.threadId = l_pTrace->dwThreadID;
+        traceData.channelId = data.channelId();
 
         p7DescriptionInfo * desc = data.descriptionById(traceData.id);
         if (desc) {
@@ -586,22 +3016,34 @@ private:
         const p7ModuleInfo & moduleInfo = data.moduleById(traceData.moduleId);
         traceData.moduleName = moduleInfo.name;
 
-        const p7ThreadInfo & threadInfo = data.threadById(traceData.threadId);
+        const p7ThreadInfo & threadInfo
+                = data.threadById(traceData.threadId,
+                                  l_pTrace->qwTimer,
+                                  _channels[data.channelId()].threadHit);
         traceData.threadName = threadInfo.name;
 
-        uint64_t timeOffset
-            = (uint64_t)(
-                    (double)(l_pTrace->qwTimer - data.timerValue()) * 10000000.0
-                    / (double)data.timerFrequency());
+        // one row in timingSampleRows() is timed, see p7ImportStats
+        p7ImportStats & stats = data.importStats();
+        const bool timed = !((stats.tracePackets[EP7TRACE_TYPE_DATA]
+                              - stats.rowsFiltered)
+                             % p7ImportStats::timingSampleRows());
+        const qint64 timeStartNs = timed ? _clock.nsecsElapsed() : 0;
 
-        traceData.time = unpackDateTime(
-                    data.processStartTime100Ns() + timeOffset);
+        traceData.timestamp = traceTimestamp(data, l_pTrace->qwTimer);
+        traceData.time = unpackDateTime(traceData.timestamp);
+
+        const qint64 formatStartNs = timed ? _clock.nsecsElapsed() : 0;
+        if (timed) {
+            stats.timeConversionNs += (formatStartNs - timeStartNs)
+                    * (qint64)p7ImportStats::timingSampleRows();
+        }
 
         const size_t traceMessageBufSize = (0x2000);
         tXCHAR traceMessageBuf[traceMessageBufSize];
         memset(traceMessageBuf, 0, traceMessageBufSize);
 
-        CFormatter * formatter = data.formatterById(desc->id);
+        CFormatter * formatter = desc ? desc->formatter : nullptr;
+        const char * failure = nullptr;
         if (formatter) {
 
             int32_t formatRes = formatter->Format(
@@ -623,13 +3065,35 @@ private:
 
                     ++l_pIter;
                 }
-
-                traceData.message = QString::fromUtf8(traceMessageBuf);
             } else {
-                traceData.message = "Unable to format the message";
+                failure = "Unable to format the message";
+                data.importStats().formatFailed++;
             }
         } else {
-            traceData.message = "No formatter found";
+            failure = "No formatter found";
+            data.importStats().noFormatter++;
+        }
+
+        // keywords are matched before the message string is made
+        if (    (!_keywordHashes.empty())
+             && (!p7Keywords::containsAll(failure ? failure : traceMessageBuf,
+                                          _keywordHashes))
+           )
+        {
+            if (timed) {
+                stats.formattingNs += (_clock.nsecsElapsed() - formatStartNs)
+                        * (qint64)p7ImportStats::timingSampleRows();
+            }
+            stats.rowsFiltered++;
+            return eOk;
+        }
+
+        traceData.message = failure ? QString(failure)
+                                    : QString::fromUtf8(traceMessageBuf);
+
+        if (timed) {
+            stats.formattingNs += (_clock.nsecsElapsed() - formatStartNs)
+                    * (qint64)p7ImportStats::timingSampleRows();
         }
 
         /*qDebug() << "TRACE: ******\n"
@@ -648,29 +3112,158 @@ private:
                  << "text:" << traceData.message << "\n";*/
 
 
-        data.addNewTraceData(std::move(traceData));
+        data.addNewTraceData(std::move(traceData),
+                             _channels[data.channelId()].chunkOffset);
 
         return eOk;
     }
 
-    eResult processInfoPacket(sP7Ext_Header * i_pPacket, p7DumpData & data)
+    // Timer value of a row to 100ns intervals since January 1, 1601
+    static uint64_t traceTimestamp(const p7StreamData & data, uint64_t timer)
+    {
+        return timerToTimestamp(data.startTime100Ns(),
+                                data.timerValue(),
+                                data.timerFrequency(),
+                                timer);
+    }
+
+    // Header-only check of a data packet, see p7ImportFilter
+    bool passesFilter(const sP7Trace_Data * trace, p7StreamData & data)
+    {
+        if (trace->bLevel < _filter.minLevel) {
+            return false;
+        }
+
+        if (    (!_filter.threads.empty())
+             && (!std::binary_search(_filter.threads.begin(),
+                                     _filter.threads.end(),
+                                     trace->dwThreadID))
+           )
+        {
+            return false;
+        }
+
+        p7StreamChunks & channel = _channels[data.channelId()];
+
+        if (_filter.hasTimeWindow()) {
+            if (!channel.filterTimersValid) {
+                resolveFilterTimers(channel, data);
+            }
+
+            // timers before the Info packet don't grow with time
+            if (trace->qwTimer < data.timerValue()) {
+                const uint64_t timestamp = traceTimestamp(data, trace->qwTimer);
+                if (    (timestamp < _filter.fromTime)
+                     || (_filter.toTime && timestamp >= _filter.toTime)
+                   )
+                {
+                    return false;
+                }
+            } else if (    (trace->qwTimer < channel.filterFromTimer)
+                        || (trace->qwTimer >= channel.filterToTimer)
+                      )
+            {
+                return false;
+            }
+        }
+
+        if (_filter.modules.empty() && _filter.traceIds.empty()) {
+            return true;
+        }
+
+        if (trace->wID >= channel.filterIds.size()) {
+            channel.filterIds.resize((size_t)trace->wID + 1, -1);
+        }
+
+        int8_t & passes = channel.filterIds[trace->wID];
+        if (passes < 0) {
+            passes = passesIdFilter(trace->wID, data) ? 1 : 0;
+        }
+        return passes;
+    }
+
+    bool passesIdFilter(uint16_t id, const p7StreamData & data) const
+    {
+        if (    (!_filter.traceIds.empty())
+             && (!std::binary_search(_filter.traceIds.begin(),
+                                     _filter.traceIds.end(),
+                                     id))
+           )
+        {
+            return false;
+        }
+
+        if (_filter.modules.empty()) {
+            return true;
+        }
+
+        const p7DescriptionInfo * desc = data.descriptionById(id);
+        if (!desc) {
+            return false;
+        }
+
+        const p7ModuleInfo & module = data.moduleById(desc->moduleId);
+        const QString moduleId = QString::number(desc->moduleId);
+        for (const QString & name : _filter.modules) {
+            if (    (!module.name.isEmpty() && name == module.name)
+                 || (name == moduleId)
+               )
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Time window to timers of the stream: the first timer of rows at or
+    // after fromTime and toTime, found with the same math as rows' time
+    void resolveFilterTimers(p7StreamChunks & channel,
+                             const p7StreamData & data)
+    {
+        auto firstTimerAt = [&data](uint64_t time) {
+            uint64_t low = data.timerValue();
+            uint64_t high = UINT64_MAX;
+            if (traceTimestamp(data, high) < time) {
+                return high;
+            }
+            while (low < high) {
+                const uint64_t middle = low + (high - low) / 2;
+                if (traceTimestamp(data, middle) < time) {
+                    low = middle + 1;
+                } else {
+                    high = middle;
+                }
+            }
+            return low;
+        };
+
+        channel.filterFromTimer = _filter.fromTime
+                ? firstTimerAt(_filter.fromTime)
+                : 0;
+        channel.filterToTimer = _filter.toTime
+                ? firstTimerAt(_filter.toTime)
+                : UINT64_MAX;
+        channel.filterTimersValid = true;
+    }
+
+    eResult processInfoPacket(sP7Ext_Header * i_pPacket, p7StreamData & data)
     {
         //qDebug() << "  -- EP7TRACE_TYPE_INFO";
 
         sP7Trace_Info *l_pInfo = (sP7Trace_Info *)i_pPacket;
 
-        // TODO:
-        //QString streamName = QString::fromUtf16(
-        //            (const char16_t *)l_pInfo->pName);
-
+        data.setName(QString::fromUtf16((const char16_t *)l_pInfo->pName));
+        data.setStartTime100Ns(((uint64_t)l_pInfo->dwTime_Hi << 32)
+                               + (uint64_t)l_pInfo->dwTime_Lo);
         data.setTimerValue(l_pInfo->qwTimer_Value);
         data.setTimerFrequency(l_pInfo->qwTimer_Frequency);
+        data.sequences().restart();
 
         return eOk;
     }
 
     eResult processThreadStartPacket(sP7Ext_Header * i_pPacket,
-                                     p7DumpData &data)
+                                     p7StreamData &data)
     {
         //qDebug() << "  -- EP7TRACE_TYPE_THREAD_START";
 
@@ -681,13 +3274,28 @@ private:
                     (const char *)l_pThStart->pName);
 
         //qDebug() << "  -- " << treadId << threadName;
-        data.addNewThread({treadId, threadName});
+        p7ThreadInfo thread;
+        thread.id = treadId;
+        thread.name = threadName;
+        thread.startTimer = l_pThStart->qwTimer;
+        data.addNewThread(thread);
+        data.importStats().threads++;
+
+        return eOk;
+    }
+
+    eResult processThreadStopPacket(sP7Ext_Header * i_pPacket,
+                                    p7StreamData &data)
+    {
+        sP7Trace_Thread_Stop *l_pThStop = (sP7Trace_Thread_Stop*)i_pPacket;
+
+        data.stopThread(l_pThStop->dwThreadID, l_pThStop->qwTimer);
 
         return eOk;
     }
 
     eResult processModulePacket(sP7Ext_Header * i_pPacket,
-                                p7DumpData &data)
+                                p7StreamData &data)
     {
         //qDebug() << "  -- EP7TRACE_TYPE_MODULE";
 
@@ -700,52 +3308,18 @@ private:
 
         //qDebug() << "  -- " << moduleId << moduleName << verbosity;
         data.addNewModule({moduleId, verbosity, moduleName});
+        data.importStats().modules++;
 
         return eOk;
     }
 
     eResult processDescPacket(sP7Ext_Header * i_pPacket,
-                              p7DumpData &data)
+                              p7StreamData &data)
     {
         //qDebug() << "  -- EP7TRACE_TYPE_DESC";
 
-        sP7Trace_Format *l_pDesc = (sP7Trace_Format*)i_pPacket;
-
-        p7DescriptionInfo * desc = new p7DescriptionInfo();
-
-        desc->id = l_pDesc->wID;
-        desc->line = l_pDesc->wLine;
-        desc->moduleId = l_pDesc->wModuleID;
-        desc->argsLen = l_pDesc->wArgs_Len;
-
-        desc->bufferSize = l_pDesc->sCommon.dwSize;
-        desc->buffer.resize(desc->bufferSize);
-
-        tWCHAR *l_pFormat = nullptr;
-
-        if (desc->buffer.size()) {
-            memcpy(desc->buffer.data(), l_pDesc, desc->bufferSize);
-            desc->m_pArgs
-                    = (sP7Trace_Arg*)(desc->buffer.data() + sizeof(sP7Trace_Format));
-
-            l_pFormat = (tWCHAR *)(desc->m_pArgs + desc->argsLen);
-            size_t l_szLen  = Get_UTF16_Length(l_pFormat) + 1;
-            desc->format.resize(l_szLen * 2);
-            Convert_UTF16_To_UTF8(l_pFormat, desc->format.data(), l_szLen * 2);
-
-            tXCHAR * m_pFile_Path = (char*)(l_pFormat + l_szLen);
-            tXCHAR * m_pFile_Name = nullptr;
-
-            if ((m_pFile_Name = strrchr(m_pFile_Path, '/'))) {
-                m_pFile_Name ++;
-            } else {
-                m_pFile_Name = m_pFile_Path;
-            };
-
-            char * pFunction = (char*)(m_pFile_Path + strlen(m_pFile_Path) + 1);
-            desc->function = QString::fromUtf8(pFunction);
-            desc->filename = QString::fromUtf8(m_pFile_Name);
-        }
+        p7DescriptionInfo * desc
+                = newDescription((const sP7Trace_Format *)i_pPacket, data);
 
         //qDebug() << "  -- " << desc->id
         //         << data.moduleById(desc->moduleId).name
@@ -755,16 +3329,7 @@ private:
         //         << desc->function;
 
         data.addNewDescription(desc);
-
-        if (desc->format.size()) {
-            CFormatter * formatter = new CFormatter(
-                    (const char *)desc->format.data(),
-                    desc->m_pArgs,
-                    (size_t)desc->argsLen,
-                    new CFormatter::sBuffer(8192));
-
-            data.addNewFormatter(formatter, desc->id);
-        }
+        data.importStats().descriptions++;
 
         return eOk;
     }
@@ -776,7 +3341,32 @@ private:
     uint64_t _qwFile_Size = 0;
 
     std::vector<uint8_t> _allDataBuffer;
+    // (buffer offset, file offset) of parts of _allDataBuffer read from
+    // the file, empty for live ingestion
+    std::vector<std::pair<size_t, uint64_t>> _bufferRanges;
+
+    p7StreamChunks _channels[USER_PACKET_CHANNEL_ID_MAX_SIZE];
+
+    p7ImportFilter _filter;
+    std::vector<uint64_t> _keywordHashes; // of _filter.keywords
+    bool _filtering = false;
+    bool _checkSequences = true;
+
+    p7BurstSettings _burstSettings;
+
+    // progress of decoding threads, see progress()
+    std::atomic<uint64_t> _bytesDecoded{0};
+    std::atomic<uint64_t> _bytesToDecode{0};
+    std::atomic<bool> _cancelled{false};
+
+    // importFiles(): importers of files, for progress() and cancel()
+    std::vector<p7DumpImporter *> _fileImporters;
+    mutable std::mutex _fileImportersMutex;
+    bool _mergeStreams = true;
+    bool _mergeInOrder = false;
 
+    // import phase timings, see p7ImportStats
+    QElapsedTimer _clock;
 };
 
 }
@@ -0,0 +1,501 @@
+#include "latency_window.h"
+#include <QtWidgets>
+#include <map>
+
+namespace p7 {
+namespace ui {
+
+namespace {
+
+enum class SpanColumns {
+    Duration = 0,
+    Key,
+    Begin,
+    Thread,
+    Channel,
+    BeginRow,
+    EndRow,
+    Count
+};
+
+enum class ThreadColumns {
+    Thread = 0,
+    Channel,
+    Spans,
+    Total,
+    Mean,
+    Max,
+    Count
+};
+
+// 100ns intervals as ms, numbers sort as numbers
+QVariant milliseconds(uint64_t duration)
+{
+    return qRound64((double)duration / 10.0) / 1000.0;
+}
+
+QTableWidgetItem * spanItem(const QVariant & value)
+{
+    QTableWidgetItem * item = new QTableWidgetItem();
+    item->setData(Qt::DisplayRole, value);
+    item->setFlags(Qt::ItemIsSelectable | Qt::ItemIsEnabled);
+    return item;
+}
+
+}
+
+LatencyHistogram::LatencyHistogram(QWidget *parent)
+    : QWidget(parent)
+{
+    setMinimumHeight(120);
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Preferred);
+    setAutoFillBackground(true);
+    setBackgroundRole(QPalette::Base);
+    setMouseTracking(true);
+}
+
+void LatencyHistogram::setReport(const p7::p7LatencyReport * report)
+{
+    _report = report;
+    _selectedBin = -1;
+    update();
+}
+
+int LatencyHistogram::selectedBin() const
+{
+    return _selectedBin;
+}
+
+QRect LatencyHistogram::plotRect() const
+{
+    const int bottomMargin = fontMetrics().height() + 4;
+    return rect().adjusted(4, 4, -4, -bottomMargin);
+}
+
+void LatencyHistogram::binsRange(int & first, int & end) const
+{
+    first = 0;
+    end = 0;
+    if (!_report) {
+        return;
+    }
+
+    const std::vector<uint64_t> & histogram = _report->histogram;
+    end = (int)histogram.size();
+    while (first < end && !histogram[(size_t)first]) {
+        ++first;
+    }
+}
+
+int LatencyHistogram::binAt(int x) const
+{
+    int first = 0;
+    int end = 0;
+    binsRange(first, end);
+
+    const QRect plot = plotRect();
+    if (first == end || x < plot.left() || x > plot.right()) {
+        return -1;
+    }
+    return qMin(first + (x - plot.left()) * (end - first) / plot.width(),
+                end - 1);
+}
+
+void LatencyHistogram::paintEvent(QPaintEvent *event)
+{
+    QWidget::paintEvent(event);
+
+    int first = 0;
+    int end = 0;
+    binsRange(first, end);
+    const QRect plot = plotRect();
+    if (first == end || plot.width() < 2) {
+        return;
+    }
+
+    uint64_t maxSpans = 0;
+    for (int bin = first; bin < end; ++bin) {
+        maxSpans = qMax(maxSpans, _report->histogram[(size_t)bin]);
+    }
+
+    QPainter painter(this);
+    const double width = (double)plot.width() / (end - first);
+    for (int bin = first; bin < end; ++bin) {
+        const uint64_t spans = _report->histogram[(size_t)bin];
+        if (!spans) {
+            continue;
+        }
+        // a single span is still visible
+        const double height = qMax((double)spans * plot.height()
+                                       / (double)maxSpans,
+                                   2.0);
+        painter.fillRect(QRectF(plot.left() + width * (bin - first) + 1,
+                                plot.bottom() + 1 - height,
+                                qMax(width - 2.0, 1.0), height),
+                         palette().color(bin == _selectedBin
+                                         ? QPalette::Link
+                                         : QPalette::Highlight));
+    }
+
+    painter.setPen(palette().color(QPalette::Mid));
+    painter.drawLine(plot.bottomLeft(), plot.bottomRight());
+
+    // labels
+    painter.setPen(palette().color(QPalette::Text));
+    const QRect labels(plot.left(), plot.bottom() + 2,
+                       plot.width(), fontMetrics().height());
+    const uint64_t from = first ? p7::p7LatencyReport::histogramBinEnd(
+                                      (size_t)first - 1)
+                                : 0;
+    painter.drawText(labels, Qt::AlignLeft, p7::latencyAsString(from));
+    const uint64_t to = p7::p7LatencyReport::histogramBinEnd((size_t)end - 1);
+    painter.drawText(labels, Qt::AlignRight, p7::latencyAsString(to));
+    painter.drawText(labels, Qt::AlignHCenter,
+                     tr("max %1 spans per bin").arg(maxSpans));
+}
+
+void LatencyHistogram::mouseMoveEvent(QMouseEvent *event)
+{
+    const int bin = binAt(event->x());
+    if (bin < 0) {
+        QToolTip::hideText();
+        return;
+    }
+
+    const uint64_t from = bin ? p7::p7LatencyReport::histogramBinEnd(
+                                    (size_t)bin - 1)
+                              : 0;
+    QToolTip::showText(event->globalPos(),
+                       tr("%1 - %2: %3 spans")
+                       .arg(p7::latencyAsString(from))
+                       .arg(p7::latencyAsString(
+                                p7::p7LatencyReport::histogramBinEnd(
+                                    (size_t)bin)))
+                       .arg(_report->histogram[(size_t)bin]),
+                       this);
+}
+
+void LatencyHistogram::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton) {
+        return;
+    }
+
+    // a click on the selected bin shows all spans again
+    const int bin = binAt(event->x());
+    _selectedBin = bin == _selectedBin ? -1 : bin;
+    update();
+    emit binSelected(_selectedBin);
+}
+
+LatencyWindow::LatencyWindow(p7::P7DumpModel * model,
+                             QWidget *parent)
+    : QDialog(parent)
+    , _model(model)
+{
+    setWindowTitle(tr("Latency"));
+    resize(QSize(1200, 800));
+
+    _beginSelector = new QComboBox();
+    _endSelector = new QComboBox();
+    for (QComboBox * selector : { _beginSelector, _endSelector }) {
+        selector->setSizeAdjustPolicy(
+                    QComboBox::AdjustToMinimumContentsLengthWithIcon);
+        selector->setMinimumContentsLength(40);
+    }
+
+    _keySelector = new QSpinBox();
+    _keySelector->setRange(0, 32);
+    _keySelector->setSpecialValueText(tr("none"));
+    _keySelector->setToolTip(tr("Argument of both formats (from 1) which"
+                                " pairs a begin with its end"));
+
+    _sameThreadCheckBox = new QCheckBox(tr("Same thread"));
+    _sameThreadCheckBox->setChecked(true);
+
+    _analyzeButton = new QPushButton(tr("Analyze"));
+    connect(_analyzeButton, &QAbstractButton::clicked,
+            this, &LatencyWindow::onAnalyzeClicked);
+
+    QGridLayout * settingsLayout = new QGridLayout();
+    settingsLayout->addWidget(new QLabel(tr("Begin:")), 0, 0);
+    settingsLayout->addWidget(_beginSelector, 0, 1);
+    settingsLayout->addWidget(new QLabel(tr("Key argument:")), 0, 2);
+    settingsLayout->addWidget(_keySelector, 0, 3);
+    settingsLayout->addWidget(new QLabel(tr("End:")), 1, 0);
+    settingsLayout->addWidget(_endSelector, 1, 1);
+    settingsLayout->addWidget(_sameThreadCheckBox, 1, 2, 1, 2);
+    settingsLayout->addWidget(_analyzeButton, 0, 4, 2, 1);
+    settingsLayout->setColumnStretch(1, 1);
+
+    _summaryValue = new QLabel();
+    _summaryValue->setTextInteractionFlags(Qt::TextSelectableByMouse);
+
+    _histogram = new LatencyHistogram();
+    connect(_histogram, &LatencyHistogram::binSelected,
+            this, &LatencyWindow::onBinSelected);
+
+    _spansValue = new QLabel();
+
+    _spansTable = new QTableWidget(0, static_cast<int>(SpanColumns::Count));
+    _spansTable->setHorizontalHeaderLabels({
+        tr("Duration, ms"), tr("Key"), tr("Begin"), tr("Thread"),
+        tr("Channel"), tr("Begin row"), tr("End row")
+    });
+    _spansTable->verticalHeader()->hide();
+    _spansTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    _spansTable->horizontalHeader()->setStretchLastSection(true);
+    connect(_spansTable, &QTableWidget::cellDoubleClicked,
+            this, &LatencyWindow::onSpanDoubleClicked);
+
+    _threadsTable = new QTableWidget(0,
+                                     static_cast<int>(ThreadColumns::Count));
+    _threadsTable->setHorizontalHeaderLabels({
+        tr("Thread"), tr("Channel"), tr("Spans"), tr("Total, ms"),
+        tr("Mean, ms"), tr("Max, ms")
+    });
+    _threadsTable->verticalHeader()->hide();
+    _threadsTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    _threadsTable->horizontalHeader()->setStretchLastSection(true);
+
+    QVBoxLayout * spansLayout = new QVBoxLayout();
+    spansLayout->setContentsMargins(0, 0, 0, 0);
+    spansLayout->addWidget(_spansValue);
+    spansLayout->addWidget(_spansTable, 1);
+
+    QWidget * spansWidget = new QWidget();
+    spansWidget->setLayout(spansLayout);
+
+    QTabWidget * tabs = new QTabWidget();
+    tabs->addTab(spansWidget, tr("Spans"));
+    tabs->addTab(_threadsTable, tr("Threads"));
+
+    QSplitter * splitter = new QSplitter(Qt::Vertical);
+    splitter->addWidget(_histogram);
+    splitter->addWidget(tabs);
+    splitter->setStretchFactor(1, 1);
+
+    QVBoxLayout * mainLayout = new QVBoxLayout();
+    mainLayout->addLayout(settingsLayout);
+    mainLayout->addWidget(_summaryValue);
+    mainLayout->addWidget(splitter, 1);
+    setLayout(mainLayout);
+
+    // spans refer to rows of the dump, drop them before it is replaced
+    connect(_model, &QAbstractItemModel::modelAboutToBeReset,
+            this, &LatencyWindow::onModelAboutToBeReset);
+    connect(_model, &QAbstractItemModel::modelReset,
+            this, &LatencyWindow::showModelData);
+
+    showModelData();
+}
+
+void LatencyWindow::showModelData()
+{
+    const p7::p7DumpData & data = _model->dumpData();
+
+    // trace IDs with rows, the format of the first stream which has it
+    std::map<uint16_t, QString> formats;
+    for (size_t i = 0; i < data.streamsCount(); ++i) {
+        const p7::p7StreamData & stream = data.stream(i);
+        const std::vector<p7::p7TraceIdStats> & ids = stream.traceIdStats();
+        for (size_t id = 0; id < ids.size(); ++id) {
+            const p7::p7DescriptionInfo * desc
+                    = stream.descriptionById((uint16_t)id);
+            if (ids[id].rows && desc && !formats.count((uint16_t)id)) {
+                formats[(uint16_t)id] = QString::fromUtf8(desc->format);
+            }
+        }
+    }
+
+    for (QComboBox * selector : { _beginSelector, _endSelector }) {
+        const QVariant current = selector->currentData();
+        selector->clear();
+        for (const auto & it : formats) {
+            selector->addItem(QString("%1: %2").arg(it.first).arg(it.second),
+                              (uint)it.first);
+        }
+        const int index = selector->findData(current);
+        if (index >= 0) {
+            selector->setCurrentIndex(index);
+        }
+    }
+    _analyzeButton->setEnabled(formats.size() > 1);
+
+    showReport();
+}
+
+void LatencyWindow::onAnalyzeClicked()
+{
+    p7::p7LatencySettings settings;
+    settings.beginId = (uint16_t)_beginSelector->currentData().toUInt();
+    settings.endId = (uint16_t)_endSelector->currentData().toUInt();
+    settings.keyArgument = (size_t)_keySelector->value();
+    settings.sameThread = _sameThreadCheckBox->isChecked();
+
+    if (settings.beginId == settings.endId) {
+        QMessageBox::warning(this, windowTitle(),
+                             tr("Begin and end trace IDs must differ"));
+        return;
+    }
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    _report = p7::p7LatencyReport::analyze(_model->dumpData(), settings);
+    QApplication::restoreOverrideCursor();
+
+    showReport();
+}
+
+void LatencyWindow::showReport()
+{
+    _histogram->setReport(_report.spans.empty() ? nullptr : &_report);
+
+    QString summary = tr("%1 spans, %2 begins without end,"
+                         " %3 ends without begin")
+            .arg(_report.spans.size())
+            .arg(_report.unmatchedBegins)
+            .arg(_report.unmatchedEnds);
+    if (_report.noKey) {
+        summary += tr(", %1 rows without the key argument")
+                .arg(_report.noKey);
+    }
+    if (!_report.percentiles.empty()) {
+        QStringList percentiles;
+        for (const p7::p7LatencyReport::Percentile & percentile
+                : _report.percentiles) {
+            const QString rank = percentile.rank == 0.0
+                    ? tr("min")
+                    : (percentile.rank == 1.0
+                        ? tr("max")
+                        : QString("p%1").arg(percentile.rank * 100.0));
+            percentiles << rank + " "
+                           + p7::latencyAsString(percentile.duration);
+        }
+        summary += "\n" + percentiles.join(", ");
+    }
+    _summaryValue->setText(summary);
+
+    const p7::p7DumpData & data = _model->dumpData();
+    QSignalBlocker blocker(_threadsTable);
+    _threadsTable->setSortingEnabled(false);
+    _threadsTable->clearContents();
+    _threadsTable->setRowCount((int)_report.threads.size());
+    for (size_t i = 0; i < _report.threads.size(); ++i) {
+        const p7::p7LatencyReport::Thread & thread = _report.threads[i];
+        const p7::p7StreamData & stream = data.stream(thread.stream);
+        const QString name = stream.threadById(thread.threadId).name;
+        const QString id = "0x" + QString::number(thread.threadId, 16);
+
+        auto set = [this, i](ThreadColumns column, const QVariant & value) {
+            _threadsTable->setItem((int)i, static_cast<int>(column),
+                                   spanItem(value));
+        };
+        set(ThreadColumns::Thread, name.isEmpty() ? id
+                                                  : name + "(" + id + ")");
+        set(ThreadColumns::Channel, _model->streamName((int)thread.stream));
+        set(ThreadColumns::Spans, (qulonglong)thread.spans);
+        set(ThreadColumns::Total, milliseconds(thread.totalTime));
+        set(ThreadColumns::Mean, milliseconds(thread.totalTime
+                                              / qMax(thread.spans,
+                                                     (uint64_t)1)));
+        set(ThreadColumns::Max, milliseconds(thread.maxTime));
+    }
+    _threadsTable->setSortingEnabled(true);
+    _threadsTable->resizeColumnsToContents();
+
+    showSpans(-1);
+}
+
+void LatencyWindow::showSpans(int bin)
+{
+    std::vector<size_t> spans;
+    if (bin < 0) {
+        spans = _report.slowest;
+        _spansValue->setText(tr("The slowest %1 spans, double click shows"
+                                " the begin row (the end row in its column)")
+                             .arg(spans.size()));
+    } else {
+        for (size_t i = 0; i < _report.spans.size(); ++i) {
+            if ((int)p7::p7LatencyReport::histogramBin(
+                    _report.spans[i].duration) == bin) {
+                spans.push_back(i);
+            }
+        }
+
+        // the longest ones of the bin
+        const size_t shown = qMin(spans.size(), _report.settings.slowestCount);
+        std::partial_sort(spans.begin(), spans.begin() + (ptrdiff_t)shown,
+                          spans.end(), [this](size_t left, size_t right) {
+            return _report.spans[left].duration
+                    > _report.spans[right].duration;
+        });
+        spans.resize(shown);
+        _spansValue->setText(tr("%1 spans of the bin, %2 shown")
+                             .arg(_report.histogram[(size_t)bin])
+                             .arg(spans.size()));
+    }
+
+    const p7::p7DumpData & data = _model->dumpData();
+    QSignalBlocker blocker(_spansTable);
+    _spansTable->setSortingEnabled(false);
+    _spansTable->clearContents();
+    _spansTable->setRowCount((int)spans.size());
+    for (size_t i = 0; i < spans.size(); ++i) {
+        const p7::p7LatencySpan & span = _report.spans[spans[i]];
+        const p7::p7StreamData & stream = data.stream(span.stream);
+        const QString name = stream.threadById(span.threadId).name;
+        const QString id = "0x" + QString::number(span.threadId, 16);
+
+        auto set = [this, i](SpanColumns column, const QVariant & value) {
+            _spansTable->setItem((int)i, static_cast<int>(column),
+                                 spanItem(value));
+        };
+        set(SpanColumns::Duration, milliseconds(span.duration));
+        _spansTable->item((int)i, static_cast<int>(SpanColumns::Duration))
+                ->setData(Qt::UserRole, (qulonglong)spans[i]);
+        set(SpanColumns::Key, _report.keyText(data, span));
+        set(SpanColumns::Begin, p7::unpackDateTime(span.beginTime)
+                                    .toString("yyyy-MM-dd HH:mm:ss.zzz"));
+        set(SpanColumns::Thread, name.isEmpty() ? id
+                                                : name + "(" + id + ")");
+        set(SpanColumns::Channel, _model->streamName((int)span.stream));
+        set(SpanColumns::BeginRow, (qulonglong)span.beginNumber);
+        set(SpanColumns::EndRow, (qulonglong)span.endNumber);
+    }
+    _spansTable->setSortingEnabled(true);
+    _spansTable->resizeColumnsToContents();
+}
+
+void LatencyWindow::onBinSelected(int bin)
+{
+    showSpans(bin);
+}
+
+void LatencyWindow::onSpanDoubleClicked(int row, int column)
+{
+    const QTableWidgetItem * item = _spansTable->item(
+                row, static_cast<int>(SpanColumns::Duration));
+    if (!item) {
+        return;
+    }
+
+    const size_t index = (size_t)item->data(Qt::UserRole).toULongLong();
+    if (index >= _report.spans.size()) {
+        return;
+    }
+
+    const p7::p7LatencySpan & span = _report.spans[index];
+    emit rowActivated(span.stream,
+                      column == static_cast<int>(SpanColumns::EndRow)
+                        ? span.endNumber
+                        : span.beginNumber);
+}
+
+void LatencyWindow::onModelAboutToBeReset()
+{
+    _histogram->setReport(nullptr);
+    _report = p7::p7LatencyReport();
+}
+
+} // namespace ui
+} // namespace p7
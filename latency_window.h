@@ -0,0 +1,101 @@
+#ifndef UI_LATENCYWINDOW_H
+#define UI_LATENCYWINDOW_H
+
+#include <QCheckBox>
+#include <QComboBox>
+#include <QDialog>
+#include <QLabel>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QTableWidget>
+#include <QWidget>
+#include "p7d_model.h"
+#include "p7d_latency.h"
+
+namespace p7 {
+namespace ui {
+
+// Bars of spans per duration bin of a report (powers of two), a click
+// selects a bin
+class LatencyHistogram : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit LatencyHistogram(QWidget *parent = nullptr);
+
+    // the report is owned by the caller, nullptr to clear
+    void setReport(const p7::p7LatencyReport * report);
+
+    // -1 if none
+    int selectedBin() const;
+
+    Q_SIGNAL void binSelected(int bin);
+
+protected:
+
+    virtual void paintEvent(QPaintEvent *event) override;
+    virtual void mouseMoveEvent(QMouseEvent *event) override;
+    virtual void mousePressEvent(QMouseEvent *event) override;
+
+private:
+
+    QRect plotRect() const;
+    // bins from the first to the last one with spans
+    void binsRange(int & first, int & end) const;
+    int binAt(int x) const;
+
+    const p7::p7LatencyReport * _report = nullptr;
+    int _selectedBin = -1;
+};
+
+// Durations between rows of a begin and an end trace ID (say "start
+// request id=%d" and "end request id=%d") paired by a key argument and
+// thread, see p7LatencyReport: percentiles, a histogram, the slowest
+// spans and time per thread. Double click on a span shows its begin row
+// in the main table, or its end row in the End column.
+class LatencyWindow : public QDialog
+{
+    Q_OBJECT
+
+public:
+    LatencyWindow(p7::P7DumpModel * model,
+                  QWidget *parent = nullptr);
+
+    void showModelData();
+
+    // a row of a span is activated: its stream and number
+    Q_SIGNAL void rowActivated(size_t stream, quint64 number);
+
+private:
+
+    Q_SLOT void onAnalyzeClicked();
+    Q_SLOT void onBinSelected(int bin);
+    Q_SLOT void onSpanDoubleClicked(int row, int column);
+    Q_SLOT void onModelAboutToBeReset();
+
+    void showReport();
+    // the slowest spans of a bin, of all if bin is -1
+    void showSpans(int bin);
+
+    QComboBox * _beginSelector;
+    QComboBox * _endSelector;
+    QSpinBox * _keySelector;
+    QCheckBox * _sameThreadCheckBox;
+    QPushButton * _analyzeButton;
+
+    QLabel * _summaryValue;
+    LatencyHistogram * _histogram;
+    QLabel * _spansValue;
+    QTableWidget * _spansTable;
+    QTableWidget * _threadsTable;
+
+    p7::p7LatencyReport _report;
+
+    p7::P7DumpModel * _model;
+};
+
+} // namespace ui
+} // namespace p7
+
+#endif // UI_LATENCYWINDOW_H
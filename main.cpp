@@ -20,13 +20,152 @@
 
 
 #include <QApplication>
+#include <QCommandLineParser>
+#include <iostream>
 #include "main_window.h"
+#include "p7d_summary.h"
+#include "p7d_latency.h"
 
 #ifdef Q_OS_WIN
     #include <Windows.h> // SetProcessDPIAware()
 #endif // Q_OS_WIN
 
 
+// Import filter options, prints the wrong value and returns false
+static bool parseImportFilter(const QCommandLineParser & parser,
+                              p7::p7ImportFilter & filter)
+{
+    auto fail = [](const QString & value) {
+        std::cerr << "Invalid value: " << value.toStdString() << std::endl;
+        return false;
+    };
+
+    const QString level = parser.value("min-level");
+    if (!level.isEmpty()) {
+        int found = EP7TRACE_LEVEL_COUNT;
+        for (int i = 0; i < EP7TRACE_LEVEL_COUNT; ++i) {
+            if (!level.compare(p7::traceLevelAsString((eP7Trace_Level)i),
+                               Qt::CaseInsensitive)) {
+                found = i;
+            }
+        }
+        if (found == EP7TRACE_LEVEL_COUNT) {
+            return fail(level);
+        }
+        filter.minLevel = (eP7Trace_Level)found;
+    }
+
+    for (const QString & module : parser.value("modules")
+                                      .split(',', Qt::SkipEmptyParts)) {
+        filter.modules.push_back(module.trimmed());
+    }
+
+    // ids are decimal or 0x hex
+    for (const QString & thread : parser.value("threads")
+                                      .split(',', Qt::SkipEmptyParts)) {
+        bool ok = false;
+        filter.threads.push_back(thread.trimmed().toUInt(&ok, 0));
+        if (!ok) {
+            return fail(thread);
+        }
+    }
+
+    for (const QString & id : parser.value("ids")
+                                  .split(',', Qt::SkipEmptyParts)) {
+        bool ok = false;
+        filter.traceIds.push_back(id.trimmed().toUShort(&ok, 0));
+        if (!ok) {
+            return fail(id);
+        }
+    }
+
+    for (const QString & word : parser.value("grep")
+                                    .split(' ', Qt::SkipEmptyParts)) {
+        filter.keywords.push_back(word);
+    }
+
+    // local time, like the Time column
+    auto time = [](const QString & value) {
+        QDateTime dateTime = QDateTime::fromString(value,
+                                                   "yyyy-MM-dd HH:mm:ss.zzz");
+        if (!dateTime.isValid()) {
+            dateTime = QDateTime::fromString(value, "yyyy-MM-dd HH:mm:ss");
+        }
+        return p7::packDateTime(dateTime);
+    };
+
+    if (parser.isSet("from")) {
+        filter.fromTime = time(parser.value("from"));
+        if (!filter.fromTime) {
+            return fail(parser.value("from"));
+        }
+    }
+    if (parser.isSet("to")) {
+        filter.toTime = time(parser.value("to"));
+        if (!filter.toTime) {
+            return fail(parser.value("to"));
+        }
+    }
+
+    return true;
+}
+
+// --build-catalog and --query, returns the exit code
+static int runCatalog(const QCommandLineParser & parser,
+                      const QStringList & files,
+                      const p7::p7ImportFilter & filter)
+{
+    const QString catalogName = parser.value("catalog");
+    p7::p7DumpCatalog catalog;
+    const bool loaded = catalog.load(catalogName);
+
+    if (parser.isSet("build-catalog")) {
+        const size_t scanned = catalog.update(files,
+                                              parser.isSet("keywords"));
+        if (!catalog.save(catalogName)) {
+            std::cerr << "Unable to write " << catalogName.toStdString()
+                      << std::endl;
+            return 1;
+        }
+        std::cout << "Scanned " << scanned << " files, "
+                  << catalog.entries().size() << " dumps in the catalog"
+                  << std::endl;
+        return 0;
+    }
+
+    if (!loaded) {
+        std::cerr << "Unable to read " << catalogName.toStdString()
+                  << std::endl;
+        return 1;
+    }
+
+    p7::p7CatalogQuery query;
+    query.hostName = parser.value("host");
+    query.processName = parser.value("process");
+    query.fromTime = filter.fromTime;
+    query.toTime = filter.toTime;
+    query.minLevel = filter.minLevel;
+
+    auto timeText = [](uint64_t time) {
+        return p7::unpackDateTime(time)
+                .toString("yyyy-MM-dd HH:mm:ss.zzz").toStdString();
+    };
+
+    for (const p7::p7CatalogEntry * entry : catalog.query(query)) {
+        std::cout << entry->fileName.toStdString() << '\t'
+                  << entry->hostName.toStdString() << '\t'
+                  << entry->processName.toStdString() << '\t'
+                  << entry->processId << '\t'
+                  << timeText(entry->fromTime) << '\t'
+                  << timeText(entry->toTime) << '\t'
+                  << entry->rows << '\t'
+                  << entry->rowsAtOrAbove(EP7TRACE_LEVEL_ERROR) << std::endl;
+    }
+
+    return 0;
+}
+
+
 int main(int argc, char *argv[])
 {
 
@@ -43,8 +182,271 @@ int main(int argc, char *argv[])
     QCoreApplication::setOrganizationName("p7dviewer");
     QCoreApplication::setApplicationName("p7dviewer");
 
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addPositionalArgument("files",
+        "P7 dumps (*.p7d) or directories of them to open, several dumps"
+        " are merged by time.");
+    QCommandLineOption statsOption("stats",
+        "Print import statistics of the file and exit.");
+    parser.addOption(statsOption);
+    QCommandLineOption summaryOption("summary",
+        "Print rows per level, module, thread and trace ID and the time"
+        " span of the files from packet headers only and exit.");
+    parser.addOption(summaryOption);
+    QCommandLineOption printOption("print",
+        "Print imported rows (time, level, module, text) and exit.");
+    parser.addOption(printOption);
+    QCommandLineOption burstsOption("bursts",
+        "Print bursts of the log rate of imported rows and exit.");
+    parser.addOption(burstsOption);
+    QCommandLineOption gapsOption("gaps",
+        "Print gaps, duplicates and reorderings of sequence numbers of"
+        " traces per channel and exit.");
+    parser.addOption(gapsOption);
+    QCommandLineOption burstMultipleOption("burst-multiple",
+        "A burst is a 100ms window with N times the usual rows"
+        " (default 5).", "N");
+    parser.addOption(burstMultipleOption);
+    QCommandLineOption latencyOption("latency",
+        "Print durations between rows of trace IDs BEGIN and END with the"
+        " same value of argument ARG (from 1, optional) on one thread and"
+        " exit.", "BEGIN,END[,ARG]");
+    parser.addOption(latencyOption);
+    QCommandLineOption maxRowsOption("max-rows",
+        "Follow/listen: keep at most N newest rows.", "N");
+    parser.addOption(maxRowsOption);
+    QCommandLineOption maxMemoryOption("max-mb",
+        "Follow/listen: keep rows within N MB.", "N");
+    parser.addOption(maxMemoryOption);
+    parser.addOption(QCommandLineOption("min-level",
+        "Import rows of this level and above (Trace ... Critical).",
+        "level"));
+    parser.addOption(QCommandLineOption("modules",
+        "Import rows of these modules only (names or ids).", "a,b"));
+    parser.addOption(QCommandLineOption("threads",
+        "Import rows of these thread ids only.", "a,b"));
+    parser.addOption(QCommandLineOption("ids",
+        "Import rows of these trace IDs only.", "a,b"));
+    parser.addOption(QCommandLineOption("from",
+        "Import rows from this time (yyyy-MM-dd HH:mm:ss.zzz).", "time"));
+    parser.addOption(QCommandLineOption("to",
+        "Import rows before this time.", "time"));
+    parser.addOption(QCommandLineOption("grep",
+        "Import rows whose text has all these whole words (ASCII letters"
+        " case-insensitive).", "words"));
+    parser.addOption(QCommandLineOption("catalog",
+        "Dump catalog file: --from/--to and --grep import only blocks of"
+        " cataloged files which may have such rows.", "file"));
+    parser.addOption(QCommandLineOption("build-catalog",
+        "Add the files (or changed ones) to the --catalog and exit."));
+    parser.addOption(QCommandLineOption("keywords",
+        "--build-catalog: also index words of every block for --grep"
+        " (decodes the files)."));
+    parser.addOption(QCommandLineOption("query",
+        "Print dumps of the --catalog with rows in --from/--to of"
+        " --min-level or above and exit."));
+    parser.addOption(QCommandLineOption("host",
+        "--query: dumps of this host only.", "name"));
+    parser.addOption(QCommandLineOption("process",
+        "--query: dumps of this process only.", "name"));
+    parser.process(a);
+
+    p7::p7ImportFilter filter;
+    if (!parseImportFilter(parser, filter)) {
+        return 1;
+    }
+
+    p7::p7BurstSettings burstSettings;
+    if (parser.isSet(burstMultipleOption)) {
+        bool ok = false;
+        burstSettings.multiple = parser.value(burstMultipleOption)
+                                     .toDouble(&ok);
+        if (!ok || burstSettings.multiple <= 1.0) {
+            std::cerr << "Invalid value: "
+                      << parser.value(burstMultipleOption).toStdString()
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    p7::p7LatencySettings latencySettings;
+    if (parser.isSet(latencyOption)) {
+        const QStringList values = parser.value(latencyOption).split(',');
+        bool ok = values.size() == 2 || values.size() == 3;
+        for (int i = 0; ok && i < values.size(); ++i) {
+            const uint value = values[i].trimmed().toUInt(&ok);
+            ok = ok && value <= UINT16_MAX;
+            if (i == 0) {
+                latencySettings.beginId = (uint16_t)value;
+            } else if (i == 1) {
+                latencySettings.endId = (uint16_t)value;
+            } else {
+                latencySettings.keyArgument = value;
+            }
+        }
+        if (!ok || latencySettings.beginId == latencySettings.endId) {
+            std::cerr << "Invalid value: "
+                      << parser.value(latencyOption).toStdString()
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    const QStringList files
+            = p7::ui::MainWindow::dumpFiles(parser.positionalArguments());
+
+    if (parser.isSet("build-catalog") || parser.isSet("query")) {
+        if (!parser.isSet("catalog")) {
+            std::cerr << "No --catalog given" << std::endl;
+            return 1;
+        }
+        return runCatalog(parser, files, filter);
+    }
+
+    if (parser.isSet(summaryOption)) {
+        if (files.isEmpty()) {
+            std::cerr << "No file to import" << std::endl;
+            return 1;
+        }
+
+        std::vector<std::string> fileNames;
+        for (const QString & file : files) {
+            fileNames.push_back(file.toStdString());
+        }
+
+        const p7::p7DumpSummary summary
+                = p7::p7DumpSummary::scanFiles(fileNames);
+        if (!summary.files) {
+            std::cerr << "Unable to read the files" << std::endl;
+            return 1;
+        }
+        std::cout << p7::summaryAsString(summary).toStdString();
+        return 0;
+    }
+
+    std::shared_ptr<p7::p7DumpCatalog> catalog;
+    if (parser.isSet("catalog")) {
+        catalog = std::make_shared<p7::p7DumpCatalog>();
+        if (!catalog->load(parser.value("catalog"))) {
+            std::cerr << "Unable to read " << parser.value("catalog")
+                         .toStdString() << std::endl;
+            return 1;
+        }
+    }
+
+    if (    (parser.isSet(statsOption))
+         || (parser.isSet(printOption))
+         || (parser.isSet(burstsOption))
+         || (parser.isSet(gapsOption))
+         || (parser.isSet(latencyOption))
+       )
+    {
+        if (files.isEmpty()) {
+            std::cerr << "No file to import" << std::endl;
+            return 1;
+        }
+
+        std::vector<std::string> fileNames;
+        for (const QString & file : files) {
+            fileNames.push_back(file.toStdString());
+        }
+
+        // a cataloged file is read partially for a time window or words
+        const p7::p7CatalogEntry * entry
+                = (catalog && filter.skipsBlocks() && files.size() == 1)
+                    ? catalog->find(files.first())
+                    : nullptr;
+
+        p7::p7DumpImporter importer;
+        importer.setFilter(filter);
+        importer.setBurstSettings(burstSettings);
+        p7::p7DumpData data = entry
+                ? importer.importTimeRange(fileNames.front(),
+                                           catalog->timeIndexes(*entry),
+                                           filter.fromTime,
+                                           filter.toTime)
+                : (fileNames.size() == 1
+                    ? importer.import(fileNames.front())
+                    : importer.importFiles(fileNames));
+
+        if (parser.isSet(printOption)) {
+            for (size_t i = 0; i < data.traceDataCount(); ++i) {
+                const p7::p7TraceDataInfo & row = data.traceDataAt(i);
+                std::cout << row.time.toString("yyyy-MM-dd HH:mm:ss.zzz")
+                                     .toStdString() << '\t'
+                          << p7::traceLevelAsString(row.verbosity)
+                                     .toStdString() << '\t'
+                          << row.moduleName.toStdString() << '\t'
+                          << row.message.toStdString() << '\n';
+            }
+        }
+        if (parser.isSet(burstsOption)) {
+            auto timeText = [](uint64_t time) {
+                return p7::unpackDateTime(time)
+                        .toString("yyyy-MM-dd HH:mm:ss.zzz").toStdString();
+            };
+            const double window = (double)burstSettings.window / 1e7;
+            for (size_t i = 0; i < data.streamsCount(); ++i) {
+                const p7::p7StreamData & stream = data.stream(i);
+                for (const p7::p7Burst & burst : stream.bursts().bursts()) {
+                    std::cout << timeText(burst.fromTime) << '\t'
+                              << timeText(burst.toTime) << '\t'
+                              << burst.rows << '\t'
+                              << (uint64_t)(burst.peakRows / window) << '\t'
+                              << (uint64_t)(burst.baseline / window) << '\t'
+                              << stream.name().toStdString() << '\n';
+                }
+            }
+        }
+        if (parser.isSet(gapsOption)) {
+            static const char * const kinds[] = {
+                "gap", "duplicate", "reordered", "restart"
+            };
+            std::cout << p7::sequenceChecksAsString(data).toStdString();
+            for (size_t i = 0; i < data.streamsCount(); ++i) {
+                const p7::p7StreamData & stream = data.stream(i);
+                for (const p7::p7SequenceEvent & event
+                         : stream.sequences().events())
+                {
+                    std::cout << kinds[event.kind] << '\t'
+                              << event.row + 1 << '\t'
+                              << event.sequence << '\t'
+                              << (event.kind == p7::p7SequenceEvent::Gap
+                                      ? event.missing()
+                                      : event.count) << '\t'
+                              << stream.name().toStdString() << '\n';
+                }
+            }
+        }
+        if (parser.isSet(latencyOption)) {
+            const p7::p7LatencyReport report
+                    = p7::p7LatencyReport::analyze(data, latencySettings);
+            std::cout << p7::latencyReportAsString(data, report)
+                         .toStdString();
+        }
+        if (parser.isSet(statsOption)) {
+            std::cout << p7::importStatsAsString(data.importStats())
+                         .toStdString();
+        }
+        return 0;
+    }
+
+    p7::p7RetentionBudget retention;
+    retention.maxRows = parser.value(maxRowsOption).toULongLong();
+    retention.maxBytes
+            = (size_t)parser.value(maxMemoryOption).toULongLong() * 1024 * 1024;
+
     p7::ui::MainWindow mainWindow;
+    mainWindow.setRetention(retention);
+    mainWindow.setImportFilter(filter);
+    mainWindow.setBurstSettings(burstSettings);
+    mainWindow.setCatalog(catalog);
     mainWindow.showMaximized();
 
+    if (!files.isEmpty()) {
+        mainWindow.importP7Dump(files);
+    }
+
     return a.exec();
 }
@@ -1,4 +1,9 @@
 #include "main_window.h"
+#include "telemetry_window.h"
+#include "trace_ids_window.h"
+#include "thread_lanes_window.h"
+#include "latency_window.h"
+#include "rate_timeline.h"
 #include <QtWidgets>
 
 namespace p7 {
@@ -6,36 +11,114 @@ namespace ui {
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
+    , _follower(&_model)
+    , _receiver(&_model)
 {
     setMinimumSize(QSize(700, 400));
     setWindowTitle("P7D Viewer");
 
-    _centralWidget = new CentralWidget(&_model);
+    _centralWidget = new CentralWidget(&_model, &_follower, &_receiver);
     setCentralWidget(_centralWidget);
 }
 
 void MainWindow::importP7Dump(const QString & filename)
 {
-    p7::p7DumpImporter importer;
-    p7::p7DumpData data = importer.import(filename.toStdString());
+    _receiver.stop();
 
-    _model.setDumpData(std::move(data));
-    _centralWidget->showModelData();
+    // decoded in batches, see CentralWidget::onLoadingProgress();
+    // the follower keeps the importer to continue from the end of the file
+    _follower.open(filename);
+}
+
+void MainWindow::importP7Dump(const QStringList & paths)
+{
+    const QStringList files = dumpFiles(paths);
+    if (files.isEmpty()) {
+        return;
+    }
+
+    _receiver.stop();
+    _follower.open(files);
+}
+
+QStringList MainWindow::dumpFiles(const QStringList & paths)
+{
+    QStringList files;
+    for (const QString & path : paths) {
+        const QFileInfo info(path);
+        if (!info.isDir()) {
+            files.append(path);
+            continue;
+        }
+
+        const QDir dir(path);
+        for (const QString & name : dir.entryList(QStringList("*.p7d"),
+                                                  QDir::Files,
+                                                  QDir::Name)) {
+            files.append(dir.filePath(name));
+        }
+    }
+    return files;
 }
 
 void MainWindow::importP7Dump(const QByteArray & fileContent)
 {
+    // file content only (browse dialog, WASM), nothing to follow
+    _follower.close();
+    _receiver.stop();
+
     p7::p7DumpImporter importer;
+    importer.setFilter(_model.importFilter());
+    importer.setBurstSettings(_model.burstSettings());
     p7::p7DumpData data = importer.import(fileContent);
 
     _model.setDumpData(std::move(data));
     _centralWidget->showModelData();
 }
 
+void MainWindow::setRetention(const p7::p7RetentionBudget & budget)
+{
+    _model.setRetention(budget);
+}
+
+void MainWindow::setImportFilter(const p7::p7ImportFilter & filter)
+{
+    _model.setImportFilter(filter);
+}
+
+void MainWindow::setBurstSettings(const p7::p7BurstSettings & settings)
+{
+    _model.setBurstSettings(settings);
+}
+
+void MainWindow::setCatalog(std::shared_ptr<const p7::p7DumpCatalog> catalog)
+{
+    _follower.setCatalog(catalog);
+}
+
+bool MainWindow::listen(quint16 port)
+{
+    _follower.close();
+
+    bool listening = _receiver.start(port);
+    _centralWidget->showModelData();
+    return listening;
+}
+
+void MainWindow::stopListening()
+{
+    _receiver.stop();
+    _centralWidget->showModelData();
+}
+
 CentralWidget::CentralWidget(p7::P7DumpModel * model,
+                             p7::P7DumpFollower * follower,
+                             p7::P7ReplayReceiver * receiver,
                              QWidget *parent)
     : QWidget(parent)
     , _model(model)
+    , _follower(follower)
+    , _receiver(receiver)
 {
     createWidgets();
 
@@ -47,7 +130,10 @@ void CentralWidget::dragEnterEvent(QDragEnterEvent *event)
     if (event->mimeData()->hasUrls()) {
         QList<QUrl> urls = event->mimeData()->urls();
         for (const QUrl & url : urls) {
-            if (url.fileName().endsWith(".p7d")) {
+            if (    (url.fileName().endsWith(".p7d"))
+                 || (QFileInfo(url.toLocalFile()).isDir())
+               )
+            {
                 event->acceptProposedAction();
                 break;
             }
@@ -58,14 +144,21 @@ void CentralWidget::dragEnterEvent(QDragEnterEvent *event)
 void CentralWidget::dropEvent(QDropEvent *event)
 {
     if (event->mimeData()->hasUrls()) {
+        // several files or a directory: rotated dumps of one incident
+        QStringList paths;
         QList<QUrl> urls = event->mimeData()->urls();
         for (const QUrl & url : urls) {
-            if (url.fileName().endsWith(".p7d")) {
-                event->acceptProposedAction();
-                static_cast<MainWindow *>(parent())->importP7Dump(url.path());
-                break;
+            if (    (url.fileName().endsWith(".p7d"))
+                 || (QFileInfo(url.toLocalFile()).isDir())
+               )
+            {
+                paths.append(url.toLocalFile());
             }
         }
+
+        if (!paths.isEmpty()) {
+            static_cast<MainWindow *>(parent())->importP7Dump(paths);
+        }
     }
 
     event->acceptProposedAction();
@@ -81,6 +174,14 @@ void CentralWidget::createWidgets()
     connect(_openFileButton, &QAbstractButton::clicked,
             this, &CentralWidget::onOpenFileButtonClicked);
 
+    _listenButton = new QPushButton(tr("Listen to p7dreplay..."));
+    connect(_listenButton, &QAbstractButton::clicked,
+            this, &CentralWidget::onListenButtonClicked);
+
+    _goToTimeButton = new QPushButton(tr("Go to time..."));
+    connect(_goToTimeButton, &QAbstractButton::clicked,
+            this, &CentralWidget::onGoToTimeButtonClicked);
+
     _hostNameLabel = new QLabel(tr("Host:"));
     _hostNameValue = new QLabel();
 
@@ -89,7 +190,16 @@ void CentralWidget::createWidgets()
 
     _processDateTimeValue = new QLabel();
 
+    // several trace channels in one dump: all merged by time or one of them
+    _streamSelector = new QComboBox();
+    _streamSelector->hide();
+    connect(_streamSelector,
+            QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &CentralWidget::onStreamSelected);
+
     processDataLayout->addWidget(_openFileButton);
+    processDataLayout->addWidget(_listenButton);
+    processDataLayout->addWidget(_goToTimeButton);
     processDataLayout->addStretch(1);
 
     processDataLayout->addWidget(_hostNameLabel);
@@ -101,8 +211,50 @@ void CentralWidget::createWidgets()
     processDataLayout->addStretch(1);
 
     processDataLayout->addWidget(_processDateTimeValue);
+    processDataLayout->addStretch(1);
+
+    processDataLayout->addWidget(_streamSelector);
+    processDataLayout->addStretch(1);
+
+    // tail mode for dumps which are still being written
+    _followCheckBox = new QCheckBox(tr("Follow"));
+    _followCheckBox->setEnabled(false);
+    connect(_followCheckBox, &QAbstractButton::toggled,
+            this, &CentralWidget::onFollowToggled);
+
+    _autoScrollCheckBox = new QCheckBox(tr("Auto-scroll"));
+    _autoScrollCheckBox->setChecked(true);
+    _autoScrollCheckBox->setEnabled(false);
+
+    connect(_follower, &p7::P7DumpFollower::rowsAppended,
+            this, &CentralWidget::onRowsAppended);
+    connect(_follower, &p7::P7DumpFollower::opened,
+            this, &CentralWidget::showModelData);
+    connect(_follower, &p7::P7DumpFollower::loadingStarted,
+            this, [this]() { onLoadingProgress(0); });
+    connect(_follower, &p7::P7DumpFollower::loadingProgress,
+            this, &CentralWidget::onLoadingProgress);
+    connect(_follower, &p7::P7DumpFollower::summaryReady,
+            this, &CentralWidget::onSummaryReady);
+    connect(_receiver, &p7::P7ReplayReceiver::rowsAppended,
+            this, &CentralWidget::onRowsAppended);
+    connect(_receiver, &p7::P7ReplayReceiver::headerReceived,
+            this, &CentralWidget::showModelData);
+
+    processDataLayout->addWidget(_followCheckBox);
+    processDataLayout->addWidget(_autoScrollCheckBox);
     processDataLayout->addStretch(10);
 
+    _overviewText = new QPlainTextEdit();
+    _overviewText->setReadOnly(true);
+    _overviewText->setMaximumHeight(fontMetrics().lineSpacing() * 12);
+    _overviewText->hide();
+
+    _rateTimeline = new RateTimeline(_model);
+    _rateTimeline->hide();
+    connect(_rateTimeline, &RateTimeline::timeClicked,
+            this, &CentralWidget::onTimelineClicked);
+
     _traceTable = new QTableView();
     _traceTable->verticalHeader()->hide();
     _traceTable->horizontalHeader()->setHighlightSections(false);
@@ -115,8 +267,60 @@ void CentralWidget::createWidgets()
         _traceTable->setColumnWidth(i, _model->columnWidth(i));
     }
 
+    QHBoxLayout * statusLayout = new QHBoxLayout();
+
+    _importStatsValue = new QLabel();
+    _importStatsButton = new QPushButton(tr("Details..."));
+    _importStatsButton->setEnabled(false);
+    connect(_importStatsButton, &QAbstractButton::clicked,
+            this, &CentralWidget::onImportStatsButtonClicked);
+
+    _memoryReportButton = new QPushButton(tr("Memory..."));
+    _memoryReportButton->setEnabled(false);
+    connect(_memoryReportButton, &QAbstractButton::clicked,
+            this, &CentralWidget::onMemoryReportButtonClicked);
+
+    _telemetryButton = new QPushButton(tr("Telemetry..."));
+    _telemetryButton->setEnabled(false);
+    connect(_telemetryButton, &QAbstractButton::clicked,
+            this, &CentralWidget::onTelemetryButtonClicked);
+
+    _traceIdsButton = new QPushButton(tr("Trace IDs..."));
+    _traceIdsButton->setEnabled(false);
+    connect(_traceIdsButton, &QAbstractButton::clicked,
+            this, &CentralWidget::onTraceIdsButtonClicked);
+
+    _threadLanesButton = new QPushButton(tr("Threads..."));
+    _threadLanesButton->setEnabled(false);
+    connect(_threadLanesButton, &QAbstractButton::clicked,
+            this, &CentralWidget::onThreadLanesButtonClicked);
+
+    _latencyButton = new QPushButton(tr("Latency..."));
+    _latencyButton->setEnabled(false);
+    connect(_latencyButton, &QAbstractButton::clicked,
+            this, &CentralWidget::onLatencyButtonClicked);
+
+    _overviewButton = new QPushButton(tr("Overview"));
+    _overviewButton->setCheckable(true);
+    _overviewButton->setEnabled(false);
+    connect(_overviewButton, &QAbstractButton::toggled,
+            this, &CentralWidget::onOverviewToggled);
+
+    statusLayout->addWidget(_importStatsValue);
+    statusLayout->addStretch(1);
+    statusLayout->addWidget(_overviewButton);
+    statusLayout->addWidget(_traceIdsButton);
+    statusLayout->addWidget(_threadLanesButton);
+    statusLayout->addWidget(_latencyButton);
+    statusLayout->addWidget(_telemetryButton);
+    statusLayout->addWidget(_importStatsButton);
+    statusLayout->addWidget(_memoryReportButton);
+
     mainLayout->addLayout(processDataLayout);
+    mainLayout->addWidget(_overviewText);
+    mainLayout->addWidget(_rateTimeline);
     mainLayout->addWidget(_traceTable);
+    mainLayout->addLayout(statusLayout);
 
     mainLayout->setAlignment(processDataLayout, Qt::AlignTop | Qt::AlignLeft);
 
@@ -137,13 +341,348 @@ void CentralWidget::onOpenFileButtonClicked()
     });
 }
 
+void CentralWidget::onImportStatsButtonClicked()
+{
+    QMessageBox box(this);
+    box.setWindowTitle(tr("Import statistics"));
+    box.setText(_importStatsValue->text());
+    box.setDetailedText(p7::importStatsAsString(_model->importStats())
+                        + "Sequence numbers per channel:\n"
+                        + p7::sequenceChecksAsString(_model->dumpData()));
+    box.exec();
+}
+
+void CentralWidget::onMemoryReportButtonClicked()
+{
+    p7::p7MemoryReport report = _model->memoryReport();
+
+    QMessageBox box(this);
+    box.setWindowTitle(tr("Memory usage"));
+    box.setText(tr("%1 MB used, %2 bytes per row")
+                .arg((double)report.total() / (1024.0 * 1024.0), 0, 'f', 1)
+                .arg(report.bytesPerRow(report.total()), 0, 'f', 1));
+    box.setDetailedText(p7::memoryReportAsString(report));
+    box.exec();
+}
+
+void CentralWidget::onTelemetryButtonClicked()
+{
+    if (!_telemetryWindow) {
+        _telemetryWindow = new TelemetryWindow(_model, this);
+    }
+
+    _telemetryWindow->show();
+    _telemetryWindow->raise();
+    _telemetryWindow->activateWindow();
+}
+
+void CentralWidget::onTraceIdsButtonClicked()
+{
+    if (!_traceIdsWindow) {
+        _traceIdsWindow = new TraceIdsWindow(_model, this);
+        connect(_traceIdsWindow, &TraceIdsWindow::rowActivated,
+                this, &CentralWidget::onRowActivated);
+    }
+
+    _traceIdsWindow->show();
+    _traceIdsWindow->raise();
+    _traceIdsWindow->activateWindow();
+}
+
+void CentralWidget::onThreadLanesButtonClicked()
+{
+    if (!_threadLanesWindow) {
+        _threadLanesWindow = new ThreadLanesWindow(_model, this);
+        connect(_threadLanesWindow, &ThreadLanesWindow::rowActivated,
+                this, &CentralWidget::onRowActivated);
+    }
+
+    _threadLanesWindow->show();
+    _threadLanesWindow->raise();
+    _threadLanesWindow->activateWindow();
+}
+
+void CentralWidget::onLatencyButtonClicked()
+{
+    if (!_latencyWindow) {
+        _latencyWindow = new LatencyWindow(_model, this);
+        connect(_latencyWindow, &LatencyWindow::rowActivated,
+                this, &CentralWidget::onRowActivated);
+    }
+
+    _latencyWindow->show();
+    _latencyWindow->raise();
+    _latencyWindow->activateWindow();
+}
+
+void CentralWidget::onRowActivated(size_t stream, quint64 number)
+{
+    int row = _model->viewRow(stream, number);
+
+    // a row of another channel: the merged view shows all of them
+    if (row < 0 && _model->currentStream() >= 0) {
+        _streamSelector->setCurrentIndex(0);
+        row = _model->viewRow(stream, number);
+    }
+
+    if (row >= 0) {
+        showRow(row);
+    }
+}
+
+void CentralWidget::onFollowToggled(bool checked)
+{
+    _follower->setFollowing(checked);
+    _autoScrollCheckBox->setEnabled(_follower->isFollowing());
+}
+
+void CentralWidget::onListenButtonClicked()
+{
+    MainWindow * mainWindow = static_cast<MainWindow *>(parent());
+
+    if (_receiver->isListening()) {
+        mainWindow->stopListening();
+        return;
+    }
+
+    bool ok = false;
+    // not the Baical transport, P7 clients can't send here
+    int port = QInputDialog::getInt(this, tr("Listen to p7dreplay"),
+                                    tr("UDP port of p7dreplay on 127.0.0.1:"),
+                                    9009, 1, 65535, 1, &ok);
+    if (!ok) {
+        return;
+    }
+
+    if (!mainWindow->listen((quint16)port)) {
+        QMessageBox::warning(this, tr("Listen to p7dreplay"),
+                             tr("Unable to listen on port %1").arg(port));
+    }
+}
+
+void CentralWidget::onGoToTimeButtonClicked()
+{
+    if (!_model->rowCount()) {
+        return;
+    }
+
+    // the date of the current row, a time of day is enough to type
+    const int currentRow = qMax(_traceTable->currentIndex().row(), 0);
+    const QDateTime current = p7::unpackDateTime(_model->rowTime(currentRow));
+
+    bool ok = false;
+    const QString text = QInputDialog::getText(
+                this, tr("Go to time"),
+                tr("Time (HH:mm:ss.zzz or yyyy-MM-dd HH:mm:ss.zzz):"),
+                QLineEdit::Normal, current.toString("HH:mm:ss.zzz"), &ok);
+    if (!ok) {
+        return;
+    }
+
+    QDateTime target = QDateTime::fromString(text.trimmed(),
+                                             "yyyy-MM-dd HH:mm:ss.zzz");
+    if (!target.isValid()) {
+        QTime time = QTime::fromString(text.trimmed(), "HH:mm:ss.zzz");
+        if (!time.isValid()) {
+            time = QTime::fromString(text.trimmed(), "HH:mm:ss");
+        }
+        target = QDateTime(current.date(), time);
+    }
+
+    if (!target.isValid()) {
+        QMessageBox::warning(this, tr("Go to time"),
+                             tr("Invalid time: %1").arg(text));
+        return;
+    }
+
+    const int row = _model->rowAtTime(p7::packDateTime(target));
+    if (row < 0) {
+        QMessageBox::information(this, tr("Go to time"),
+                                 tr("No rows at or after %1")
+                                    .arg(target.toString(
+                                             "yyyy-MM-dd HH:mm:ss.zzz")));
+        return;
+    }
+
+    showRow(row);
+}
+
+void CentralWidget::showRow(int row)
+{
+    const QModelIndex index = _model->index(
+                row, static_cast<int>(p7::P7DumpModel::Columns::Time));
+    _traceTable->setCurrentIndex(index);
+    _traceTable->scrollTo(index, QAbstractItemView::PositionAtTop);
+}
+
+void CentralWidget::onLoadingProgress(int percent)
+{
+    const QStringList files = _follower->fileNames();
+    const QString name = files.size() == 1
+            ? QFileInfo(files.first()).fileName()
+            : tr("%1 files").arg(files.size());
+
+    _importStatsValue->setText(tr("Importing %1... %2%")
+                               .arg(name)
+                               .arg(percent));
+}
+
+void CentralWidget::onSummaryReady()
+{
+    _overviewText->setPlainText(p7::summaryAsString(_follower->summary()));
+    _overviewButton->setEnabled(true);
+    _overviewButton->setChecked(true);
+}
+
+void CentralWidget::onOverviewToggled(bool checked)
+{
+    _overviewText->setVisible(checked);
+}
+
+void CentralWidget::onTimelineClicked(quint64 time)
+{
+    const int row = _model->rowAtTime(time);
+    if (row >= 0) {
+        showRow(row);
+    }
+}
+
+void CentralWidget::onRowsAppended(int rows)
+{
+    Q_UNUSED(rows);
+
+    // a new channel has been written
+    if (_streamSelector->count() != _model->streamsCount() + 1) {
+        showModelData();
+    } else {
+        showImportStats();
+        _rateTimeline->setVisible(_model->dumpData().traceDataCount() > 0);
+        _rateTimeline->update();
+        _threadLanesButton->setEnabled(
+                    _model->dumpData().traceDataCount() > 0);
+        _latencyButton->setEnabled(_model->dumpData().traceDataCount() > 0);
+        if (_threadLanesWindow) {
+            _threadLanesWindow->updateLanes();
+        }
+    }
+
+    // rows of a file being loaded are not followed
+    if (_autoScrollCheckBox->isChecked() && !_follower->isLoading()) {
+        _model->fetchAll();
+        _traceTable->scrollToBottom();
+    }
+}
+
+void CentralWidget::onStreamSelected(int index)
+{
+    if (index < 0) {
+        return;
+    }
+
+    // first item is the merged view
+    _model->setCurrentStream(index - 1);
+}
+
 void CentralWidget::showModelData()
 {
     _hostNameValue->setText(_model->hostName());
     _processNameValue->setText(_model->processName());
     _processDateTimeValue->setText(_model->processDateTimeAsString());
+
+    const int streamsCount = _model->streamsCount();
+
+    {
+        QSignalBlocker blocker(_streamSelector);
+        _streamSelector->clear();
+        _streamSelector->addItem(tr("All channels"));
+        for (int i = 0; i < streamsCount; ++i) {
+            _streamSelector->addItem(_model->streamName(i));
+        }
+        _streamSelector->setCurrentIndex(_model->currentStream() + 1);
+    }
+
+    _streamSelector->setVisible(streamsCount > 1);
+    _traceTable->setColumnHidden(
+                static_cast<int>(p7::P7DumpModel::Columns::Channel),
+                streamsCount < 2);
+    _traceTable->setColumnHidden(
+                static_cast<int>(p7::P7DumpModel::Columns::Dump),
+                _model->filesCount() < 2);
+
+    if (_model->filesCount() > 1) {
+        _processNameValue->setText(tr("%1 (%2 files)")
+                                   .arg(_model->processName())
+                                   .arg(_model->filesCount()));
+    }
+
+    _listenButton->setText(_receiver->isListening()
+                           ? tr("Stop listening")
+                           : tr("Listen to p7dreplay..."));
+    // received rows are always appended at the end
+    const bool live = _receiver->isListening();
+
+    {
+        QSignalBlocker blocker(_followCheckBox);
+        _followCheckBox->setEnabled(!_follower->fileName().isEmpty());
+        _followCheckBox->setChecked(_follower->isFollowing());
+    }
+    _autoScrollCheckBox->setEnabled(_follower->isFollowing() || live);
+
+    showImportStats();
+
+    _telemetryButton->setEnabled(
+                _model->dumpData().telemetryStreamsCount() > 0);
+    _traceIdsButton->setEnabled(_model->dumpData().traceDataCount() > 0);
+    _threadLanesButton->setEnabled(_model->dumpData().traceDataCount() > 0);
+    _latencyButton->setEnabled(_model->dumpData().traceDataCount() > 0);
+    _rateTimeline->setVisible(_model->dumpData().traceDataCount() > 0);
+
+    // no summary of a dump read from memory or received
+    if (!_follower->summary().files) {
+        _overviewButton->setChecked(false);
+        _overviewButton->setEnabled(false);
+    }
+}
+
+void CentralWidget::showImportStats()
+{
+    const p7::p7ImportStats & stats = _model->importStats();
+
+    double seconds = (double)stats.totalNs / 1e9;
+    double mbPerSec = seconds > 0
+            ? (double)stats.bytesRead / (1024.0 * 1024.0) / seconds
+            : 0.0;
+
+    QString text = tr("%1 rows, %2 MB imported in %3 ms (%4 MB/s)")
+            .arg(_model->streamRowsCount())
+            .arg((double)stats.bytesRead / (1024.0 * 1024.0), 0, 'f', 1)
+            .arg((double)stats.totalNs / 1e6, 0, 'f', 0)
+            .arg(mbPerSec, 0, 'f', 1);
+
+    // traces the client dropped, rows after them are marked in the table
+    const p7::p7DumpData & data = _model->dumpData();
+    uint64_t gaps = 0;
+    uint64_t missing = 0;
+    for (size_t i = 0; i < data.streamsCount(); ++i) {
+        gaps += data.stream(i).sequences().gaps();
+        missing += data.stream(i).sequences().missing();
+    }
+    if (gaps) {
+        text += tr(", %1 traces lost in %2 gaps").arg(missing).arg(gaps);
+    }
+
+    if (_receiver->isListening()) {
+        text += tr(", port %1: %2 datagrams, %3 refused or broken")
+                .arg(_receiver->port())
+                .arg(_receiver->datagramsCount())
+                .arg(_receiver->droppedCount());
+    }
+
+    _importStatsValue->setText(text);
+    _importStatsButton->setEnabled(true);
+    _memoryReportButton->setEnabled(true);
 }
 
 } // namespace ui
-} // namespace p7d
+} // namespace p7
 
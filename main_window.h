@@ -3,14 +3,24 @@
 
 #include <QMainWindow>
 #include <QLabel>
+#include <QComboBox>
+#include <QCheckBox>
 #include <QTableView>
 #include <QPushButton>
+#include <QPlainTextEdit>
 #include "p7d_model.h"
+#include "p7d_follower.h"
+#include "p7d_replay_receiver.h"
 
 namespace p7 {
 namespace ui {
 
 class CentralWidget;
+class TelemetryWindow;
+class TraceIdsWindow;
+class ThreadLanesWindow;
+class LatencyWindow;
+class RateTimeline;
 
 class MainWindow : public QMainWindow
 {
@@ -20,13 +30,30 @@ public:
     explicit MainWindow(QWidget *parent = nullptr);
 
     void importP7Dump(const QString & filename);
+    // Rotated dumps, directories are replaced by their *.p7d files
+    void importP7Dump(const QStringList & paths);
     void importP7Dump(const QByteArray & fileContent);
 
+    // Dump files of paths: files as they are, *.p7d files of directories
+    // by name
+    static QStringList dumpFiles(const QStringList & paths);
+
+    void setRetention(const p7::p7RetentionBudget & budget);
+    void setImportFilter(const p7::p7ImportFilter & filter);
+    void setBurstSettings(const p7::p7BurstSettings & settings);
+    void setCatalog(std::shared_ptr<const p7::p7DumpCatalog> catalog);
+
+    // Live ingestion from tools/p7dreplay or a compatible sender
+    bool listen(quint16 port);
+    void stopListening();
+
 private:
 
     CentralWidget * _centralWidget;
 
     p7::P7DumpModel _model;
+    p7::P7DumpFollower _follower;
+    p7::P7ReplayReceiver _receiver;
 };
 
 class CentralWidget : public QWidget
@@ -35,6 +62,8 @@ class CentralWidget : public QWidget
 
 public:
     CentralWidget(p7::P7DumpModel * model,
+                  p7::P7DumpFollower * follower,
+                  p7::P7ReplayReceiver * receiver,
                   QWidget *parent = nullptr);
 
     void showModelData();
@@ -49,8 +78,31 @@ private:
     void createWidgets();
 
     Q_SLOT void onOpenFileButtonClicked();
+    Q_SLOT void onImportStatsButtonClicked();
+    Q_SLOT void onMemoryReportButtonClicked();
+    Q_SLOT void onStreamSelected(int index);
+    Q_SLOT void onTelemetryButtonClicked();
+    Q_SLOT void onTraceIdsButtonClicked();
+    Q_SLOT void onThreadLanesButtonClicked();
+    Q_SLOT void onLatencyButtonClicked();
+    // a row of another window (trace IDs, threads, latency) is activated
+    Q_SLOT void onRowActivated(size_t stream, quint64 number);
+    Q_SLOT void onFollowToggled(bool checked);
+    Q_SLOT void onListenButtonClicked();
+    Q_SLOT void onGoToTimeButtonClicked();
+    Q_SLOT void onRowsAppended(int rows);
+    Q_SLOT void onLoadingProgress(int percent);
+    Q_SLOT void onSummaryReady();
+    Q_SLOT void onOverviewToggled(bool checked);
+    Q_SLOT void onTimelineClicked(quint64 time);
+
+    void showImportStats();
+    // select a row of the view and scroll it to the top
+    void showRow(int row);
 
     QPushButton * _openFileButton;
+    QPushButton * _listenButton;
+    QPushButton * _goToTimeButton;
 
     QLabel * _hostNameLabel;
     QLabel * _hostNameValue;
@@ -60,9 +112,36 @@ private:
 
     QLabel * _processDateTimeValue;
 
+    QComboBox * _streamSelector;
+
+    QCheckBox * _followCheckBox;
+    QCheckBox * _autoScrollCheckBox;
+
+    // summary of the files, shown as soon as it is ready
+    QPlainTextEdit * _overviewText;
+
+    // rows per time stacked by level, bursts highlighted
+    RateTimeline * _rateTimeline;
+
     QTableView * _traceTable;
 
+    QLabel * _importStatsValue;
+    QPushButton * _importStatsButton;
+    QPushButton * _memoryReportButton;
+    QPushButton * _telemetryButton;
+    QPushButton * _traceIdsButton;
+    QPushButton * _threadLanesButton;
+    QPushButton * _latencyButton;
+    QPushButton * _overviewButton;
+
+    TelemetryWindow * _telemetryWindow = nullptr;
+    TraceIdsWindow * _traceIdsWindow = nullptr;
+    ThreadLanesWindow * _threadLanesWindow = nullptr;
+    LatencyWindow * _latencyWindow = nullptr;
+
     p7::P7DumpModel * _model;
+    p7::P7DumpFollower * _follower;
+    p7::P7ReplayReceiver * _receiver;
 };
 
 } // namespace ui
@@ -23,6 +23,7 @@
 #include <stddef.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdarg.h>
 #include <cstring>
 #include "GTypes.h"
 
@@ -65,6 +66,10 @@
 #define P7TRACE_THREAD_NAME_LENGTH                                          (48)
 #define P7TRACE_MODULE_NAME_LENGTH                                          (54)
 
+// P7Telemetry
+#define P7TELEMETRY_NAME_LENGTH                                             (64)
+#define P7TELEMETRY_COUNTER_NAME_LENGTH                                     (64)
+
 enum eResult
 {
     /// <summary> Success result code </summary>
@@ -186,6 +191,18 @@ enum eP7Trace_Type
     EP7TRACE_TYPE_MAX           = 32
 };
 
+enum eP7Tel_Type
+{
+    EP7TEL_TYPE_INFO            =  0, //Client->Server
+    EP7TEL_TYPE_COUNTER             , //Client->Server
+    EP7TEL_TYPE_VALUE               , //Client->Server
+    EP7TEL_TYPE_ENABLE              , //Server->Client
+    EP7TEL_TYPE_CLOSE               , //Client->Server
+    EP7TEL_TYPE_UTC_OFFS            , //Client->Server
+
+    EP7TEL_TYPE_MAX             = 32
+};
+
 struct sH_User_Data //user data header, map for sH_User_Raw
 {
     uint32_t dwSize       :USER_PACKET_SIZE_BITS_COUNT;       //<< 28 bits for Size
@@ -293,6 +310,18 @@ struct sP7Trace_Thread_Start
     int8_t         pName[P7TRACE_THREAD_NAME_LENGTH]; //Thread name (UTF-8)
 } ATTR_PACK(2);
 
+//Thread stop info
+struct sP7Trace_Thread_Stop
+{
+    union
+    {
+        sP7Ext_Header sCommon;
+        sP7Ext_Raw    sCommonRaw;
+    };
+    uint32_t       dwThreadID;                        //Thread ID
+    uint64_t       qwTimer;                           //High resolution timer value
+} ATTR_PACK(2);
+
 //Module info
 struct sP7Trace_Module
 {
@@ -306,9 +335,89 @@ struct sP7Trace_Module
     int8_t           pName[P7TRACE_MODULE_NAME_LENGTH]; //name (UTF-8)
 } ATTR_PACK(2);
 
+//Telemetry stream info, the same for V1 and V2 streams
+struct sP7Tel_Info
+{
+    union
+    {
+        sP7Ext_Header sCommon;
+        sP7Ext_Raw    sCommonRaw;
+    };
+    //Contains a 64-bit value representing the number of 100-nanosecond intervals
+    //since January 1, 1601 (UTC).
+    uint32_t       dwTime_Hi;
+    uint32_t       dwTime_Lo;
+    //Hi resolution timer value and timer's count heartbeats in second
+    uint64_t       qwTimer_Value;
+    uint64_t       qwTimer_Frequency;
+    uint64_t       qwFlags;
+    char16_t       pName[P7TELEMETRY_NAME_LENGTH];
+} ATTR_PACK(2);
+
+//Telemetry V1 counter description
+struct sP7Tel_Counter_v1
+{
+    union
+    {
+        sP7Ext_Header sCommon;
+        sP7Ext_Raw    sCommonRaw;
+    };
+    uint8_t        bID;
+    uint8_t        bOn;
+    int64_t        llMin;
+    int64_t        llMax;
+    int64_t        llAlarm;
+    char16_t       pName[P7TELEMETRY_COUNTER_NAME_LENGTH];
+} ATTR_PACK(2);
+
+//Telemetry V1 sample
+struct sP7Tel_Value_v1
+{
+    union
+    {
+        sP7Ext_Header sCommon;
+        sP7Ext_Raw    sCommonRaw;
+    };
+    uint8_t        bID;
+    uint8_t        bSeqN;
+    uint64_t       qwTimer;      //High resolution timer value
+    int64_t        llValue;
+} ATTR_PACK(2);
+
+//Telemetry V2 counter description
+struct sP7Tel_Counter_v2
+{
+    union
+    {
+        sP7Ext_Header sCommon;
+        sP7Ext_Raw    sCommonRaw;
+    };
+    uint16_t       wID;
+    uint8_t        bOn;
+    double         dbMin;
+    double         dbAlarmMin;
+    double         dbMax;
+    double         dbAlarmMax;
+    char16_t       pName[P7TELEMETRY_COUNTER_NAME_LENGTH];
+} ATTR_PACK(2);
+
+//Telemetry V2 sample
+struct sP7Tel_Value_v2
+{
+    union
+    {
+        sP7Ext_Header sCommon;
+        sP7Ext_Raw    sCommonRaw;
+    };
+    uint16_t       wID;
+    uint16_t       wSeqN;
+    uint64_t       qwTimer;      //High resolution timer value
+    double         dbValue;
+} ATTR_PACK(2);
+
 PRAGMA_PACK_EXIT()
 
-static uint64_t ntohqw(uint64_t i_qwX)
+static inline uint64_t ntohqw(uint64_t i_qwX)
 {
 #if defined(_WIN32) || defined(_WIN64)
     return _byteswap_uint64(i_qwX);
@@ -0,0 +1,209 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                             /
+// 2022 (c) Ragnar Lodbrok                                                     /
+//                                                                             /
+// This library is free software; you can redistribute it and/or               /
+// modify it under the terms of the GNU Lesser General Public                  /
+// License as published by the Free Software Foundation; either                /
+// version 3.0 of the License, or (at your option) any later version.          /
+//                                                                             /
+// This library is distributed in the hope that it will be useful,             /
+// but WITHOUT ANY WARRANTY; without even the implied warranty of              /
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU           /
+// Lesser General Public License for more details.                             /
+//                                                                             /
+// You should have received a copy of the GNU Lesser General Public            /
+// License along with this library.                                            /
+//                                                                             /
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef P7_DUMP_ARENA_H
+#define P7_DUMP_ARENA_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <stdlib.h>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace p7 {
+
+// Bump allocator for per-dump metadata (descriptions, formatters).
+// Memory is never freed one by one: clear() (or destructor) calls
+// destructors of created objects in reverse order and frees all blocks.
+class p7Arena
+{
+public:
+
+    explicit p7Arena(size_t blockSize = 16 * 1024)
+        : _blockSize(blockSize)
+    {}
+
+    p7Arena(const p7Arena &) = delete;
+    p7Arena& operator=(const p7Arena &) = delete;
+
+    ~p7Arena()
+    {
+        clear();
+    }
+
+    void * allocate(size_t size, size_t align = alignof(std::max_align_t))
+    {
+        if (!size) {
+            size = 1;
+        }
+
+        if (_head) {
+            size_t offs = alignUp(_head->used, align);
+            if (offs + size <= _head->size) {
+                _head->used = offs + size;
+                _bytesUsed += size;
+                return blockData(_head) + offs;
+            }
+        }
+
+        // big allocations get their own block so the current one
+        // keeps its free space
+        if (size + align > _blockSize / 4) {
+            Block * block = newBlock(size + align);
+            if (_head) {
+                block->next = _head->next;
+                _head->next = block;
+            } else {
+                _head = block;
+            }
+            size_t offs = alignUp(0, align);
+            block->used = offs + size;
+            _bytesUsed += size;
+            return blockData(block) + offs;
+        }
+
+        Block * block = newBlock(_blockSize);
+        block->next = _head;
+        _head = block;
+
+        size_t offs = alignUp(0, align);
+        block->used = offs + size;
+        _bytesUsed += size;
+        return blockData(block) + offs;
+    }
+
+    void * copy(const void * data, size_t size, size_t align = 1)
+    {
+        void * dst = allocate(size, align);
+        memcpy(dst, data, size);
+        return dst;
+    }
+
+    template<typename T, typename... Args>
+    T * create(Args&&... args)
+    {
+        void * memory = allocate(sizeof(T), alignof(T));
+        T * object = new (memory) T(std::forward<Args>(args)...);
+
+        if (!std::is_trivially_destructible<T>::value) {
+            Destructor * destructor = (Destructor *)allocate(
+                        sizeof(Destructor), alignof(Destructor));
+            destructor->object = object;
+            destructor->destroy = &destroy<T>;
+            destructor->next = _destructors;
+            _destructors = destructor;
+        }
+
+        return object;
+    }
+
+    void clear()
+    {
+        while (_destructors) {
+            Destructor * destructor = _destructors;
+            _destructors = destructor->next;
+            destructor->destroy(destructor->object);
+        }
+
+        while (_head) {
+            Block * block = _head;
+            _head = block->next;
+            free(block);
+        }
+
+        _bytesUsed = 0;
+        _bytesReserved = 0;
+    }
+
+    size_t bytesUsed() const
+    {
+        return _bytesUsed;
+    }
+
+    size_t bytesReserved() const
+    {
+        return _bytesReserved;
+    }
+
+private:
+
+    struct Block
+    {
+        Block * next;
+        size_t size;
+        size_t used;
+    };
+
+    struct Destructor
+    {
+        Destructor * next;
+        void * object;
+        void (*destroy)(void *);
+    };
+
+    template<typename T>
+    static void destroy(void * object)
+    {
+        static_cast<T *>(object)->~T();
+    }
+
+    static size_t alignUp(size_t value, size_t align)
+    {
+        return (value + align - 1) & ~(align - 1);
+    }
+
+    static char * blockData(Block * block)
+    {
+        return (char *)block + headerSize();
+    }
+
+    static constexpr size_t headerSize()
+    {
+        return (sizeof(Block) + alignof(std::max_align_t) - 1)
+                & ~(alignof(std::max_align_t) - 1);
+    }
+
+    Block * newBlock(size_t size)
+    {
+        Block * block = (Block *)malloc(headerSize() + size);
+        if (!block) {
+            throw std::bad_alloc();
+        }
+
+        block->next = nullptr;
+        block->size = size;
+        block->used = 0;
+
+        _bytesReserved += headerSize() + size;
+
+        return block;
+    }
+
+    size_t _blockSize;
+    Block * _head = nullptr;
+    Destructor * _destructors = nullptr;
+    size_t _bytesUsed = 0;
+    size_t _bytesReserved = 0;
+};
+
+}
+
+#endif // P7_DUMP_ARENA_H
@@ -0,0 +1,166 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                             /
+// 2022 (c) Ragnar Lodbrok                                                     /
+//                                                                             /
+// This library is free software; you can redistribute it and/or               /
+// modify it under the terms of the GNU Lesser General Public                  /
+// License as published by the Free Software Foundation; either                /
+// version 3.0 of the License, or (at your option) any later version.          /
+//                                                                             /
+// This library is distributed in the hope that it will be useful,             /
+// but WITHOUT ANY WARRANTY; without even the implied warranty of              /
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU           /
+// Lesser General Public License for more details.                             /
+//                                                                             /
+// You should have received a copy of the GNU Lesser General Public            /
+// License along with this library.                                            /
+//                                                                             /
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef P7_DUMP_BLOCK_DEQUE_H
+#define P7_DUMP_BLOCK_DEQUE_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <deque>
+#include <utility>
+#include <vector>
+
+namespace p7 {
+
+// Append-only sequence stored in fixed size blocks, the oldest items can
+// be dropped from the front. Items never move once added, so references
+// stay valid until the item is dropped. Every item has an absolute
+// number which keeps growing (the first one ever added is 0), indexes
+// are relative to the first item not dropped yet. popFront() frees whole
+// blocks, items of a partially dropped block are freed with the block.
+template<typename T, size_t BlockSize = 4096>
+class p7BlockDeque
+{
+public:
+
+    static constexpr size_t blockSize()
+    {
+        return BlockSize;
+    }
+
+    size_t size() const
+    {
+        return _size;
+    }
+
+    bool empty() const
+    {
+        return !_size;
+    }
+
+    // absolute number of the first item, index 0
+    uint64_t firstNumber() const
+    {
+        return _first;
+    }
+
+    // absolute number the next added item will get
+    uint64_t endNumber() const
+    {
+        return _first + _size;
+    }
+
+    // dropped items still held by the first block
+    size_t frontOffset() const
+    {
+        return _offset;
+    }
+
+    T & operator[](size_t index)
+    {
+        const size_t position = _offset + index;
+        return _blocks[position / BlockSize][position % BlockSize];
+    }
+
+    const T & operator[](size_t index) const
+    {
+        const size_t position = _offset + index;
+        return _blocks[position / BlockSize][position % BlockSize];
+    }
+
+    T & back()
+    {
+        return _blocks.back().back();
+    }
+
+    void push_back(T && item)
+    {
+        if (_blocks.empty() || _blocks.back().size() == BlockSize) {
+            _blocks.emplace_back();
+            _blocks.back().reserve(BlockSize);
+        }
+
+        _blocks.back().push_back(std::move(item));
+        ++_size;
+    }
+
+    void push_back(const T & item)
+    {
+        push_back(T(item));
+    }
+
+    // Drops count oldest items, whole blocks are freed at once
+    void popFront(size_t count)
+    {
+        if (count > _size) {
+            count = _size;
+        }
+
+        _offset += count;
+        _first += count;
+        _size -= count;
+
+        while (_offset >= BlockSize) {
+            _blocks.pop_front();
+            _offset -= BlockSize;
+        }
+    }
+
+    void clear()
+    {
+        clear(_first + _size);
+    }
+
+    // the next added item gets number first
+    void clear(uint64_t first)
+    {
+        _first = first;
+        _size = 0;
+        _offset = 0;
+        _blocks.clear();
+    }
+
+    // Frees spare capacity of the block list. The last block keeps its
+    // reserved capacity, shrinking it would move its items on the next
+    // append
+    void shrinkToFit()
+    {
+        _blocks.shrink_to_fit();
+    }
+
+    size_t capacity() const
+    {
+        size_t items = 0;
+        for (const std::vector<T> & block : _blocks) {
+            items += block.capacity();
+        }
+        return items;
+    }
+
+private:
+
+    std::deque<std::vector<T>> _blocks;
+    uint64_t _first = 0;  // absolute number of the first item
+    size_t _offset = 0;   // of the first item in the first block
+    size_t _size = 0;
+};
+
+}
+
+#endif // P7_DUMP_BLOCK_DEQUE_H
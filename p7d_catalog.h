@@ -0,0 +1,853 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                             /
+// 2022 (c) Ragnar Lodbrok                                                     /
+//                                                                             /
+// This library is free software; you can redistribute it and/or               /
+// modify it under the terms of the GNU Lesser General Public                  /
+// License as published by the Free Software Foundation; either                /
+// version 3.0 of the License, or (at your option) any later version.          /
+//                                                                             /
+// This library is distributed in the hope that it will be useful,             /
+// but WITHOUT ANY WARRANTY; without even the implied warranty of              /
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU           /
+// Lesser General Public License for more details.                             /
+//                                                                             /
+// You should have received a copy of the GNU Lesser General Public            /
+// License along with this library.                                            /
+//                                                                             /
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef P7_DUMP_CATALOG_H
+#define P7_DUMP_CATALOG_H
+
+#include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QString>
+#include <QStringList>
+#include "importer.h"
+#include "p7d_scanner.h"
+
+namespace p7 {
+
+// Summary of one dump file in p7DumpCatalog
+struct p7CatalogEntry
+{
+    QString fileName;               // absolute path
+    uint64_t fileSize = 0;
+    qint64 modified = 0;            // ms since epoch, see p7DumpCatalog::find()
+
+    QString hostName;
+    QString processName;
+    uint32_t processId = 0;
+    uint64_t processStartTime = 0;  // 100ns since 1601 (UTC)
+
+    uint64_t fromTime = 0;          // the earliest and the latest row
+    uint64_t toTime = 0;
+    uint64_t rows = 0;
+    uint64_t levelRows[EP7TRACE_LEVEL_COUNT] = {};
+
+    // time indexes of trace channels, loaded on demand (timeIndexes()),
+    // from this range of the catalog file
+    std::vector<p7ChannelTimeIndex> indexes;
+    uint64_t indexOffset = 0;
+    uint64_t indexSize = 0;
+    bool keywordIndex = false;      // indexes have keyword filters
+
+    uint64_t rowsAtOrAbove(eP7Trace_Level level) const
+    {
+        uint64_t count = 0;
+        for (int i = level; i < EP7TRACE_LEVEL_COUNT; ++i) {
+            count += levelRows[i];
+        }
+        return count;
+    }
+};
+
+// Dumps to find in a catalog, empty fields match everything
+struct p7CatalogQuery
+{
+    QString hostName;
+    QString processName;
+    uint64_t fromTime = 0; // dumps with rows in [from, to), 0 - open
+    uint64_t toTime = 0;
+    eP7Trace_Level minLevel = EP7TRACE_LEVEL_TRACE; // with rows of the
+                                                    // level or above
+};
+
+// Catalog of dump files: host, process, time range, rows per level and
+// the time index of every file, so archives of many dumps are searched
+// without opening them. Building a catalog entry scans packet headers
+// only: the file header, Info packets and sP7Trace_Data headers for the
+// time index; descriptions are not parsed and nothing is formatted.
+// Optionally the index also gets a keyword filter of the words of
+// messages of every block (indexKeywords()), that one decodes the dump.
+//
+// The catalog file keeps the summaries together at the start, load()
+// reads only them; time indexes follow and are read per dump when a
+// partial import needs one, see timeIndexes() and
+// p7DumpImporter::importTimeRange().
+class p7DumpCatalog
+{
+public:
+
+    // Summaries of a catalog file, false if it can't be read
+    bool load(const QString & fileName)
+    {
+        _entries.clear();
+        _fileName.clear();
+
+        FILE * file = fopen(fileName.toStdString().c_str(), "rb");
+        if (!file) {
+            return false;
+        }
+
+        const uint64_t catalogSize = fileSize(file);
+        uint64_t marker = 0;
+        uint32_t version = 0;
+        uint32_t count = 0;
+        uint64_t summariesSize = 0;
+        std::vector<uint8_t> summaries;
+
+        bool ok =   (fread(&marker, sizeof(marker), 1, file) == 1)
+                 && (fread(&version, sizeof(version), 1, file) == 1)
+                 && (fread(&count, sizeof(count), 1, file) == 1)
+                 && (fread(&summariesSize, sizeof(summariesSize), 1, file) == 1)
+                 && (marker == catalogMarker())
+                 && (version == catalogVersion())
+                 && (summariesSize <= catalogSize - headerSize());
+        if (ok) {
+            summaries.resize((size_t)summariesSize);
+            ok = fread(summaries.data(), 1, summaries.size(), file)
+                    == summaries.size();
+        }
+        fclose(file);
+
+        // an entry whose index isn't in the file (a truncated or corrupt
+        // catalog) is dropped, the next update() scans its dump again
+        Reader reader(summaries);
+        for (uint32_t i = 0; ok && i < count; ++i) {
+            p7CatalogEntry entry;
+            ok = readSummary(reader, entry);
+            if (    (ok)
+                 && (entry.indexSize <= catalogSize)
+                 && (entry.indexOffset <= catalogSize - entry.indexSize)
+               )
+            {
+                _entries.push_back(std::move(entry));
+            }
+        }
+
+        if (!ok) {
+            _entries.clear();
+            return false;
+        }
+
+        _fileName = fileName;
+        return true;
+    }
+
+    // Writes the catalog (a temporary file renamed over fileName), time
+    // indexes of entries kept from load() are copied from the old file
+    bool save(const QString & fileName)
+    {
+        std::vector<std::vector<uint8_t>> indexes(_entries.size());
+        for (size_t i = 0; i < _entries.size(); ++i) {
+            if (!_entries[i].indexes.empty() || !_entries[i].indexSize) {
+                Writer writer(indexes[i]);
+                writeIndexes(writer, _entries[i].indexes);
+            }
+        }
+
+        std::vector<uint8_t> summaries;
+        Writer writer(summaries);
+        uint64_t indexOffset = 0;
+        for (size_t i = 0; i < _entries.size(); ++i) {
+            // offsets are relative to the end of summaries until known
+            if (!_entries[i].indexes.empty() || !_entries[i].indexSize) {
+                _entries[i].indexSize = indexes[i].size();
+            }
+            writeSummary(writer, _entries[i], indexOffset);
+            indexOffset += _entries[i].indexSize;
+        }
+        const uint64_t summariesSize = summaries.size();
+
+        const std::string tempName = fileName.toStdString() + ".tmp";
+        FILE * file = fopen(tempName.c_str(), "wb");
+        if (!file) {
+            return false;
+        }
+        FILE * oldFile = _fileName.isEmpty()
+                ? nullptr
+                : fopen(_fileName.toStdString().c_str(), "rb");
+        const uint64_t oldSize = oldFile ? fileSize(oldFile) : 0;
+
+        const uint64_t marker = catalogMarker();
+        const uint32_t version = catalogVersion();
+        const uint32_t count = (uint32_t)_entries.size();
+        bool ok =   (fwrite(&marker, sizeof(marker), 1, file) == 1)
+                 && (fwrite(&version, sizeof(version), 1, file) == 1)
+                 && (fwrite(&count, sizeof(count), 1, file) == 1)
+                 && (fwrite(&summariesSize, sizeof(summariesSize), 1, file) == 1)
+                 && (fwrite(summaries.data(), 1, summaries.size(), file)
+                        == summaries.size());
+
+        std::vector<uint8_t> copy;
+        for (size_t i = 0; ok && i < _entries.size(); ++i) {
+            p7CatalogEntry & entry = _entries[i];
+            if (indexes[i].empty() && entry.indexSize) {
+                // the old file may have been changed since load()
+                ok =   (oldFile)
+                    && (entry.indexSize <= oldSize)
+                    && (entry.indexOffset <= oldSize - entry.indexSize);
+                if (ok) {
+                    copy.resize((size_t)entry.indexSize);
+                }
+                ok =   (ok)
+                    && (seekFile(oldFile, (int64_t)entry.indexOffset))
+                    && (fread(copy.data(), 1, copy.size(), oldFile)
+                            == copy.size())
+                    && (fwrite(copy.data(), 1, copy.size(), file)
+                            == copy.size());
+            } else {
+                ok = fwrite(indexes[i].data(), 1, indexes[i].size(), file)
+                        == indexes[i].size();
+            }
+        }
+
+        if (oldFile) {
+            fclose(oldFile);
+        }
+        ok = (fclose(file) == 0) && ok;
+
+        const std::string name = fileName.toStdString();
+        if (ok) {
+            remove(name.c_str());
+            ok = rename(tempName.c_str(), name.c_str()) == 0;
+        }
+        if (!ok) {
+            remove(tempName.c_str());
+            return false;
+        }
+
+        // offsets in the new file
+        indexOffset = headerSize() + summariesSize;
+        for (p7CatalogEntry & entry : _entries) {
+            entry.indexOffset = indexOffset;
+            indexOffset += entry.indexSize;
+        }
+        _fileName = fileName;
+
+        return true;
+    }
+
+    // Adds dumps to the catalog or rescans them if they have changed (or
+    // have no keyword filters yet and keywords are asked for), entries of
+    // files which don't exist any more are dropped. Files are scanned in
+    // parallel. Returns the number of files scanned.
+    size_t update(const QStringList & fileNames, bool keywords = false)
+    {
+        _entries.erase(std::remove_if(
+                           _entries.begin(), _entries.end(),
+                           [](const p7CatalogEntry & entry) {
+                               return !QFileInfo(entry.fileName).exists();
+                           }),
+                       _entries.end());
+
+        std::vector<QString> toScan;
+        for (const QString & fileName : fileNames) {
+            const p7CatalogEntry * entry = find(fileName);
+            if (!entry || (keywords && !entry->keywordIndex)) {
+                toScan.push_back(QFileInfo(fileName).absoluteFilePath());
+            }
+        }
+
+        std::vector<p7CatalogEntry> scanned(toScan.size());
+        std::vector<char> valid(toScan.size(), 0);
+
+        std::atomic<size_t> nextFile(0);
+        auto worker = [&toScan, &scanned, &valid, &nextFile, keywords]() {
+            size_t file;
+            while ((file = nextFile++) < toScan.size()) {
+                valid[file] = scanDump(toScan[file], scanned[file])
+                           && (!keywords || indexKeywords(toScan[file],
+                                                          scanned[file]));
+            }
+        };
+
+        size_t threadsCount = std::min<size_t>(
+                    toScan.size(),
+                    std::max(1u, std::thread::hardware_concurrency()));
+
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < threadsCount; ++i) {
+            threads.emplace_back(worker);
+        }
+
+        worker();
+
+        for (std::thread & thread : threads) {
+            thread.join();
+        }
+
+        for (size_t i = 0; i < scanned.size(); ++i) {
+            if (!valid[i]) {
+                continue;
+            }
+
+            auto it = std::find_if(_entries.begin(), _entries.end(),
+                                   [&](const p7CatalogEntry & entry) {
+                                       return entry.fileName
+                                               == scanned[i].fileName;
+                                   });
+            if (it != _entries.end()) {
+                *it = std::move(scanned[i]);
+            } else {
+                _entries.push_back(std::move(scanned[i]));
+            }
+        }
+
+        return toScan.size();
+    }
+
+    const std::vector<p7CatalogEntry> & entries() const
+    {
+        return _entries;
+    }
+
+    // Entry of the file if the file hasn't changed since it was scanned
+    // (same size and modification time), nullptr otherwise
+    const p7CatalogEntry * find(const QString & fileName) const
+    {
+        const QFileInfo info(fileName);
+        const QString path = info.absoluteFilePath();
+
+        for (const p7CatalogEntry & entry : _entries) {
+            if (entry.fileName == path) {
+                const bool current
+                        =  (entry.fileSize == (uint64_t)info.size())
+                        && (entry.modified
+                                == info.lastModified().toMSecsSinceEpoch());
+                return current ? &entry : nullptr;
+            }
+        }
+
+        return nullptr;
+    }
+
+    // Entries matching query in catalog order; a dump matches the time
+    // window if its time range intersects it and the level if it has
+    // such rows anywhere
+    std::vector<const p7CatalogEntry *> query(const p7CatalogQuery & query) const
+    {
+        std::vector<const p7CatalogEntry *> found;
+
+        for (const p7CatalogEntry & entry : _entries) {
+            if (    (!query.hostName.isEmpty())
+                 && (query.hostName.compare(entry.hostName,
+                                            Qt::CaseInsensitive) != 0)
+               )
+            {
+                continue;
+            }
+            if (    (!query.processName.isEmpty())
+                 && (query.processName.compare(entry.processName,
+                                               Qt::CaseInsensitive) != 0)
+               )
+            {
+                continue;
+            }
+            if (    (!entry.rows)
+                 || (entry.toTime < query.fromTime)
+                 || (query.toTime && entry.fromTime >= query.toTime)
+               )
+            {
+                continue;
+            }
+            if (    (query.minLevel > EP7TRACE_LEVEL_TRACE)
+                 && (!entry.rowsAtOrAbove(query.minLevel))
+               )
+            {
+                continue;
+            }
+
+            found.push_back(&entry);
+        }
+
+        return found;
+    }
+
+    // Time indexes of an entry for p7DumpImporter::importTimeRange(),
+    // read from the catalog file unless the entry was scanned since
+    std::vector<p7ChannelTimeIndex> timeIndexes(const p7CatalogEntry & entry) const
+    {
+        if (!entry.indexes.empty() || !entry.indexSize || _fileName.isEmpty()) {
+            return entry.indexes;
+        }
+
+        std::vector<p7ChannelTimeIndex> indexes;
+
+        FILE * file = fopen(_fileName.toStdString().c_str(), "rb");
+        if (!file) {
+            return indexes;
+        }
+
+        // the file may have changed since load() checked the range
+        const uint64_t size = fileSize(file);
+        std::vector<uint8_t> bytes;
+        bool ok =   (entry.indexSize <= size)
+                 && (entry.indexOffset <= size - entry.indexSize);
+        if (ok) {
+            bytes.resize((size_t)entry.indexSize);
+            ok =   (seekFile(file, (int64_t)entry.indexOffset))
+                && (fread(bytes.data(), 1, bytes.size(), file)
+                       == bytes.size());
+        }
+        fclose(file);
+
+        Reader reader(bytes);
+        if (!ok || !readIndexes(reader, indexes)) {
+            indexes.clear();
+        }
+
+        return indexes;
+    }
+
+    // Header-only scan of a dump file into entry (see p7DumpScanner),
+    // false if the file can't be read or isn't a dump. Channels, chunks
+    // and rows are walked the way p7DumpImporter does, so the time index
+    // is the one an unfiltered import of the file builds.
+    static bool scanDump(const QString & fileName, p7CatalogEntry & entry)
+    {
+        const QFileInfo info(fileName);
+        entry = p7CatalogEntry();
+        entry.fileName = info.absoluteFilePath();
+        entry.fileSize = (uint64_t)info.size();
+        entry.modified = info.lastModified().toMSecsSinceEpoch();
+
+        // rows of every channel, trace channels get a time index
+        struct Visitor
+        {
+            explicit Visitor(p7CatalogEntry & entry)
+                : entry(entry)
+                , indexes(USER_PACKET_CHANNEL_ID_MAX_SIZE)
+                , rows(USER_PACKET_CHANNEL_ID_MAX_SIZE, 0)
+                , trace(USER_PACKET_CHANNEL_ID_MAX_SIZE, 0)
+            {}
+
+            void data(uint8_t channelId,
+                      const sP7Trace_Data * packet,
+                      uint64_t time,
+                      uint64_t chunkOffset)
+            {
+                indexes[channelId].addRow(rows[channelId]++, time, chunkOffset);
+                if (packet->bLevel < EP7TRACE_LEVEL_COUNT) {
+                    entry.levelRows[packet->bLevel]++;
+                }
+                if (time != UINT64_MAX) {
+                    entry.fromTime = (std::min)(entry.fromTime, time);
+                    entry.toTime = (std::max)(entry.toTime, time);
+                }
+            }
+
+            void packet(uint8_t, const sP7Ext_Header *)
+            {}
+
+            void chunk(uint8_t channelId,
+                       uint64_t offset,
+                       uint64_t end,
+                       bool metadata)
+            {
+                trace[channelId] = 1;
+                indexes[channelId].addChunk(offset, end, metadata);
+            }
+
+            p7CatalogEntry & entry;
+            std::vector<p7TimeIndex> indexes;
+            std::vector<uint64_t> rows;
+            std::vector<char> trace;
+        };
+
+        entry.fromTime = UINT64_MAX;
+        entry.toTime = 0;
+
+        sP7File_Header header;
+        Visitor visitor(entry);
+        if (!p7DumpScanner::scan(fileName.toStdString(), header, visitor)) {
+            return false;
+        }
+
+        entry.hostName = QString::fromUtf16((const char16_t *)header.pHost_Name);
+        entry.processName
+                = QString::fromUtf16((const char16_t *)header.pProcess_Name);
+        entry.processId = header.dwProcess_ID;
+        entry.processStartTime
+                = ((uint64_t)(header.dwProcess_Start_Time_Hi) << 32)
+                + (uint64_t)header.dwProcess_Start_Time_Lo;
+
+        for (size_t i = 0; i < visitor.trace.size(); ++i) {
+            if (!visitor.trace[i]) {
+                continue;
+            }
+            entry.rows += visitor.rows[i];
+
+            p7ChannelTimeIndex channel;
+            channel.channelId = (uint8_t)i;
+            channel.index = std::move(visitor.indexes[i]);
+            entry.indexes.push_back(std::move(channel));
+        }
+
+        if (entry.fromTime > entry.toTime) {
+            entry.fromTime = entry.toTime = 0;
+        }
+
+        return true;
+    }
+
+    // Keyword filters of the blocks of a scanned entry: the dump is
+    // decoded part by part (words are those of formatted messages) and
+    // the words of rows of every block are added to its filter. False if
+    // the file can't be decoded.
+    static bool indexKeywords(const QString & fileName, p7CatalogEntry & entry)
+    {
+        std::vector<p7ChannelTimeIndex> & indexes = entry.indexes;
+
+        // block of every channel which gets words now and its words
+        struct Block
+        {
+            size_t index = SIZE_MAX;
+            bool open = false;
+            std::vector<uint64_t> words;
+        };
+        std::vector<Block> blocks(indexes.size());
+
+        for (p7ChannelTimeIndex & channel : indexes) {
+            channel.keywords.assign(channel.index.blocks().size(),
+                                    p7KeywordFilter());
+        }
+
+        auto finishBlock = [&indexes, &blocks](size_t channel) {
+            Block & block = blocks[channel];
+            if (!block.open) {
+                return;
+            }
+
+            std::sort(block.words.begin(), block.words.end());
+            block.words.erase(std::unique(block.words.begin(),
+                                          block.words.end()),
+                              block.words.end());
+
+            p7KeywordFilter filter(block.words.size());
+            for (uint64_t word : block.words) {
+                filter.add(word);
+            }
+            indexes[channel].keywords[block.index] = std::move(filter);
+
+            block.words.clear();
+            block.open = false;
+        };
+
+        const std::string name = fileName.toStdString();
+        p7DumpImporter importer;
+        p7DumpData data;
+        uint64_t pending = UINT64_MAX;
+
+        for (;;) {
+            if (!importer.importAppended(name, data, 64 * 1024 * 1024)) {
+                return false;
+            }
+
+            for (size_t i = 0; i < data.streamsCount(); ++i) {
+                const p7StreamData & stream = data.stream(i);
+                auto found = std::find_if(
+                            indexes.begin(), indexes.end(),
+                            [&stream](const p7ChannelTimeIndex & channel) {
+                                return channel.channelId == stream.channelId();
+                            });
+                if (found == indexes.end()) {
+                    continue;
+                }
+
+                const size_t channel = found - indexes.begin();
+                const std::deque<p7TimeBlock> & timeBlocks
+                        = found->index.blocks();
+                Block & block = blocks[channel];
+
+                for (size_t row = 0; row < stream.traceDataCount(); ++row) {
+                    const uint64_t number = stream.firstRowNumber() + row;
+
+                    // rows come in order, blocks are found by moving on
+                    if (    (block.index == SIZE_MAX)
+                         || (number >= timeBlocks[block.index].firstRow
+                                       + timeBlocks[block.index].rows)
+                       )
+                    {
+                        finishBlock(channel);
+                        size_t next = block.index == SIZE_MAX
+                                ? 0
+                                : block.index + 1;
+                        while (    (next < timeBlocks.size())
+                                && (timeBlocks[next].firstRow
+                                        + timeBlocks[next].rows <= number)
+                              )
+                        {
+                            ++next;
+                        }
+                        if (next == timeBlocks.size()) {
+                            break;
+                        }
+                        block.index = next;
+                        block.open = true;
+                    }
+
+                    const QByteArray message
+                            = stream.traceDataAt(row).message.toUtf8();
+                    p7Keywords::forEachWord(message.constData(),
+                                            (size_t)message.size(),
+                                            [&block](uint64_t word) {
+                                                block.words.push_back(word);
+                                            });
+                }
+            }
+
+            data.dropOldestRows(data.traceDataCount());
+
+            // the rest is an incomplete chunk if nothing more was read
+            const uint64_t left = importer.pendingBytes();
+            if (!left || left == pending) {
+                break;
+            }
+            pending = left;
+        }
+
+        for (size_t channel = 0; channel < blocks.size(); ++channel) {
+            finishBlock(channel);
+        }
+
+        entry.keywordIndex = true;
+        return true;
+    }
+
+private:
+
+    static constexpr uint64_t catalogMarker()
+    {
+        return 0x474C544143443750ULL; // "P7DCATLG"
+    }
+
+    static constexpr uint32_t catalogVersion()
+    {
+        return 2;
+    }
+
+    // marker, version, count and size of summaries
+    static constexpr uint64_t headerSize()
+    {
+        return sizeof(uint64_t) + 2 * sizeof(uint32_t) + sizeof(uint64_t);
+    }
+
+    // Little endian, as the dumps themselves
+    struct Writer
+    {
+        explicit Writer(std::vector<uint8_t> & bytes)
+            : bytes(bytes)
+        {}
+
+        template<typename T>
+        void value(T value)
+        {
+            const uint8_t * data = (const uint8_t *)&value;
+            bytes.insert(bytes.end(), data, data + sizeof(T));
+        }
+
+        void string(const QString & text)
+        {
+            const std::string utf8 = text.toStdString();
+            value((uint32_t)utf8.size());
+            bytes.insert(bytes.end(), utf8.begin(), utf8.end());
+        }
+
+        std::vector<uint8_t> & bytes;
+    };
+
+    struct Reader
+    {
+        explicit Reader(const std::vector<uint8_t> & bytes)
+            : bytes(bytes)
+        {}
+
+        template<typename T>
+        bool value(T & value)
+        {
+            if (bytes.size() - offset < sizeof(T)) {
+                return false;
+            }
+            memcpy(&value, bytes.data() + offset, sizeof(T));
+            offset += sizeof(T);
+            return true;
+        }
+
+        bool string(QString & text)
+        {
+            uint32_t size = 0;
+            if (!value(size) || bytes.size() - offset < size) {
+                return false;
+            }
+            text = QString::fromUtf8((const char *)bytes.data() + offset,
+                                     (int)size);
+            offset += size;
+            return true;
+        }
+
+        const std::vector<uint8_t> & bytes;
+        size_t offset = 0;
+    };
+
+    static void writeSummary(Writer & writer,
+                             const p7CatalogEntry & entry,
+                             uint64_t indexOffset)
+    {
+        writer.string(entry.fileName);
+        writer.value(entry.fileSize);
+        writer.value(entry.modified);
+        writer.string(entry.hostName);
+        writer.string(entry.processName);
+        writer.value(entry.processId);
+        writer.value(entry.processStartTime);
+        writer.value(entry.fromTime);
+        writer.value(entry.toTime);
+        writer.value(entry.rows);
+        for (uint64_t rows : entry.levelRows) {
+            writer.value(rows);
+        }
+        writer.value(indexOffset);
+        writer.value(entry.indexSize);
+        writer.value((uint8_t)entry.keywordIndex);
+    }
+
+    // index offsets are relative to the end of summaries in the file
+    static bool readSummary(Reader & reader, p7CatalogEntry & entry)
+    {
+        bool ok =   reader.string(entry.fileName)
+                 && reader.value(entry.fileSize)
+                 && reader.value(entry.modified)
+                 && reader.string(entry.hostName)
+                 && reader.string(entry.processName)
+                 && reader.value(entry.processId)
+                 && reader.value(entry.processStartTime)
+                 && reader.value(entry.fromTime)
+                 && reader.value(entry.toTime)
+                 && reader.value(entry.rows);
+        for (uint64_t & rows : entry.levelRows) {
+            ok = ok && reader.value(rows);
+        }
+        uint8_t keywordIndex = 0;
+        ok = ok && reader.value(entry.indexOffset)
+                && reader.value(entry.indexSize)
+                && reader.value(keywordIndex);
+        entry.keywordIndex = keywordIndex != 0;
+
+        const uint64_t base = headerSize() + reader.bytes.size();
+        ok = ok && (entry.indexOffset <= UINT64_MAX - base);
+        entry.indexOffset += base;
+        return ok;
+    }
+
+    static void writeIndexes(Writer & writer,
+                             const std::vector<p7ChannelTimeIndex> & indexes)
+    {
+        writer.value((uint32_t)indexes.size());
+        for (const p7ChannelTimeIndex & channel : indexes) {
+            writer.value(channel.channelId);
+            writer.value((uint32_t)channel.index.blocks().size());
+            for (const p7TimeBlock & block : channel.index.blocks()) {
+                writer.value(block.firstRow);
+                writer.value(block.rows);
+                writer.value((uint8_t)block.metadata);
+                writer.value(block.minTime);
+                writer.value(block.maxTime);
+                writer.value(block.fileOffset);
+                writer.value(block.fileEnd);
+            }
+
+            writer.value((uint32_t)channel.keywords.size());
+            for (const p7KeywordFilter & filter : channel.keywords) {
+                writer.value((uint32_t)filter.bits().size());
+                for (uint64_t bits : filter.bits()) {
+                    writer.value(bits);
+                }
+            }
+        }
+    }
+
+    static bool readIndexes(Reader & reader,
+                            std::vector<p7ChannelTimeIndex> & indexes)
+    {
+        uint32_t count = 0;
+        if (!reader.value(count)) {
+            return false;
+        }
+
+        for (uint32_t i = 0; i < count; ++i) {
+            p7ChannelTimeIndex channel;
+            uint32_t blocks = 0;
+            if (!reader.value(channel.channelId) || !reader.value(blocks)) {
+                return false;
+            }
+
+            for (uint32_t j = 0; j < blocks; ++j) {
+                p7TimeBlock block;
+                uint8_t metadata = 0;
+                if (    (!reader.value(block.firstRow))
+                     || (!reader.value(block.rows))
+                     || (!reader.value(metadata))
+                     || (!reader.value(block.minTime))
+                     || (!reader.value(block.maxTime))
+                     || (!reader.value(block.fileOffset))
+                     || (!reader.value(block.fileEnd))
+                   )
+                {
+                    return false;
+                }
+                block.metadata = metadata != 0;
+                channel.index.appendBlock(block);
+            }
+
+            uint32_t filters = 0;
+            if (!reader.value(filters) || (filters && filters != blocks)) {
+                return false;
+            }
+            channel.keywords.resize(filters);
+            for (p7KeywordFilter & filter : channel.keywords) {
+                uint32_t size = 0;
+                if (    (!reader.value(size))
+                     || ((reader.bytes.size() - reader.offset) / 8 < size)
+                   )
+                {
+                    return false;
+                }
+                std::vector<uint64_t> bits(size);
+                for (uint64_t & word : bits) {
+                    reader.value(word);
+                }
+                filter.setBits(std::move(bits));
+            }
+
+            indexes.push_back(std::move(channel));
+        }
+
+        return true;
+    }
+
+    std::vector<p7CatalogEntry> _entries;
+    QString _fileName; // the file loaded or saved last, for time indexes
+};
+
+}
+
+#endif // P7_DUMP_CATALOG_H
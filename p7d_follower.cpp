@@ -0,0 +1,402 @@
+#include "p7d_follower.h"
+
+#include <QFileInfo>
+
+namespace p7 {
+
+namespace {
+
+// rows are inserted at most this often, a busy writer may append
+// thousands of packets per second
+const int batchIntervalMs = 100;
+const int pollIntervalMs = 1000;
+const int progressIntervalMs = 200;
+
+// rows of a file being loaded are given to the model per batch
+const size_t loadBatchBytes = 4 * 1024 * 1024;
+
+}
+
+P7DumpFollower::P7DumpFollower(P7DumpModel * model, QObject *parent)
+    : QObject(parent)
+    , _model(model)
+{
+    _batchTimer.setSingleShot(true);
+    _batchTimer.setInterval(batchIntervalMs);
+    connect(&_batchTimer, &QTimer::timeout,
+            this, &P7DumpFollower::readAppended);
+
+    _pollTimer.setInterval(pollIntervalMs);
+    connect(&_pollTimer, &QTimer::timeout,
+            this, &P7DumpFollower::onFileChanged);
+
+    _progressTimer.setInterval(progressIntervalMs);
+    connect(&_progressTimer, &QTimer::timeout,
+            this, &P7DumpFollower::onProgressTimer);
+
+    connect(&_watcher, &QFileSystemWatcher::fileChanged,
+            this, &P7DumpFollower::onFileChanged);
+}
+
+P7DumpFollower::~P7DumpFollower()
+{
+    stopLoading();
+}
+
+void P7DumpFollower::open(const QString & fileName)
+{
+    open(QStringList(fileName));
+}
+
+void P7DumpFollower::open(const QStringList & fileNames)
+{
+    const bool following = _following;
+    close();
+
+    _fileNames = fileNames;
+    if (fileNames.size() == 1) {
+        _fileName = fileNames.first();
+        _following = following;
+    }
+    startLoading();
+}
+
+void P7DumpFollower::close()
+{
+    setFollowing(false);
+    stopLoading();
+    _importer.reset();
+    _fileName.clear();
+    _fileNames.clear();
+    _summary = p7DumpSummary();
+}
+
+QString P7DumpFollower::fileName() const
+{
+    return _fileName;
+}
+
+QStringList P7DumpFollower::fileNames() const
+{
+    return _fileNames;
+}
+
+bool P7DumpFollower::isLoading() const
+{
+    return _loadThread.joinable();
+}
+
+bool P7DumpFollower::isFollowing() const
+{
+    return _following;
+}
+
+void P7DumpFollower::setFollowing(bool following)
+{
+    if (_fileName.isEmpty()) {
+        following = false;
+    }
+
+    if (following == _following) {
+        return;
+    }
+
+    _following = following;
+
+    // watching starts once the file is loaded
+    if (isLoading()) {
+        return;
+    }
+
+    if (_following) {
+        startWatching();
+    } else {
+        stopWatching();
+    }
+}
+
+void P7DumpFollower::setCatalog(std::shared_ptr<const p7DumpCatalog> catalog)
+{
+    _catalog = catalog;
+}
+
+const p7DumpSummary & P7DumpFollower::summary() const
+{
+    return _summary;
+}
+
+void P7DumpFollower::startWatching()
+{
+    _watcher.addPath(_fileName);
+    _pollTimer.start();
+    // catch up with what was written since the import
+    _batchTimer.start(0);
+}
+
+void P7DumpFollower::stopWatching()
+{
+    if (!_watcher.files().isEmpty()) {
+        _watcher.removePaths(_watcher.files());
+    }
+    _pollTimer.stop();
+    _batchTimer.stop();
+}
+
+void P7DumpFollower::onFileChanged()
+{
+    if (!_following || isLoading()) {
+        return;
+    }
+
+    // writer may replace the file (rotation), watch the new one
+    if (_watcher.files().isEmpty() && QFileInfo::exists(_fileName)) {
+        _watcher.addPath(_fileName);
+    }
+
+    if (!_batchTimer.isActive()) {
+        _batchTimer.start(batchIntervalMs);
+    }
+}
+
+void P7DumpFollower::readAppended()
+{
+    if (!_following || !_importer || isLoading()) {
+        return;
+    }
+
+    int rows = _model->appendFrom(*_importer, _fileName.toStdString());
+
+    if (rows < 0) {
+        stopWatching();
+        startLoading();
+        return;
+    }
+
+    if (rows > 0) {
+        emit rowsAppended(rows);
+    }
+
+    // importAppended() reads a limited batch, keep the UI responsive
+    // while catching up with a big tail; an incomplete chunk at the end
+    // waits for the next change notification
+    const uint64_t pending = _importer->pendingBytes();
+    if (pending > 0 && pending != _pendingBytes) {
+        _batchTimer.start(0);
+    }
+    _pendingBytes = pending;
+}
+
+void P7DumpFollower::onProgressTimer()
+{
+    if (_importer && _loadThread.joinable()) {
+        emit loadingProgress((int)(_importer->progress() * 100.0));
+    }
+}
+
+void P7DumpFollower::startLoading()
+{
+    stopLoading();
+
+    _importer.reset(new p7DumpImporter());
+    _importer->setFilter(_model->importFilter());
+    _importer->setBurstSettings(_model->burstSettings());
+    _pendingBytes = 0;
+
+    std::vector<std::string> fileNames;
+    for (const QString & fileName : _fileNames) {
+        fileNames.push_back(fileName.toStdString());
+    }
+    const int generation = ++_loadGeneration;
+
+    // the catalog entry is used while the file is as it was scanned
+    const p7ImportFilter & filter = _model->importFilter();
+    const p7CatalogEntry * entry = (_catalog && filter.skipsBlocks()
+                                    && fileNames.size() == 1)
+            ? _catalog->find(_fileNames.first())
+            : nullptr;
+    std::vector<p7ChannelTimeIndex> indexes;
+    if (entry) {
+        indexes = _catalog->timeIndexes(*entry);
+    }
+
+    std::shared_ptr<p7DumpData> data = std::make_shared<p7DumpData>();
+    p7DumpImporter * importer = _importer.get();
+
+    if (indexes.empty() && fileNames.size() == 1) {
+        _loadingBatches = true;
+        _loadBytes = (uint64_t)QFileInfo(_fileName).size();
+        _importer->setMergeInOrder(true);
+        _model->setDumpData(p7DumpData());
+        _model->setLoading(true);
+
+        const std::string fileName = fileNames.front();
+        _loadThread = std::thread([this, importer, fileName, data,
+                                   generation]() {
+            // batches as in follow mode, from the header on; the model
+            // gets a copy of what every batch added
+            p7BatchCursor shown;
+            uint64_t pending = 0;
+            for (;;) {
+                const bool read = importer->importAppended(fileName, *data,
+                                                           loadBatchBytes);
+
+                // rows of an incomplete chunk at the end wait for
+                // following, a file which can't be read or has shrunk
+                // keeps what was decoded
+                const uint64_t left = read ? importer->pendingBytes() : 0;
+                if (    (left == 0)
+                     || (left == pending)
+                     || (importer->isCancelled())
+                   )
+                {
+                    break;
+                }
+                pending = left;
+
+                std::shared_ptr<p7RowsBatch> batch
+                        = std::make_shared<p7RowsBatch>(
+                            data->rowsSince(shown));
+                QMetaObject::invokeMethod(this, [this, batch, pending,
+                                                 generation]() {
+                    onBatch(batch, pending, generation);
+                }, Qt::QueuedConnection);
+            }
+
+            if (importer->isCancelled()) {
+                return;
+            }
+
+            // rows held back for the merged order, spare capacity of the
+            // blocks is dropped once, as after an import at once
+            importer->setMergeInOrder(false);
+            data->mergeStreams();
+            data->shrinkToFit();
+
+            QMetaObject::invokeMethod(this, [this, data, generation]() {
+                onLoaded(data, generation);
+            }, Qt::QueuedConnection);
+        });
+    } else {
+        // the model keeps showing the previous dump until this one is ready
+        _loadThread = std::thread([this, importer, fileNames, indexes,
+                                   filter, data, generation]() {
+            if (!indexes.empty()) {
+                *data = importer->importTimeRange(fileNames.front(), indexes,
+                                                  filter.fromTime,
+                                                  filter.toTime);
+            } else {
+                *data = importer->importFiles(fileNames);
+            }
+
+            QMetaObject::invokeMethod(this, [this, data, generation]() {
+                onLoaded(data, generation);
+            }, Qt::QueuedConnection);
+        });
+
+        _progressTimer.start();
+    }
+
+    // headers only, much faster than the import running meanwhile
+    _summary = p7DumpSummary();
+    _summaryCancelled = false;
+    std::shared_ptr<p7DumpSummary> summary = std::make_shared<p7DumpSummary>();
+    _summaryThread = std::thread([this, fileNames, summary, generation]() {
+        *summary = p7DumpSummary::scanFiles(fileNames, &_summaryCancelled);
+
+        QMetaObject::invokeMethod(this, [this, summary, generation]() {
+            onSummary(summary, generation);
+        }, Qt::QueuedConnection);
+    });
+
+    emit loadingStarted();
+}
+
+void P7DumpFollower::stopLoading()
+{
+    // the scan stops at its next chunk, its partial summary is dropped
+    // by the generation of its onSummary()
+    if (_summaryThread.joinable()) {
+        _summaryCancelled = true;
+        _summaryThread.join();
+    }
+
+    if (!_loadThread.joinable()) {
+        return;
+    }
+
+    ++_loadGeneration;
+    _importer->cancel();
+    _loadThread.join();
+    _progressTimer.stop();
+    _importer.reset();
+
+    // rows of a file loaded in batches so far stay in the model
+    if (_loadingBatches) {
+        _loadingBatches = false;
+        _model->setLoading(false);
+    }
+}
+
+void P7DumpFollower::onBatch(std::shared_ptr<p7RowsBatch> batch,
+                             uint64_t pending,
+                             int generation)
+{
+    if (generation != _loadGeneration) {
+        return;
+    }
+
+    const bool first = _model->rowCount() == 0;
+    const int rows = _model->appendFrom([batch](p7DumpData & data) {
+        data.appendBatch(std::move(*batch));
+        return true;
+    });
+
+    if (first && rows > 0) {
+        emit opened();
+    } else if (rows > 0) {
+        emit rowsAppended(rows);
+    }
+
+    const uint64_t decoded = _loadBytes > pending ? _loadBytes - pending : 0;
+    emit loadingProgress(_loadBytes
+                         ? (int)(decoded * 100 / _loadBytes)
+                         : 0);
+}
+
+void P7DumpFollower::onLoaded(std::shared_ptr<p7DumpData> data, int generation)
+{
+    if (generation != _loadGeneration) {
+        return;
+    }
+
+    _loadThread.join();
+    _progressTimer.stop();
+
+    if (_loadingBatches) {
+        _loadingBatches = false;
+        _pendingBytes = _importer->pendingBytes();
+        _model->setGrownDumpData(std::move(*data));
+        _model->setLoading(false);
+    } else {
+        _model->setDumpData(std::move(*data));
+    }
+    emit opened();
+
+    if (_following) {
+        startWatching();
+    }
+}
+
+void P7DumpFollower::onSummary(std::shared_ptr<p7DumpSummary> summary,
+                               int generation)
+{
+    if (generation != _loadGeneration || !_summaryThread.joinable()) {
+        return;
+    }
+
+    _summaryThread.join();
+    _summary = std::move(*summary);
+    emit summaryReady();
+}
+
+}
@@ -0,0 +1,112 @@
+#ifndef P7_DUMP_FOLLOWER
+#define P7_DUMP_FOLLOWER
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <QFileSystemWatcher>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include "p7d_catalog.h"
+#include "p7d_model.h"
+#include "p7d_summary.h"
+
+namespace p7 {
+
+// Opens dump files on a background thread. A single file is decoded in
+// batches (streams of a batch in parallel, see p7DumpImporter::readData())
+// whose rows are copied to the model as they come, the model gets the
+// decoded dump in their place at the end (P7DumpModel::setGrownDumpData()).
+// Several files and catalog time windows are decoded at once, the model
+// gets the dump once it is ready.
+//
+// Tail mode for a dump which is still being written: the file is watched
+// (inotify on Linux) and appended chunks are decoded into the model in
+// batches, starting from the end of the last complete chunk. A truncated
+// or replaced file is imported anew.
+//
+// A summary of the files made from packet headers only (p7DumpSummary)
+// is ready long before the import, see summaryReady().
+class P7DumpFollower : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    explicit P7DumpFollower(P7DumpModel * model, QObject *parent = nullptr);
+    ~P7DumpFollower() override;
+
+    // Starts import of the whole file, following is kept as it was
+    void open(const QString & fileName);
+    // Several files (rotated dumps) are combined into one dump, they
+    // can't be followed
+    void open(const QStringList & fileNames);
+    void close();
+
+    // The followed file, empty for several files
+    QString fileName() const;
+    QStringList fileNames() const;
+    bool isLoading() const;
+
+    bool isFollowing() const;
+    void setFollowing(bool following);
+
+    // With a time window or keywords in the import filter, files of the
+    // catalog are imported partially: only blocks which may have such
+    // rows are read
+    void setCatalog(std::shared_ptr<const p7DumpCatalog> catalog);
+
+    // Summary of the files being imported or imported last, no files
+    // until summaryReady()
+    const p7DumpSummary & summary() const;
+
+    Q_SIGNAL void loadingStarted();
+    Q_SIGNAL void loadingProgress(int percent);
+    Q_SIGNAL void summaryReady();
+    // the model has got the dump: the first rows of a file loaded in
+    // batches, then again the whole of it
+    Q_SIGNAL void opened();
+    Q_SIGNAL void rowsAppended(int rows);
+
+private:
+
+    Q_SLOT void onFileChanged();
+    Q_SLOT void readAppended();
+    Q_SLOT void onProgressTimer();
+
+    void startLoading();
+    void stopLoading();
+    void onBatch(std::shared_ptr<p7RowsBatch> batch,
+                 uint64_t pending,
+                 int generation);
+    void onLoaded(std::shared_ptr<p7DumpData> data, int generation);
+    void onSummary(std::shared_ptr<p7DumpSummary> summary, int generation);
+    void startWatching();
+    void stopWatching();
+
+    P7DumpModel * _model;
+    std::unique_ptr<p7DumpImporter> _importer;
+    std::shared_ptr<const p7DumpCatalog> _catalog;
+    QString _fileName;
+    QStringList _fileNames;
+    bool _following = false;
+    uint64_t _pendingBytes = 0;
+
+    std::thread _loadThread;
+    bool _loadingBatches = false; // of a single file, see onBatch()
+    uint64_t _loadBytes = 0; // size of the file when loading started
+    std::thread _summaryThread;
+    std::atomic<bool> _summaryCancelled{false};
+    p7DumpSummary _summary;
+    int _loadGeneration = 0; // results of cancelled imports are ignored
+
+    QFileSystemWatcher _watcher;
+    QTimer _batchTimer; // coalesces bursts of change notifications
+    QTimer _pollTimer;  // in case notifications are not supported
+    QTimer _progressTimer;
+};
+
+}
+
+#endif
@@ -0,0 +1,685 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                             /
+// 2022 (c) Ragnar Lodbrok                                                     /
+//                                                                             /
+// This library is free software; you can redistribute it and/or               /
+// modify it under the terms of the GNU Lesser General Public                  /
+// License as published by the Free Software Foundation; either                /
+// version 3.0 of the License, or (at your option) any later version.          /
+//                                                                             /
+// This library is distributed in the hope that it will be useful,             /
+// but WITHOUT ANY WARRANTY; without even the implied warranty of              /
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU           /
+// Lesser General Public License for more details.                             /
+//                                                                             /
+// You should have received a copy of the GNU Lesser General Public            /
+// License along with this library.                                            /
+//                                                                             /
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef P7_DUMP_GENERATOR_H
+#define P7_DUMP_GENERATOR_H
+
+// Synthetic *.p7d writer used for scale testing and benchmarks.
+// Does not depend on Qt, so it can be used from command line tools.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <cmath>
+#include <string>
+#include <vector>
+#include "p7Structs.h"
+
+namespace p7 {
+
+// Kinds of trace arguments the generator puts into descriptions
+enum class p7GenArgKind {
+    Int32 = 0,
+    Int64,
+    Double,
+    Char,
+    Pointer,
+    StringA,    // P7TRACE_ARG_TYPE_STRA
+    StringU8,   // P7TRACE_ARG_TYPE_USTR8
+    StringU16,  // P7TRACE_ARG_TYPE_USTR16
+    Count
+};
+
+enum class p7GenLengthDistribution {
+    Fixed = 0,   // always lengthMin
+    Uniform,     // [lengthMin, lengthMax]
+    Exponential  // lengthMin + exponential variate of mean
+                 // lengthMean - lengthMin, capped by lengthMax
+};
+
+struct p7DumpGeneratorOptions
+{
+    // Rows (data packets) in total over all channels
+    uint64_t rows = 100000;
+    // If not 0, rows are generated until the file reaches this size
+    uint64_t targetBytes = 0;
+
+    uint32_t descriptions = 256;   // per channel
+    uint32_t threads = 8;          // per channel
+    uint32_t modules = 4;          // per channel
+    uint32_t channels = 1;         // trace channels, max 32
+
+    // Argument count per description is [0, maxArgs], kind is chosen
+    // by weights (indexed by p7GenArgKind)
+    uint32_t maxArgs = 4;
+    uint32_t argWeights[static_cast<int>(p7GenArgKind::Count)]
+        = {40, 10, 10, 5, 5, 10, 15, 5};
+
+    // Weights of trace levels (indexed by eP7Trace_Level)
+    uint32_t levelWeights[EP7TRACE_LEVEL_COUNT] = {10, 30, 40, 12, 6, 2};
+
+    // Length of the format text and of each string argument
+    p7GenLengthDistribution lengthDistribution
+        = p7GenLengthDistribution::Exponential;
+    uint32_t lengthMin = 8;
+    uint32_t lengthMean = 48;
+    uint32_t lengthMax = 1024;
+
+    // Timer ticks per second and mean ticks between two rows
+    uint64_t timerFrequency = 10000000ull;
+    uint64_t timerStepMean = 2000ull;
+
+    // Max size of one sH_User_Data chunk
+    uint32_t chunkSize = 64 * 1024;
+
+    // Gaps of 1..16 sequence numbers per 1000 rows, as a client which
+    // drops traces under load leaves
+    uint32_t dropsPerMille = 0;
+
+    uint64_t seed = 1;
+
+    std::string hostName = "p7dgen-host";
+    std::string processName = "p7dgen";
+};
+
+// xorshift64*, we don't use <random> distributions as their output
+// differs between standard libraries and files must be reproducible
+class p7GenRandom
+{
+public:
+
+    explicit p7GenRandom(uint64_t seed)
+        : _state(seed ? seed : 0x9E3779B97F4A7C15ull)
+    {}
+
+    uint64_t next()
+    {
+        _state ^= _state >> 12;
+        _state ^= _state << 25;
+        _state ^= _state >> 27;
+        return _state * 0x2545F4914F6CDD1Dull;
+    }
+
+    // [0, n)
+    uint32_t below(uint32_t n)
+    {
+        return n ? (uint32_t)(next() % n) : 0;
+    }
+
+    // [0, 1)
+    double unit()
+    {
+        return (double)(next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    template<size_t N>
+    uint32_t weighted(const uint32_t (&weights)[N])
+    {
+        uint64_t total = 0;
+        for (size_t i = 0; i < N; ++i) {
+            total += weights[i];
+        }
+        if (!total) {
+            return 0;
+        }
+
+        uint64_t value = next() % total;
+        for (size_t i = 0; i < N; ++i) {
+            if (value < weights[i]) {
+                return (uint32_t)i;
+            }
+            value -= weights[i];
+        }
+        return (uint32_t)(N - 1);
+    }
+
+private:
+    uint64_t _state;
+};
+
+class p7DumpGenerator
+{
+public:
+
+    explicit p7DumpGenerator(const p7DumpGeneratorOptions & options)
+        : _options(options)
+        , _random(options.seed)
+    {
+        if (_options.channels < 1) {
+            _options.channels = 1;
+        }
+        if (_options.channels > USER_PACKET_CHANNEL_ID_MAX_SIZE) {
+            _options.channels = USER_PACKET_CHANNEL_ID_MAX_SIZE;
+        }
+        if (_options.descriptions < 1) {
+            _options.descriptions = 1;
+        }
+        if (_options.threads < 1) {
+            _options.threads = 1;
+        }
+        if (_options.modules < 1) {
+            _options.modules = 1;
+        }
+        if (_options.lengthMax < _options.lengthMin) {
+            _options.lengthMax = _options.lengthMin;
+        }
+        if (_options.chunkSize < 4096) {
+            _options.chunkSize = 4096;
+        }
+    }
+
+    bool generate(const std::string & fileName)
+    {
+        FILE * file = fopen(fileName.c_str(), "wb");
+        if (!file) {
+            return false;
+        }
+
+        bool res = generate(file);
+
+        if (fclose(file) != 0) {
+            res = false;
+        }
+
+        return res;
+    }
+
+    bool generate(FILE * file)
+    {
+        _file = file;
+        _bytesWritten = 0;
+        _rowsWritten = 0;
+        _sequenceGaps = 0;
+        _sequencesDropped = 0;
+        _failed = false;
+
+        writeFileHeader();
+
+        _channels.clear();
+        _channels.resize(_options.channels);
+
+        for (uint32_t i = 0; i < _options.channels; ++i) {
+            initChannel(i);
+        }
+
+        uint64_t row = 0;
+        while (!_failed) {
+            if (_options.targetBytes) {
+                if (_bytesWritten + pendingBytes() >= _options.targetBytes) {
+                    break;
+                }
+            } else if (row >= _options.rows) {
+                break;
+            }
+
+            writeDataPacket((uint32_t)(row % _options.channels));
+            ++row;
+        }
+
+        for (uint32_t i = 0; i < _options.channels; ++i) {
+            writeClosePacket(i);
+            flushChunk(i);
+        }
+
+        _file = nullptr;
+
+        return !_failed;
+    }
+
+    uint64_t bytesWritten() const
+    {
+        return _bytesWritten;
+    }
+
+    uint64_t rowsWritten() const
+    {
+        return _rowsWritten;
+    }
+
+    // Gaps of dropsPerMille after the first row of a channel and the
+    // numbers skipped by them, what p7SequenceCheck finds missing
+    uint64_t sequenceGaps() const
+    {
+        return _sequenceGaps;
+    }
+
+    uint64_t sequencesDropped() const
+    {
+        return _sequencesDropped;
+    }
+
+    const p7DumpGeneratorOptions & options() const
+    {
+        return _options;
+    }
+
+    // Fixed process start time: 2022-01-01 00:00:00 UTC in 100ns since 1601
+    static constexpr uint64_t startTime100Ns()
+    {
+        return 132854688000000000ull;
+    }
+
+private:
+
+    struct Description
+    {
+        uint16_t id = 0;
+        uint16_t moduleId = 0;
+        uint8_t level = 0;
+        std::vector<p7GenArgKind> args;
+        bool sent = false;
+    };
+
+    struct Channel
+    {
+        std::vector<uint8_t> chunk;
+        std::vector<Description> descriptions;
+        std::vector<uint32_t> threadIds;
+        uint64_t timer = 0;
+        uint32_t sequence = 0;
+    };
+
+    void write(const void * data, size_t size)
+    {
+        if (_failed) {
+            return;
+        }
+        if (fwrite(data, 1, size, _file) != size) {
+            _failed = true;
+            return;
+        }
+        _bytesWritten += size;
+    }
+
+    uint64_t pendingBytes() const
+    {
+        uint64_t size = 0;
+        for (const Channel & channel : _channels) {
+            size += channel.chunk.size();
+        }
+        return size;
+    }
+
+    static void putUtf16(std::vector<uint8_t> & out, const std::string & text)
+    {
+        for (char c : text) {
+            uint16_t ch = (uint8_t)c;
+            out.push_back(ch & 0xFF);
+            out.push_back(ch >> 8);
+        }
+        out.push_back(0);
+        out.push_back(0);
+    }
+
+    static void putUtf8(std::vector<uint8_t> & out, const std::string & text)
+    {
+        out.insert(out.end(), text.begin(), text.end());
+        out.push_back(0);
+    }
+
+    template<typename T>
+    static void putValue(std::vector<uint8_t> & out, T value)
+    {
+        const uint8_t * bytes = (const uint8_t *)&value;
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    static sP7Ext_Header extHeader(uint32_t type, uint32_t subType,
+                                   size_t size)
+    {
+        sP7Ext_Header header;
+        header.dwType = type;
+        header.dwSubType = subType;
+        header.dwSize = (uint32_t)size;
+        return header;
+    }
+
+    uint32_t randomLength()
+    {
+        const p7DumpGeneratorOptions & o = _options;
+
+        switch (o.lengthDistribution) {
+        case p7GenLengthDistribution::Fixed:
+            return o.lengthMin;
+        case p7GenLengthDistribution::Uniform:
+            return o.lengthMin + _random.below(o.lengthMax - o.lengthMin + 1);
+        case p7GenLengthDistribution::Exponential:
+        default: {
+                double mean = (double)(o.lengthMean > o.lengthMin
+                                       ? o.lengthMean - o.lengthMin : 1);
+                double value = -mean * std::log(1.0 - _random.unit());
+                uint64_t length = o.lengthMin + (uint64_t)value;
+                return (uint32_t)(length > o.lengthMax ? o.lengthMax : length);
+            }
+        }
+    }
+
+    std::string randomText(uint32_t length)
+    {
+        static const char * words[] = {
+            "request", "socket", "buffer", "client", "timeout", "queue",
+            "session", "worker", "index", "cache", "flush", "commit",
+            "packet", "stream", "reply", "module", "value", "state"
+        };
+        const uint32_t wordsCount = sizeof(words) / sizeof(words[0]);
+
+        std::string text;
+        text.reserve(length + 16);
+
+        while (text.size() < length) {
+            if (!text.empty()) {
+                text += ' ';
+            }
+            text += words[_random.below(wordsCount)];
+        }
+        text.resize(length);
+
+        return text;
+    }
+
+    void writeFileHeader()
+    {
+        sP7File_Header header;
+        memset(&header, 0, sizeof(header));
+
+        header.qwMarker = P7_DAMP_FILE_MARKER_V1;
+        header.dwProcess_ID = 4242;
+        header.dwProcess_Start_Time_Hi = (uint32_t)(startTime100Ns() >> 32);
+        header.dwProcess_Start_Time_Lo = (uint32_t)(startTime100Ns());
+
+        for (size_t i = 0; i < _options.processName.size()
+                            && i + 1 < P7_DAMP_FILE_PROCESS_LENGTH; ++i) {
+            header.pProcess_Name[i] = (uint8_t)_options.processName[i];
+        }
+        for (size_t i = 0; i < _options.hostName.size()
+                            && i + 1 < P7_DAMP_FILE_HOST_LENGTH; ++i) {
+            header.pHost_Name[i] = (uint8_t)_options.hostName[i];
+        }
+
+        write(&header, sizeof(header));
+    }
+
+    void appendPacket(uint32_t channelId, const void * packet, size_t size)
+    {
+        Channel & channel = _channels[channelId];
+
+        if (channel.chunk.size() + size > _options.chunkSize) {
+            flushChunk(channelId);
+        }
+
+        if (channel.chunk.empty()) {
+            channel.chunk.resize(sizeof(sH_User_Data));
+        }
+
+        const uint8_t * bytes = (const uint8_t *)packet;
+        channel.chunk.insert(channel.chunk.end(), bytes, bytes + size);
+    }
+
+    void flushChunk(uint32_t channelId)
+    {
+        Channel & channel = _channels[channelId];
+
+        if (channel.chunk.size() <= sizeof(sH_User_Data)) {
+            channel.chunk.clear();
+            return;
+        }
+
+        sH_User_Data header;
+        header.dwSize = (uint32_t)channel.chunk.size();
+        header.dwChannel_ID = channelId;
+        memcpy(channel.chunk.data(), &header, sizeof(header));
+
+        write(channel.chunk.data(), channel.chunk.size());
+        channel.chunk.clear();
+    }
+
+    void initChannel(uint32_t channelId)
+    {
+        Channel & channel = _channels[channelId];
+
+        // Info packet must be the first one in the stream
+        sP7Trace_Info info;
+        memset(&info, 0, sizeof(info));
+        info.sCommon = extHeader(EP7USER_TYPE_TRACE, EP7TRACE_TYPE_INFO,
+                                 sizeof(info));
+        info.dwTime_Hi = (uint32_t)(startTime100Ns() >> 32);
+        info.dwTime_Lo = (uint32_t)(startTime100Ns());
+        info.qwTimer_Value = 1000000ull * (channelId + 1);
+        info.qwTimer_Frequency = _options.timerFrequency;
+        std::string name = "Trace" + std::to_string(channelId);
+        for (size_t i = 0; i < name.size(); ++i) {
+            info.pName[i] = (uint8_t)name[i];
+        }
+        appendPacket(channelId, &info, sizeof(info));
+
+        channel.timer = info.qwTimer_Value;
+
+        for (uint32_t i = 0; i < _options.modules; ++i) {
+            sP7Trace_Module module;
+            memset(&module, 0, sizeof(module));
+            module.sCommon = extHeader(EP7USER_TYPE_TRACE,
+                                       EP7TRACE_TYPE_MODULE, sizeof(module));
+            module.wModuleID = (uint16_t)i;
+            module.eVerbosity = EP7TRACE_LEVEL_TRACE;
+            snprintf((char *)module.pName, sizeof(module.pName),
+                     "Module%u", i);
+            appendPacket(channelId, &module, sizeof(module));
+        }
+
+        for (uint32_t i = 0; i < _options.threads; ++i) {
+            uint32_t threadId = 0x1000 + channelId * 0x10000 + i;
+
+            sP7Trace_Thread_Start thread;
+            memset(&thread, 0, sizeof(thread));
+            thread.sCommon = extHeader(EP7USER_TYPE_TRACE,
+                                       EP7TRACE_TYPE_THREAD_START,
+                                       sizeof(thread));
+            thread.dwThreadID = threadId;
+            thread.qwTimer = channel.timer;
+            snprintf((char *)thread.pName, sizeof(thread.pName),
+                     "Worker%u", i);
+            appendPacket(channelId, &thread, sizeof(thread));
+
+            channel.threadIds.push_back(threadId);
+        }
+
+        channel.descriptions.resize(_options.descriptions);
+        for (uint32_t i = 0; i < _options.descriptions; ++i) {
+            Description & desc = channel.descriptions[i];
+            desc.id = (uint16_t)i;
+            desc.moduleId = (uint16_t)_random.below(_options.modules);
+            desc.level = (uint8_t)_random.weighted(_options.levelWeights);
+
+            uint32_t argsCount = _random.below(_options.maxArgs + 1);
+            for (uint32_t a = 0; a < argsCount; ++a) {
+                desc.args.push_back(
+                    (p7GenArgKind)_random.weighted(_options.argWeights));
+            }
+        }
+    }
+
+    static sP7Trace_Arg argInfo(p7GenArgKind kind)
+    {
+        switch (kind) {
+        case p7GenArgKind::Int32:     return {P7TRACE_ARG_TYPE_INT32, 4};
+        case p7GenArgKind::Int64:     return {P7TRACE_ARG_TYPE_INT64, 8};
+        case p7GenArgKind::Double:    return {P7TRACE_ARG_TYPE_DOUBLE, 8};
+        case p7GenArgKind::Char:      return {P7TRACE_ARG_TYPE_CHAR, 4};
+        case p7GenArgKind::Pointer:   return {P7TRACE_ARG_TYPE_PVOID, 8};
+        case p7GenArgKind::StringA:   return {P7TRACE_ARG_TYPE_STRA, 0};
+        case p7GenArgKind::StringU8:  return {P7TRACE_ARG_TYPE_USTR8, 0};
+        case p7GenArgKind::StringU16: return {P7TRACE_ARG_TYPE_USTR16, 0};
+        default:                      return {P7TRACE_ARG_TYPE_UNK, 0};
+        }
+    }
+
+    static const char * argSpecifier(p7GenArgKind kind)
+    {
+        switch (kind) {
+        case p7GenArgKind::Int32:     return "%d";
+        case p7GenArgKind::Int64:     return "%lld";
+        case p7GenArgKind::Double:    return "%.3f";
+        case p7GenArgKind::Char:      return "%c";
+        case p7GenArgKind::Pointer:   return "%p";
+        case p7GenArgKind::StringA:   return "%hs";
+        case p7GenArgKind::StringU8:  return "%s";
+        case p7GenArgKind::StringU16: return "%ls";
+        default:                      return "";
+        }
+    }
+
+    void writeDescPacket(uint32_t channelId, Description & desc)
+    {
+        std::vector<uint8_t> packet(sizeof(sP7Trace_Format));
+
+        for (p7GenArgKind kind : desc.args) {
+            sP7Trace_Arg arg = argInfo(kind);
+            packet.push_back(arg.bType);
+            packet.push_back(arg.bSize);
+        }
+
+        std::string format = randomText(randomLength());
+        for (p7GenArgKind kind : desc.args) {
+            format += " ";
+            format += argSpecifier(kind);
+        }
+        putUtf16(packet, format);
+
+        char path[64];
+        snprintf(path, sizeof(path), "/src/module%u/source%u.cpp",
+                 desc.moduleId, desc.id % 97);
+        putUtf8(packet, path);
+
+        char function[64];
+        snprintf(function, sizeof(function), "Function%u", desc.id);
+        putUtf8(packet, function);
+
+        sP7Trace_Format * header = (sP7Trace_Format *)packet.data();
+        memset(header, 0, sizeof(sP7Trace_Format));
+        header->sCommon = extHeader(EP7USER_TYPE_TRACE, EP7TRACE_TYPE_DESC,
+                                    packet.size());
+        header->wID = desc.id;
+        header->wLine = (uint16_t)(10 + desc.id % 5000);
+        header->wModuleID = desc.moduleId;
+        header->wArgs_Len = (uint16_t)desc.args.size();
+
+        appendPacket(channelId, packet.data(), packet.size());
+
+        desc.sent = true;
+    }
+
+    void writeDataPacket(uint32_t channelId)
+    {
+        Channel & channel = _channels[channelId];
+
+        Description & desc
+            = channel.descriptions[_random.below(_options.descriptions)];
+
+        // Descriptions are sent right before the first usage, as P7 does
+        if (!desc.sent) {
+            writeDescPacket(channelId, desc);
+        }
+
+        _packet.resize(sizeof(sP7Trace_Data));
+
+        for (p7GenArgKind kind : desc.args) {
+            switch (kind) {
+            case p7GenArgKind::Int32:
+                putValue<int32_t>(_packet, (int32_t)_random.next());
+                break;
+            case p7GenArgKind::Int64:
+                putValue<int64_t>(_packet, (int64_t)_random.next());
+                break;
+            case p7GenArgKind::Double:
+                putValue<double>(_packet, _random.unit() * 1000.0);
+                break;
+            case p7GenArgKind::Char:
+                putValue<int32_t>(_packet, 'a' + (int32_t)_random.below(26));
+                break;
+            case p7GenArgKind::Pointer:
+                putValue<uint64_t>(_packet, _random.next() & ~0x7ull);
+                break;
+            case p7GenArgKind::StringA:
+            case p7GenArgKind::StringU8:
+                putUtf8(_packet, randomText(randomLength()));
+                break;
+            case p7GenArgKind::StringU16:
+                putUtf16(_packet, randomText(randomLength()));
+                break;
+            default:
+                break;
+            }
+        }
+
+        channel.timer += 1 + _random.below(
+                    (uint32_t)(2 * _options.timerStepMean));
+
+        sP7Trace_Data * header = (sP7Trace_Data *)_packet.data();
+        memset(header, 0, sizeof(sP7Trace_Data));
+        header->sCommon = extHeader(EP7USER_TYPE_TRACE, EP7TRACE_TYPE_DATA,
+                                    _packet.size());
+        header->wID = desc.id;
+        header->bLevel = desc.level;
+        header->bProcessor = (uint8_t)_random.below(8);
+        header->dwThreadID
+            = channel.threadIds[_random.below((uint32_t)channel.threadIds.size())];
+        if (    (_options.dropsPerMille)
+             && (_random.below(1000) < _options.dropsPerMille)
+           )
+        {
+            const uint32_t dropped = 1 + _random.below(16);
+            // numbers before the first row of a channel are not known
+            if (channel.sequence) {
+                ++_sequenceGaps;
+                _sequencesDropped += dropped;
+            }
+            channel.sequence += dropped;
+        }
+        header->dwSequence = channel.sequence++;
+        header->qwTimer = channel.timer;
+
+        appendPacket(channelId, _packet.data(), _packet.size());
+
+        ++_rowsWritten;
+    }
+
+    void writeClosePacket(uint32_t channelId)
+    {
+        sP7Ext_Header close = extHeader(EP7USER_TYPE_TRACE,
+                                        EP7TRACE_TYPE_CLOSE,
+                                        sizeof(sP7Ext_Header));
+        appendPacket(channelId, &close, sizeof(close));
+    }
+
+    p7DumpGeneratorOptions _options;
+    p7GenRandom _random;
+
+    std::vector<Channel> _channels;
+    std::vector<uint8_t> _packet;
+
+    FILE * _file = nullptr;
+    uint64_t _bytesWritten = 0;
+    uint64_t _rowsWritten = 0;
+    uint64_t _sequenceGaps = 0;
+    uint64_t _sequencesDropped = 0;
+    bool _failed = false;
+};
+
+}
+
+#endif // P7_DUMP_GENERATOR_H
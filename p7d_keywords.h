@@ -0,0 +1,214 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                             /
+// 2022 (c) Ragnar Lodbrok                                                     /
+//                                                                             /
+// This library is free software; you can redistribute it and/or               /
+// modify it under the terms of the GNU Lesser General Public                  /
+// License as published by the Free Software Foundation; either                /
+// version 3.0 of the License, or (at your option) any later version.          /
+//                                                                             /
+// This library is distributed in the hope that it will be useful,             /
+// but WITHOUT ANY WARRANTY; without even the implied warranty of              /
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU           /
+// Lesser General Public License for more details.                             /
+//                                                                             /
+// You should have received a copy of the GNU Lesser General Public            /
+// License along with this library.                                            /
+//                                                                             /
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef P7_DUMP_KEYWORDS_H
+#define P7_DUMP_KEYWORDS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace p7 {
+
+// Words of messages, see p7ImportFilter::keywords: runs of ASCII letters,
+// digits, '_' and non-ASCII bytes of UTF-8 text. ASCII letters are
+// case-folded, other characters are compared as they are. Words are
+// handled as 64 bit hashes.
+class p7Keywords
+{
+public:
+
+    // fn(uint64_t hash) for every word of text, repeats included
+    template<typename Fn>
+    static void forEachWord(const char * text, size_t size, Fn fn)
+    {
+        const uint8_t * byte = (const uint8_t *)text;
+        const uint8_t * end = byte + size;
+
+        while (byte < end) {
+            if (!isWordByte(*byte)) {
+                ++byte;
+                continue;
+            }
+
+            // FNV-1a
+            uint64_t hash = 0xCBF29CE484222325ULL;
+            for (; byte < end && isWordByte(*byte); ++byte) {
+                hash ^= foldCase(*byte);
+                hash *= 0x100000001B3ULL;
+            }
+            fn(mix(hash));
+        }
+    }
+
+    // Unique hashes of the words of text, sorted
+    static std::vector<uint64_t> wordHashes(const char * text, size_t size)
+    {
+        std::vector<uint64_t> hashes;
+        forEachWord(text, size, [&hashes](uint64_t hash) {
+            hashes.push_back(hash);
+        });
+        std::sort(hashes.begin(), hashes.end());
+        hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+        return hashes;
+    }
+
+    // All words (at most 64 unique hashes) are among the words of the
+    // zero terminated text
+    static bool containsAll(const char * text,
+                            const std::vector<uint64_t> & words)
+    {
+        const size_t count = (std::min)(words.size(), (size_t)64);
+        const uint64_t all = count == 64 ? UINT64_MAX
+                                         : ((uint64_t)1 << count) - 1;
+        uint64_t found = 0;
+
+        size_t size = 0;
+        while (text[size]) {
+            ++size;
+        }
+
+        forEachWord(text, size, [&](uint64_t hash) {
+            for (size_t i = 0; i < count; ++i) {
+                if (words[i] == hash) {
+                    found |= (uint64_t)1 << i;
+                }
+            }
+        });
+
+        return found == all;
+    }
+
+private:
+
+    static bool isWordByte(uint8_t byte)
+    {
+        return  (byte >= 0x80)
+             || (byte >= '0' && byte <= '9')
+             || (byte >= 'a' && byte <= 'z')
+             || (byte >= 'A' && byte <= 'Z')
+             || (byte == '_');
+    }
+
+    static uint8_t foldCase(uint8_t byte)
+    {
+        return (byte >= 'A' && byte <= 'Z') ? byte + ('a' - 'A') : byte;
+    }
+
+    // FNV-1a is weak in the low bits the filter probes use
+    static uint64_t mix(uint64_t hash)
+    {
+        hash ^= hash >> 33;
+        hash *= 0xFF51AFD7ED558CCDULL;
+        hash ^= hash >> 33;
+        hash *= 0xC4CEB9FE1A85EC53ULL;
+        hash ^= hash >> 33;
+        return hash;
+    }
+};
+
+// Bloom filter of the word hashes of a block of rows: ~10 bits and 7
+// probes per word, ~1% false positives. An empty filter (not built)
+// may contain anything.
+class p7KeywordFilter
+{
+public:
+
+    p7KeywordFilter() = default;
+
+    // Sized for words unique hashes
+    explicit p7KeywordFilter(size_t words)
+        : _bits((std::max)((size_t)1, (words * bitsPerWord() + 63) / 64), 0)
+    {}
+
+    static constexpr size_t bitsPerWord()
+    {
+        return 10;
+    }
+
+    static constexpr uint32_t probes()
+    {
+        return 7;
+    }
+
+    void add(uint64_t hash)
+    {
+        const uint64_t size = _bits.size() * 64;
+        uint64_t bit = (uint32_t)hash;
+        const uint64_t step = (hash >> 32) | 1;
+        for (uint32_t i = 0; i < probes(); ++i, bit += step) {
+            const uint64_t index = bit % size;
+            _bits[index / 64] |= (uint64_t)1 << (index % 64);
+        }
+    }
+
+    bool mayContain(uint64_t hash) const
+    {
+        if (_bits.empty()) {
+            return true;
+        }
+
+        const uint64_t size = _bits.size() * 64;
+        uint64_t bit = (uint32_t)hash;
+        const uint64_t step = (hash >> 32) | 1;
+        for (uint32_t i = 0; i < probes(); ++i, bit += step) {
+            const uint64_t index = bit % size;
+            if (!(_bits[index / 64] & ((uint64_t)1 << (index % 64)))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool mayContainAll(const std::vector<uint64_t> & hashes) const
+    {
+        for (uint64_t hash : hashes) {
+            if (!mayContain(hash)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool isEmpty() const
+    {
+        return _bits.empty();
+    }
+
+    // For p7DumpCatalog files
+    const std::vector<uint64_t> & bits() const
+    {
+        return _bits;
+    }
+
+    void setBits(std::vector<uint64_t> && bits)
+    {
+        _bits = std::move(bits);
+    }
+
+private:
+
+    std::vector<uint64_t> _bits;
+};
+
+}
+
+#endif // P7_DUMP_KEYWORDS_H
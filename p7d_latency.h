@@ -0,0 +1,812 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                             /
+// 2022 (c) Ragnar Lodbrok                                                     /
+//                                                                             /
+// This library is free software; you can redistribute it and/or               /
+// modify it under the terms of the GNU Lesser General Public                  /
+// License as published by the Free Software Foundation; either                /
+// version 3.0 of the License, or (at your option) any later version.          /
+//                                                                             /
+// This library is distributed in the hope that it will be useful,             /
+// but WITHOUT ANY WARRANTY; without even the implied warranty of              /
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU           /
+// Lesser General Public License for more details.                             /
+//                                                                             /
+// You should have received a copy of the GNU Lesser General Public            /
+// License along with this library.                                            /
+//                                                                             /
+////////////////////////////////////////////////////////////////////////////////
+
+
+
+#ifndef P7_DUMP_LATENCY_H
+#define P7_DUMP_LATENCY_H
+
+#include <ctype.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <QElapsedTimer>
+#include <QString>
+#include "importer.h"
+
+namespace p7 {
+
+// printf-like format of a description split at its conversions, to find
+// an argument in a message formatted from it. Arguments are not kept after
+// import, they are read back from the row text by the type of their
+// conversion: integers (d i u x X o b p c) are parsed into their value,
+// other arguments are their text up to the literal text after them.
+class p7FormatTemplate
+{
+public:
+
+    p7FormatTemplate() {}
+
+    // UTF-8 format of a description (p7DescriptionInfo::format)
+    explicit p7FormatTemplate(const char * format)
+    {
+        std::string literal;
+        while (format && *format) {
+            const char c = *format++;
+            if (c != '%') {
+                literal += (c == '\n' || c == '\r') ? ';' : c;
+                continue;
+            }
+            if (*format == '%') {
+                literal += *format++;
+                continue;
+            }
+
+            // flags, width, precision and size are skipped
+            while (*format && strchr("-+ #0", *format)) {
+                ++format;
+            }
+            while (*format && (isdigit((unsigned char)*format)
+                               || *format == '*' || *format == '.')) {
+                ++format;
+            }
+            while (*format && strchr("hlLqjztIw", *format)) {
+                ++format;
+                // I32, I64
+                while (isdigit((unsigned char)*format)) {
+                    ++format;
+                }
+            }
+            if (!*format) {
+                break;
+            }
+
+            Argument argument;
+            argument.prefix = QString::fromUtf8(literal.c_str());
+            argument.conversion = *format++;
+            _arguments.push_back(argument);
+            literal.clear();
+        }
+        _suffix = QString::fromUtf8(literal.c_str());
+    }
+
+    size_t argumentsCount() const
+    {
+        return _arguments.size();
+    }
+
+    bool isInteger(size_t index) const
+    {
+        return     (index < _arguments.size())
+                && (strchr("diuxXobpc", _arguments[index].conversion));
+    }
+
+    // Text [from, to) of argument index (from 0) in the message, false if
+    // the message doesn't match the format up to it
+    bool find(const QString & message, size_t index, int & from, int & to) const
+    {
+        uint64_t value = 0;
+        return find(message, index, from, to, value);
+    }
+
+    // The argument as a key: the value of an integer, a hash of the text
+    // of others
+    bool key(const QString & message, size_t index, uint64_t & key) const
+    {
+        int from = 0;
+        int to = 0;
+        if (!find(message, index, from, to, key)) {
+            return false;
+        }
+
+        if (!isInteger(index)) {
+            // FNV-1a
+            key = 14695981039346656037ull;
+            for (int i = from; i < to; ++i) {
+                key = (key ^ message.at(i).unicode()) * 1099511628211ull;
+            }
+        }
+        return true;
+    }
+
+private:
+
+    struct Argument
+    {
+        QString prefix;      // literal text before the conversion
+        char conversion = 0;
+    };
+
+    static bool matches(const QString & message, int pos, const QString & text)
+    {
+        if (pos + text.size() > message.size()) {
+            return false;
+        }
+        for (int i = 0; i < text.size(); ++i) {
+            if (message.at(pos + i) != text.at(i)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // End of an integer printed at pos, its value; -1 if there is none
+    static int scanInteger(const QString & message,
+                           int pos,
+                           char conversion,
+                           int & from,
+                           uint64_t & value)
+    {
+        const int size = message.size();
+
+        // right aligned
+        while (pos < size && message.at(pos).unicode() == ' ') {
+            ++pos;
+        }
+        from = pos;
+
+        if (conversion == 'c') {
+            value = pos < size ? message.at(pos).unicode() : 0;
+            return pos < size ? pos + 1 : -1;
+        }
+
+        bool negative = false;
+        if (    (pos < size)
+             && (conversion == 'd' || conversion == 'i')
+             && (message.at(pos).unicode() == '-'
+                 || message.at(pos).unicode() == '+')
+           )
+        {
+            negative = message.at(pos).unicode() == '-';
+            ++pos;
+        }
+
+        uint64_t base = 10;
+        if (conversion == 'x' || conversion == 'X' || conversion == 'p') {
+            base = 16;
+        } else if (conversion == 'o') {
+            base = 8;
+        } else if (conversion == 'b') {
+            base = 2;
+        }
+
+        // 0x, 0b of the # flag
+        if (    (base == 16 || base == 2)
+             && (pos + 2 < size)
+             && (message.at(pos).unicode() == '0')
+             && (base == 16
+                    ? (message.at(pos + 1).unicode() | 0x20) == 'x'
+                    : message.at(pos + 1).unicode() == 'b')
+           )
+        {
+            pos += 2;
+        }
+
+        const int digits = pos;
+        value = 0;
+        for (; pos < size; ++pos) {
+            const ushort c = message.at(pos).unicode();
+            uint64_t digit = base;
+            if (c >= '0' && c <= '9') {
+                digit = c - '0';
+            } else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f') {
+                digit = (c | 0x20) - 'a' + 10;
+            }
+            if (digit >= base) {
+                break;
+            }
+            value = value * base + digit;
+        }
+
+        if (pos == digits) {
+            return -1;
+        }
+        value = negative ? (uint64_t)(-(int64_t)value) : value;
+        return pos;
+    }
+
+    bool find(const QString & message,
+              size_t index,
+              int & from,
+              int & to,
+              uint64_t & value) const
+    {
+        if (index >= _arguments.size()) {
+            return false;
+        }
+
+        int pos = 0;
+        for (size_t i = 0; i <= index; ++i) {
+            const Argument & argument = _arguments[i];
+            if (!matches(message, pos, argument.prefix)) {
+                // left aligned argument before
+                while (pos < message.size()
+                       && message.at(pos).unicode() == ' ') {
+                    ++pos;
+                }
+                if (!matches(message, pos, argument.prefix)) {
+                    return false;
+                }
+            }
+            pos += argument.prefix.size();
+
+            const QString & next = i + 1 < _arguments.size()
+                    ? _arguments[i + 1].prefix
+                    : _suffix;
+            int start = pos;
+            int end = 0;
+            if (isInteger(i)) {
+                end = scanInteger(message, pos, argument.conversion, start,
+                                  value);
+            } else if (!next.isEmpty()) {
+                end = message.indexOf(next, pos);
+            } else if (i + 1 == _arguments.size()) {
+                end = message.size();
+            } else {
+                // two arguments without text between them
+                end = -1;
+            }
+            if (end < 0) {
+                return false;
+            }
+
+            from = start;
+            to = end;
+            pos = end;
+        }
+        return true;
+    }
+
+    std::vector<Argument> _arguments;
+    QString _suffix;
+};
+
+// What to pair: rows of the begin and the end trace IDs with the same key
+// argument (and thread)
+struct p7LatencySettings
+{
+    uint16_t beginId = 0;
+    uint16_t endId = 0;
+    size_t keyArgument = 0;    // conversion of both formats, from 1; 0 - none
+    bool sameThread = true;    // an end pairs with a begin of its thread
+    size_t slowestCount = 100;
+};
+
+// A begin row and its end row
+struct p7LatencySpan
+{
+    uint32_t stream = 0;
+    uint32_t threadId = 0;    // of the begin row
+    uint64_t key = 0;         // see p7FormatTemplate::key()
+    uint64_t beginTime = 0;   // 100ns since 1601
+    uint64_t duration = 0;    // 100ns
+    uint64_t beginNumber = 0; // row numbers in the stream
+    uint64_t endNumber = 0;
+};
+
+// Durations between begin and end rows of the trace IDs of every stream.
+// Rows are split into blocks paired in parallel, spans crossing blocks
+// are paired when the blocks are joined in order, so the result is the
+// same as of one pass: an end closes the latest open begin of its key, a
+// begin replaces an open one.
+struct p7LatencyReport
+{
+    struct Thread
+    {
+        uint32_t stream = 0;
+        uint32_t threadId = 0;
+        uint64_t spans = 0;
+        uint64_t totalTime = 0; // 100ns
+        uint64_t maxTime = 0;
+    };
+
+    struct Percentile
+    {
+        double rank = 0.0;      // 0 - the shortest, 1 - the longest
+        uint64_t duration = 0;  // 100ns
+    };
+
+    p7LatencySettings settings;
+
+    std::vector<p7LatencySpan> spans;
+    uint64_t unmatchedBegins = 0; // replaced or still open at the end
+    uint64_t unmatchedEnds = 0;
+    uint64_t noKey = 0;           // rows without the key argument
+
+    std::vector<Percentile> percentiles;
+    // spans of duration [2^(i-1), 2^i) 100ns, 0 in the first one
+    std::vector<uint64_t> histogram;
+    std::vector<size_t> slowest;  // in spans, the slowest first
+    std::vector<Thread> threads;  // the longest total time first
+
+    qint64 analyzeNs = 0;
+
+    static size_t histogramBin(uint64_t duration)
+    {
+        size_t bin = 0;
+        for (; duration; duration >>= 1) {
+            ++bin;
+        }
+        return bin;
+    }
+
+    // the first duration after the bin, 100ns
+    static uint64_t histogramBinEnd(size_t bin)
+    {
+        return bin < 64 ? (uint64_t)1 << bin : UINT64_MAX;
+    }
+
+    static constexpr size_t blockRows()
+    {
+        return 65536;
+    }
+
+    static p7LatencyReport analyze(const p7DumpData & data,
+                                   const p7LatencySettings & settings)
+    {
+        QElapsedTimer clock;
+        clock.start();
+
+        p7LatencyReport report;
+        report.settings = settings;
+        if (settings.beginId == settings.endId) {
+            return report;
+        }
+
+        // formats of the begin and the end of every stream
+        std::vector<std::pair<p7FormatTemplate, p7FormatTemplate>> formats;
+        std::vector<Block> blocks;
+        for (size_t i = 0; i < data.streamsCount(); ++i) {
+            const p7StreamData & stream = data.stream(i);
+            auto format = [&stream](uint16_t id) {
+                const p7DescriptionInfo * desc = stream.descriptionById(id);
+                return desc ? p7FormatTemplate(desc->format)
+                            : p7FormatTemplate();
+            };
+            formats.emplace_back(format(settings.beginId),
+                                 format(settings.endId));
+
+            for (size_t row = 0; row < stream.traceDataCount();
+                 row += blockRows()) {
+                Block block;
+                block.stream = i;
+                block.from = row;
+                block.to = (std::min)(row + blockRows(),
+                                      stream.traceDataCount());
+                blocks.push_back(std::move(block));
+            }
+        }
+
+        std::atomic<size_t> next(0);
+        auto worker = [&data, &settings, &formats, &blocks, &next]() {
+            size_t block;
+            while ((block = next++) < blocks.size()) {
+                pairBlock(data, settings, formats[blocks[block].stream],
+                          blocks[block]);
+            }
+        };
+
+        const size_t threadsCount = (std::min)(
+                    blocks.size(),
+                    (size_t)(std::max)(1u, std::thread::hardware_concurrency()));
+
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < threadsCount; ++i) {
+            threads.emplace_back(worker);
+        }
+
+        worker();
+
+        for (std::thread & thread : threads) {
+            thread.join();
+        }
+
+        report.join(blocks);
+        report.summarize();
+        report.analyzeNs = clock.nsecsElapsed();
+        return report;
+    }
+
+    // Text of the key of a span from its begin row, empty if the row has
+    // been dropped
+    QString keyText(const p7DumpData & data, const p7LatencySpan & span) const
+    {
+        const p7StreamData & stream = data.stream(span.stream);
+        const size_t row = stream.rowIndex((uint32_t)span.beginNumber);
+        if (!settings.keyArgument || row >= stream.traceDataCount()) {
+            return QString();
+        }
+
+        const p7TraceDataInfo & begin = stream.traceDataAt(row);
+        const p7DescriptionInfo * desc = stream.descriptionById(begin.id);
+        int from = 0;
+        int to = 0;
+        if (    (!desc)
+             || (!p7FormatTemplate(desc->format).find(
+                     begin.message, settings.keyArgument - 1, from, to))
+           )
+        {
+            return QString();
+        }
+        return begin.message.mid(from, to - from);
+    }
+
+private:
+
+    struct PairKey
+    {
+        uint64_t key;
+        uint32_t threadId;
+
+        bool operator==(const PairKey & other) const
+        {
+            return key == other.key && threadId == other.threadId;
+        }
+
+        bool operator<(const PairKey & other) const
+        {
+            return key != other.key ? key < other.key
+                                    : threadId < other.threadId;
+        }
+    };
+
+    struct PairKeyHash
+    {
+        size_t operator()(const PairKey & key) const
+        {
+            return (size_t)((key.key ^ ((uint64_t)key.threadId << 32)
+                             ^ key.threadId) * 0x9E3779B97F4A7C15ull);
+        }
+    };
+
+    struct Event
+    {
+        uint64_t number = 0;
+        uint64_t time = 0;
+        uint32_t threadId = 0;
+    };
+
+    // begins and ends of a key in a block, what is left after pairing
+    struct Pending
+    {
+        std::vector<Event> leadingEnds; // before the first begin
+        bool hasBegin = false;
+        bool open = false;
+        Event begin;                    // the open one
+    };
+
+    struct Block
+    {
+        size_t stream = 0;
+        size_t from = 0;
+        size_t to = 0;
+
+        std::vector<p7LatencySpan> spans;
+        // keys with leading ends or an open begin at the end
+        std::unordered_map<PairKey, Pending, PairKeyHash> pending;
+        // keys which had a begin, sorted
+        std::vector<PairKey> begun;
+        uint64_t unmatchedBegins = 0;
+        uint64_t unmatchedEnds = 0;
+        uint64_t noKey = 0;
+    };
+
+    static void addSpan(std::vector<p7LatencySpan> & spans,
+                        size_t stream,
+                        const PairKey & key,
+                        const Event & begin,
+                        const Event & end)
+    {
+        p7LatencySpan span;
+        span.stream = (uint32_t)stream;
+        span.threadId = begin.threadId;
+        span.key = key.key;
+        span.beginTime = begin.time;
+        // timers of other cores may be a bit behind
+        span.duration = end.time > begin.time ? end.time - begin.time : 0;
+        span.beginNumber = begin.number;
+        span.endNumber = end.number;
+        spans.push_back(span);
+    }
+
+    static void pairBlock(
+            const p7DumpData & data,
+            const p7LatencySettings & settings,
+            const std::pair<p7FormatTemplate, p7FormatTemplate> & formats,
+            Block & block)
+    {
+        const p7StreamData & stream = data.stream(block.stream);
+        std::unordered_map<PairKey, Pending, PairKeyHash> keys;
+
+        for (size_t i = block.from; i < block.to; ++i) {
+            const p7TraceDataInfo & row = stream.traceDataAt(i);
+            const bool isBegin = row.id == settings.beginId;
+            if (!isBegin && row.id != settings.endId) {
+                continue;
+            }
+
+            PairKey key = { 0, settings.sameThread ? row.threadId : 0 };
+            if (    (settings.keyArgument)
+                 && (!(isBegin ? formats.first : formats.second).key(
+                         row.message, settings.keyArgument - 1, key.key))
+               )
+            {
+                block.noKey++;
+                continue;
+            }
+
+            Event event;
+            event.number = stream.firstRowNumber() + i;
+            event.time = row.timestamp;
+            event.threadId = row.threadId;
+
+            Pending & pending = keys[key];
+            if (isBegin) {
+                block.unmatchedBegins += pending.open ? 1 : 0;
+                pending.hasBegin = true;
+                pending.open = true;
+                pending.begin = event;
+            } else if (pending.open) {
+                addSpan(block.spans, block.stream, key, pending.begin, event);
+                pending.open = false;
+            } else if (!pending.hasBegin) {
+                pending.leadingEnds.push_back(event);
+            } else {
+                block.unmatchedEnds++;
+            }
+        }
+
+        // what the blocks before and after may need
+        for (auto & it : keys) {
+            if (it.second.hasBegin) {
+                block.begun.push_back(it.first);
+            }
+            if (it.second.open || !it.second.leadingEnds.empty()) {
+                block.pending.emplace(it.first, std::move(it.second));
+            }
+        }
+        std::sort(block.begun.begin(), block.begun.end());
+    }
+
+    // Spans of blocks and the ones crossing them, blocks of a stream are
+    // in order of rows
+    void join(std::vector<Block> & blocks)
+    {
+        size_t spansCount = 0;
+        for (const Block & block : blocks) {
+            spansCount += block.spans.size();
+        }
+        spans.reserve(spansCount);
+
+        std::unordered_map<PairKey, Event, PairKeyHash> carried;
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            Block & block = blocks[i];
+            if (i && blocks[i - 1].stream != block.stream) {
+                unmatchedBegins += carried.size();
+                carried.clear();
+            }
+
+            spans.insert(spans.end(), block.spans.begin(), block.spans.end());
+            std::vector<p7LatencySpan>().swap(block.spans);
+            unmatchedBegins += block.unmatchedBegins;
+            unmatchedEnds += block.unmatchedEnds;
+            noKey += block.noKey;
+
+            // begins open at the end of blocks before
+            for (auto it = carried.begin(); it != carried.end();) {
+                auto pending = block.pending.find(it->first);
+                if (    (pending != block.pending.end())
+                     && (!pending->second.leadingEnds.empty())
+                   )
+                {
+                    std::vector<Event> & ends = pending->second.leadingEnds;
+                    addSpan(spans, block.stream, it->first, it->second,
+                            ends.front());
+                    ends.erase(ends.begin());
+                    it = carried.erase(it);
+                } else if (std::binary_search(block.begun.begin(),
+                                              block.begun.end(),
+                                              it->first)) {
+                    unmatchedBegins++;
+                    it = carried.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+
+            for (const auto & it : block.pending) {
+                unmatchedEnds += it.second.leadingEnds.size();
+                if (it.second.open) {
+                    carried[it.first] = it.second.begin;
+                }
+            }
+            block.pending.clear();
+        }
+        unmatchedBegins += carried.size();
+    }
+
+    void summarize()
+    {
+        percentiles.clear();
+        histogram.clear();
+        slowest.clear();
+        threads.clear();
+        if (spans.empty()) {
+            return;
+        }
+
+        std::vector<uint64_t> durations;
+        durations.reserve(spans.size());
+        std::unordered_map<uint64_t, Thread> byThread;
+        for (const p7LatencySpan & span : spans) {
+            durations.push_back(span.duration);
+
+            const size_t bin = histogramBin(span.duration);
+            if (histogram.size() <= bin) {
+                histogram.resize(bin + 1, 0);
+            }
+            histogram[bin]++;
+
+            Thread & thread = byThread[((uint64_t)span.stream << 32)
+                                       | span.threadId];
+            thread.stream = span.stream;
+            thread.threadId = span.threadId;
+            thread.spans++;
+            thread.totalTime += span.duration;
+            thread.maxTime = (std::max)(thread.maxTime, span.duration);
+        }
+
+        // nearest rank, ascending ranks select in what is left
+        auto from = durations.begin();
+        for (double rank : { 0.0, 0.5, 0.9, 0.99, 0.999, 1.0 }) {
+            const size_t index = rank > 0.0
+                    ? (size_t)std::ceil(rank * (double)durations.size()) - 1
+                    : 0;
+            auto nth = durations.begin() + (ptrdiff_t)index;
+            std::nth_element(from, nth, durations.end());
+            from = nth;
+
+            Percentile percentile;
+            percentile.rank = rank;
+            percentile.duration = *nth;
+            percentiles.push_back(percentile);
+        }
+
+        // the shortest of the slowest ones on top of the heap
+        auto longer = [this](size_t left, size_t right) {
+            return spans[left].duration > spans[right].duration;
+        };
+        for (size_t i = 0; i < spans.size(); ++i) {
+            if (slowest.size() < settings.slowestCount) {
+                slowest.push_back(i);
+                std::push_heap(slowest.begin(), slowest.end(), longer);
+            } else if (    (!slowest.empty())
+                        && (spans[i].duration
+                            > spans[slowest.front()].duration)
+                      )
+            {
+                std::pop_heap(slowest.begin(), slowest.end(), longer);
+                slowest.back() = i;
+                std::push_heap(slowest.begin(), slowest.end(), longer);
+            }
+        }
+        std::sort_heap(slowest.begin(), slowest.end(), longer);
+
+        for (const auto & it : byThread) {
+            threads.push_back(it.second);
+        }
+        std::sort(threads.begin(), threads.end(),
+                  [](const Thread & left, const Thread & right) {
+            return left.totalTime > right.totalTime;
+        });
+    }
+};
+
+// Duration as text: 100ns intervals in us, ms or s
+static inline QString latencyAsString(uint64_t duration)
+{
+    if (duration < 10000) {
+        return QString("%1 us").arg((double)duration / 10.0, 0, 'f', 1);
+    }
+    if (duration < 10000000) {
+        return QString("%1 ms").arg((double)duration / 1e4, 0, 'f', 2);
+    }
+    return QString("%1 s").arg((double)duration / 1e7, 0, 'f', 3);
+}
+
+static inline QString latencyReportAsString(const p7DumpData & data,
+                                            const p7LatencyReport & report,
+                                            size_t top = 10)
+{
+    QString text = QString("Spans: %1 (trace IDs %2 -> %3")
+            .arg(report.spans.size())
+            .arg(report.settings.beginId)
+            .arg(report.settings.endId);
+    if (report.settings.keyArgument) {
+        text += QString(", key argument %1").arg(report.settings.keyArgument);
+    }
+    text += report.settings.sameThread ? ", same thread)\n" : ")\n";
+    text += QString("Begins without end: %1\n").arg(report.unmatchedBegins);
+    text += QString("Ends without begin: %1\n").arg(report.unmatchedEnds);
+    if (report.noKey) {
+        text += QString("Rows without the key: %1\n").arg(report.noKey);
+    }
+    text += QString("Time: %1 ms\n").arg((double)report.analyzeNs / 1e6,
+                                         0, 'f', 1);
+
+    if (report.spans.empty()) {
+        return text;
+    }
+
+    text += "Percentiles:\n";
+    for (const p7LatencyReport::Percentile & percentile
+            : report.percentiles) {
+        text += QString("  %1%: %2\n")
+                .arg(percentile.rank * 100.0)
+                .arg(latencyAsString(percentile.duration));
+    }
+
+    text += "Histogram:\n";
+    for (size_t bin = 0; bin < report.histogram.size(); ++bin) {
+        if (report.histogram[bin]) {
+            text += QString("  < %1: %2\n")
+                    .arg(latencyAsString(
+                             p7LatencyReport::histogramBinEnd(bin)))
+                    .arg(report.histogram[bin]);
+        }
+    }
+
+    text += "Slowest:\n";
+    for (size_t i = 0; i < report.slowest.size() && i < top; ++i) {
+        const p7LatencySpan & span = report.spans[report.slowest[i]];
+        const QString key = report.keyText(data, span);
+        text += QString("  %1\t%2\t%3\tthread 0x%4\trows %5-%6%7\n")
+                .arg(latencyAsString(span.duration))
+                .arg(unpackDateTime(span.beginTime)
+                        .toString("yyyy-MM-dd HH:mm:ss.zzz"))
+                .arg(data.stream(span.stream).name())
+                .arg(QString::number(span.threadId, 16))
+                .arg(span.beginNumber)
+                .arg(span.endNumber)
+                .arg(key.isEmpty() ? QString() : "\tkey " + key);
+    }
+
+    text += "Threads:\n";
+    for (size_t i = 0; i < report.threads.size() && i < top; ++i) {
+        const p7LatencyReport::Thread & thread = report.threads[i];
+        text += QString("  0x%1\t%2\t%3 spans\ttotal %4\tmax %5\n")
+                .arg(QString::number(thread.threadId, 16))
+                .arg(data.stream(thread.stream).name())
+                .arg(thread.spans)
+                .arg(latencyAsString(thread.totalTime))
+                .arg(latencyAsString(thread.maxTime));
+    }
+
+    return text;
+}
+
+} // namespace p7
+
+#endif // P7_DUMP_LATENCY_H
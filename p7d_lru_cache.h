@@ -0,0 +1,166 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                             /
+// 2022 (c) Ragnar Lodbrok                                                     /
+//                                                                             /
+// This library is free software; you can redistribute it and/or               /
+// modify it under the terms of the GNU Lesser General Public                  /
+// License as published by the Free Software Foundation; either                /
+// version 3.0 of the License, or (at your option) any later version.          /
+//                                                                             /
+// This library is distributed in the hope that it will be useful,             /
+// but WITHOUT ANY WARRANTY; without even the implied warranty of              /
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU           /
+// Lesser General Public License for more details.                             /
+//                                                                             /
+// You should have received a copy of the GNU Lesser General Public            /
+// License along with this library.                                            /
+//                                                                             /
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef P7_DUMP_LRU_CACHE_H
+#define P7_DUMP_LRU_CACHE_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+namespace p7 {
+
+// Bounded cache which drops the least recently used entry when full.
+// Entries live in one vector linked by indexes, so a full cache reuses
+// the slot of the dropped entry and doesn't allocate per insert.
+template<typename Key, typename Value>
+class p7LruCache
+{
+public:
+
+    explicit p7LruCache(size_t capacity)
+        : _capacity(capacity ? capacity : 1)
+    {
+        _entries.reserve(_capacity);
+        _index.reserve(_capacity);
+    }
+
+    size_t size() const
+    {
+        return _entries.size();
+    }
+
+    size_t capacity() const
+    {
+        return _capacity;
+    }
+
+    // Value of the key or nullptr, a found entry becomes the most recent
+    const Value * find(const Key & key)
+    {
+        auto it = _index.find(key);
+        if (it == _index.end()) {
+            return nullptr;
+        }
+        touch(it->second);
+        return &_entries[it->second].value;
+    }
+
+    // Adds or replaces the value of the key
+    const Value & insert(const Key & key, Value value)
+    {
+        auto it = _index.find(key);
+        if (it != _index.end()) {
+            touch(it->second);
+            _entries[it->second].value = std::move(value);
+            return _entries[it->second].value;
+        }
+
+        uint32_t slot;
+        if (_entries.size() < _capacity) {
+            slot = (uint32_t)_entries.size();
+            _entries.push_back(Entry());
+        } else {
+            // reuse the least recent entry
+            slot = _tail;
+            unlink(slot);
+            _index.erase(_entries[slot].key);
+        }
+
+        Entry & entry = _entries[slot];
+        entry.key = key;
+        entry.value = std::move(value);
+        pushFront(slot);
+        _index.emplace(key, slot);
+        return entry.value;
+    }
+
+    void clear()
+    {
+        _entries.clear();
+        _index.clear();
+        _head = _tail = none();
+    }
+
+private:
+
+    static constexpr uint32_t none()
+    {
+        return UINT32_MAX;
+    }
+
+    struct Entry
+    {
+        Key key = Key();
+        Value value = Value();
+        uint32_t prev = none();
+        uint32_t next = none();
+    };
+
+    void unlink(uint32_t slot)
+    {
+        Entry & entry = _entries[slot];
+        if (entry.prev != none()) {
+            _entries[entry.prev].next = entry.next;
+        } else {
+            _head = entry.next;
+        }
+        if (entry.next != none()) {
+            _entries[entry.next].prev = entry.prev;
+        } else {
+            _tail = entry.prev;
+        }
+        entry.prev = entry.next = none();
+    }
+
+    void pushFront(uint32_t slot)
+    {
+        Entry & entry = _entries[slot];
+        entry.prev = none();
+        entry.next = _head;
+        if (_head != none()) {
+            _entries[_head].prev = slot;
+        }
+        _head = slot;
+        if (_tail == none()) {
+            _tail = slot;
+        }
+    }
+
+    void touch(uint32_t slot)
+    {
+        if (slot != _head) {
+            unlink(slot);
+            pushFront(slot);
+        }
+    }
+
+    size_t _capacity;
+    std::vector<Entry> _entries;
+    std::unordered_map<Key, uint32_t> _index;
+
+    // most and least recently used entries
+    uint32_t _head = none();
+    uint32_t _tail = none();
+};
+
+}
+
+#endif // P7_DUMP_LRU_CACHE_H
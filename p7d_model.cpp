@@ -1,29 +1,566 @@
 #include "p7d_model.h"
 
+#include <QFileInfo>
 #include <QGuiApplication>
 #include <QPalette>
+#include <QStringList>
 
 namespace p7 {
 
-void P7DumpModel::setDumpData(const p7DumpData & data)
+P7DumpModel::P7DumpModel(QObject *parent)
+    : QAbstractTableModel(parent)
+    , _cells(cellsCacheCapacity())
 {
-    size_t oldRowsCount = _data.traceDataCount();
-    if (oldRowsCount) {
-        beginRemoveRows(QModelIndex(), 0, oldRowsCount-1);
-        _data = {};
+    for (int level = 0; level < EP7TRACE_LEVEL_COUNT; ++level) {
+        _levelTexts[level] = traceLevelAsString((eP7Trace_Level)level);
+    }
+
+    // level backgrounds are derived from the palette
+    if (qGuiApp) {
+        connect(qGuiApp, &QGuiApplication::paletteChanged,
+                this, &P7DumpModel::onPaletteChanged);
+    }
+}
+
+P7DumpModel::~P7DumpModel()
+{
+    if (_releaseThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(_releaseMutex);
+            _releaseStop = true;
+        }
+        _releaseWake.notify_one();
+        _releaseThread.join();
+    }
+}
+
+void P7DumpModel::setDumpData(p7DumpData && data)
+{
+    beginResetModel();
+    p7DumpData oldData = std::move(_data);
+    _data = std::move(data);
+    _stream = -1;
+    _rowsCount = (std::min)(streamRowsCount(), fetchRowsCount());
+    invalidateDisplayCache();
+    endResetModel();
+
+    releaseDumpData(std::move(oldData));
+}
+
+int P7DumpModel::appendFrom(p7DumpImporter & importer,
+                            const std::string & fileName)
+{
+    return appendFrom([&](p7DumpData & data) {
+        return importer.importAppended(fileName, data);
+    });
+}
+
+int P7DumpModel::appendFrom(const std::function<bool (p7DumpData &)> & import)
+{
+    const size_t streamsBefore = _data.streamsCount();
+    const int rowsBefore = streamRowsCount();
+
+    if (!import(_data)) {
+        return -1;
+    }
+
+    const int rowsAfter = streamRowsCount();
+
+    if (rowsAfter == rowsBefore) {
+        return 0;
+    }
+
+    // a new channel rebuilds the merged view, rows before it may move
+    if (_data.streamsCount() != streamsBefore && _stream < 0) {
+        beginResetModel();
+        _rowsCount = (std::min)(rowsAfter, fetchRowsCount());
+        invalidateDisplayCache();
+        endResetModel();
+    } else if (_rowsCount == rowsBefore) {
+        // the view is at the end already, otherwise new rows are fetched
+        beginInsertRows(QModelIndex(), rowsBefore, rowsAfter - 1);
+        _rowsCount = rowsAfter;
+        endInsertRows();
+    }
+
+    // rows of a file being loaded are all kept, as if it was loaded
+    // at once
+    if (!_loading) {
+        applyRetention();
+    }
+
+    return rowsAfter - rowsBefore;
+}
+
+void P7DumpModel::setLoading(bool loading)
+{
+    _loading = loading;
+}
+
+bool P7DumpModel::isLoading() const
+{
+    return _loading;
+}
+
+void P7DumpModel::setGrownDumpData(p7DumpData && data)
+{
+    p7DumpData oldData;
+    appendFrom([&](p7DumpData & shown) {
+        oldData = std::move(shown);
+        shown = std::move(data);
+        return true;
+    });
+
+    // shown rows get what only the decoded dump has, e.g. sequence gaps
+    invalidateDisplayCache();
+    if (_rowsCount > 0) {
+        emit dataChanged(index(0, 0),
+                         index(_rowsCount - 1, (int)Columns::Count - 1));
+    }
+
+    releaseDumpData(std::move(oldData));
+}
+
+void P7DumpModel::setRetention(const p7RetentionBudget & budget)
+{
+    _retention = budget;
+}
+
+const p7RetentionBudget & P7DumpModel::retention() const
+{
+    return _retention;
+}
+
+void P7DumpModel::setImportFilter(const p7ImportFilter & filter)
+{
+    _importFilter = filter;
+}
+
+const p7ImportFilter & P7DumpModel::importFilter() const
+{
+    return _importFilter;
+}
+
+void P7DumpModel::setBurstSettings(const p7BurstSettings & settings)
+{
+    _burstSettings = settings;
+}
+
+const p7BurstSettings & P7DumpModel::burstSettings() const
+{
+    return _burstSettings;
+}
+
+void P7DumpModel::applyRetention()
+{
+    const size_t drop = _data.rowsOverBudget(_retention);
+    if (!drop) {
+        return;
+    }
+
+    // rows of the shown stream among the oldest rows of the dump
+    const int rows = (std::min)(
+                _rowsCount,
+                _stream < 0
+                    ? (int)drop
+                    : (int)_data.streamRowsAmongOldest((size_t)_stream, drop));
+
+    if (rows > 0) {
+        beginRemoveRows(QModelIndex(), 0, rows - 1);
+    }
+
+    _data.dropOldestRows(drop);
+    _rowsCount -= rows;
+
+    if (rows > 0) {
         endRemoveRows();
     }
+}
+
+bool P7DumpModel::canFetchMore(const QModelIndex &parent) const
+{
+    if (parent.isValid()) {
+        return false;
+    }
+    return _rowsCount < streamRowsCount();
+}
+
+void P7DumpModel::fetchMore(const QModelIndex &parent)
+{
+    if (parent.isValid()) {
+        return;
+    }
 
-    int newRowsCount = data.traceDataCount();
-    if (newRowsCount) {
-        beginInsertRows(QModelIndex(), 0, newRowsCount-1);
-        _data = data;
+    // batches grow with the rows shown, the end of a huge dump is
+    // reached in a few steps of scrolling
+    const int available = streamRowsCount();
+    const int rows = (std::min)(available - _rowsCount,
+                                (std::max)(_rowsCount, fetchRowsCount()));
+    if (rows <= 0) {
+        return;
+    }
+
+    beginInsertRows(QModelIndex(), _rowsCount, _rowsCount + rows - 1);
+    _rowsCount += rows;
+    endInsertRows();
+}
+
+void P7DumpModel::fetchAll()
+{
+    const int available = streamRowsCount();
+    if (_rowsCount >= available) {
+        return;
+    }
+
+    beginInsertRows(QModelIndex(), _rowsCount, available - 1);
+    _rowsCount = available;
+    endInsertRows();
+}
+
+int P7DumpModel::rowAtTime(uint64_t time)
+{
+    const int row = _stream < 0
+            ? (int)_data.rowAtTime(time)
+            : (int)_data.stream((size_t)_stream).rowAtTime(time);
+    if (row >= streamRowsCount()) {
+        return -1;
+    }
+
+    fetchUpTo(row);
+    return row;
+}
+
+int P7DumpModel::viewRow(size_t stream, uint64_t number)
+{
+    if (stream >= _data.streamsCount()) {
+        return -1;
+    }
+
+    int row = -1;
+    if (_stream < 0) {
+        row = (int)_data.viewIndexOf(stream, number);
+    } else if ((size_t)_stream == stream) {
+        const p7StreamData & streamData = _data.stream(stream);
+        row = number >= streamData.firstRowNumber()
+                ? (int)(number - streamData.firstRowNumber())
+                : -1;
+    }
+
+    if (row < 0 || row >= streamRowsCount()) {
+        return -1;
+    }
+
+    fetchUpTo(row);
+    return row;
+}
+
+// views get rows up to row and a batch after it
+void P7DumpModel::fetchUpTo(int row)
+{
+    if (row >= _rowsCount) {
+        const int rows = (std::min)(streamRowsCount(), row + fetchRowsCount());
+        beginInsertRows(QModelIndex(), _rowsCount, rows - 1);
+        _rowsCount = rows;
         endInsertRows();
-    } else {
-        _data = data;
     }
 }
 
+uint64_t P7DumpModel::rowTime(int row) const
+{
+    return traceDataAt(row).timestamp;
+}
+
+int P7DumpModel::fetchRowsCount()
+{
+    return 64 * 1024;
+}
+
+size_t P7DumpModel::cellsCacheCapacity()
+{
+    return 4096;
+}
+
+void P7DumpModel::invalidateDisplayCache()
+{
+    _moduleTexts.clear();
+    _threadTexts.clear();
+    _fileTexts.clear();
+    _levelBackgroundsValid = false;
+    _cells.clear();
+}
+
+void P7DumpModel::onPaletteChanged()
+{
+    invalidateDisplayCache();
+
+    if (_rowsCount) {
+        emit dataChanged(index(0, 0),
+                         index(_rowsCount - 1, columnCount() - 1),
+                         {Qt::BackgroundRole});
+    }
+}
+
+uint64_t P7DumpModel::rowNumber(int row) const
+{
+    // numbers don't change when the oldest rows are dropped
+    const uint64_t first = _stream < 0
+            ? _data.firstRowNumber()
+            : _data.stream((size_t)_stream).firstRowNumber();
+    return first + (uint64_t)row;
+}
+
+size_t P7DumpModel::fileIndexOf(int row) const
+{
+    return _stream < 0
+            ? _data.fileIndexAt((size_t)row)
+            : _data.stream((size_t)_stream).fileIndex();
+}
+
+uint64_t P7DumpModel::displayNameKey(int row,
+                                     const p7TraceDataInfo & data,
+                                     uint32_t id) const
+{
+    // ids are per stream, streams of several files share channels
+    const uint64_t file = _data.files().size() > 1 ? fileIndexOf(row) : 0;
+    return (file << 40) | ((uint64_t)data.channelId << 32) | id;
+}
+
+const QString & P7DumpModel::fileText(int row) const
+{
+    const std::vector<p7DumpFile> & files = _data.files();
+    if (_fileTexts.size() != files.size()) {
+        _fileTexts.clear();
+        for (const p7DumpFile & file : files) {
+            _fileTexts.push_back(QString("%1:%2 %3")
+                                 .arg(file.processName())
+                                 .arg(file.header.dwProcess_ID)
+                                 .arg(QFileInfo(file.fileName).fileName()));
+        }
+    }
+
+    static const QString none;
+    const size_t file = fileIndexOf(row);
+    return file < _fileTexts.size() ? _fileTexts[file] : none;
+}
+
+const QString & P7DumpModel::moduleText(int row,
+                                        const p7TraceDataInfo & data) const
+{
+    DisplayName & text = _moduleTexts[displayNameKey(row, data, data.moduleId)];
+
+    // rows decoded before the module description have no name
+    if (text.text.isEmpty() || text.name != data.moduleName) {
+        text.name = data.moduleName;
+        text.text = data.moduleName.isEmpty()
+                ? QString::number(data.moduleId)
+                : data.moduleName
+                    + "(" + QString::number(data.moduleId) + ")";
+    }
+
+    return text.text;
+}
+
+const QString & P7DumpModel::threadText(int row,
+                                        const p7TraceDataInfo & data) const
+{
+    DisplayName & text = _threadTexts[displayNameKey(row, data, data.threadId)];
+
+    // thread ids are reused by threads with other names
+    if (text.text.isEmpty() || text.name != data.threadName) {
+        text.name = data.threadName;
+        text.text = data.threadName.isEmpty()
+                ? "0x" + QString::number(data.threadId, 16)
+                : data.threadName
+                    + "(0x" + QString::number(data.threadId, 16) + ")";
+    }
+
+    return text.text;
+}
+
+const QVariant & P7DumpModel::levelBackground(eP7Trace_Level level) const
+{
+    static const QVariant none;
+    if (level >= EP7TRACE_LEVEL_COUNT) {
+        return none;
+    }
+
+    if (!_levelBackgroundsValid) {
+        const QColor window = QGuiApplication::palette()
+                .color(QPalette::Window);
+
+        // R+G = yellow
+        QColor warning = window;
+        warning.setRedF(qMin(warning.redF() + 0.1, 1.0));
+        warning.setGreenF(qMin(warning.greenF() + 0.1, 1.0));
+
+        // Red
+        QColor error = window;
+        error.setRedF(qMin(error.redF() + 0.1, 1.0));
+
+        for (QVariant & background : _levelBackgrounds) {
+            background = QVariant();
+        }
+        _levelBackgrounds[EP7TRACE_LEVEL_WARNING] = warning;
+        _levelBackgrounds[EP7TRACE_LEVEL_ERROR] = error;
+        _levelBackgrounds[EP7TRACE_LEVEL_CRITICAL] = error;
+
+        // Blue, darker in light and dark palettes alike
+        QColor gap = window;
+        gap.setRedF(qMax(gap.redF() - 0.15, 0.0));
+        gap.setGreenF(qMax(gap.greenF() - 0.05, 0.0));
+        _gapBackground = gap;
+
+        _levelBackgroundsValid = true;
+    }
+
+    return _levelBackgrounds[level];
+}
+
+const QVariant & P7DumpModel::gapBackground() const
+{
+    // made with level backgrounds
+    levelBackground(EP7TRACE_LEVEL_TRACE);
+    return _gapBackground;
+}
+
+const p7SequenceCheck & P7DumpModel::sequencesAt(int row,
+                                                 uint64_t & number) const
+{
+    if (_stream < 0) {
+        const size_t stream = _data.streamIndexAt((size_t)row, number);
+        return _data.stream(stream).sequences();
+    }
+
+    number = rowNumber(row);
+    return _data.stream((size_t)_stream).sequences();
+}
+
+const QString & P7DumpModel::cachedCell(int row,
+                                        Columns column,
+                                        const p7TraceDataInfo & data) const
+{
+    const uint64_t key = rowNumber(row) * (uint64_t)Columns::Count
+            + (uint64_t)column;
+    if (const QString * text = _cells.find(key)) {
+        return *text;
+    }
+
+    QString text;
+    switch (column) {
+    case Columns::Time:
+        text = data.time.toString("HH:mm:ss.zzz");
+        break;
+    default:
+        break;
+    }
+
+    return _cells.insert(key, std::move(text));
+}
+
+void P7DumpModel::releaseDumpData(p7DumpData && data)
+{
+    // freeing millions of rows takes a while, don't stall the UI: one
+    // worker frees dumps in the order they were replaced
+    {
+        std::lock_guard<std::mutex> lock(_releaseMutex);
+        _released.push_back(std::move(data));
+    }
+    _releaseWake.notify_one();
+
+    if (!_releaseThread.joinable()) {
+        _releaseThread = std::thread(&P7DumpModel::releaseLoop, this);
+    }
+}
+
+void P7DumpModel::releaseLoop()
+{
+    std::unique_lock<std::mutex> lock(_releaseMutex);
+    for (;;) {
+        _releaseWake.wait(lock, [this]() {
+            return _releaseStop || !_released.empty();
+        });
+        if (_released.empty()) {
+            return; // stopped, everything is freed
+        }
+
+        {
+            const p7DumpData data = std::move(_released.front());
+            _released.pop_front();
+            lock.unlock();
+        } // freed here, the UI may queue more meanwhile
+        lock.lock();
+    }
+}
+
+int P7DumpModel::streamsCount() const
+{
+    return (int)_data.streamsCount();
+}
+
+QString P7DumpModel::streamName(int stream) const
+{
+    const p7StreamData & streamData = _data.stream((size_t)stream);
+    QString name = QString(tr("Channel %1: %2"))
+            .arg(streamData.channelId())
+            .arg(streamData.name());
+
+    const std::vector<p7DumpFile> & files = _data.files();
+    if (files.size() > 1 && streamData.fileIndex() < files.size()) {
+        name = QFileInfo(files[streamData.fileIndex()].fileName).fileName()
+                + " / " + name;
+    }
+
+    return name;
+}
+
+int P7DumpModel::currentStream() const
+{
+    return _stream;
+}
+
+void P7DumpModel::setCurrentStream(int stream)
+{
+    if (stream >= streamsCount()) {
+        stream = -1;
+    }
+
+    if (stream == _stream) {
+        return;
+    }
+
+    beginResetModel();
+    _stream = stream;
+    _rowsCount = (std::min)(streamRowsCount(), fetchRowsCount());
+    invalidateDisplayCache();
+    endResetModel();
+}
+
+int P7DumpModel::streamRowsCount() const
+{
+    if (_stream < 0) {
+        return (int)_data.traceDataCount();
+    }
+    return (int)_data.stream((size_t)_stream).traceDataCount();
+}
+
+const p7TraceDataInfo & P7DumpModel::traceDataAt(int row) const
+{
+    if (_stream < 0) {
+        return _data.traceDataAt((size_t)row);
+    }
+    return _data.stream((size_t)_stream).traceDataAt((size_t)row);
+}
+
+const p7DumpData & P7DumpModel::dumpData() const
+{
+    return _data;
+}
+
+int P7DumpModel::filesCount() const
+{
+    return (int)_data.files().size();
+}
+
 QString P7DumpModel::hostName() const
 {
     return _data.hostName();
@@ -39,6 +576,16 @@ QString P7DumpModel::processDateTimeAsString() const
     return _data.processDateTime().toString("yyyy-MM-dd HH:mm:ss");
 }
 
+const p7ImportStats & P7DumpModel::importStats() const
+{
+    return _data.importStats();
+}
+
+p7MemoryReport P7DumpModel::memoryReport() const
+{
+    return _data.memoryReport();
+}
+
 int P7DumpModel::columnCount(const QModelIndex &parent) const
 {
     Q_UNUSED(parent);
@@ -48,7 +595,8 @@ int P7DumpModel::columnCount(const QModelIndex &parent) const
 int P7DumpModel::rowCount(const QModelIndex &parent) const
 {
     Q_UNUSED(parent);
-    return _data.traceDataCount();
+    // rows given to views so far, see fetchMore()
+    return _rowsCount;
 }
 
 Qt::ItemFlags P7DumpModel::flags(const QModelIndex &index) const
@@ -69,6 +617,10 @@ QVariant P7DumpModel::headerData(int section,
         switch (static_cast<Columns>(section)) {
         case Columns::Number:
             return QString(tr("#"));
+        case Columns::Dump:
+            return QString(tr("Dump"));
+        case Columns::Channel:
+            return QString(tr("Channel"));
         case Columns::ID:
             return QString(tr("ID"));
         case Columns::Level:
@@ -104,39 +656,41 @@ QVariant P7DumpModel::data(const QModelIndex &index, int role) const
         return QVariant();
     }
 
-    if (index.row() >= (int)_data.traceDataCount()) {
+    if (index.row() >= rowCount()) {
         return QVariant();
     }
 
     if (role == Qt::DisplayRole) {
 
-        const p7TraceDataInfo & data = _data.traceDataAt((size_t)index.row());
+        const p7TraceDataInfo & data = traceDataAt(index.row());
 
         switch (static_cast<Columns>(index.column())) {
 
         case Columns::Number:
-            return index.row() + 1;
+            return (qulonglong)(rowNumber(index.row()) + 1);
+
+        case Columns::Dump:
+            return fileText(index.row());
+
+        case Columns::Channel:
+            return data.channelId;
 
         case Columns::ID:
             return data.id;
 
         case Columns::Level:
-            return traceLevelAsString(data.verbosity);
+            return data.verbosity < EP7TRACE_LEVEL_COUNT
+                    ? _levelTexts[data.verbosity]
+                    : QString();
 
         case Columns::Module:
-            return data.moduleName.isEmpty()
-                    ? QString::number(data.moduleId)
-                    : data.moduleName
-                        + "(" + QString::number(data.moduleId) + ")";
+            return moduleText(index.row(), data);
 
         case Columns::CPUNumber:
             return data.processorNumber;
 
         case Columns::Thread:
-            return data.threadName.isEmpty()
-                    ? "0x" + QString::number(data.threadId, 16)
-                    : data.threadName
-                        + "(0x" + QString::number(data.threadId, 16) + ")";
+            return threadText(index.row(), data);
 
         case Columns::File:
             return data.filename;
@@ -148,7 +702,7 @@ QVariant P7DumpModel::data(const QModelIndex &index, int role) const
             return data.function;
 
         case Columns::Time:
-            return data.time.toString("HH:mm:ss.zzz");
+            return cachedCell(index.row(), Columns::Time, data);
 
         case Columns::Text:
             return data.message;
@@ -159,37 +713,25 @@ QVariant P7DumpModel::data(const QModelIndex &index, int role) const
 
     } else if (role == Qt::BackgroundRole) {
 
-        const p7TraceDataInfo & data = _data.traceDataAt((size_t)index.row());
-
-        switch (data.verbosity) {
-
-        case eP7Trace_Level::EP7TRACE_LEVEL_WARNING: {
-
-                QColor bgColor = QGuiApplication::palette()
-                    .color(QPalette::Window);
-
-                // R+G = yellow
-                bgColor.setRedF(qMin(bgColor.redF() + 0.1, 1.0));
-                bgColor.setGreenF(qMin(bgColor.greenF() + 0.1, 1.0));
-
-                return bgColor;
-            }
-
-        case eP7Trace_Level::EP7TRACE_LEVEL_ERROR:
-        case eP7Trace_Level::EP7TRACE_LEVEL_CRITICAL: {
-
-                QColor bgColor = QGuiApplication::palette()
-                    .color(QPalette::Window);
-
-                // Red
-                bgColor.setRedF(qMin(bgColor.redF() + 0.1, 1.0));
-
-                return bgColor;
-            }
-
-        default:
-            break;
+        uint64_t number = 0;
+        if (sequencesAt(index.row(), number).hasGapAt(number)) {
+            return gapBackground();
+        }
+        return levelBackground(traceDataAt(index.row()).verbosity);
+
+    } else if (role == Qt::ToolTipRole) {
+
+        uint64_t number = 0;
+        const p7SequenceCheck::Range events
+                = sequencesAt(index.row(), number).eventsAt(number);
+        QStringList texts;
+        for (const p7SequenceEvent * event = events.first;
+             event != events.second;
+             ++event)
+        {
+            texts << sequenceEventAsString(*event);
         }
+        return texts.isEmpty() ? QVariant() : QVariant(texts.join('\n'));
 
     }
 
@@ -199,6 +741,8 @@ QVariant P7DumpModel::data(const QModelIndex &index, int role) const
 int P7DumpModel::columnWidth(int columnIndex) const
 {
     switch (static_cast<Columns>(columnIndex)) {
+    case Columns::Dump:
+        return 250;
     case Columns::Module:
         return 200;
     case Columns::Thread:
@@ -1,9 +1,17 @@
 #ifndef P7_DUMP_MODEL
 #define P7_DUMP_MODEL
 
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include "p7d_lru_cache.h"
 #include "importer.h"
 #include <QAbstractTableModel>
 #include <QString>
+#include <QVariant>
 
 namespace p7 {
 
@@ -13,6 +21,8 @@ public:
 
     enum class Columns {
         Number = 0,
+        Dump,
+        Channel,
         ID,
         Level,
         Module,
@@ -26,24 +36,164 @@ public:
         Count
     };
 
-    void setDumpData(const p7DumpData & data);
+    explicit P7DumpModel(QObject *parent = nullptr);
+    ~P7DumpModel() override;
+
+    // Adopts data without copying, previous dump is freed in background.
+    // Views get the first fetchRowsCount() rows, the rest on scrolling
+    // (fetchMore), so the reset doesn't depend on the dump size.
+    void setDumpData(p7DumpData && data);
+
+    // Follow mode: decodes bytes appended to fileName since the last
+    // import by the same importer and inserts new rows at the end.
+    // Returns the number of new rows or -1 if the file was truncated.
+    int appendFrom(p7DumpImporter & importer, const std::string & fileName);
+
+    // Same for any source: import appends to the dump given to it and
+    // returns false if the dump has to be replaced
+    int appendFrom(const std::function<bool (p7DumpData &)> & import);
+
+    // Progressive load: a file decoded on another thread gives its rows
+    // through appendFrom() as they come (see p7DumpData::appendBatch()),
+    // retention doesn't apply meanwhile
+    void setLoading(bool loading);
+    bool isLoading() const;
+
+    // The end of a progressive load: the decoded dump replaces the one
+    // of its batches. Rows shown so far are at the same places in it,
+    // views keep them and get the others as from appendFrom().
+    void setGrownDumpData(p7DumpData && data);
+
+    // Limits rows kept by appendFrom(), the oldest rows over the budget
+    // are removed from the model
+    void setRetention(const p7RetentionBudget & budget);
+    const p7RetentionBudget & retention() const;
+
+    // Rows skipped by importers of the model's sources (files, follow
+    // and live modes), applies to the next import
+    void setImportFilter(const p7ImportFilter & filter);
+    const p7ImportFilter & importFilter() const;
+
+    // Burst detection of importers of the model's sources, applies to
+    // the next import
+    void setBurstSettings(const p7BurstSettings & settings);
+    const p7BurstSettings & burstSettings() const;
+
+    // Trace streams of the dump, the model shows all of them merged by
+    // time (-1) or rows of one stream
+    int streamsCount() const;
+    QString streamName(int stream) const;
+    int currentStream() const;
+    void setCurrentStream(int stream);
+
+    const p7DumpData & dumpData() const;
+
+    // Files of a dump combined from several files, 0 for one file
+    int filesCount() const;
 
     QString hostName() const;
     QString processName() const;
     QString processDateTimeAsString() const;
+    const p7ImportStats & importStats() const;
+    p7MemoryReport memoryReport() const;
 
     Qt::ItemFlags flags(const QModelIndex &index) const override;
     QVariant data(const QModelIndex &index, int role) const override;
     QVariant headerData(int section, Qt::Orientation orientation,
                         int role = Qt::DisplayRole) const override;
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+    // Gives all rows to views, e.g. to scroll to the last one
+    void fetchAll();
+
+    // Jump to time: the first row at or after time (100ns since 1601)
+    // found by the time index, views get rows up to it; -1 if none
+    int rowAtTime(uint64_t time);
+    uint64_t rowTime(int row) const;
+
+    // Row of the shown view with a row of a stream (its number), e.g. a
+    // link from the trace ID view; views get rows up to it, -1 if the
+    // view doesn't show it
+    int viewRow(size_t stream, uint64_t number);
+
+    // Rows of the shown stream (or merged view) in the dump, views may
+    // have got fewer so far (rowCount)
+    int streamRowsCount() const;
     int columnCount(const QModelIndex &parent = QModelIndex()) const override;
 
     int columnWidth(int columnIndex) const;
 
+    // Formatted cells kept for repaints and small scroll steps
+    static size_t cellsCacheCapacity();
+
 private:
 
+    void releaseDumpData(p7DumpData && data);
+    void releaseLoop();
+    const p7TraceDataInfo & traceDataAt(int row) const;
+
+    static int fetchRowsCount();
+    void fetchUpTo(int row);
+    void applyRetention();
+
+    // Display strings of the shown rows are cached: texts of modules and
+    // threads by id, level strings and backgrounds (rebuilt when the
+    // palette changes) and formatted cells of recently shown rows by
+    // row number. Rows keep their numbers until the view is reset.
+    void invalidateDisplayCache();
+    void onPaletteChanged();
+    uint64_t rowNumber(int row) const;
+    size_t fileIndexOf(int row) const;
+    uint64_t displayNameKey(int row,
+                            const p7TraceDataInfo & data,
+                            uint32_t id) const;
+    const QString & fileText(int row) const;
+    const QString & moduleText(int row, const p7TraceDataInfo & data) const;
+    const QString & threadText(int row, const p7TraceDataInfo & data) const;
+    const QVariant & levelBackground(eP7Trace_Level level) const;
+    // of rows after traces the client dropped, see p7SequenceCheck
+    const QVariant & gapBackground() const;
+    // sequence numbers of the stream of a row and the row's number there
+    const p7SequenceCheck & sequencesAt(int row, uint64_t & number) const;
+    // texts formatted per call (Time); Text, Function and File are kept
+    // formatted in the row and returned shared, caching them would only
+    // push formatted cells out
+    const QString & cachedCell(int row,
+                               Columns column,
+                               const p7TraceDataInfo & data) const;
+
+    struct DisplayName
+    {
+        QString name; // name of the row the text was made for
+        QString text;
+    };
+
     p7DumpData _data;
+    int _stream = -1;
+    int _rowsCount = 0;
+    bool _loading = false;
+    p7RetentionBudget _retention;
+    p7ImportFilter _importFilter;
+    p7BurstSettings _burstSettings;
+    // dumps replaced in the model, freed by _releaseThread
+    std::thread _releaseThread;
+    std::mutex _releaseMutex;
+    std::condition_variable _releaseWake;
+    std::deque<p7DumpData> _released;
+    bool _releaseStop = false;
+
+    // key: file << 40 | channel << 32 | module or thread id
+    mutable std::unordered_map<uint64_t, DisplayName> _moduleTexts;
+    mutable std::unordered_map<uint64_t, DisplayName> _threadTexts;
+    mutable std::vector<QString> _fileTexts; // by file index
+    QString _levelTexts[EP7TRACE_LEVEL_COUNT];
+    mutable QVariant _levelBackgrounds[EP7TRACE_LEVEL_COUNT];
+    mutable QVariant _gapBackground;
+    mutable bool _levelBackgroundsValid = false;
+    // key: row number * Columns::Count + column
+    mutable p7LruCache<uint64_t, QString> _cells;
 };
 
 }
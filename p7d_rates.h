@@ -0,0 +1,465 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                             /
+// 2022 (c) Ragnar Lodbrok                                                     /
+//                                                                             /
+// This library is free software; you can redistribute it and/or               /
+// modify it under the terms of the GNU Lesser General Public                  /
+// License as published by the Free Software Foundation; either                /
+// version 3.0 of the License, or (at your option) any later version.          /
+//                                                                             /
+// This library is distributed in the hope that it will be useful,             /
+// but WITHOUT ANY WARRANTY; without even the implied warranty of              /
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU           /
+// Lesser General Public License for more details.                             /
+//                                                                             /
+// You should have received a copy of the GNU Lesser General Public            /
+// License along with this library.                                            /
+//                                                                             /
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef P7_DUMP_RATES_H
+#define P7_DUMP_RATES_H
+
+#include <stdint.h>
+#include <math.h>
+#include <algorithm>
+#include <vector>
+#include "p7Structs.h"
+
+namespace p7 {
+
+// Rows per time bucket and level of a stream, counted as rows are added.
+// Buckets start at minBucketTime() and get twice as wide whenever the
+// time span needs more than maxBuckets() of them, so a day long dump
+// costs the same as a minute long one. A level of detail pyramid on top
+// (lodFanout() buckets of level N-1 per bucket of level N) lets a
+// timeline of any zoom be drawn from about as many buckets as it has
+// pixels, see query().
+class p7RateHistogram
+{
+public:
+
+    static constexpr size_t levelsCount()
+    {
+        return EP7TRACE_LEVEL_COUNT;
+    }
+
+    static constexpr uint64_t minBucketTime()
+    {
+        return 10000; // 1ms
+    }
+
+    static constexpr size_t maxBuckets()
+    {
+        return 16384;
+    }
+
+    static constexpr size_t lodFanout()
+    {
+        return 4;
+    }
+
+    // levels are not built below this size
+    static constexpr size_t lodMinBuckets()
+    {
+        return 256;
+    }
+
+    void addRow(uint64_t time, eP7Trace_Level level)
+    {
+        if (!_rows) {
+            _origin = time - time % _bucketTime;
+            _firstTime = _lastTime = time;
+        }
+        ++_rows;
+        _firstTime = (std::min)(_firstTime, time);
+        _lastTime = (std::max)(_lastTime, time);
+
+        // rows of other streams of a merged dump may come earlier
+        if (time < _origin) {
+            growLeft(time);
+        }
+
+        size_t bucket = (size_t)((time - _origin) / _bucketTime);
+        while (bucket >= maxBuckets()) {
+            coarsen();
+            bucket = (size_t)((time - _origin) / _bucketTime);
+        }
+
+        if (bucket >= bucketsCount()) {
+            _counts.resize((bucket + 1) * levelsCount(), 0);
+        }
+        ++_counts[bucket * levelsCount() + (std::min)((size_t)level,
+                                                      levelsCount() - 1)];
+        _dirtyFrom = (std::min)(_dirtyFrom, bucket);
+    }
+
+    // Updates the pyramid for buckets changed since the previous call:
+    // only the end of it while rows are appended
+    void buildLod()
+    {
+        if (_dirtyFrom == noBucket()) {
+            return;
+        }
+
+        size_t dirtyFrom = _dirtyFrom;
+        size_t levels = 0;
+
+        auto lowerLevel = [this, &levels]() {
+            return levels ? &_levels[levels - 1] : &_counts;
+        };
+
+        while (lowerLevel()->size() / levelsCount() > lodMinBuckets()) {
+            if (_levels.size() == levels) {
+                _levels.emplace_back();
+            }
+            const std::vector<uint32_t> * lower = lowerLevel();
+            std::vector<uint32_t> & level = _levels[levels];
+
+            const size_t lowerBuckets = lower->size() / levelsCount();
+            const size_t buckets = (lowerBuckets + lodFanout() - 1)
+                    / lodFanout();
+            dirtyFrom /= lodFanout();
+
+            level.resize(buckets * levelsCount());
+            std::fill(level.begin() + dirtyFrom * levelsCount(),
+                      level.end(), 0);
+            for (size_t i = dirtyFrom * lodFanout(); i < lowerBuckets; ++i) {
+                const uint32_t * counts = lower->data() + i * levelsCount();
+                uint32_t * sums = level.data()
+                        + (i / lodFanout()) * levelsCount();
+                for (size_t j = 0; j < levelsCount(); ++j) {
+                    sums[j] += counts[j];
+                }
+            }
+
+            ++levels;
+        }
+
+        _levels.resize(levels);
+        _dirtyFrom = noBucket();
+    }
+
+    // Drops spare capacity once import is done
+    void shrinkToFit()
+    {
+        _counts.shrink_to_fit();
+    }
+
+    uint64_t rows() const
+    {
+        return _rows;
+    }
+
+    // the earliest and the latest row, 100ns since 1601
+    uint64_t firstTime() const
+    {
+        return _firstTime;
+    }
+
+    uint64_t lastTime() const
+    {
+        return _lastTime;
+    }
+
+    uint64_t bucketTime() const
+    {
+        return _bucketTime;
+    }
+
+    size_t bucketsCount() const
+    {
+        return _counts.size() / levelsCount();
+    }
+
+    // Rows per level in bins equal parts of [from, to) added to counts
+    // (bins * levelsCount(), by bin then level), so streams of a merged
+    // view can be summed. Takes the coarsest pyramid level with buckets
+    // not wider than a bin; a bucket wider than a bin (deep zoom) is spread
+    // over the bins it covers. Levels are used as of the last buildLod().
+    void query(uint64_t from,
+               uint64_t to,
+               size_t bins,
+               std::vector<double> & counts) const
+    {
+        if (counts.size() < bins * levelsCount()) {
+            counts.resize(bins * levelsCount(), 0.0);
+        }
+        if (!_rows || !bins || from >= to) {
+            return;
+        }
+
+        const double binTime = (double)(to - from) / (double)bins;
+
+        const std::vector<uint32_t> * level = &_counts;
+        uint64_t bucketTime = _bucketTime;
+        if (_dirtyFrom == noBucket()) {
+            for (const std::vector<uint32_t> & coarser : _levels) {
+                if ((double)(bucketTime * lodFanout()) > binTime) {
+                    break;
+                }
+                level = &coarser;
+                bucketTime *= lodFanout();
+            }
+        }
+
+        const size_t buckets = level->size() / levelsCount();
+        const size_t first = from > _origin
+                ? (size_t)((from - _origin) / bucketTime)
+                : 0;
+        const size_t last = (std::min)(
+                    buckets,
+                    to > _origin
+                        ? (size_t)((to - _origin + bucketTime - 1)
+                                   / bucketTime)
+                        : (size_t)0);
+
+        for (size_t i = first; i < last; ++i) {
+            const uint32_t * bucket = level->data() + i * levelsCount();
+            const double start = (double)(_origin + i * bucketTime)
+                    - (double)from;
+            const double end = start + (double)bucketTime;
+
+            const size_t firstBin = (size_t)(std::max)(start / binTime, 0.0);
+            const size_t lastBin = (std::min)(
+                        bins - 1, (size_t)((end - 1.0) / binTime));
+            for (size_t bin = firstBin; bin <= lastBin; ++bin) {
+                const double overlap
+                        = (std::min)(end, (double)(bin + 1) * binTime)
+                        - (std::max)(start, (double)bin * binTime);
+                const double share = overlap / (double)bucketTime;
+                if (share <= 0.0) {
+                    continue;
+                }
+                double * sums = counts.data() + bin * levelsCount();
+                for (size_t j = 0; j < levelsCount(); ++j) {
+                    sums[j] += bucket[j] * share;
+                }
+            }
+        }
+    }
+
+    size_t memoryUsage() const
+    {
+        size_t bytes = _counts.capacity() * sizeof(uint32_t);
+        for (const std::vector<uint32_t> & level : _levels) {
+            bytes += level.capacity() * sizeof(uint32_t);
+        }
+        return bytes;
+    }
+
+private:
+
+    static constexpr size_t noBucket()
+    {
+        return (size_t)-1;
+    }
+
+    // Buckets twice as wide, origin aligned to the new width
+    void coarsen()
+    {
+        const uint64_t bucketTime = _bucketTime * 2;
+        const uint64_t origin = _origin - _origin % bucketTime;
+
+        std::vector<uint32_t> counts(
+                    ((bucketsCount() + 1) / 2 + 1) * levelsCount(), 0);
+        size_t buckets = 0;
+        for (size_t i = 0; i < bucketsCount(); ++i) {
+            const size_t bucket = (size_t)((_origin + i * _bucketTime
+                                            - origin) / bucketTime);
+            for (size_t j = 0; j < levelsCount(); ++j) {
+                counts[bucket * levelsCount() + j]
+                        += _counts[i * levelsCount() + j];
+            }
+            buckets = bucket + 1;
+        }
+        counts.resize(buckets * levelsCount());
+
+        _counts.swap(counts);
+        _bucketTime = bucketTime;
+        _origin = origin;
+        _dirtyFrom = 0;
+    }
+
+    // Buckets before the origin down to time
+    void growLeft(uint64_t time)
+    {
+        uint64_t origin = time - time % _bucketTime;
+        while (bucketsCount() + (_origin - origin) / _bucketTime
+               > maxBuckets()) {
+            coarsen();
+            origin = time - time % _bucketTime;
+        }
+
+        _counts.insert(_counts.begin(),
+                       (size_t)((_origin - origin) / _bucketTime)
+                            * levelsCount(),
+                       0);
+        _origin = origin;
+        _dirtyFrom = 0;
+    }
+
+    uint64_t _rows = 0;
+    uint64_t _firstTime = 0;
+    uint64_t _lastTime = 0;
+
+    uint64_t _origin = 0; // time of the first bucket
+    uint64_t _bucketTime = minBucketTime();
+    std::vector<uint32_t> _counts; // by bucket then level
+
+    std::vector<std::vector<uint32_t>> _levels; // pyramid, same layout
+    size_t _dirtyFrom = noBucket(); // first bucket changed since buildLod()
+};
+
+// When a stream logs much more than it usually does
+struct p7BurstSettings
+{
+    double multiple = 5.0;     // of the baseline rate
+    uint64_t window = 1000000; // 100ms, 100ns intervals
+    uint32_t minRows = 20;     // per window, quiet streams don't burst
+};
+
+// Consecutive windows of a burst
+struct p7Burst
+{
+    uint64_t fromTime = 0;
+    uint64_t toTime = 0;  // excluded
+    uint64_t rows = 0;
+    uint32_t peakRows = 0; // of the busiest window
+    double baseline = 0.0; // rows per window before the burst
+};
+
+// Streaming burst detection: rows are counted per window of time, the
+// baseline is an exponential moving average of rows per window (empty
+// windows included) and a window with more than multiple times the
+// baseline rows is a burst. The baseline follows a burst much slower, so
+// a storm of minutes stays one burst while a lasting change of the rate
+// becomes the new baseline eventually.
+class p7BurstDetector
+{
+public:
+
+    // windows the baseline averages, roughly
+    static constexpr double baselineWindows()
+    {
+        return 64.0;
+    }
+
+    // windows before the first burst may be found
+    static constexpr uint64_t warmUpWindows()
+    {
+        return 10;
+    }
+
+    void setSettings(const p7BurstSettings & settings)
+    {
+        _settings = settings;
+        _settings.window = (std::max)(_settings.window, (uint64_t)1);
+    }
+
+    const p7BurstSettings & settings() const
+    {
+        return _settings;
+    }
+
+    // rows of a stream are mostly ordered by time, an earlier one is
+    // counted to the current window
+    void addRow(uint64_t time)
+    {
+        if (!_windows && !_windowRows) {
+            _windowStart = time - time % _settings.window;
+        }
+
+        if (time >= _windowStart + _settings.window) {
+            const uint64_t windows = (time - _windowStart) / _settings.window;
+            closeWindow();
+            skipWindows(windows - 1);
+            _windowStart += windows * _settings.window;
+        }
+
+        ++_windowRows;
+    }
+
+    // Bursts of closed windows ordered by time
+    const std::vector<p7Burst> & bursts() const
+    {
+        return _bursts;
+    }
+
+    double baseline() const
+    {
+        return _baseline;
+    }
+
+    size_t memoryUsage() const
+    {
+        return _bursts.capacity() * sizeof(p7Burst);
+    }
+
+private:
+
+    void closeWindow()
+    {
+        const double alpha = 1.0 / baselineWindows();
+
+        if (!_windows) {
+            _baseline = (double)_windowRows;
+        }
+
+        const bool burst = (_windows >= warmUpWindows())
+                && (_windowRows >= _settings.minRows)
+                && ((double)_windowRows > _baseline * _settings.multiple);
+
+        if (burst) {
+            if (_inBurst) {
+                p7Burst & last = _bursts.back();
+                last.toTime = _windowStart + _settings.window;
+                last.rows += _windowRows;
+                last.peakRows = (std::max)(last.peakRows, _windowRows);
+            } else {
+                p7Burst next;
+                next.fromTime = _windowStart;
+                next.toTime = _windowStart + _settings.window;
+                next.rows = _windowRows;
+                next.peakRows = _windowRows;
+                next.baseline = _baseline;
+                _bursts.push_back(next);
+            }
+            _baseline += ((double)_windowRows - _baseline) * alpha / 16.0;
+        } else {
+            _baseline += ((double)_windowRows - _baseline) * alpha;
+        }
+
+        _inBurst = burst;
+        _windowRows = 0;
+        ++_windows;
+    }
+
+    void skipWindows(uint64_t windows)
+    {
+        if (!windows) {
+            return;
+        }
+
+        const double alpha = 1.0 / baselineWindows();
+        _baseline *= pow(1.0 - alpha, (double)(std::min)(windows,
+                                                         (uint64_t)4096));
+        _inBurst = false;
+        _windows += windows;
+    }
+
+    p7BurstSettings _settings;
+
+    uint64_t _windowStart = 0;
+    uint32_t _windowRows = 0;
+    uint64_t _windows = 0; // closed
+    double _baseline = 0.0;
+    bool _inBurst = false;
+
+    std::vector<p7Burst> _bursts;
+};
+
+} // namespace p7
+
+#endif // P7_DUMP_RATES_H
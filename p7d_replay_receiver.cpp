@@ -0,0 +1,326 @@
+#include "p7d_replay_receiver.h"
+
+#include <QUdpSocket>
+
+namespace p7 {
+
+namespace {
+
+// payloads waiting for the decoder, each slot grows to the biggest
+// payload it has held (64 KB at most); the decoder is woken at once, the
+// queue only covers the time it is busy, a full queue holds the client
+// back (packets are not acknowledged)
+const size_t queueCapacity = 4096;
+
+// the decoder ships what it has decoded at least this often
+const size_t maxBatchBytes = 8 * 1024 * 1024;
+const size_t maxDatagramSize = 65535;
+const int socketWaitMs = 100;
+
+}
+
+P7ReplayReceiver::P7ReplayReceiver(P7DumpModel * model, QObject *parent)
+    : QObject(parent)
+    , _model(model)
+    , _queue(queueCapacity)
+{
+}
+
+P7ReplayReceiver::~P7ReplayReceiver()
+{
+    stop();
+}
+
+bool P7ReplayReceiver::start(quint16 port)
+{
+    stop();
+
+    _importer.reset(new p7DumpImporter());
+    _importer->setFilter(_model->importFilter());
+    _importer->setBurstSettings(_model->burstSettings());
+    // the dump of the model merges rows as they come
+    _importer->setMergeStreams(false);
+    _decoded = p7DumpData();
+    _cursor = p7BatchCursor();
+    _headerDecoded = false;
+    _model->setDumpData(p7DumpData());
+
+    _stop = false;
+    _datagrams = 0;
+    _dropped = 0;
+    {
+        std::lock_guard<std::mutex> lock(_decodeMutex);
+        _received = false;
+        _decodeStop = false;
+        _unshipped = false;
+        _shipped.reset();
+        _headerShipped = false;
+    }
+
+    std::promise<bool> bound;
+    std::future<bool> listening = bound.get_future();
+    _socketThread = std::thread(&P7ReplayReceiver::receive, this,
+                                port, std::move(bound));
+
+    if (!listening.get()) {
+        _socketThread.join();
+        _importer.reset();
+        return false;
+    }
+
+    _decodeThread = std::thread(&P7ReplayReceiver::decode, this);
+    _port = port;
+    return true;
+}
+
+void P7ReplayReceiver::stop()
+{
+    if (!_socketThread.joinable()) {
+        return;
+    }
+
+    _stop = true;
+    _socketThread.join();
+
+    {
+        std::lock_guard<std::mutex> lock(_decodeMutex);
+        _decodeStop = true;
+    }
+    _decodeWake.notify_one();
+    _decodeThread.join();
+
+    // what has arrived is still shown, all of it
+    showDecoded();
+    shipDecoded();
+    showDecoded();
+
+    _importer.reset();
+    _decoded = p7DumpData();
+    _port = 0;
+}
+
+bool P7ReplayReceiver::isListening() const
+{
+    return _socketThread.joinable();
+}
+
+quint16 P7ReplayReceiver::port() const
+{
+    return _port;
+}
+
+uint64_t P7ReplayReceiver::datagramsCount() const
+{
+    return _datagrams;
+}
+
+uint64_t P7ReplayReceiver::droppedCount() const
+{
+    return _dropped;
+}
+
+void P7ReplayReceiver::receive(quint16 port, std::promise<bool> bound)
+{
+    // created here, blocking API of the socket needs no event loop
+    QUdpSocket socket;
+    if (!socket.bind(QHostAddress::LocalHost, port)) {
+        bound.set_value(false);
+        return;
+    }
+    bound.set_value(true);
+
+    p7TransportReceiver transport;
+    std::vector<uint8_t> datagram(maxDatagramSize);
+    QHostAddress address;
+    quint16 peerPort = 0;
+
+    // payload of a hello or of the next data packet, false if the
+    // queue is full
+    auto take = [this](const uint8_t * data, size_t size, bool header) {
+        Datagram * slot = _queue.producerSlot();
+        if (!slot) {
+            return false;
+        }
+
+        if (slot->data.size() < size) {
+            slot->data.resize(size);
+        }
+        memcpy(slot->data.data(), data, size);
+        slot->size = size;
+        slot->header = header;
+        _queue.push();
+        return true;
+    };
+
+    while (!_stop) {
+        if (!socket.waitForReadyRead(socketWaitMs)) {
+            continue;
+        }
+
+        bool queued = false;
+        while (socket.hasPendingDatagrams()) {
+            const qint64 size = socket.readDatagram(
+                        (char *)datagram.data(), (qint64)datagram.size(),
+                        &address, &peerPort);
+            if (size < 0) {
+                ++_dropped;
+                continue;
+            }
+
+            const uint64_t peer
+                    = ((uint64_t)address.toIPv4Address() << 16) | peerPort;
+            p7TransportHeader reply;
+            bool hasReply = false;
+
+            switch (transport.receive(datagram.data(), (size_t)size, peer,
+                                      take, reply, hasReply)) {
+            case p7TransportReceiver::Accepted:
+                ++_datagrams;
+                queued = true;
+                break;
+            case p7TransportReceiver::Refused:
+            case p7TransportReceiver::Malformed:
+                ++_dropped;
+                break;
+            default:
+                break;
+            }
+
+            if (hasReply) {
+                socket.writeDatagram((const char *)&reply, sizeof(reply),
+                                     address, peerPort);
+            }
+        }
+
+        if (queued) {
+            {
+                std::lock_guard<std::mutex> lock(_decodeMutex);
+                _received = true;
+            }
+            _decodeWake.notify_one();
+        }
+    }
+}
+
+void P7ReplayReceiver::decode()
+{
+    for (;;) {
+        bool stopping = false;
+        bool ship = false;
+        {
+            std::unique_lock<std::mutex> lock(_decodeMutex);
+            _decodeWake.wait(lock, [this]() {
+                return _received || _decodeStop || (_unshipped && !_shipped);
+            });
+            stopping = _decodeStop;
+            ship = _unshipped && !_shipped;
+            _received = false;
+        }
+
+        if (stopping) {
+            // the socket thread is done, stop() shows the rest
+            while (decodeBatch()) {
+            }
+            return;
+        }
+
+        // the model has taken the previous batch
+        if (ship) {
+            shipDecoded();
+            QMetaObject::invokeMethod(this, [this]() {
+                showDecoded();
+            }, Qt::QueuedConnection);
+        }
+
+        if (decodeBatch()) {
+            std::lock_guard<std::mutex> lock(_decodeMutex);
+            _received = true;
+        }
+    }
+}
+
+bool P7ReplayReceiver::decodeBatch()
+{
+    _batch.clear();
+    bool full = false;
+    bool header = false;
+
+    while (!(full = _batch.size() >= maxBatchBytes)) {
+        Datagram * datagram = _queue.consumerSlot();
+        if (!datagram) {
+            break;
+        }
+
+        const uint8_t * data = datagram->data.data();
+        if (datagram->header) {
+            memcpy(&_decoded.header(), data, sizeof(sP7File_Header));
+            header = true;
+        } else {
+            _batch.insert(_batch.end(), data, data + datagram->size);
+        }
+
+        _queue.pop();
+    }
+
+    if (!_batch.empty()) {
+        _importer->importChunks(_batch, _decoded);
+    }
+
+    if (header || !_batch.empty()) {
+        _headerDecoded = _headerDecoded || header;
+        std::lock_guard<std::mutex> lock(_decodeMutex);
+        _unshipped = true;
+    }
+
+    return full;
+}
+
+void P7ReplayReceiver::shipDecoded()
+{
+    // rows the model has got are of no use here any more
+    std::unique_ptr<p7RowsBatch> batch(
+                new p7RowsBatch(_decoded.rowsSince(_cursor)));
+    _decoded.dropCopied(_cursor);
+
+    std::lock_guard<std::mutex> lock(_decodeMutex);
+    _shipped = std::move(batch);
+    _headerShipped = _headerShipped || _headerDecoded;
+    _headerDecoded = false;
+    _unshipped = false;
+}
+
+void P7ReplayReceiver::showDecoded()
+{
+    std::unique_ptr<p7RowsBatch> batch;
+    bool header = false;
+    {
+        std::lock_guard<std::mutex> lock(_decodeMutex);
+        batch = std::move(_shipped);
+        header = _headerShipped;
+        _headerShipped = false;
+    }
+
+    // the decoder may ship the next batch
+    _decodeWake.notify_one();
+
+    if (!batch) {
+        return;
+    }
+
+    // streams are merged up to their last rows, a quiet stream doesn't
+    // hold back the others
+    const int rows = _model->appendFrom([&batch](p7DumpData & data) {
+        data.appendBatch(std::move(*batch), false);
+        return true;
+    });
+
+    if (header) {
+        emit headerReceived();
+    }
+
+    if (rows > 0) {
+        emit rowsAppended(rows);
+    }
+}
+
+}
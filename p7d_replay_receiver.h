@@ -0,0 +1,102 @@
+#ifndef P7_DUMP_REPLAY_RECEIVER
+#define P7_DUMP_REPLAY_RECEIVER
+
+#include <atomic>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <QObject>
+#include "p7d_model.h"
+#include "p7d_spsc_queue.h"
+#include "p7d_transport.h"
+
+namespace p7 {
+
+// Live ingestion of a dump sent by tools/p7dreplay over the exchange of
+// p7d_transport.h: a client says hello with the dump header, then sends
+// sH_User_Data chunks as they are stored in *.p7d files, which are
+// acknowledged once queued. This is not the Baical server: it takes one
+// client at a time on the loopback interface.
+//
+// The socket thread only answers the client and copies payloads to a
+// lock-free queue. The decoder thread drains the queue into a dump of
+// its own and hands what it decoded to the thread of the model in
+// batches (see p7DumpData::rowsSince()), one at a time: views read the
+// dump of the model without locks, so only that thread may append to it.
+class P7ReplayReceiver : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    explicit P7ReplayReceiver(P7DumpModel * model, QObject *parent = nullptr);
+    ~P7ReplayReceiver() override;
+
+    // Empties the model and listens on the loopback interface
+    bool start(quint16 port);
+    // Shows all datagrams received so far and stops listening
+    void stop();
+
+    bool isListening() const;
+    quint16 port() const;
+
+    // hellos and data packets taken
+    uint64_t datagramsCount() const;
+    // refused while the queue was full (the client sends them again),
+    // malformed datagrams
+    uint64_t droppedCount() const;
+
+    Q_SIGNAL void rowsAppended(int rows);
+    Q_SIGNAL void headerReceived();
+
+private:
+
+    struct Datagram
+    {
+        std::vector<uint8_t> data; // keeps capacity between datagrams
+        size_t size = 0;
+        bool header = false; // sP7File_Header of a hello, else chunks
+    };
+
+    void receive(quint16 port, std::promise<bool> bound);
+
+    void decode();
+    // one batch of the queue, false if the queue is empty now
+    bool decodeBatch();
+    // what was decoded since the previous batch goes to _shipped
+    void shipDecoded();
+    // appends _shipped to the model
+    void showDecoded();
+
+    P7DumpModel * _model;
+
+    p7SpscQueue<Datagram> _queue;
+    std::thread _socketThread;
+    std::atomic<bool> _stop{false};
+    std::atomic<uint64_t> _datagrams{0};
+    std::atomic<uint64_t> _dropped{0};
+    quint16 _port = 0;
+
+    // the decoder thread's while listening
+    std::thread _decodeThread;
+    std::unique_ptr<p7DumpImporter> _importer;
+    p7DumpData _decoded;
+    p7BatchCursor _cursor;
+    std::vector<uint8_t> _batch; // chunks of datagrams of one batch
+    bool _headerDecoded = false;
+
+    std::mutex _decodeMutex;
+    std::condition_variable _decodeWake;
+    bool _received = false;   // datagrams were queued
+    bool _decodeStop = false; // the queue gets no more datagrams
+    bool _unshipped = false;  // _decoded has rows not in a batch yet
+    std::unique_ptr<p7RowsBatch> _shipped; // for showDecoded()
+    bool _headerShipped = false;
+};
+
+}
+
+#endif
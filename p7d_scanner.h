@@ -0,0 +1,202 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                             /
+// 2022 (c) Ragnar Lodbrok                                                     /
+//                                                                             /
+// This library is free software; you can redistribute it and/or               /
+// modify it under the terms of the GNU Lesser General Public                  /
+// License as published by the Free Software Foundation; either                /
+// version 3.0 of the License, or (at your option) any later version.          /
+//                                                                             /
+// This library is distributed in the hope that it will be useful,             /
+// but WITHOUT ANY WARRANTY; without even the implied warranty of              /
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU           /
+// Lesser General Public License for more details.                             /
+//                                                                             /
+// You should have received a copy of the GNU Lesser General Public            /
+// License along with this library.                                            /
+//                                                                             /
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef P7_DUMP_SCANNER_H
+#define P7_DUMP_SCANNER_H
+
+#include <stdio.h>
+#include <atomic>
+#include <string>
+#include <vector>
+#include "importer.h"
+
+namespace p7 {
+
+// Header-only walk over the trace packets of a dump file: chunks are
+// framed the way p7DumpImporter frames them and packets are visited in
+// place, descriptions are not parsed and nothing is formatted. Packets
+// of other streams (telemetry) are skipped unread. Used by
+// p7DumpCatalog and p7DumpSummary.
+//
+// The visitor gets
+//   void data(uint8_t channelId, const sP7Trace_Data * trace,
+//             uint64_t time, uint64_t chunkOffset);
+//   void packet(uint8_t channelId, const sP7Ext_Header * packet);
+//   void chunk(uint8_t channelId, uint64_t offset, uint64_t end,
+//              bool metadata);
+// data() for data packets with the timestamp of the row (100ns since
+// 1601), packet() for the other trace packets and chunk() after every
+// chunk of a trace stream, metadata if it had non-data packets.
+// A scan stops at the next chunk once cancelled is set.
+class p7DumpScanner
+{
+public:
+
+    // False if the file can't be read or isn't a dump, or if the scan
+    // was cancelled
+    template<typename Visitor>
+    static bool scan(const std::string & fileName,
+                     sP7File_Header & header,
+                     Visitor & visitor,
+                     const std::atomic<bool> * cancelled = nullptr)
+    {
+        FILE * file = fopen(fileName.c_str(), "rb");
+        if (!file) {
+            return false;
+        }
+
+        const uint64_t fileSize = p7::fileSize(file);
+
+        if (    (fread(&header, sizeof(header), 1, file) != 1)
+             || (P7_DAMP_FILE_MARKER_V1 != header.qwMarker)
+           )
+        {
+            fclose(file);
+            return false;
+        }
+
+        struct Channel
+        {
+            enum class Type { Unknown, Trace, Other } type = Type::Unknown;
+            uint64_t startTime = 0;
+            uint64_t timerValue = 0;
+            uint64_t timerFrequency = 0;
+        };
+        std::vector<Channel> channels(USER_PACKET_CHANNEL_ID_MAX_SIZE);
+
+        // packets are read in place, the padding keeps a truncated
+        // sP7Trace_Data at the end of a chunk inside the buffer
+        std::vector<uint8_t> chunk;
+        uint64_t offset = sizeof(header);
+        sH_User_Data chunkHeader;
+
+        while (fread(&chunkHeader, sizeof(chunkHeader), 1, file) == 1) {
+            if (cancelled && *cancelled) {
+                fclose(file);
+                return false;
+            }
+
+            if (    (chunkHeader.dwSize < sizeof(sH_User_Data))
+                 || (offset + chunkHeader.dwSize > fileSize)
+               )
+            {
+                break;
+            }
+
+            const size_t size = chunkHeader.dwSize - sizeof(sH_User_Data);
+            const uint8_t channelId = (uint8_t)chunkHeader.dwChannel_ID;
+            Channel & channel = channels[channelId];
+
+            // a seek drops the stdio buffer, small chunks are read through
+            if (channel.type == Channel::Type::Other) {
+                if (size > 64 * 1024) {
+                    if (!seekFile(file, (int64_t)size, SEEK_CUR)) {
+                        break;
+                    }
+                } else {
+                    chunk.resize(size);
+                    if (fread(chunk.data(), 1, size, file) != size) {
+                        break;
+                    }
+                }
+                offset += chunkHeader.dwSize;
+                continue;
+            }
+
+            chunk.assign(size + sizeof(sP7Trace_Data), 0);
+            if (fread(chunk.data(), 1, size, file) != size) {
+                break;
+            }
+
+            if (    (channel.type == Channel::Type::Unknown)
+                 && (size >= sizeof(sP7Ext_Header))
+               )
+            {
+                const sP7Ext_Header * streamHeader
+                        = (const sP7Ext_Header *)chunk.data();
+                channel.type = streamHeader->dwType == EP7USER_TYPE_TRACE
+                        ? Channel::Type::Trace
+                        : Channel::Type::Other;
+            }
+
+            if (channel.type == Channel::Type::Trace) {
+                bool metadata = false;
+                const uint8_t * packet = chunk.data();
+                const uint8_t * end = chunk.data() + size;
+
+                while (packet + sizeof(sP7Ext_Header) <= end) {
+                    const sP7Ext_Header * packetHeader
+                            = (const sP7Ext_Header *)packet;
+                    if (    (packetHeader->dwSize < sizeof(sP7Ext_Header))
+                         || (packet + packetHeader->dwSize > end)
+                       )
+                    {
+                        break;
+                    }
+
+                    if (EP7TRACE_TYPE_DATA == packetHeader->dwSubType) {
+                        const sP7Trace_Data * trace
+                                = (const sP7Trace_Data *)packet;
+                        visitor.data(channelId,
+                                     trace,
+                                     timerToTimestamp(channel.startTime,
+                                                      channel.timerValue,
+                                                      channel.timerFrequency,
+                                                      trace->qwTimer),
+                                     offset);
+                    } else {
+                        metadata = true;
+
+                        if (EP7TRACE_TYPE_INFO == packetHeader->dwSubType) {
+                            const sP7Trace_Info * info
+                                    = (const sP7Trace_Info *)packet;
+                            channel.startTime
+                                    = ((uint64_t)info->dwTime_Hi << 32)
+                                    + (uint64_t)info->dwTime_Lo;
+                            channel.timerValue = info->qwTimer_Value;
+                            channel.timerFrequency = info->qwTimer_Frequency;
+                        } else if (EP7TRACE_TYPE_CLOSE
+                                       == packetHeader->dwSubType) {
+                            // the importer skips the rest of the chunk
+                            break;
+                        }
+
+                        visitor.packet(channelId, packetHeader);
+                    }
+
+                    packet += packetHeader->dwSize;
+                }
+
+                visitor.chunk(channelId,
+                              offset,
+                              offset + chunkHeader.dwSize,
+                              metadata);
+            }
+
+            offset += chunkHeader.dwSize;
+        }
+
+        fclose(file);
+        return true;
+    }
+};
+
+}
+
+#endif // P7_DUMP_SCANNER_H
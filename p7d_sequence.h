@@ -0,0 +1,389 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                             /
+// 2022 (c) Ragnar Lodbrok                                                     /
+//                                                                             /
+// This library is free software; you can redistribute it and/or               /
+// modify it under the terms of the GNU Lesser General Public                  /
+// License as published by the Free Software Foundation; either                /
+// version 3.0 of the License, or (at your option) any later version.          /
+//                                                                             /
+// This library is distributed in the hope that it will be useful,             /
+// but WITHOUT ANY WARRANTY; without even the implied warranty of              /
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU           /
+// Lesser General Public License for more details.                             /
+//                                                                             /
+// You should have received a copy of the GNU Lesser General Public            /
+// License along with this library.                                            /
+//                                                                             /
+////////////////////////////////////////////////////////////////////////////////
+
+
+
+#ifndef P7_DUMP_SEQUENCE_H
+#define P7_DUMP_SEQUENCE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include <QString>
+
+namespace p7 {
+
+// Anomaly of the sequence numbers of a trace stream. The P7 client gives
+// every trace of a channel the next number (sP7Trace_Data::dwSequence),
+// so a gap means it dropped traces, e.g. its buffers overflowed under
+// load.
+struct p7SequenceEvent
+{
+    enum Kind : uint8_t
+    {
+        Gap = 0,   // numbers are missing before the packet
+        Duplicate, // the number came already
+        Reordered, // a missing number of an earlier gap came late
+        Restart,   // far from the highest number, counting starts again
+        KindsCount
+    };
+
+    // number of the row of the packet, or of the next imported row if the
+    // packet was filtered out
+    uint64_t row = 0;
+    uint32_t sequence = 0; // of the packet
+    uint32_t count = 0;    // Gap: numbers missing; Reordered: behind the highest
+    uint32_t late = 0;     // Gap: missing numbers which came later
+    uint8_t kind = Gap;
+
+    // numbers still missing
+    uint32_t missing() const
+    {
+        return kind == Gap ? count - late : 0;
+    }
+};
+
+// Checks sequence numbers of packets of a stream as they are decoded,
+// before the import filter, so filtered out rows are no gaps. Numbers
+// are collected in batches and a batch is compared to consecutive
+// numbers by a branch-free loop the compiler vectorizes; only a batch
+// with an anomaly is walked packet by packet. A number behind the
+// highest one is looked for in the last open gaps (Reordered) before it
+// is a duplicate. Counters cover all packets, events are kept up to
+// maxEvents().
+class p7SequenceCheck
+{
+public:
+
+    typedef std::pair<const p7SequenceEvent *, const p7SequenceEvent *> Range;
+
+    // packets checked at once
+    static constexpr size_t batchSize()
+    {
+        return 256;
+    }
+
+    // gaps a late number is looked for in
+    static constexpr size_t openGapsCount()
+    {
+        return 64;
+    }
+
+    // numbers a packet may be behind or ahead of the highest one, farther
+    // is a new count (a restarted client) rather than millions of drops
+    static constexpr uint32_t restartDistance()
+    {
+        return 1u << 24;
+    }
+
+    static constexpr size_t maxEvents()
+    {
+        return 1u << 18;
+    }
+
+    // row: number of the packet's row if it passes the import filter
+    void addPacket(uint32_t sequence, uint64_t row)
+    {
+        _sequences[_batch] = sequence;
+        _rows[_batch] = row;
+        if (++_batch == batchSize()) {
+            flush();
+        }
+    }
+
+    // Checks packets added so far, called once chunks of the stream are
+    // decoded
+    void flush()
+    {
+        if (!_batch) {
+            return;
+        }
+
+        if (!_started) {
+            _highest = _sequences[0] - 1;
+            _started = true;
+        }
+
+        // all numbers follow the highest one by one
+        uint32_t steps = (_sequences[0] - _highest) ^ 1u;
+        for (size_t i = 1; i < _batch; ++i) {
+            steps |= (_sequences[i] - _sequences[i - 1]) ^ 1u;
+        }
+
+        if (!steps) {
+            _highest = _sequences[_batch - 1];
+        } else {
+            for (size_t i = 0; i < _batch; ++i) {
+                check(_sequences[i], _rows[i]);
+            }
+        }
+
+        _packets += _batch;
+        _batch = 0;
+    }
+
+    // Numbers of a new session of the channel (sP7Trace_Info) and of
+    // packets after a part of the file which wasn't read start a new count
+    void restart()
+    {
+        flush();
+        _started = false;
+        _openGaps.clear();
+    }
+
+    uint64_t packets() const
+    {
+        return _packets;
+    }
+
+    uint64_t gaps() const
+    {
+        return _counts[p7SequenceEvent::Gap];
+    }
+
+    // numbers of all gaps which didn't come later
+    uint64_t missing() const
+    {
+        return _missing;
+    }
+
+    uint64_t duplicates() const
+    {
+        return _counts[p7SequenceEvent::Duplicate];
+    }
+
+    uint64_t reordered() const
+    {
+        return _counts[p7SequenceEvent::Reordered];
+    }
+
+    uint64_t restarts() const
+    {
+        return _counts[p7SequenceEvent::Restart];
+    }
+
+    uint64_t anomalies() const
+    {
+        return gaps() + duplicates() + reordered() + restarts();
+    }
+
+    // Events ordered by row, several of them may share a row
+    const std::vector<p7SequenceEvent> & events() const
+    {
+        return _events;
+    }
+
+    // events over maxEvents(), counted only
+    uint64_t eventsOmitted() const
+    {
+        return anomalies() - _events.size();
+    }
+
+    Range eventsAt(uint64_t row) const
+    {
+        auto less = [](const p7SequenceEvent & event, uint64_t row) {
+            return event.row < row;
+        };
+        auto first = std::lower_bound(_events.begin(), _events.end(),
+                                      row, less);
+        auto last = first;
+        while (last != _events.end() && last->row == row) {
+            ++last;
+        }
+        return Range(_events.data() + (first - _events.begin()),
+                     _events.data() + (last - _events.begin()));
+    }
+
+    // A row follows traces dropped by the client (missing still)
+    bool hasGapAt(uint64_t row) const
+    {
+        if (_events.empty()) {
+            return false;
+        }
+        const Range range = eventsAt(row);
+        for (const p7SequenceEvent * event = range.first;
+             event != range.second;
+             ++event)
+        {
+            if (event->missing()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    size_t memoryUsage() const
+    {
+        return batchSize() * (sizeof(uint32_t) + sizeof(uint64_t))
+                + _events.capacity() * sizeof(p7SequenceEvent)
+                + _openGaps.capacity() * sizeof(OpenGap);
+    }
+
+private:
+
+    // a gap with numbers which may still come late
+    struct OpenGap
+    {
+        uint32_t sequence = 0; // of the packet after the gap
+        uint32_t count = 0;
+        uint32_t late = 0;
+        uint32_t event = 0;    // index in _events or noEvent()
+    };
+
+    static constexpr uint32_t noEvent()
+    {
+        return UINT32_MAX;
+    }
+
+    void check(uint32_t sequence, uint64_t row)
+    {
+        const uint32_t ahead = sequence - _highest;
+        if (ahead == 1) {
+            _highest = sequence;
+            return;
+        }
+
+        const uint32_t behind = _highest - sequence;
+        if (    (ahead > restartDistance())
+             && (behind > restartDistance())
+           )
+        {
+            addEvent(p7SequenceEvent::Restart, sequence, row, 0);
+            _highest = sequence;
+            _openGaps.clear();
+            return;
+        }
+
+        if (ahead && ahead <= restartDistance()) {
+            // tracked even if the event is counted only, so its late
+            // numbers aren't duplicates
+            OpenGap gap;
+            gap.sequence = sequence;
+            gap.count = ahead - 1;
+            gap.event = addEvent(p7SequenceEvent::Gap, sequence, row,
+                                 ahead - 1)
+                    ? (uint32_t)(_events.size() - 1) : noEvent();
+            if (_openGaps.size() == openGapsCount()) {
+                _openGaps.erase(_openGaps.begin());
+            }
+            _openGaps.push_back(gap);
+            _missing += ahead - 1;
+            _highest = sequence;
+            return;
+        }
+
+        // the newest gap first, a gap is closed once all its numbers came
+        for (size_t i = _openGaps.size(); i-- > 0; ) {
+            OpenGap & gap = _openGaps[i];
+            if (gap.sequence - sequence - 1 < gap.count) {
+                if (gap.event != noEvent()) {
+                    _events[gap.event].late++;
+                }
+                if (++gap.late == gap.count) {
+                    _openGaps.erase(_openGaps.begin() + (ptrdiff_t)i);
+                }
+                --_missing;
+                addEvent(p7SequenceEvent::Reordered, sequence, row, behind);
+                return;
+            }
+        }
+
+        addEvent(p7SequenceEvent::Duplicate, sequence, row, 0);
+    }
+
+    // false if the event is counted only
+    bool addEvent(uint8_t kind, uint32_t sequence, uint64_t row, uint32_t count)
+    {
+        ++_counts[kind];
+        if (_events.size() >= maxEvents()) {
+            return false;
+        }
+
+        p7SequenceEvent event;
+        event.row = row;
+        event.sequence = sequence;
+        event.count = count;
+        event.kind = kind;
+        _events.push_back(event);
+        return true;
+    }
+
+    std::vector<uint32_t> _sequences = std::vector<uint32_t>(batchSize());
+    std::vector<uint64_t> _rows = std::vector<uint64_t>(batchSize());
+    size_t _batch = 0;
+
+    bool _started = false;
+    uint32_t _highest = 0;
+
+    uint64_t _packets = 0;
+    uint64_t _missing = 0;
+    uint64_t _counts[p7SequenceEvent::KindsCount] = {};
+    std::vector<p7SequenceEvent> _events;
+    std::vector<OpenGap> _openGaps; // the last ones, oldest first
+};
+
+static inline QString sequenceEventAsString(const p7SequenceEvent & event)
+{
+    switch (event.kind) {
+    case p7SequenceEvent::Gap:
+        if (!event.missing()) {
+            return QString("%1 traces before sequence number %2 came later")
+                    .arg(event.count).arg(event.sequence);
+        }
+        return event.late
+                ? QString("%1 of %2 traces missing before sequence number"
+                          " %3, the rest came later")
+                  .arg(event.missing()).arg(event.count).arg(event.sequence)
+                : QString("%1 traces missing before sequence number %2")
+                  .arg(event.count).arg(event.sequence);
+    case p7SequenceEvent::Duplicate:
+        return QString("Sequence number %1 came again").arg(event.sequence);
+    case p7SequenceEvent::Reordered:
+        return QString("Sequence number %1 came late, %2 behind")
+                .arg(event.sequence).arg(event.count);
+    case p7SequenceEvent::Restart:
+        return QString("Sequence numbers start again at %1")
+                .arg(event.sequence);
+    default:
+        break;
+    }
+    return QString();
+}
+
+static inline QString sequenceCheckAsString(const p7SequenceCheck & check)
+{
+    QString text = QString("%1 traces checked, %2 gaps (%3 traces missing),"
+                           " %4 duplicates, %5 reordered, %6 restarts")
+            .arg(check.packets())
+            .arg(check.gaps())
+            .arg(check.missing())
+            .arg(check.duplicates())
+            .arg(check.reordered())
+            .arg(check.restarts());
+    if (check.eventsOmitted()) {
+        text += QString(", %1 not listed").arg(check.eventsOmitted());
+    }
+    return text;
+}
+
+} // namespace p7
+
+#endif // P7_DUMP_SEQUENCE_H
@@ -0,0 +1,115 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                             /
+// 2022 (c) Ragnar Lodbrok                                                     /
+//                                                                             /
+// This library is free software; you can redistribute it and/or               /
+// modify it under the terms of the GNU Lesser General Public                  /
+// License as published by the Free Software Foundation; either                /
+// version 3.0 of the License, or (at your option) any later version.          /
+//                                                                             /
+// This library is distributed in the hope that it will be useful,             /
+// but WITHOUT ANY WARRANTY; without even the implied warranty of              /
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU           /
+// Lesser General Public License for more details.                             /
+//                                                                             /
+// You should have received a copy of the GNU Lesser General Public            /
+// License along with this library.                                            /
+//                                                                             /
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef P7_DUMP_SPSC_QUEUE_H
+#define P7_DUMP_SPSC_QUEUE_H
+
+#include <stddef.h>
+#include <atomic>
+#include <vector>
+
+namespace p7 {
+
+// Bounded lock-free queue for one producer and one consumer thread.
+// Slots are allocated once and reused: the producer fills the slot
+// returned by producerSlot() and publishes it with push(), the consumer
+// reads consumerSlot() in place and releases it with pop(), so slot
+// buffers (e.g. vectors) keep their capacity and nothing is allocated
+// per item.
+template<typename T>
+class p7SpscQueue
+{
+public:
+
+    // capacity is rounded up to a power of two
+    explicit p7SpscQueue(size_t capacity)
+    {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        _slots.resize(size);
+        _mask = size - 1;
+    }
+
+    p7SpscQueue(const p7SpscQueue &) = delete;
+    p7SpscQueue& operator=(const p7SpscQueue &) = delete;
+
+    size_t capacity() const
+    {
+        return _slots.size();
+    }
+
+    // Producer: free slot to fill or nullptr if the queue is full
+    T * producerSlot()
+    {
+        const size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _headCache == _slots.size()) {
+            _headCache = _head.load(std::memory_order_acquire);
+            if (tail - _headCache == _slots.size()) {
+                return nullptr;
+            }
+        }
+        return &_slots[tail & _mask];
+    }
+
+    // Producer: publishes the slot returned by producerSlot()
+    void push()
+    {
+        _tail.store(_tail.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_release);
+    }
+
+    // Consumer: oldest published slot or nullptr if the queue is empty
+    T * consumerSlot()
+    {
+        const size_t head = _head.load(std::memory_order_relaxed);
+        if (head == _tailCache) {
+            _tailCache = _tail.load(std::memory_order_acquire);
+            if (head == _tailCache) {
+                return nullptr;
+            }
+        }
+        return &_slots[head & _mask];
+    }
+
+    // Consumer: gives the slot returned by consumerSlot() back
+    void pop()
+    {
+        _head.store(_head.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_release);
+    }
+
+private:
+
+    std::vector<T> _slots;
+    size_t _mask = 0;
+
+    // indexes grow forever, slot is index & _mask; each side caches the
+    // other one to touch the shared cache line only when needed
+    alignas(64) std::atomic<size_t> _tail{0};
+    size_t _headCache = 0;
+
+    alignas(64) std::atomic<size_t> _head{0};
+    size_t _tailCache = 0;
+};
+
+}
+
+#endif // P7_DUMP_SPSC_QUEUE_H
@@ -0,0 +1,458 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                             /
+// 2022 (c) Ragnar Lodbrok                                                     /
+//                                                                             /
+// This library is free software; you can redistribute it and/or               /
+// modify it under the terms of the GNU Lesser General Public                  /
+// License as published by the Free Software Foundation; either                /
+// version 3.0 of the License, or (at your option) any later version.          /
+//                                                                             /
+// This library is distributed in the hope that it will be useful,             /
+// but WITHOUT ANY WARRANTY; without even the implied warranty of              /
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU           /
+// Lesser General Public License for more details.                             /
+//                                                                             /
+// You should have received a copy of the GNU Lesser General Public            /
+// License along with this library.                                            /
+//                                                                             /
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef P7_DUMP_SUMMARY_H
+#define P7_DUMP_SUMMARY_H
+
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <QElapsedTimer>
+#include <QString>
+#include "p7d_scanner.h"
+
+namespace p7 {
+
+// Overview of dumps made from packet headers only (p7DumpScanner): rows
+// per level, module, thread and trace ID and the time span. Messages are
+// never formatted and rows never become strings, so a summary takes a
+// fraction of an import and is ready long before it.
+struct p7DumpSummary
+{
+    // rows of a module, thread or trace ID
+    struct Count
+    {
+        uint8_t channelId = 0;  // modules and trace IDs are per channel
+        uint32_t id = 0;
+        std::string name;       // module or thread, UTF-8, may be empty
+        eP7Trace_Level level = EP7TRACE_LEVEL_COUNT; // trace IDs: last row
+        uint64_t rows = 0;
+    };
+
+    QString hostName;
+    QString processName;
+    uint32_t processId = 0;
+
+    size_t files = 0;
+    uint64_t bytes = 0;
+    uint64_t rows = 0;
+    uint64_t levelRows[EP7TRACE_LEVEL_COUNT] = {};
+    uint64_t fromTime = 0;  // the earliest and the latest row, 100ns
+    uint64_t toTime = 0;    // since 1601, 0 - no rows
+    uint32_t channels = 0;  // trace channels
+
+    // most rows first
+    std::vector<Count> modules;
+    std::vector<Count> threads;
+    std::vector<Count> traceIds;
+
+    qint64 scanNs = 0;
+
+    bool hasErrors() const
+    {
+        return  (levelRows[EP7TRACE_LEVEL_ERROR])
+             || (levelRows[EP7TRACE_LEVEL_CRITICAL]);
+    }
+
+    // Summary of one dump file, false if it can't be read or the scan
+    // was cancelled (see p7DumpScanner)
+    static bool scan(const std::string & fileName,
+                     p7DumpSummary & summary,
+                     const std::atomic<bool> * cancelled = nullptr)
+    {
+        QElapsedTimer clock;
+        clock.start();
+
+        summary = p7DumpSummary();
+
+        Visitor visitor;
+        sP7File_Header header;
+        if (!p7DumpScanner::scan(fileName, header, visitor, cancelled)) {
+            return false;
+        }
+
+        summary.hostName
+                = QString::fromUtf16((const char16_t *)header.pHost_Name);
+        summary.processName
+                = QString::fromUtf16((const char16_t *)header.pProcess_Name);
+        summary.processId = header.dwProcess_ID;
+        summary.files = 1;
+        summary.bytes = visitor.bytes;
+        summary.rows = visitor.rows;
+        memcpy(summary.levelRows, visitor.levelRows, sizeof(visitor.levelRows));
+        if (visitor.rows && visitor.fromTime <= visitor.toTime) {
+            summary.fromTime = visitor.fromTime;
+            summary.toTime = visitor.toTime;
+        }
+
+        for (size_t i = 0; i < visitor.channels.size(); ++i) {
+            const Visitor::Channel & channel = visitor.channels[i];
+            if (!channel.trace) {
+                continue;
+            }
+            summary.channels++;
+
+            std::unordered_map<uint16_t, uint64_t> moduleRows;
+            for (size_t id = 0; id < channel.idRows.size(); ++id) {
+                if (!channel.idRows[id]) {
+                    continue;
+                }
+
+                Count count;
+                count.channelId = (uint8_t)i;
+                count.id = (uint32_t)id;
+                count.level = (eP7Trace_Level)channel.idLevels[id];
+                count.rows = channel.idRows[id];
+                summary.traceIds.push_back(count);
+
+                moduleRows[channel.idModules[id]] += channel.idRows[id];
+            }
+
+            for (const auto & module : moduleRows) {
+                Count count;
+                count.channelId = (uint8_t)i;
+                count.id = module.first;
+                auto name = channel.moduleNames.find(module.first);
+                if (name != channel.moduleNames.end()) {
+                    count.name = name->second;
+                }
+                count.rows = module.second;
+                summary.modules.push_back(count);
+            }
+        }
+
+        for (const auto & thread : visitor.threadRows) {
+            Count count;
+            count.id = thread.first;
+            auto name = visitor.threadNames.find(thread.first);
+            if (name != visitor.threadNames.end()) {
+                count.name = name->second;
+            }
+            count.rows = thread.second;
+            summary.threads.push_back(count);
+        }
+
+        summary.sortCounts();
+        summary.scanNs = clock.nsecsElapsed();
+        return true;
+    }
+
+    // Rotated dumps: files are scanned in parallel and summed, counts of
+    // the same channel and id are added up. Once cancelled is set the
+    // scan stops at the next chunk and the summary is partial.
+    static p7DumpSummary scanFiles(const std::vector<std::string> & fileNames,
+                                   const std::atomic<bool> * cancelled
+                                       = nullptr)
+    {
+        QElapsedTimer clock;
+        clock.start();
+
+        std::vector<p7DumpSummary> summaries(fileNames.size());
+        std::vector<char> valid(fileNames.size(), 0);
+
+        std::atomic<size_t> nextFile(0);
+        auto worker = [&fileNames, &summaries, &valid, &nextFile,
+                       cancelled]() {
+            size_t file;
+            while ((file = nextFile++) < fileNames.size()) {
+                valid[file] = scan(fileNames[file], summaries[file], cancelled);
+            }
+        };
+
+        size_t threadsCount = std::min<size_t>(
+                    fileNames.size(),
+                    std::max(1u, std::thread::hardware_concurrency()));
+
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < threadsCount; ++i) {
+            threads.emplace_back(worker);
+        }
+
+        worker();
+
+        for (std::thread & thread : threads) {
+            thread.join();
+        }
+
+        p7DumpSummary summary;
+        for (size_t i = 0; i < summaries.size(); ++i) {
+            if (valid[i]) {
+                summary.add(summaries[i]);
+            }
+        }
+        summary.scanNs = clock.nsecsElapsed();
+        return summary;
+    }
+
+    void add(const p7DumpSummary & other)
+    {
+        if (!files) {
+            hostName = other.hostName;
+            processName = other.processName;
+            processId = other.processId;
+        }
+
+        if (other.rows) {
+            fromTime = rows ? (std::min)(fromTime, other.fromTime)
+                            : other.fromTime;
+            toTime = (std::max)(toTime, other.toTime);
+        }
+
+        files += other.files;
+        bytes += other.bytes;
+        rows += other.rows;
+        for (int i = 0; i < EP7TRACE_LEVEL_COUNT; ++i) {
+            levelRows[i] += other.levelRows[i];
+        }
+        channels = (std::max)(channels, other.channels);
+
+        addCounts(modules, other.modules);
+        addCounts(threads, other.threads);
+        addCounts(traceIds, other.traceIds);
+        sortCounts();
+    }
+
+private:
+
+    struct Visitor
+    {
+        struct Channel
+        {
+            bool trace = false;
+            // by trace ID: rows, level of the last row, module of the
+            // description
+            std::vector<uint64_t> idRows;
+            std::vector<uint8_t> idLevels;
+            std::vector<uint16_t> idModules;
+            std::unordered_map<uint16_t, std::string> moduleNames;
+        };
+
+        Visitor()
+            : channels(USER_PACKET_CHANNEL_ID_MAX_SIZE)
+        {}
+
+        void data(uint8_t channelId,
+                  const sP7Trace_Data * trace,
+                  uint64_t time,
+                  uint64_t)
+        {
+            Channel & channel = channels[channelId];
+            if (channel.idRows.empty()) {
+                channel.idRows.assign(UINT16_MAX + 1, 0);
+                channel.idLevels.assign(UINT16_MAX + 1, EP7TRACE_LEVEL_COUNT);
+            }
+            if (channel.idModules.empty()) {
+                channel.idModules.assign(UINT16_MAX + 1, 0);
+            }
+
+            rows++;
+            if (trace->bLevel < EP7TRACE_LEVEL_COUNT) {
+                levelRows[trace->bLevel]++;
+            }
+            if (time != UINT64_MAX) {
+                fromTime = (std::min)(fromTime, time);
+                toTime = (std::max)(toTime, time);
+            }
+
+            channel.idRows[trace->wID]++;
+            channel.idLevels[trace->wID] = trace->bLevel;
+
+            // rows of a thread mostly come in runs
+            if (!lastThreadRows || trace->dwThreadID != lastThread) {
+                lastThread = trace->dwThreadID;
+                lastThreadRows = &threadRows[lastThread];
+            }
+            (*lastThreadRows)++;
+        }
+
+        void packet(uint8_t channelId, const sP7Ext_Header * packet)
+        {
+            Channel & channel = channels[channelId];
+
+            if (    (EP7TRACE_TYPE_DESC == packet->dwSubType)
+                 && (packet->dwSize >= sizeof(sP7Trace_Format))
+               )
+            {
+                const sP7Trace_Format * desc = (const sP7Trace_Format *)packet;
+                if (channel.idModules.empty()) {
+                    channel.idModules.assign(UINT16_MAX + 1, 0);
+                }
+                channel.idModules[desc->wID] = desc->wModuleID;
+            } else if (    (EP7TRACE_TYPE_MODULE == packet->dwSubType)
+                        && (packet->dwSize >= sizeof(sP7Trace_Module))
+                      )
+            {
+                const sP7Trace_Module * module = (const sP7Trace_Module *)packet;
+                channel.moduleNames[module->wModuleID]
+                        = name(module->pName, P7TRACE_MODULE_NAME_LENGTH);
+            } else if (    (EP7TRACE_TYPE_THREAD_START == packet->dwSubType)
+                        && (packet->dwSize >= sizeof(sP7Trace_Thread_Start))
+                      )
+            {
+                const sP7Trace_Thread_Start * thread
+                        = (const sP7Trace_Thread_Start *)packet;
+                threadNames[thread->dwThreadID]
+                        = name(thread->pName, P7TRACE_THREAD_NAME_LENGTH);
+            }
+        }
+
+        void chunk(uint8_t channelId, uint64_t, uint64_t end, bool)
+        {
+            channels[channelId].trace = true;
+            bytes = (std::max)(bytes, end);
+        }
+
+        static std::string name(const int8_t * text, size_t size)
+        {
+            const char * begin = (const char *)text;
+            return std::string(begin, strnlen(begin, size));
+        }
+
+        std::vector<Channel> channels;
+        std::unordered_map<uint32_t, uint64_t> threadRows;
+        std::unordered_map<uint32_t, std::string> threadNames;
+        uint32_t lastThread = 0;
+        uint64_t * lastThreadRows = nullptr;
+
+        uint64_t bytes = 0;
+        uint64_t rows = 0;
+        uint64_t levelRows[EP7TRACE_LEVEL_COUNT] = {};
+        uint64_t fromTime = UINT64_MAX;
+        uint64_t toTime = 0;
+    };
+
+    static void addCounts(std::vector<Count> & counts,
+                          const std::vector<Count> & other)
+    {
+        auto key = [](const Count & count) {
+            return ((uint64_t)count.channelId << 32) | count.id;
+        };
+
+        std::unordered_map<uint64_t, size_t> indexes;
+        for (size_t i = 0; i < counts.size(); ++i) {
+            indexes[key(counts[i])] = i;
+        }
+
+        for (const Count & count : other) {
+            auto it = indexes.find(key(count));
+            if (it == indexes.end()) {
+                indexes[key(count)] = counts.size();
+                counts.push_back(count);
+                continue;
+            }
+
+            Count & existing = counts[it->second];
+            existing.rows += count.rows;
+            existing.level = count.level;
+            if (existing.name.empty()) {
+                existing.name = count.name;
+            }
+        }
+    }
+
+    void sortCounts()
+    {
+        auto byRows = [](const Count & a, const Count & b) {
+            return a.rows > b.rows;
+        };
+        std::stable_sort(modules.begin(), modules.end(), byRows);
+        std::stable_sort(threads.begin(), threads.end(), byRows);
+        std::stable_sort(traceIds.begin(), traceIds.end(), byRows);
+    }
+};
+
+// Text of a summary, at most top entries of modules, threads and IDs
+static inline QString summaryAsString(const p7DumpSummary & summary, size_t top = 10)
+{
+    auto timeText = [](uint64_t time) {
+        return unpackDateTime(time).toString("yyyy-MM-dd HH:mm:ss.zzz");
+    };
+
+    QString text;
+    text += QString("Host: %1, process: %2 (%3)\n")
+            .arg(summary.hostName)
+            .arg(summary.processName)
+            .arg(summary.processId);
+    if (summary.files > 1) {
+        text += QString("Files: %1\n").arg(summary.files);
+    }
+    text += QString("Rows: %1 in %2 trace channels, %3 MB\n")
+            .arg(summary.rows)
+            .arg(summary.channels)
+            .arg((double)summary.bytes / (1024.0 * 1024.0), 0, 'f', 1);
+    if (summary.rows) {
+        text += QString("Time: %1 - %2 (%3 s)\n")
+                .arg(timeText(summary.fromTime))
+                .arg(timeText(summary.toTime))
+                .arg((double)(summary.toTime - summary.fromTime) / 1e7,
+                     0, 'f', 3);
+    }
+    text += QString("Errors: %1\n").arg(summary.hasErrors() ? "yes" : "no");
+
+    text += "Rows per level:\n";
+    for (int i = 0; i < EP7TRACE_LEVEL_COUNT; ++i) {
+        if (summary.levelRows[i]) {
+            text += QString("  %1: %2\n")
+                    .arg(traceLevelAsString((eP7Trace_Level)i))
+                    .arg(summary.levelRows[i]);
+        }
+    }
+
+    auto counts = [&text, top](const char * title,
+                               const std::vector<p7DumpSummary::Count> & counts,
+                               bool channels) {
+        if (counts.empty()) {
+            return;
+        }
+        text += QString("%1 (%2, top %3):\n")
+                .arg(title)
+                .arg(counts.size())
+                .arg((std::min)(top, counts.size()));
+        for (size_t i = 0; i < counts.size() && i < top; ++i) {
+            const p7DumpSummary::Count & count = counts[i];
+            QString line = channels
+                    ? QString("  #%1 %2").arg(count.channelId).arg(count.id)
+                    : QString("  0x%1").arg(count.id, 0, 16);
+            if (!count.name.empty()) {
+                line += " " + QString::fromStdString(count.name);
+            }
+            if (count.level < EP7TRACE_LEVEL_COUNT) {
+                line += " " + traceLevelAsString(count.level);
+            }
+            text += QString("%1: %2\n").arg(line).arg(count.rows);
+        }
+    };
+
+    counts("Modules", summary.modules, true);
+    counts("Threads", summary.threads, false);
+    counts("Trace IDs", summary.traceIds, true);
+
+    text += QString("Scanned in %1 ms\n")
+            .arg((double)summary.scanNs / 1e6, 0, 'f', 1);
+
+    return text;
+}
+
+}
+
+#endif // P7_DUMP_SUMMARY_H
@@ -0,0 +1,511 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                             /
+// 2022 (c) Ragnar Lodbrok                                                     /
+//                                                                             /
+// This library is free software; you can redistribute it and/or               /
+// modify it under the terms of the GNU Lesser General Public                  /
+// License as published by the Free Software Foundation; either                /
+// version 3.0 of the License, or (at your option) any later version.          /
+//                                                                             /
+// This library is distributed in the hope that it will be useful,             /
+// but WITHOUT ANY WARRANTY; without even the implied warranty of              /
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU           /
+// Lesser General Public License for more details.                             /
+//                                                                             /
+// You should have received a copy of the GNU Lesser General Public            /
+// License along with this library.                                            /
+//                                                                             /
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef P7_DUMP_TELEMETRY_H
+#define P7_DUMP_TELEMETRY_H
+
+#include <stdint.h>
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <vector>
+#include <QString>
+
+namespace p7 {
+
+// Point of a chart: one sample or min/max/avg of a bucket of samples
+struct p7TelemetryPoint
+{
+    uint64_t timestamp = 0; // first sample of the bucket, 100ns since 1601
+    double min = 0.0;
+    double max = 0.0;
+    double avg = 0.0;
+    uint64_t count = 0;     // samples in the bucket
+};
+
+// Samples of one telemetry counter stored as columns, plus a level of
+// detail pyramid: level N has one bucket per lodFanout() buckets of
+// level N-1 (level 0 are samples), so any time range can be drawn from
+// a bounded number of points.
+class p7TelemetrySeries
+{
+public:
+
+    static constexpr size_t lodFanout()
+    {
+        return 8;
+    }
+
+    // levels are not built below this size, raw samples are cheap enough
+    static constexpr size_t lodMinBuckets()
+    {
+        return 256;
+    }
+
+    uint16_t id = 0;
+    bool enabled = true;
+    double min = 0.0;
+    double max = 0.0;
+    double alarmMin = std::numeric_limits<double>::quiet_NaN();
+    double alarmMax = std::numeric_limits<double>::quiet_NaN();
+    QString name;
+
+    void append(uint64_t timestamp, double value)
+    {
+        _dirtyFrom = (std::min)(_dirtyFrom, _values.size());
+        _timestamps.push_back(timestamp);
+        _values.push_back(value);
+    }
+
+    size_t samplesCount() const
+    {
+        return _values.size();
+    }
+
+    uint64_t timestampAt(size_t index) const
+    {
+        return _timestamps[index];
+    }
+
+    double valueAt(size_t index) const
+    {
+        return _values[index];
+    }
+
+    uint64_t firstTimestamp() const
+    {
+        return _timestamps.empty() ? 0 : _timestamps.front();
+    }
+
+    uint64_t lastTimestamp() const
+    {
+        return _timestamps.empty() ? 0 : _timestamps.back();
+    }
+
+    size_t levelsCount() const
+    {
+        return _levels.size();
+    }
+
+    // Updates the pyramid for samples appended since the previous call:
+    // only buckets at the end of every level, samples must be ordered by
+    // time
+    void buildLod()
+    {
+        if (_dirtyFrom == noSample()) {
+            return;
+        }
+
+        size_t dirtyFrom = _dirtyFrom;
+        size_t levels = 0;
+
+        // level 1 from samples
+        size_t lowerCount = _values.size();
+        if (lowerCount > lodMinBuckets()) {
+            if (_levels.empty()) {
+                _levels.emplace_back();
+            }
+            Level & level = _levels[0];
+            dirtyFrom = (std::min)(dirtyFrom / lodFanout(), level.size());
+            level.resize(dirtyFrom);
+
+            for (size_t i = dirtyFrom * lodFanout(); i < lowerCount;
+                 i += lodFanout()) {
+                size_t end = (std::min)(lowerCount, i + lodFanout());
+                double lo = _values[i];
+                double hi = _values[i];
+                double sum = 0.0;
+                for (size_t j = i; j < end; ++j) {
+                    lo = (std::min)(lo, _values[j]);
+                    hi = (std::max)(hi, _values[j]);
+                    sum += _values[j];
+                }
+                level.append(_timestamps[i], lo, hi, sum / (double)(end - i),
+                             (uint32_t)(end - i));
+            }
+
+            lowerCount = level.size();
+            ++levels;
+        }
+
+        while (levels && lowerCount > lodMinBuckets()) {
+            if (_levels.size() == levels) {
+                _levels.emplace_back();
+            }
+            const Level & lower = _levels[levels - 1];
+            Level & level = _levels[levels];
+            dirtyFrom = (std::min)(dirtyFrom / lodFanout(), level.size());
+            level.resize(dirtyFrom);
+
+            for (size_t i = dirtyFrom * lodFanout(); i < lowerCount;
+                 i += lodFanout()) {
+                size_t end = (std::min)(lowerCount, i + lodFanout());
+                double lo = lower.min[i];
+                double hi = lower.max[i];
+                double sum = 0.0;
+                uint32_t samples = 0;
+                for (size_t j = i; j < end; ++j) {
+                    lo = (std::min)(lo, lower.min[j]);
+                    hi = (std::max)(hi, lower.max[j]);
+                    sum += lower.avg[j] * (double)lower.count[j];
+                    samples += lower.count[j];
+                }
+                level.append(lower.timestamp[i], lo, hi,
+                             sum / (double)samples, samples);
+            }
+
+            lowerCount = level.size();
+            ++levels;
+        }
+
+        _levels.resize(levels);
+        _dirtyFrom = noSample();
+    }
+
+    // Drops samples and levels, e.g. once they are copied elsewhere
+    void clearSamples()
+    {
+        _timestamps.clear();
+        _values.clear();
+        _levels.clear();
+        _dirtyFrom = noSample();
+    }
+
+    // Drops spare capacity once import is done
+    void shrinkToFit()
+    {
+        _timestamps.shrink_to_fit();
+        _values.shrink_to_fit();
+        for (Level & level : _levels) {
+            level.shrinkToFit();
+        }
+    }
+
+    // Points covering [from, to] from the finest level which gives no more
+    // than maxPoints points. One point before and after the range are
+    // included, so lines reach the edges of a chart.
+    std::vector<p7TelemetryPoint> query(uint64_t from,
+                                        uint64_t to,
+                                        size_t maxPoints) const
+    {
+        std::vector<p7TelemetryPoint> points;
+        if (_values.empty() || from > to) {
+            return points;
+        }
+
+        size_t first = 0;
+        size_t last = 0;
+        range(_timestamps, from, to, first, last);
+
+        if (last - first <= maxPoints || _levels.empty()) {
+            points.reserve(last - first);
+            for (size_t i = first; i < last; ++i) {
+                p7TelemetryPoint point;
+                point.timestamp = _timestamps[i];
+                point.min = point.max = point.avg = _values[i];
+                point.count = 1;
+                points.push_back(point);
+            }
+            return points;
+        }
+
+        const Level * level = nullptr;
+        for (const Level & candidate : _levels) {
+            level = &candidate;
+            range(level->timestamp, from, to, first, last);
+            if (last - first <= maxPoints) {
+                break;
+            }
+        }
+
+        // the coarsest level may still be too detailed for a tiny chart
+        size_t step = (last - first + maxPoints - 1) / (std::max)(maxPoints,
+                                                                  (size_t)1);
+
+        points.reserve((last - first + step - 1) / step);
+        for (size_t i = first; i < last; i += step) {
+            size_t end = (std::min)(last, i + step);
+
+            p7TelemetryPoint point;
+            point.timestamp = level->timestamp[i];
+            point.min = level->min[i];
+            point.max = level->max[i];
+            double sum = 0.0;
+            for (size_t j = i; j < end; ++j) {
+                point.min = (std::min)(point.min, level->min[j]);
+                point.max = (std::max)(point.max, level->max[j]);
+                sum += level->avg[j] * (double)level->count[j];
+                point.count += level->count[j];
+            }
+            point.avg = sum / (double)point.count;
+            points.push_back(point);
+        }
+
+        return points;
+    }
+
+    size_t memoryUsage() const
+    {
+        size_t bytes = sizeof(*this)
+                + _timestamps.capacity() * sizeof(uint64_t)
+                + _values.capacity() * sizeof(double);
+        for (const Level & level : _levels) {
+            bytes += level.memoryUsage();
+        }
+        return bytes;
+    }
+
+private:
+
+    struct Level
+    {
+        std::vector<uint64_t> timestamp;
+        std::vector<double> min;
+        std::vector<double> max;
+        std::vector<double> avg;
+        std::vector<uint32_t> count;
+
+        size_t size() const
+        {
+            return timestamp.size();
+        }
+
+        // drops buckets from size on, they are computed again
+        void resize(size_t size)
+        {
+            timestamp.resize(size);
+            min.resize(size);
+            max.resize(size);
+            avg.resize(size);
+            count.resize(size);
+        }
+
+        void shrinkToFit()
+        {
+            timestamp.shrink_to_fit();
+            min.shrink_to_fit();
+            max.shrink_to_fit();
+            avg.shrink_to_fit();
+            count.shrink_to_fit();
+        }
+
+        void append(uint64_t time, double lo, double hi, double mean,
+                    uint32_t samples)
+        {
+            timestamp.push_back(time);
+            min.push_back(lo);
+            max.push_back(hi);
+            avg.push_back(mean);
+            count.push_back(samples);
+        }
+
+        size_t memoryUsage() const
+        {
+            return timestamp.capacity() * sizeof(uint64_t)
+                    + (min.capacity() + max.capacity() + avg.capacity())
+                        * sizeof(double)
+                    + count.capacity() * sizeof(uint32_t);
+        }
+    };
+
+    // [first, last) indexes of times in [from, to] widened by one on each side
+    static void range(const std::vector<uint64_t> & times,
+                      uint64_t from,
+                      uint64_t to,
+                      size_t & first,
+                      size_t & last)
+    {
+        first = std::lower_bound(times.begin(), times.end(), from)
+                - times.begin();
+        last = std::upper_bound(times.begin() + first, times.end(), to)
+                - times.begin();
+
+        if (first > 0) {
+            --first;
+        }
+        if (last < times.size()) {
+            ++last;
+        }
+    }
+
+    static constexpr size_t noSample()
+    {
+        return std::numeric_limits<size_t>::max();
+    }
+
+    std::vector<uint64_t> _timestamps;
+    std::vector<double> _values;
+    std::vector<Level> _levels;
+    size_t _dirtyFrom = noSample(); // first sample added since buildLod()
+};
+
+// Telemetry stream (V1 or V2) of a dump: counters by id
+class p7TelemetryStream
+{
+public:
+
+    explicit p7TelemetryStream(uint8_t channelId = 0, uint32_t version = 1)
+        : _channelId(channelId)
+        , _version(version)
+    {}
+
+    uint8_t channelId() const
+    {
+        return _channelId;
+    }
+
+    uint32_t version() const
+    {
+        return _version;
+    }
+
+    QString name() const
+    {
+        return _name;
+    }
+
+    void setName(const QString & name)
+    {
+        _name = name;
+    }
+
+    uint64_t timerValue() const {
+        return _qwTimer_Value;
+    }
+
+    void setTimerValue(uint64_t timerValue) {
+        _qwTimer_Value = timerValue;
+    }
+
+    uint64_t timerFrequency() const {
+        return _qwTimer_Frequency;
+    }
+
+    void setTimerFrequency(uint64_t timerFrequency) {
+        _qwTimer_Frequency = timerFrequency;
+    }
+
+    uint64_t startTime100Ns() const {
+        return _qwStart_Time;
+    }
+
+    void setStartTime100Ns(uint64_t startTime) {
+        _qwStart_Time = startTime;
+    }
+
+    // Timer value of a sample to 100ns intervals since January 1, 1601
+    uint64_t timestamp(uint64_t timer) const
+    {
+        if (!_qwTimer_Frequency) {
+            return _qwStart_Time;
+        }
+
+        return _qwStart_Time + (uint64_t)(
+                    (double)(timer - _qwTimer_Value) * 10000000.0
+                    / (double)_qwTimer_Frequency);
+    }
+
+    p7TelemetrySeries & addSeries(uint16_t id)
+    {
+        if (id >= _seriesById.size()) {
+            _seriesById.resize((size_t)id + 1, -1);
+        }
+
+        if (_seriesById[id] < 0) {
+            _seriesById[id] = (int)_series.size();
+            _series.emplace_back(new p7TelemetrySeries());
+        }
+
+        p7TelemetrySeries & series = *_series[(size_t)_seriesById[id]];
+        series.id = id;
+        return series;
+    }
+
+    p7TelemetrySeries * seriesById(uint16_t id)
+    {
+        if (id >= _seriesById.size() || _seriesById[id] < 0) {
+            return nullptr;
+        }
+        return _series[(size_t)_seriesById[id]].get();
+    }
+
+    size_t seriesCount() const
+    {
+        return _series.size();
+    }
+
+    const p7TelemetrySeries & seriesAt(size_t index) const
+    {
+        return *_series[index];
+    }
+
+    p7TelemetrySeries & seriesAt(size_t index)
+    {
+        return *_series[index];
+    }
+
+    uint64_t samplesCount() const
+    {
+        uint64_t count = 0;
+        for (const auto & series : _series) {
+            count += series->samplesCount();
+        }
+        return count;
+    }
+
+    void buildLod()
+    {
+        for (auto & series : _series) {
+            series->buildLod();
+        }
+    }
+
+    void shrinkToFit()
+    {
+        for (auto & series : _series) {
+            series->shrinkToFit();
+        }
+    }
+
+    size_t memoryUsage() const
+    {
+        size_t bytes = sizeof(*this) + _seriesById.capacity() * sizeof(int);
+        for (const auto & series : _series) {
+            bytes += series->memoryUsage();
+        }
+        return bytes;
+    }
+
+private:
+
+    uint8_t _channelId = 0;
+    uint32_t _version = 1;
+    QString _name;
+
+    std::vector<std::unique_ptr<p7TelemetrySeries>> _series;
+    std::vector<int> _seriesById; // index in _series or -1
+
+    uint64_t _qwTimer_Value = 0;
+    uint64_t _qwTimer_Frequency = 0;
+    uint64_t _qwStart_Time = 0;
+};
+
+}
+
+#endif // P7_DUMP_TELEMETRY_H
@@ -0,0 +1,390 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                             /
+// 2022 (c) Ragnar Lodbrok                                                     /
+//                                                                             /
+// This library is free software; you can redistribute it and/or               /
+// modify it under the terms of the GNU Lesser General Public                  /
+// License as published by the Free Software Foundation; either                /
+// version 3.0 of the License, or (at your option) any later version.          /
+//                                                                             /
+// This library is distributed in the hope that it will be useful,             /
+// but WITHOUT ANY WARRANTY; without even the implied warranty of              /
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU           /
+// Lesser General Public License for more details.                             /
+//                                                                             /
+// You should have received a copy of the GNU Lesser General Public            /
+// License along with this library.                                            /
+//                                                                             /
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef P7_DUMP_THREAD_LANES_H
+#define P7_DUMP_THREAD_LANES_H
+
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "importer.h"
+
+namespace p7 {
+
+// Pixel column of a lane: rows in it and the highest level of them
+struct p7LaneBin
+{
+    uint32_t rows = 0;
+    uint8_t level = 0;
+};
+
+// Rows of one thread (id) of a stream ordered by time, as columns, plus
+// the highest level of every block of lodFanout()^N rows, so rows of any
+// time range are counted by two binary searches and their level is found
+// in O(log rows).
+struct p7ThreadLane
+{
+    static constexpr size_t lodFanout()
+    {
+        return 16;
+    }
+
+    size_t stream = 0;
+    uint32_t threadId = 0;
+    QString name;
+    // lifetimes of threads with the id from the thread table, 100ns since
+    // 1601; a running thread ends at the last row of the stream
+    std::vector<std::pair<uint64_t, uint64_t>> lifetimes;
+
+    std::vector<uint64_t> times;
+    std::vector<uint32_t> rows; // numbers truncated to 32 bits, see p7RowRef
+    std::vector<uint8_t> levels;
+    std::vector<std::vector<uint8_t>> maxLevels; // of blocks, level 1 up
+
+    size_t rowsCount() const
+    {
+        return times.size();
+    }
+
+    // Index of the first row at or after time
+    size_t rowAtTime(uint64_t time) const
+    {
+        return std::lower_bound(times.begin(), times.end(), time)
+                - times.begin();
+    }
+
+    // Highest level of rows [from, to)
+    uint8_t maxLevel(size_t from, size_t to) const
+    {
+        uint8_t level = 0;
+        const std::vector<uint8_t> * values = &levels;
+
+        for (size_t depth = 0; from < to; ++depth) {
+            const size_t up = (from + lodFanout() - 1) / lodFanout();
+            const size_t down = to / lodFanout();
+
+            // the rest is cheaper to scan than to climb
+            if (depth == maxLevels.size() || up >= down) {
+                for (size_t i = from; i < to; ++i) {
+                    level = (std::max)(level, (*values)[i]);
+                }
+                break;
+            }
+
+            for (size_t i = from; i < up * lodFanout(); ++i) {
+                level = (std::max)(level, (*values)[i]);
+            }
+            for (size_t i = down * lodFanout(); i < to; ++i) {
+                level = (std::max)(level, (*values)[i]);
+            }
+
+            from = up;
+            to = down;
+            values = &maxLevels[depth];
+        }
+
+        return level;
+    }
+
+    // Rows of bins equal parts of [from, to), O(bins * log rows)
+    void query(uint64_t from,
+               uint64_t to,
+               size_t bins,
+               std::vector<p7LaneBin> & result) const
+    {
+        result.assign(bins, p7LaneBin());
+        if (!bins || from >= to || times.empty()) {
+            return;
+        }
+
+        const double binTime = (double)(to - from) / (double)bins;
+        size_t first = rowAtTime(from);
+        for (size_t bin = 0; bin < bins && first < times.size(); ++bin) {
+            const uint64_t end = bin + 1 == bins
+                    ? to
+                    : from + (uint64_t)(binTime * (double)(bin + 1));
+            if (times[first] >= end) {
+                continue;
+            }
+            const size_t last = std::lower_bound(times.begin() + first,
+                                                 times.end(), end)
+                    - times.begin();
+            result[bin].rows = (uint32_t)(std::min)(last - first,
+                                                    (size_t)UINT32_MAX);
+            result[bin].level = maxLevel(first, last);
+            first = last;
+        }
+    }
+
+    // Rebuilds block levels from the block of row from
+    void buildLod(size_t from)
+    {
+        const std::vector<uint8_t> * lower = &levels;
+        size_t depth = 0;
+        while (lower->size() > lodFanout()) {
+            if (maxLevels.size() == depth) {
+                maxLevels.emplace_back();
+            }
+            lower = depth ? &maxLevels[depth - 1] : &levels;
+            std::vector<uint8_t> & level = maxLevels[depth];
+
+            from /= lodFanout();
+            level.resize((lower->size() + lodFanout() - 1) / lodFanout());
+            for (size_t i = from; i < level.size(); ++i) {
+                const size_t end = (std::min)(lower->size(),
+                                              (i + 1) * lodFanout());
+                uint8_t value = 0;
+                for (size_t j = i * lodFanout(); j < end; ++j) {
+                    value = (std::max)(value, (*lower)[j]);
+                }
+                level[i] = value;
+            }
+
+            lower = &level;
+            ++depth;
+        }
+        maxLevels.resize(depth);
+    }
+
+    size_t memoryUsage() const
+    {
+        size_t bytes = times.capacity() * sizeof(uint64_t)
+                + rows.capacity() * sizeof(uint32_t)
+                + levels.capacity();
+        for (const std::vector<uint8_t> & level : maxLevels) {
+            bytes += level.capacity();
+        }
+        return bytes;
+    }
+};
+
+// Swimlanes of a dump: one lane per thread of every stream, the thread
+// table gives names and lifetimes. Built on demand in one pass over rows
+// (streams in parallel), update() adds only rows appended since.
+class p7ThreadLanes
+{
+public:
+
+    void clear()
+    {
+        _streams.clear();
+        _lanes.clear();
+    }
+
+    void update(const p7DumpData & data)
+    {
+        if (_streams.size() != data.streamsCount()) {
+            clear();
+            _streams.resize(data.streamsCount());
+        }
+
+        std::atomic<size_t> next(0);
+        auto worker = [this, &data, &next]() {
+            size_t stream;
+            while ((stream = next++) < _streams.size()) {
+                updateStream(data, stream);
+            }
+        };
+
+        const size_t threadsCount = (std::min)(
+                    _streams.size(),
+                    (size_t)(std::max)(1u, std::thread::hardware_concurrency()));
+
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < threadsCount; ++i) {
+            threads.emplace_back(worker);
+        }
+
+        worker();
+
+        for (std::thread & thread : threads) {
+            thread.join();
+        }
+
+        // lanes in order of their first row, idle threads last
+        _lanes.clear();
+        for (StreamLanes & stream : _streams) {
+            for (p7ThreadLane & lane : stream.lanes) {
+                _lanes.push_back(&lane);
+            }
+        }
+        std::stable_sort(_lanes.begin(), _lanes.end(),
+                         [](const p7ThreadLane * left,
+                            const p7ThreadLane * right) {
+            const uint64_t leftTime = left->times.empty()
+                    ? UINT64_MAX : left->times.front();
+            const uint64_t rightTime = right->times.empty()
+                    ? UINT64_MAX : right->times.front();
+            return leftTime < rightTime;
+        });
+    }
+
+    const std::vector<const p7ThreadLane *> & lanes() const
+    {
+        return _lanes;
+    }
+
+    size_t memoryUsage() const
+    {
+        size_t bytes = 0;
+        for (const StreamLanes & stream : _streams) {
+            for (const p7ThreadLane & lane : stream.lanes) {
+                bytes += lane.memoryUsage();
+            }
+        }
+        return bytes;
+    }
+
+private:
+
+    struct StreamLanes
+    {
+        std::vector<p7ThreadLane> lanes;
+        std::unordered_map<uint32_t, size_t> byThread; // lane index
+        uint64_t endRowNumber = 0;                     // added up to
+    };
+
+    void updateStream(const p7DumpData & data, size_t index)
+    {
+        const p7StreamData & stream = data.stream(index);
+        StreamLanes & lanes = _streams[index];
+
+        auto laneOf = [&lanes, index](uint32_t threadId) -> p7ThreadLane & {
+            auto it = lanes.byThread.find(threadId);
+            if (it != lanes.byThread.end()) {
+                return lanes.lanes[it->second];
+            }
+            lanes.byThread.emplace(threadId, lanes.lanes.size());
+            lanes.lanes.emplace_back();
+            lanes.lanes.back().stream = index;
+            lanes.lanes.back().threadId = threadId;
+            return lanes.lanes.back();
+        };
+
+        // threads without rows get lanes too
+        for (const auto & it : stream.threads()) {
+            laneOf(it.first);
+        }
+
+        std::vector<size_t> sizes(lanes.lanes.size());
+        for (size_t i = 0; i < lanes.lanes.size(); ++i) {
+            sizes[i] = lanes.lanes[i].rowsCount();
+        }
+
+        const uint64_t first = (std::max)(lanes.endRowNumber,
+                                          stream.firstRowNumber());
+        const bool initial = !lanes.endRowNumber;
+        for (uint64_t number = first; number < stream.endRowNumber();
+             ++number) {
+            const p7TraceDataInfo & row = stream.traceDataAt(
+                        (size_t)(number - stream.firstRowNumber()));
+            p7ThreadLane & lane = laneOf(row.threadId);
+            lane.times.push_back(row.timestamp);
+            lane.rows.push_back((uint32_t)number);
+            lane.levels.push_back((uint8_t)row.verbosity);
+        }
+        lanes.endRowNumber = stream.endRowNumber();
+        sizes.resize(lanes.lanes.size(), 0);
+
+        const uint64_t lastTime = stream.traceDataCount()
+                ? stream.traceDataAt(stream.traceDataCount() - 1).timestamp
+                : 0;
+
+        for (size_t i = 0; i < lanes.lanes.size(); ++i) {
+            p7ThreadLane & lane = lanes.lanes[i];
+            const p7ThreadInfo & thread = stream.threadById(lane.threadId);
+            lane.name = thread.name;
+
+            lane.lifetimes.clear();
+            auto threads = stream.threads().find(lane.threadId);
+            if (threads != stream.threads().end()) {
+                for (const p7ThreadInfo & info : threads->second.threads) {
+                    const uint64_t start = timerToTimestamp(
+                                stream.startTime100Ns(), stream.timerValue(),
+                                stream.timerFrequency(), info.startTimer);
+                    const uint64_t stop = info.stopTimer == UINT64_MAX
+                            ? lastTime
+                            : timerToTimestamp(stream.startTime100Ns(),
+                                               stream.timerValue(),
+                                               stream.timerFrequency(),
+                                               info.stopTimer);
+                    if (start != UINT64_MAX && stop != UINT64_MAX) {
+                        lane.lifetimes.emplace_back(start,
+                                                    (std::max)(start, stop));
+                    }
+                }
+            }
+
+            if (lane.rowsCount() == sizes[i]) {
+                continue;
+            }
+
+            // rows of a thread are ordered by time unless timers jump
+            if (!std::is_sorted(lane.times.begin() + (sizes[i] ? sizes[i] - 1
+                                                               : 0),
+                                lane.times.end())) {
+                sortLane(lane);
+                sizes[i] = 0;
+            }
+            lane.buildLod(sizes[i]);
+
+            // appended rows of follow mode keep the spare capacity
+            if (initial) {
+                lane.times.shrink_to_fit();
+                lane.rows.shrink_to_fit();
+                lane.levels.shrink_to_fit();
+            }
+        }
+    }
+
+    static void sortLane(p7ThreadLane & lane)
+    {
+        std::vector<size_t> order(lane.rowsCount());
+        std::iota(order.begin(), order.end(), (size_t)0);
+        std::stable_sort(order.begin(), order.end(),
+                         [&lane](size_t left, size_t right) {
+            return lane.times[left] < lane.times[right];
+        });
+
+        p7ThreadLane sorted;
+        sorted.times.reserve(order.size());
+        sorted.rows.reserve(order.size());
+        sorted.levels.reserve(order.size());
+        for (size_t i : order) {
+            sorted.times.push_back(lane.times[i]);
+            sorted.rows.push_back(lane.rows[i]);
+            sorted.levels.push_back(lane.levels[i]);
+        }
+        lane.times.swap(sorted.times);
+        lane.rows.swap(sorted.rows);
+        lane.levels.swap(sorted.levels);
+    }
+
+    std::vector<StreamLanes> _streams;
+    std::vector<const p7ThreadLane *> _lanes;
+};
+
+} // namespace p7
+
+#endif // P7_DUMP_THREAD_LANES_H
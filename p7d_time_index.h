@@ -0,0 +1,301 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                             /
+// 2022 (c) Ragnar Lodbrok                                                     /
+//                                                                             /
+// This library is free software; you can redistribute it and/or               /
+// modify it under the terms of the GNU Lesser General Public                  /
+// License as published by the Free Software Foundation; either                /
+// version 3.0 of the License, or (at your option) any later version.          /
+//                                                                             /
+// This library is distributed in the hope that it will be useful,             /
+// but WITHOUT ANY WARRANTY; without even the implied warranty of              /
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU           /
+// Lesser General Public License for more details.                             /
+//                                                                             /
+// You should have received a copy of the GNU Lesser General Public            /
+// License along with this library.                                            /
+//                                                                             /
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef P7_DUMP_TIME_INDEX_H
+#define P7_DUMP_TIME_INDEX_H
+
+#include <stdint.h>
+#include <algorithm>
+#include <deque>
+#include <utility>
+#include <vector>
+#include "p7d_keywords.h"
+
+namespace p7 {
+
+// Rows of one block of p7TimeIndex
+struct p7TimeBlock
+{
+    uint64_t firstRow = 0;     // row number, see p7BlockDeque
+    uint32_t rows = 0;
+    bool metadata = false;     // non-data packets among the block's chunks
+    uint64_t minTime = 0;      // row timestamps, 100ns since 1601
+    uint64_t maxTime = 0;
+    uint64_t maxTimeSoFar = 0; // of this and all previous blocks
+
+    // the file range of the stream's chunks of the block: from the chunk
+    // of the first row to the end of the last chunk before the next block
+    uint64_t fileOffset = UINT64_MAX;
+    uint64_t fileEnd = UINT64_MAX;
+};
+
+// Sparse index of rows by time: one block per blockRows() rows with the
+// time range of its rows and the part of the dump file they came from.
+// Rows are added in order; times mostly grow, so the first row at or
+// after a time is found by a binary search over maxTimeSoFar and a scan
+// of one block. The index stays tiny: ~0.05 bytes per row.
+class p7TimeIndex
+{
+public:
+
+    static constexpr uint32_t blockRows()
+    {
+        return 1024;
+    }
+
+    static constexpr uint64_t noFile()
+    {
+        return UINT64_MAX;
+    }
+
+    // time of a row without a usable one, see timerToTimestamp()
+    static constexpr uint64_t noTime()
+    {
+        return UINT64_MAX;
+    }
+
+    // chunkOffset: file offset of the sH_User_Data with the row. A row
+    // with noTime() is counted to its block but not to the block times,
+    // a block of such rows only has minTime > maxTime.
+    void addRow(uint64_t row, uint64_t time, uint64_t chunkOffset = noFile())
+    {
+        if (_blocks.empty() || _blocks.back().rows >= blockRows()) {
+            p7TimeBlock block;
+            block.firstRow = row;
+            block.minTime = noTime();
+            block.maxTime = 0;
+            block.maxTimeSoFar = _blocks.empty()
+                    ? 0
+                    : _blocks.back().maxTimeSoFar;
+            block.fileOffset = chunkOffset;
+            block.fileEnd = chunkOffset;
+            _blocks.push_back(block);
+        }
+
+        p7TimeBlock & block = _blocks.back();
+        block.rows++;
+        if (time == noTime()) {
+            return;
+        }
+        block.minTime = (std::min)(block.minTime, time);
+        block.maxTime = (std::max)(block.maxTime, time);
+        block.maxTimeSoFar = (std::max)(block.maxTimeSoFar, time);
+    }
+
+    // A chunk of the stream is decoded: blocks with its rows span it,
+    // chunks before the first row (Info, descriptions) are not indexed
+    void addChunk(uint64_t chunkOffset, uint64_t chunkEnd, bool metadata)
+    {
+        if (_blocks.empty() || _blocks.back().fileOffset == noFile()) {
+            return;
+        }
+
+        _blocks.back().metadata |= metadata;
+
+        // blocks started in this chunk and the one before them
+        for (auto block = _blocks.rbegin(); block != _blocks.rend(); ++block) {
+            block->fileEnd = (std::max)(block->fileEnd, chunkEnd);
+            if (block->fileOffset != chunkOffset) {
+                break;
+            }
+        }
+    }
+
+    // Restores a block of a saved index (see p7DumpCatalog), blocks are
+    // appended in order
+    void appendBlock(p7TimeBlock block)
+    {
+        block.maxTimeSoFar = _blocks.empty()
+                ? block.maxTime
+                : (std::max)(_blocks.back().maxTimeSoFar, block.maxTime);
+        _blocks.push_back(block);
+    }
+
+    // Retention: blocks of dropped rows are freed, see p7BlockDeque
+    void dropRowsBefore(uint64_t row)
+    {
+        const size_t count = _blocks.size();
+        while (    (!_blocks.empty())
+                && (_blocks.front().firstRow + _blocks.front().rows <= row)
+              )
+        {
+            _blocks.pop_front();
+        }
+
+        if (_blocks.size() == count) {
+            return;
+        }
+
+        // dropped blocks don't count to the maximum any more. Only the
+        // leading blocks whose maximum came from a dropped one change:
+        // once a block has its own maximum so far, the ones after it
+        // have it too. Times mostly grow, so this stops at the first
+        // block.
+        uint64_t maxTime = 0;
+        for (p7TimeBlock & block : _blocks) {
+            maxTime = (std::max)(maxTime, block.maxTime);
+            if (block.maxTimeSoFar == maxTime) {
+                break;
+            }
+            block.maxTimeSoFar = maxTime;
+        }
+    }
+
+    void clear()
+    {
+        _blocks.clear();
+    }
+
+    const std::deque<p7TimeBlock> & blocks() const
+    {
+        return _blocks;
+    }
+
+    bool hasFileRanges() const
+    {
+        return !_blocks.empty() && _blocks.front().fileOffset != noFile();
+    }
+
+    // First row number in [firstRow, endRow) with rowTime(row) >= time,
+    // endRow if there is none. Rows with noTime() are skipped.
+    template<typename RowTime>
+    uint64_t rowAtTime(uint64_t time,
+                       uint64_t firstRow,
+                       uint64_t endRow,
+                       RowTime rowTime) const
+    {
+        auto block = std::partition_point(
+                    _blocks.begin(), _blocks.end(),
+                    [time](const p7TimeBlock & candidate) {
+                        return candidate.maxTimeSoFar < time;
+                    });
+
+        // the first block may hold dropped rows only above time
+        for (; block != _blocks.end(); ++block) {
+            if (block->maxTime < time) {
+                continue;
+            }
+
+            const uint64_t end = (std::min)(endRow,
+                                            block->firstRow + block->rows);
+            for (uint64_t row = (std::max)(firstRow, block->firstRow);
+                 row < end;
+                 ++row) {
+                const uint64_t current = rowTime(row);
+                if (current >= time && current != noTime()) {
+                    return row;
+                }
+            }
+        }
+
+        return endRow;
+    }
+
+    size_t memoryUsage() const
+    {
+        return _blocks.size() * sizeof(p7TimeBlock);
+    }
+
+private:
+
+    std::deque<p7TimeBlock> _blocks;
+};
+
+// Time index of one trace channel of a dump file, see
+// p7DumpData::timeIndexes() and p7DumpImporter::importTimeRange()
+struct p7ChannelTimeIndex
+{
+    uint8_t channelId = 0;
+    p7TimeIndex index;
+    // words of messages per block, empty if not built (see p7DumpCatalog)
+    std::vector<p7KeywordFilter> keywords;
+};
+
+// Parts of a dump file with rows of [from, to) and everything rows need:
+// the part before the first row of every channel (Info, descriptions),
+// blocks which intersect the window or have non-data packets and the
+// part written after the index was built. With words (p7Keywords
+// hashes) blocks whose keyword filters don't have all of them are left
+// out too. Ranges are sorted, merged and start at chunk boundaries.
+// Empty if the index has no file ranges.
+static inline std::vector<std::pair<uint64_t, uint64_t>> timeRangeFileRanges(
+        const std::vector<p7ChannelTimeIndex> & indexes,
+        uint64_t headerSize,
+        uint64_t fileSize,
+        uint64_t from,
+        uint64_t to,
+        const std::vector<uint64_t> & words = std::vector<uint64_t>())
+{
+    std::vector<std::pair<uint64_t, uint64_t>> ranges;
+
+    uint64_t prefixEnd = headerSize;
+    uint64_t indexedEnd = headerSize;
+    for (const p7ChannelTimeIndex & channel : indexes) {
+        const std::deque<p7TimeBlock> & blocks = channel.index.blocks();
+        if (blocks.empty()) {
+            continue;
+        }
+        if (!channel.index.hasFileRanges()) {
+            return std::vector<std::pair<uint64_t, uint64_t>>();
+        }
+
+        prefixEnd = (std::max)(prefixEnd, blocks.front().fileOffset);
+        indexedEnd = (std::max)(indexedEnd, blocks.back().fileEnd);
+
+        const bool keywords = !words.empty()
+                           && channel.keywords.size() == blocks.size();
+
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            const p7TimeBlock & block = blocks[i];
+            if (    (block.metadata)
+                 || (    (block.maxTime >= from)
+                      && (!to || block.minTime < to)
+                      && (!keywords || channel.keywords[i].mayContainAll(words))
+                    )
+               )
+            {
+                ranges.emplace_back(block.fileOffset, block.fileEnd);
+            }
+        }
+    }
+
+    ranges.emplace_back(headerSize, prefixEnd);
+    ranges.emplace_back(indexedEnd, fileSize);
+
+    std::sort(ranges.begin(), ranges.end());
+
+    std::vector<std::pair<uint64_t, uint64_t>> merged;
+    for (const auto & range : ranges) {
+        const uint64_t end = (std::min)(range.second, fileSize);
+        if (range.first >= end) {
+            continue;
+        }
+        if (!merged.empty() && range.first <= merged.back().second) {
+            merged.back().second = (std::max)(merged.back().second, end);
+        } else {
+            merged.emplace_back(range.first, end);
+        }
+    }
+
+    return merged;
+}
+
+}
+
+#endif // P7_DUMP_TIME_INDEX_H
@@ -0,0 +1,287 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                             /
+// 2022 (c) Ragnar Lodbrok                                                     /
+//                                                                             /
+// This library is free software; you can redistribute it and/or               /
+// modify it under the terms of the GNU Lesser General Public                  /
+// License as published by the Free Software Foundation; either                /
+// version 3.0 of the License, or (at your option) any later version.          /
+//                                                                             /
+// This library is distributed in the hope that it will be useful,             /
+// but WITHOUT ANY WARRANTY; without even the implied warranty of              /
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU           /
+// Lesser General Public License for more details.                             /
+//                                                                             /
+// You should have received a copy of the GNU Lesser General Public            /
+// License along with this library.                                            /
+//                                                                             /
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef P7_DUMP_TRANSPORT_H
+#define P7_DUMP_TRANSPORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "p7Structs.h"
+
+namespace p7 {
+
+// Client/receiver exchange of live ingestion over UDP, modelled on the P7
+// client transport: a client opens a session with a hello carrying the
+// dump header, sends sH_User_Data chunks in numbered data packets and
+// ends with a bye. The receiver acknowledges data cumulatively (the id
+// of the last packet it took in order) and keeps no packet it can't
+// queue, so the client sends again everything after the acknowledged id
+// once it waits too long (go-back-N): nothing is lost and a busy
+// receiver slows the client down. Every datagram starts with
+// p7TransportHeader and is checked by CRC-32.
+enum p7TransportType : uint16_t
+{
+    P7_TRANSPORT_HELLO = 1, // id: client nonce; payload: sP7File_Header
+    P7_TRANSPORT_WELCOME,   // id: nonce of the hello; session assigned
+    P7_TRANSPORT_DATA,      // id: 1, 2, ...; payload: sH_User_Data chunks
+    P7_TRANSPORT_ACK,       // id: last data (or bye) taken in order
+    P7_TRANSPORT_BYE        // id: the one after the last data packet
+};
+
+#pragma pack(push, 1)
+struct p7TransportHeader
+{
+    uint32_t crc;     // CRC-32 of the datagram after this field
+    uint32_t id;
+    uint16_t type;    // p7TransportType
+    uint16_t session; // 0 in a hello
+    uint32_t size;    // of the datagram, header included
+};
+#pragma pack(pop)
+
+// CRC-32 (IEEE 802.3, as zlib), table built on first use
+static inline uint32_t p7Crc32(const void * data, size_t size)
+{
+    struct Table
+    {
+        uint32_t values[256];
+
+        Table()
+        {
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t value = i;
+                for (int bit = 0; bit < 8; ++bit) {
+                    value = (value & 1) ? (value >> 1) ^ 0xEDB88320u
+                                        : value >> 1;
+                }
+                values[i] = value;
+            }
+        }
+    };
+    static const Table table;
+
+    const uint8_t * bytes = (const uint8_t *)data;
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table.values[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+// Fills the header of a datagram of size bytes, the payload follows it
+static inline void p7SealDatagram(uint8_t * datagram,
+                                  size_t size,
+                                  uint16_t type,
+                                  uint32_t id,
+                                  uint16_t session)
+{
+    p7TransportHeader header;
+    header.crc = 0;
+    header.id = id;
+    header.type = type;
+    header.session = session;
+    header.size = (uint32_t)size;
+    memcpy(datagram, &header, sizeof(header));
+
+    header.crc = p7Crc32(datagram + sizeof(header.crc),
+                         size - sizeof(header.crc));
+    memcpy(datagram, &header.crc, sizeof(header.crc));
+}
+
+// Header of a datagram which is whole and intact
+static inline bool p7OpenDatagram(const uint8_t * datagram,
+                                  size_t size,
+                                  p7TransportHeader & header)
+{
+    if (size < sizeof(header)) {
+        return false;
+    }
+
+    memcpy(&header, datagram, sizeof(header));
+    return    (header.size == size)
+           && (header.crc == p7Crc32(datagram + sizeof(header.crc),
+                                     size - sizeof(header.crc)));
+}
+
+// Whole sH_User_Data chunks and nothing else
+static inline bool p7IsChunks(const uint8_t * data, size_t size)
+{
+    size_t offs = 0;
+    while (offs + sizeof(sH_User_Data) <= size) {
+        const sH_User_Data * header = (const sH_User_Data *)(data + offs);
+        if (header->dwSize < sizeof(sH_User_Data)) {
+            return false;
+        }
+        offs += header->dwSize;
+    }
+    return offs == size;
+}
+
+// Receiver side of the exchange, one client at a time: a hello of
+// another client (or a new hello of the same one) starts a new session
+// and packets of the previous session are ignored. Not thread-safe, it
+// belongs to the thread reading the socket.
+class p7TransportReceiver
+{
+public:
+
+    enum Result
+    {
+        Accepted,  // hello or data taken
+        Refused,   // take() failed, the client sends it again
+        Repeated,  // already taken, or ahead of a missing one
+        Closed,    // bye of the session, all its data was taken
+        Ignored,   // another session or not for a receiver
+        Malformed  // broken datagram or payload
+    };
+
+    // Handles a datagram of peer (address and port). The dump header of
+    // a hello or chunks of the next data packet go to
+    // take(data, size, isHeader), which returns false if it can't keep
+    // them now. reply gets a datagram for the peer if there is one.
+    template<typename Take>
+    Result receive(const uint8_t * datagram,
+                   size_t size,
+                   uint64_t peer,
+                   Take take,
+                   p7TransportHeader & reply,
+                   bool & hasReply)
+    {
+        hasReply = false;
+
+        p7TransportHeader header;
+        if (!p7OpenDatagram(datagram, size, header)) {
+            return Malformed;
+        }
+
+        const uint8_t * payload = datagram + sizeof(header);
+        const size_t payloadSize = size - sizeof(header);
+
+        if (header.type == P7_TRANSPORT_HELLO) {
+            const sP7File_Header * dump = (const sP7File_Header *)payload;
+            if (    (payloadSize != sizeof(sP7File_Header))
+                 || (dump->qwMarker != P7_DAMP_FILE_MARKER_V1)
+               )
+            {
+                return Malformed;
+            }
+
+            // the welcome was lost
+            if (    (_started)
+                 && (peer == _peer)
+                 && (header.id == _nonce)
+               )
+            {
+                setReply(reply, hasReply, P7_TRANSPORT_WELCOME, _nonce);
+                return Repeated;
+            }
+
+            if (!take(payload, payloadSize, true)) {
+                return Refused;
+            }
+
+            _started = true;
+            _open = true;
+            _peer = peer;
+            _nonce = header.id;
+            _next = 1;
+            if (++_session == 0) {
+                _session = 1;
+            }
+
+            setReply(reply, hasReply, P7_TRANSPORT_WELCOME, _nonce);
+            return Accepted;
+        }
+
+        if (    (!_started)
+             || (peer != _peer)
+             || (header.session != _session)
+           )
+        {
+            return Ignored;
+        }
+
+        if (header.type == P7_TRANSPORT_DATA) {
+            // a packet sent again or one after a lost one: the client
+            // learns again where to go on from
+            if (!_open || header.id != _next) {
+                setReply(reply, hasReply, P7_TRANSPORT_ACK, _next - 1);
+                return Repeated;
+            }
+
+            if (!p7IsChunks(payload, payloadSize)) {
+                return Malformed;
+            }
+
+            if (!take(payload, payloadSize, false)) {
+                return Refused;
+            }
+
+            ++_next;
+            setReply(reply, hasReply, P7_TRANSPORT_ACK, _next - 1);
+            return Accepted;
+        }
+
+        if (header.type == P7_TRANSPORT_BYE) {
+            if (header.id != _next) {
+                setReply(reply, hasReply, P7_TRANSPORT_ACK, _next - 1);
+                return Repeated;
+            }
+
+            // acknowledged again if the first ack was lost
+            setReply(reply, hasReply, P7_TRANSPORT_ACK, _next);
+            if (!_open) {
+                return Repeated;
+            }
+            _open = false;
+            return Closed;
+        }
+
+        return Ignored;
+    }
+
+    // A client has said hello and not bye yet
+    bool isOpen() const
+    {
+        return _open;
+    }
+
+private:
+
+    void setReply(p7TransportHeader & reply,
+                  bool & hasReply,
+                  uint16_t type,
+                  uint32_t id) const
+    {
+        p7SealDatagram((uint8_t *)&reply, sizeof(reply), type, id, _session);
+        hasReply = true;
+    }
+
+    bool _started = false;
+    bool _open = false;
+    uint64_t _peer = 0;
+    uint32_t _nonce = 0;
+    uint32_t _next = 1;      // id of the next data packet
+    uint16_t _session = 0;
+};
+
+}
+
+#endif // P7_DUMP_TRANSPORT_H
@@ -2,6 +2,8 @@ QT += core gui
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
+QT += network
+
 TARGET = p7dviewer
 TEMPLATE = app
 
@@ -19,13 +21,50 @@ QMAKE_LFLAGS += -Wl,--no-as-needed
 
 SOURCES  += main.cpp \
             main_window.cpp \
-            p7d_model.cpp
+            telemetry_window.cpp \
+            trace_ids_window.cpp \
+            thread_lanes_window.cpp \
+            latency_window.cpp \
+            rate_timeline.cpp \
+            p7d_model.cpp \
+            p7d_follower.cpp \
+            p7d_replay_receiver.cpp
 
 
 HEADERS  += Formatter.h \
             GTypes.h \
             p7Structs.h \
             importer.h \
+            p7d_arena.h \
+            p7d_block_deque.h \
+            p7d_rates.h \
+            p7d_sequence.h \
+            p7d_lru_cache.h \
+            p7d_time_index.h \
+            p7d_catalog.h \
+            p7d_keywords.h \
+            p7d_scanner.h \
+            p7d_summary.h \
+            p7d_telemetry.h \
+            p7d_thread_lanes.h \
+            p7d_latency.h \
             main_window.h \
-            p7d_model.h
+            telemetry_window.h \
+            trace_ids_window.h \
+            thread_lanes_window.h \
+            latency_window.h \
+            rate_timeline.h \
+            p7d_model.h \
+            p7d_follower.h \
+            p7d_replay_receiver.h \
+            p7d_spsc_queue.h \
+            p7d_transport.h
 
+# "make bench" builds and runs benchmarks from bench/bench.pro,
+# results are printed as JSON lines, fails if memory per row has grown
+# or a check of the analyses (p7dbench --check) fails
+bench.target = bench
+bench.commands = $(MKDIR) bench_build && cd bench_build \
+                 && $$QMAKE_QMAKE $$PWD/bench/bench.pro && $(MAKE) \
+                 && ./p7dbench && ./p7dbench --memory && ./p7dbench --check
+QMAKE_EXTRA_TARGETS += bench
@@ -0,0 +1,338 @@
+#include "rate_timeline.h"
+#include <QtWidgets>
+
+namespace p7 {
+namespace ui {
+
+const QColor & RateTimeline::levelColor(size_t level)
+{
+    static const QColor colors[EP7TRACE_LEVEL_COUNT] = {
+        QColor(170, 170, 170), // trace
+        QColor(120, 160, 200), // debug
+        QColor(70, 130, 210),  // info
+        QColor(230, 180, 0),   // warning
+        QColor(220, 50, 50),   // error
+        QColor(140, 0, 0)      // critical
+    };
+    return colors[level];
+}
+
+RateTimeline::RateTimeline(p7::P7DumpModel * model, QWidget *parent)
+    : QWidget(parent)
+    , _model(model)
+{
+    setFixedHeight(64);
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+    setAutoFillBackground(true);
+    setBackgroundRole(QPalette::Base);
+    setMouseTracking(true);
+
+    connect(_model, &QAbstractItemModel::modelReset,
+            this, &RateTimeline::onModelReset);
+    // appended rows (follow, live), batches fetched by the table
+    connect(_model, &QAbstractItemModel::rowsInserted,
+            this, [this]() { update(); });
+}
+
+void RateTimeline::onModelReset()
+{
+    _zoomed = false;
+    _dragging = false;
+    update();
+}
+
+QRect RateTimeline::plotRect() const
+{
+    const int bottomMargin = fontMetrics().height() + 2;
+    return rect().adjusted(0, 2, 0, -bottomMargin);
+}
+
+std::vector<const p7::p7StreamData *> RateTimeline::shownStreams() const
+{
+    std::vector<const p7::p7StreamData *> streams;
+    const p7::p7DumpData & data = _model->dumpData();
+    const int current = _model->currentStream();
+    for (size_t i = 0; i < data.streamsCount(); ++i) {
+        if (current < 0 || (size_t)current == i) {
+            streams.push_back(&data.stream(i));
+        }
+    }
+    return streams;
+}
+
+bool RateTimeline::fullRange(uint64_t & from, uint64_t & to) const
+{
+    bool found = false;
+    for (const p7::p7StreamData * stream : shownStreams()) {
+        const p7::p7RateHistogram & rates = stream->rates();
+        if (!rates.rows()) {
+            continue;
+        }
+        from = found ? qMin(from, rates.firstTime()) : rates.firstTime();
+        to = found ? qMax(to, rates.lastTime()) : rates.lastTime();
+        found = true;
+    }
+
+    // the last row is in the range too
+    to = found ? to + 1 : to;
+    return found;
+}
+
+void RateTimeline::setRange(double from, double to)
+{
+    uint64_t first = 0;
+    uint64_t last = 0;
+    if (!fullRange(first, last)) {
+        return;
+    }
+
+    // don't zoom deeper than 10ms per strip and don't leave the rows
+    const double minSpan = 100000.0;
+    if (to - from < minSpan) {
+        double center = (from + to) / 2.0;
+        from = center - minSpan / 2.0;
+        to = center + minSpan / 2.0;
+    }
+
+    const double span = qMin(to - from, (double)(last - first));
+    if (from < (double)first) {
+        from = (double)first;
+        to = from + span;
+    }
+    if (to > (double)last) {
+        to = (double)last;
+        from = to - span;
+    }
+
+    _from = (uint64_t)from;
+    _to = (uint64_t)to;
+    _zoomed = (_from > first) || (_to < last);
+    update();
+}
+
+uint64_t RateTimeline::timeAt(int x) const
+{
+    const QRect plot = plotRect();
+    const double ratio = qBound(0.0,
+                                (double)(x - plot.left()) / plot.width(),
+                                1.0);
+    return _from + (uint64_t)((double)(_to - _from) * ratio);
+}
+
+void RateTimeline::paintEvent(QPaintEvent *event)
+{
+    QWidget::paintEvent(event);
+
+    QPainter painter(this);
+    const QRect plot = plotRect();
+
+    if (!_zoomed && !fullRange(_from, _to)) {
+        return;
+    }
+    if (_to <= _from || plot.width() < 2) {
+        return;
+    }
+
+    const std::vector<const p7::p7StreamData *> streams = shownStreams();
+    const size_t bins = (size_t)plot.width();
+    const size_t levels = p7::p7RateHistogram::levelsCount();
+
+    std::vector<double> counts(bins * levels, 0.0);
+    for (const p7::p7StreamData * stream : streams) {
+        stream->rates().query(_from, _to, bins, counts);
+    }
+
+    double maxTotal = 0.0;
+    for (size_t bin = 0; bin < bins; ++bin) {
+        double total = 0.0;
+        for (size_t level = 0; level < levels; ++level) {
+            total += counts[bin * levels + level];
+        }
+        maxTotal = qMax(maxTotal, total);
+    }
+
+    const double span = (double)(_to - _from);
+    auto xOf = [&](uint64_t time) {
+        return plot.left() + ((double)time - (double)_from)
+                * plot.width() / span;
+    };
+
+    // bursts behind the bars
+    QColor burstColor(220, 50, 50);
+    burstColor.setAlphaF(0.2);
+    for (const p7::p7StreamData * stream : streams) {
+        const std::vector<p7::p7Burst> & bursts = stream->bursts().bursts();
+        auto it = std::upper_bound(bursts.begin(), bursts.end(), _from,
+                                   [](uint64_t time, const p7::p7Burst & b) {
+                                       return time < b.toTime;
+                                   });
+        for (; it != bursts.end() && it->fromTime < _to; ++it) {
+            const double left = qMax(xOf(it->fromTime), (double)plot.left());
+            const double right = qMin(xOf(it->toTime), (double)plot.right());
+            painter.fillRect(QRectF(left, plot.top(),
+                                    qMax(right - left, 2.0), plot.height()),
+                             burstColor);
+        }
+    }
+
+    // bars stacked from trace up
+    if (maxTotal > 0.0) {
+        for (size_t bin = 0; bin < bins; ++bin) {
+            double bottom = plot.bottom() + 1;
+            for (size_t level = 0; level < levels; ++level) {
+                const double count = counts[bin * levels + level];
+                if (count <= 0.0) {
+                    continue;
+                }
+                const double height = count * plot.height() / maxTotal;
+                painter.fillRect(QRectF(plot.left() + (double)bin,
+                                        bottom - height, 1.0, height),
+                                 levelColor(level));
+                bottom -= height;
+            }
+        }
+    }
+
+    painter.setPen(palette().color(QPalette::Mid));
+    painter.drawLine(plot.bottomLeft(), plot.bottomRight());
+
+    // labels
+    painter.setPen(palette().color(QPalette::Text));
+    const QRect labels(plot.left() + 2, plot.bottom() + 1,
+                       plot.width() - 4, fontMetrics().height());
+    const QString format = span >= 864000000000.0
+            ? "yyyy-MM-dd HH:mm:ss"
+            : "HH:mm:ss.zzz";
+    painter.drawText(labels, Qt::AlignLeft,
+                     unpackDateTime(_from).toString(format));
+    painter.drawText(labels, Qt::AlignRight,
+                     unpackDateTime(_to).toString(format));
+
+    const double binSeconds = span / (double)bins / 1e7;
+    painter.drawText(labels, Qt::AlignHCenter,
+                     tr("max %1 rows/s").arg(maxTotal / binSeconds, 0, 'f',
+                                             maxTotal / binSeconds < 10.0
+                                                ? 1 : 0));
+}
+
+void RateTimeline::wheelEvent(QWheelEvent *event)
+{
+    const QRect plot = plotRect();
+    if (_to <= _from || plot.width() < 2) {
+        return;
+    }
+
+    const double factor = event->angleDelta().y() > 0 ? 0.8 : 1.25;
+    const double span = (double)(_to - _from);
+    const double ratio = qBound(0.0,
+                                (event->position().x() - plot.left())
+                                    / plot.width(),
+                                1.0);
+    const double center = (double)_from + span * ratio;
+
+    setRange(center - span * factor * ratio,
+             center + span * factor * (1.0 - ratio));
+    event->accept();
+}
+
+void RateTimeline::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton) {
+        _dragging = true;
+        _dragged = false;
+        _dragX = event->x();
+        _dragFrom = _from;
+        _dragTo = _to;
+    }
+}
+
+void RateTimeline::mouseMoveEvent(QMouseEvent *event)
+{
+    const QRect plot = plotRect();
+    if (!_dragging) {
+        showToolTip(event->pos());
+        return;
+    }
+
+    // a click may move a pixel or two
+    if (qAbs(event->x() - _dragX) > 3) {
+        _dragged = true;
+    }
+    if (!_dragged || plot.width() < 2) {
+        return;
+    }
+
+    const double span = (double)(_dragTo - _dragFrom);
+    const double shift = (double)(event->x() - _dragX) * span / plot.width();
+    setRange((double)_dragFrom - shift, (double)_dragTo - shift);
+}
+
+void RateTimeline::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (_dragging && !_dragged && _to > _from) {
+        emit timeClicked(timeAt(event->x()));
+    }
+    _dragging = false;
+}
+
+void RateTimeline::mouseDoubleClickEvent(QMouseEvent *event)
+{
+    Q_UNUSED(event);
+    _zoomed = false;
+    update();
+}
+
+void RateTimeline::showToolTip(const QPoint & pos)
+{
+    const QRect plot = plotRect();
+    if (_to <= _from || plot.width() < 2) {
+        return;
+    }
+
+    // the bin under the cursor
+    const uint64_t binTime = qMax((_to - _from) / (uint64_t)plot.width(),
+                                  (uint64_t)1);
+    const uint64_t from = _from + (uint64_t)qMax(pos.x() - plot.left(), 0)
+            * binTime;
+    const uint64_t to = from + binTime;
+
+    const size_t levels = p7::p7RateHistogram::levelsCount();
+    std::vector<double> counts(levels, 0.0);
+    const std::vector<const p7::p7StreamData *> streams = shownStreams();
+    for (const p7::p7StreamData * stream : streams) {
+        stream->rates().query(from, to, 1, counts);
+    }
+
+    QString text = unpackDateTime(from).toString("HH:mm:ss.zzz");
+    for (size_t level = 0; level < levels; ++level) {
+        if (counts[level] >= 0.5) {
+            text += QString("\n%1: %2")
+                    .arg(p7::traceLevelAsString((eP7Trace_Level)level))
+                    .arg(qRound64(counts[level]));
+        }
+    }
+
+    for (const p7::p7StreamData * stream : streams) {
+        const std::vector<p7::p7Burst> & bursts = stream->bursts().bursts();
+        const double window = (double)stream->bursts().settings().window
+                / 1e7;
+        auto it = std::upper_bound(bursts.begin(), bursts.end(), from,
+                                   [](uint64_t time, const p7::p7Burst & b) {
+                                       return time < b.toTime;
+                                   });
+        for (; it != bursts.end() && it->fromTime < to; ++it) {
+            text += tr("\nBurst (%1): %2 rows in %3 s, peak %4 rows/s,"
+                       " baseline %5 rows/s")
+                    .arg(stream->name())
+                    .arg(it->rows)
+                    .arg((double)(it->toTime - it->fromTime) / 1e7)
+                    .arg(it->peakRows / window, 0, 'f', 0)
+                    .arg(it->baseline / window, 0, 'f', 1);
+        }
+    }
+
+    QToolTip::showText(mapToGlobal(pos), text, this);
+}
+
+} // namespace ui
+} // namespace p7
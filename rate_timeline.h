@@ -0,0 +1,68 @@
+#ifndef UI_RATETIMELINE_H
+#define UI_RATETIMELINE_H
+
+#include <vector>
+#include <QWidget>
+#include "p7d_model.h"
+
+namespace p7 {
+namespace ui {
+
+// Strip of rows per time bucket stacked by level over the streams of the
+// shown view, drawn from their rate pyramids (p7RateHistogram), so the
+// cost of a repaint depends on the width and not on rows. Bursts found
+// during import are highlighted. Wheel zooms, drag pans, double click
+// shows all, a click seeks the table to the time.
+class RateTimeline : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit RateTimeline(p7::P7DumpModel * model, QWidget *parent = nullptr);
+
+    // clicked time, 100ns since 1601
+    Q_SIGNAL void timeClicked(quint64 time);
+
+    // of rows of a level in charts
+    static const QColor & levelColor(size_t level);
+
+protected:
+
+    virtual void paintEvent(QPaintEvent *event) override;
+    virtual void wheelEvent(QWheelEvent *event) override;
+    virtual void mousePressEvent(QMouseEvent *event) override;
+    virtual void mouseMoveEvent(QMouseEvent *event) override;
+    virtual void mouseReleaseEvent(QMouseEvent *event) override;
+    virtual void mouseDoubleClickEvent(QMouseEvent *event) override;
+
+private:
+
+    Q_SLOT void onModelReset();
+
+    QRect plotRect() const;
+    std::vector<const p7::p7StreamData *> shownStreams() const;
+    // time span of rows of the shown streams, false if there are none
+    bool fullRange(uint64_t & from, uint64_t & to) const;
+    void setRange(double from, double to);
+    uint64_t timeAt(int x) const;
+    void showToolTip(const QPoint & pos);
+
+    p7::P7DumpModel * _model;
+
+    // visible time range, 100ns intervals; all rows until zoomed, so new
+    // rows of follow mode show up
+    bool _zoomed = false;
+    uint64_t _from = 0;
+    uint64_t _to = 0;
+
+    bool _dragging = false;
+    bool _dragged = false;
+    int _dragX = 0;
+    uint64_t _dragFrom = 0;
+    uint64_t _dragTo = 0;
+};
+
+} // namespace ui
+} // namespace p7
+
+#endif // UI_RATETIMELINE_H
@@ -0,0 +1,311 @@
+#include "telemetry_window.h"
+#include <QtWidgets>
+
+namespace p7 {
+namespace ui {
+
+TelemetryChart::TelemetryChart(QWidget *parent)
+    : QWidget(parent)
+{
+    setMinimumSize(QSize(400, 200));
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+    setAutoFillBackground(true);
+    setBackgroundRole(QPalette::Base);
+}
+
+void TelemetryChart::setSeries(const p7::p7TelemetrySeries * series)
+{
+    _series = series;
+    _dragging = false;
+    resetRange();
+}
+
+QRect TelemetryChart::plotRect() const
+{
+    const int leftMargin = fontMetrics().horizontalAdvance("-0000000.00") + 8;
+    const int bottomMargin = fontMetrics().height() + 6;
+    return rect().adjusted(leftMargin, 6, -6, -bottomMargin);
+}
+
+void TelemetryChart::resetRange()
+{
+    if (_series && _series->samplesCount()) {
+        _from = _series->firstTimestamp();
+        _to = qMax(_series->lastTimestamp(), _from + 1);
+    } else {
+        _from = _to = 0;
+    }
+    update();
+}
+
+void TelemetryChart::setRange(double from, double to)
+{
+    if (!_series || !_series->samplesCount()) {
+        return;
+    }
+
+    // don't zoom deeper than 1us per chart and don't leave the data
+    const double minSpan = 10.0;
+    if (to - from < minSpan) {
+        double center = (from + to) / 2.0;
+        from = center - minSpan / 2.0;
+        to = center + minSpan / 2.0;
+    }
+
+    const double first = (double)_series->firstTimestamp();
+    const double last = (double)qMax(_series->lastTimestamp(),
+                                     _series->firstTimestamp() + 1);
+    const double span = qMin(to - from, last - first);
+
+    if (from < first) {
+        from = first;
+        to = first + span;
+    }
+    if (to > last) {
+        to = last;
+        from = last - span;
+    }
+
+    _from = (uint64_t)from;
+    _to = (uint64_t)to;
+    update();
+}
+
+void TelemetryChart::paintEvent(QPaintEvent *event)
+{
+    QWidget::paintEvent(event);
+
+    QPainter painter(this);
+    const QRect plot = plotRect();
+
+    painter.setPen(palette().color(QPalette::Mid));
+    painter.drawRect(plot);
+
+    if (!_series || !_series->samplesCount() || plot.width() < 2) {
+        painter.setPen(palette().color(QPalette::Text));
+        painter.drawText(plot, Qt::AlignCenter, tr("No samples"));
+        return;
+    }
+
+    std::vector<p7::p7TelemetryPoint> points
+            = _series->query(_from, _to, (size_t)plot.width());
+    if (points.empty()) {
+        return;
+    }
+
+    double minValue = points.front().min;
+    double maxValue = points.front().max;
+    uint64_t samples = 0;
+    for (const p7::p7TelemetryPoint & point : points) {
+        minValue = qMin(minValue, point.min);
+        maxValue = qMax(maxValue, point.max);
+        samples += point.count;
+    }
+    if (maxValue - minValue < 1e-9) {
+        minValue -= 1.0;
+        maxValue += 1.0;
+    }
+    const double padding = (maxValue - minValue) * 0.05;
+    minValue -= padding;
+    maxValue += padding;
+
+    const double span = (double)(_to - _from);
+    auto xOf = [&](uint64_t timestamp) {
+        return plot.left()
+                + ((double)timestamp - (double)_from) * plot.width() / span;
+    };
+    auto yOf = [&](double value) {
+        return plot.bottom()
+                - (value - minValue) * plot.height() / (maxValue - minValue);
+    };
+
+    painter.save();
+    painter.setClipRect(plot.adjusted(1, 1, 0, 0));
+    painter.setRenderHint(QPainter::Antialiasing, false);
+
+    // min/max band of every bucket
+    QColor bandColor = palette().color(QPalette::Highlight);
+    bandColor.setAlphaF(0.3);
+    painter.setPen(bandColor);
+    for (const p7::p7TelemetryPoint & point : points) {
+        if (point.count > 1) {
+            const double x = xOf(point.timestamp);
+            painter.drawLine(QPointF(x, yOf(point.min)),
+                             QPointF(x, yOf(point.max)));
+        }
+    }
+
+    QPolygonF line;
+    line.reserve((int)points.size());
+    for (const p7::p7TelemetryPoint & point : points) {
+        line.append(QPointF(xOf(point.timestamp), yOf(point.avg)));
+    }
+    painter.setPen(QPen(palette().color(QPalette::Highlight), 1.5));
+    painter.drawPolyline(line);
+
+    painter.restore();
+
+    // axes labels
+    painter.setPen(palette().color(QPalette::Text));
+    const QFontMetrics metrics = fontMetrics();
+    const QRect leftLabels(0, plot.top(), plot.left() - 4, plot.height());
+    painter.drawText(leftLabels, Qt::AlignRight | Qt::AlignTop,
+                     QString::number(maxValue, 'g', 8));
+    painter.drawText(leftLabels, Qt::AlignRight | Qt::AlignBottom,
+                     QString::number(minValue, 'g', 8));
+
+    const QRect bottomLabels(plot.left(), plot.bottom() + 3,
+                             plot.width(), metrics.height());
+    painter.drawText(bottomLabels, Qt::AlignLeft,
+                     unpackDateTime(_from).toString("HH:mm:ss.zzz"));
+    painter.drawText(bottomLabels, Qt::AlignRight,
+                     unpackDateTime(_to).toString("HH:mm:ss.zzz"));
+    painter.drawText(bottomLabels, Qt::AlignHCenter,
+                     tr("%1 points, %2 samples")
+                        .arg(points.size())
+                        .arg(samples));
+}
+
+void TelemetryChart::wheelEvent(QWheelEvent *event)
+{
+    const QRect plot = plotRect();
+    if (!_series || plot.width() < 2) {
+        return;
+    }
+
+    const double factor = event->angleDelta().y() > 0 ? 0.8 : 1.25;
+    const double span = (double)(_to - _from);
+    const double ratio = qBound(0.0,
+                                (event->position().x() - plot.left())
+                                    / plot.width(),
+                                1.0);
+    const double center = (double)_from + span * ratio;
+
+    setRange(center - span * factor * ratio,
+             center + span * factor * (1.0 - ratio));
+    event->accept();
+}
+
+void TelemetryChart::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton) {
+        _dragging = true;
+        _dragX = event->x();
+        _dragFrom = _from;
+        _dragTo = _to;
+    }
+}
+
+void TelemetryChart::mouseMoveEvent(QMouseEvent *event)
+{
+    const QRect plot = plotRect();
+    if (!_dragging || plot.width() < 2) {
+        return;
+    }
+
+    const double span = (double)(_dragTo - _dragFrom);
+    const double shift = (double)(event->x() - _dragX) * span / plot.width();
+    setRange((double)_dragFrom - shift, (double)_dragTo - shift);
+}
+
+void TelemetryChart::mouseReleaseEvent(QMouseEvent *event)
+{
+    Q_UNUSED(event);
+    _dragging = false;
+}
+
+void TelemetryChart::mouseDoubleClickEvent(QMouseEvent *event)
+{
+    Q_UNUSED(event);
+    resetRange();
+}
+
+TelemetryWindow::TelemetryWindow(p7::P7DumpModel * model,
+                                 QWidget *parent)
+    : QDialog(parent)
+    , _model(model)
+{
+    setWindowTitle(tr("Telemetry"));
+    resize(QSize(1000, 500));
+
+    _seriesList = new QListWidget();
+    connect(_seriesList, &QListWidget::currentRowChanged,
+            this, &TelemetryWindow::onSeriesSelected);
+
+    _chart = new TelemetryChart();
+    _seriesValue = new QLabel();
+
+    QVBoxLayout * chartLayout = new QVBoxLayout();
+    chartLayout->addWidget(_seriesValue);
+    chartLayout->addWidget(_chart, 1);
+
+    QHBoxLayout * mainLayout = new QHBoxLayout();
+    mainLayout->addWidget(_seriesList, 1);
+    mainLayout->addLayout(chartLayout, 3);
+
+    setLayout(mainLayout);
+
+    // series belong to the dump, drop them before the dump is replaced
+    connect(_model, &QAbstractItemModel::modelAboutToBeReset,
+            this, &TelemetryWindow::onModelAboutToBeReset);
+    connect(_model, &QAbstractItemModel::modelReset,
+            this, &TelemetryWindow::showModelData);
+
+    showModelData();
+}
+
+void TelemetryWindow::showModelData()
+{
+    const int currentRow = _seriesList->currentRow();
+
+    _series.clear();
+
+    QSignalBlocker blocker(_seriesList);
+    _seriesList->clear();
+
+    const p7::p7DumpData & data = _model->dumpData();
+    for (size_t i = 0; i < data.telemetryStreamsCount(); ++i) {
+        const p7::p7TelemetryStream & stream = data.telemetryStream(i);
+        for (size_t j = 0; j < stream.seriesCount(); ++j) {
+            const p7::p7TelemetrySeries & series = stream.seriesAt(j);
+            _series.push_back(&series);
+            _seriesList->addItem(QString("%1 / %2")
+                                 .arg(stream.name())
+                                 .arg(series.name.isEmpty()
+                                      ? QString::number(series.id)
+                                      : series.name));
+        }
+    }
+
+    const int row = (currentRow >= 0 && currentRow < (int)_series.size())
+            ? currentRow
+            : (_series.empty() ? -1 : 0);
+    _seriesList->setCurrentRow(row);
+    onSeriesSelected(row);
+}
+
+void TelemetryWindow::onSeriesSelected(int row)
+{
+    if (row < 0 || row >= (int)_series.size()) {
+        _chart->setSeries(nullptr);
+        _seriesValue->clear();
+        return;
+    }
+
+    const p7::p7TelemetrySeries * series = _series[(size_t)row];
+    _chart->setSeries(series);
+    _seriesValue->setText(tr("%1: %2 samples, range %3 .. %4")
+                          .arg(series->name)
+                          .arg(series->samplesCount())
+                          .arg(series->min)
+                          .arg(series->max));
+}
+
+void TelemetryWindow::onModelAboutToBeReset()
+{
+    _chart->setSeries(nullptr);
+    _series.clear();
+}
+
+} // namespace ui
+} // namespace p7
@@ -0,0 +1,79 @@
+#ifndef UI_TELEMETRYWINDOW_H
+#define UI_TELEMETRYWINDOW_H
+
+#include <vector>
+#include <QDialog>
+#include <QLabel>
+#include <QListWidget>
+#include "p7d_model.h"
+
+namespace p7 {
+namespace ui {
+
+// Chart of one telemetry counter: min/max band and average line built from
+// the series LOD pyramid, so the number of drawn points doesn't depend on
+// the number of samples. Wheel zooms, drag pans, double click shows all.
+class TelemetryChart : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit TelemetryChart(QWidget *parent = nullptr);
+
+    void setSeries(const p7::p7TelemetrySeries * series);
+
+protected:
+
+    virtual void paintEvent(QPaintEvent *event) override;
+    virtual void wheelEvent(QWheelEvent *event) override;
+    virtual void mousePressEvent(QMouseEvent *event) override;
+    virtual void mouseMoveEvent(QMouseEvent *event) override;
+    virtual void mouseReleaseEvent(QMouseEvent *event) override;
+    virtual void mouseDoubleClickEvent(QMouseEvent *event) override;
+
+private:
+
+    QRect plotRect() const;
+    void resetRange();
+    void setRange(double from, double to);
+
+    const p7::p7TelemetrySeries * _series = nullptr;
+
+    // visible time range, 100ns intervals
+    uint64_t _from = 0;
+    uint64_t _to = 0;
+
+    bool _dragging = false;
+    int _dragX = 0;
+    uint64_t _dragFrom = 0;
+    uint64_t _dragTo = 0;
+};
+
+class TelemetryWindow : public QDialog
+{
+    Q_OBJECT
+
+public:
+    TelemetryWindow(p7::P7DumpModel * model,
+                    QWidget *parent = nullptr);
+
+    void showModelData();
+
+private:
+
+    Q_SLOT void onSeriesSelected(int row);
+    Q_SLOT void onModelAboutToBeReset();
+
+    QListWidget * _seriesList;
+    TelemetryChart * _chart;
+    QLabel * _seriesValue;
+
+    std::vector<const p7::p7TelemetrySeries *> _series;
+
+    p7::P7DumpModel * _model;
+};
+
+} // namespace ui
+} // namespace p7
+
+#endif // UI_TELEMETRYWINDOW_H
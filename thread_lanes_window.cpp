@@ -0,0 +1,481 @@
+#include "thread_lanes_window.h"
+#include "rate_timeline.h"
+#include <QtWidgets>
+#include <cmath>
+
+namespace p7 {
+namespace ui {
+
+ThreadLanesChart::ThreadLanesChart(p7::P7DumpModel * model, QWidget *parent)
+    : QAbstractScrollArea(parent)
+    , _model(model)
+{
+    viewport()->setMouseTracking(true);
+    verticalScrollBar()->setSingleStep(1);
+    setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+}
+
+void ThreadLanesChart::setLanes(const p7::p7ThreadLanes * lanes)
+{
+    _lanes = lanes;
+    _zoomed = false;
+    _dragging = false;
+    updateLanes();
+}
+
+void ThreadLanesChart::updateLanes()
+{
+    updateScrollBar();
+    viewport()->update();
+}
+
+QRect ThreadLanesChart::plotRect() const
+{
+    const int bottomMargin = fontMetrics().height() + 2;
+    return viewport()->rect().adjusted(namesWidth(), 0, 0, -bottomMargin);
+}
+
+bool ThreadLanesChart::fullRange(uint64_t & from, uint64_t & to) const
+{
+    bool found = false;
+    if (!_lanes) {
+        return found;
+    }
+
+    for (const p7::p7ThreadLane * lane : _lanes->lanes()) {
+        if (lane->times.empty()) {
+            continue;
+        }
+        from = found ? qMin(from, lane->times.front()) : lane->times.front();
+        to = found ? qMax(to, lane->times.back()) : lane->times.back();
+        found = true;
+    }
+
+    // the last row is in the range too
+    to = found ? to + 1 : to;
+    return found;
+}
+
+void ThreadLanesChart::setRange(double from, double to)
+{
+    uint64_t first = 0;
+    uint64_t last = 0;
+    if (!fullRange(first, last)) {
+        return;
+    }
+
+    // a pixel is never shorter than 1us
+    const double minSpan = 10.0 * qMax(plotRect().width(), 1);
+    if (to - from < minSpan) {
+        double center = (from + to) / 2.0;
+        from = center - minSpan / 2.0;
+        to = center + minSpan / 2.0;
+    }
+
+    const double span = qMin(to - from, (double)(last - first));
+    if (from < (double)first) {
+        from = (double)first;
+        to = from + span;
+    }
+    if (to > (double)last) {
+        to = (double)last;
+        from = to - span;
+    }
+
+    _from = (uint64_t)from;
+    _to = (uint64_t)to;
+    _zoomed = (_from > first) || (_to < last);
+    viewport()->update();
+}
+
+uint64_t ThreadLanesChart::timeAt(int x) const
+{
+    const QRect plot = plotRect();
+    const double ratio = qBound(0.0,
+                                (double)(x - plot.left()) / plot.width(),
+                                1.0);
+    return _from + (uint64_t)((double)(_to - _from) * ratio);
+}
+
+void ThreadLanesChart::updateScrollBar()
+{
+    const int lanes = _lanes ? (int)_lanes->lanes().size() : 0;
+    const int visible = qMax(plotRect().height() / laneHeight(), 1);
+    verticalScrollBar()->setRange(0, qMax(lanes - visible, 0));
+    verticalScrollBar()->setPageStep(visible);
+}
+
+const p7::p7ThreadLane * ThreadLanesChart::laneAt(const QPoint & pos) const
+{
+    const QRect plot = plotRect();
+    if (!_lanes || pos.y() < plot.top() || pos.y() > plot.bottom()) {
+        return nullptr;
+    }
+
+    const size_t index = (size_t)(verticalScrollBar()->value()
+                                  + (pos.y() - plot.top()) / laneHeight());
+    return index < _lanes->lanes().size() ? _lanes->lanes()[index] : nullptr;
+}
+
+bool ThreadLanesChart::rowAt(const p7::p7ThreadLane * lane,
+                             int x,
+                             size_t & index) const
+{
+    const uint64_t time = timeAt(x);
+    const uint64_t from = timeAt(x - 3);
+    const uint64_t to = timeAt(x + 4);
+
+    // the nearest of the rows around the time
+    const size_t next = lane->rowAtTime(time);
+    const bool hasNext = next < lane->rowsCount() && lane->times[next] < to;
+    const bool hasPrev = next > 0 && lane->times[next - 1] >= from;
+    if (!hasNext && !hasPrev) {
+        return false;
+    }
+
+    if (    (hasNext && !hasPrev)
+         || (    (hasNext)
+              && (lane->times[next] - time < time - lane->times[next - 1])
+            )
+       )
+    {
+        index = next;
+    } else {
+        index = next - 1;
+    }
+    return true;
+}
+
+void ThreadLanesChart::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+
+    QPainter painter(viewport());
+    const QRect plot = plotRect();
+    painter.fillRect(viewport()->rect(), palette().color(QPalette::Base));
+
+    if (!_zoomed && !fullRange(_from, _to)) {
+        return;
+    }
+    if (_to <= _from || plot.width() < 2 || plot.height() < laneHeight()) {
+        return;
+    }
+
+    const std::vector<const p7::p7ThreadLane *> & lanes = _lanes->lanes();
+    const size_t firstLane = (size_t)verticalScrollBar()->value();
+    const size_t endLane = qMin(lanes.size(),
+                                firstLane + (size_t)(plot.height()
+                                                     / laneHeight()) + 1);
+    const size_t bins = (size_t)plot.width();
+    const double span = (double)(_to - _from);
+
+    // ticks are written into the image pixel by pixel, a frame of a few
+    // thousand bins per lane would be slow through QPainter
+    if (_image.size() != plot.size()) {
+        _image = QImage(plot.size(), QImage::Format_RGB32);
+    }
+    _image.fill(palette().color(QPalette::Base));
+
+    const QRgb lifetimeColor = palette().color(QPalette::AlternateBase).rgb();
+    const QRgb separatorColor = palette().color(QPalette::Midlight).rgb();
+    QRgb levelColors[EP7TRACE_LEVEL_COUNT];
+    for (size_t level = 0; level < EP7TRACE_LEVEL_COUNT; ++level) {
+        levelColors[level] = RateTimeline::levelColor(level).rgb();
+    }
+
+    auto fill = [this](int left, int right, int top, int bottom, QRgb color) {
+        left = qBound(0, left, _image.width());
+        right = qBound(left, right, _image.width());
+        bottom = qMin(bottom, _image.height());
+        for (int y = qMax(top, 0); y < bottom; ++y) {
+            QRgb * line = reinterpret_cast<QRgb *>(_image.scanLine(y));
+            std::fill(line + left, line + right, color);
+        }
+    };
+
+    for (size_t i = firstLane; i < endLane; ++i) {
+        const p7::p7ThreadLane * lane = lanes[i];
+        const int top = (int)(i - firstLane) * laneHeight();
+
+        // the thread was running
+        for (const auto & lifetime : lane->lifetimes) {
+            if (lifetime.second < _from || lifetime.first >= _to) {
+                continue;
+            }
+            const double left = ((double)lifetime.first - (double)_from)
+                    * plot.width() / span;
+            const double right = ((double)lifetime.second - (double)_from)
+                    * plot.width() / span;
+            fill((int)qMax(left, -1.0), (int)qMin(right, (double)bins) + 1,
+                 top + 1, top + laneHeight() - 1, lifetimeColor);
+        }
+        fill(0, (int)bins, top + laneHeight() - 1, top + laneHeight(),
+             separatorColor);
+
+        lane->query(_from, _to, bins, _bins);
+
+        uint32_t maxRows = 0;
+        for (const p7::p7LaneBin & bin : _bins) {
+            maxRows = qMax(maxRows, bin.rows);
+        }
+        if (!maxRows) {
+            continue;
+        }
+
+        // a single row is a short tick, the densest column fills the lane
+        const int innerHeight = laneHeight() - 4;
+        const double scale = std::log2((double)maxRows + 1.0);
+        for (size_t bin = 0; bin < bins; ++bin) {
+            if (!_bins[bin].rows) {
+                continue;
+            }
+            const double density = maxRows > 1
+                    ? std::log2((double)_bins[bin].rows + 1.0) / scale
+                    : 1.0;
+            const int height = qMax(innerHeight / 3,
+                                    (int)(innerHeight * density));
+            const int bottom = top + laneHeight() - 2;
+            fill((int)bin, (int)bin + 1, bottom - height, bottom,
+                 levelColors[qMin((size_t)_bins[bin].level,
+                                  (size_t)EP7TRACE_LEVEL_COUNT - 1)]);
+        }
+    }
+
+    painter.drawImage(plot.topLeft(), _image);
+
+    // names
+    painter.setPen(palette().color(QPalette::Text));
+    for (size_t i = firstLane; i < endLane; ++i) {
+        const p7::p7ThreadLane * lane = lanes[i];
+        const QRect name(2, plot.top() + (int)(i - firstLane) * laneHeight(),
+                         namesWidth() - 6, laneHeight());
+        const QString id = "0x" + QString::number(lane->threadId, 16);
+        QString text = lane->name.isEmpty()
+                ? id
+                : lane->name + "(" + id + ")";
+        if (_model->streamsCount() > 1) {
+            text = _model->streamName((int)lane->stream) + ": " + text;
+        }
+        painter.drawText(name, Qt::AlignLeft | Qt::AlignVCenter,
+                         fontMetrics().elidedText(text, Qt::ElideMiddle,
+                                                  name.width()));
+    }
+
+    painter.setPen(palette().color(QPalette::Mid));
+    painter.drawLine(plot.topLeft() - QPoint(1, 0),
+                     plot.bottomLeft() - QPoint(1, 0));
+    painter.drawLine(plot.bottomLeft(), plot.bottomRight());
+
+    // labels
+    painter.setPen(palette().color(QPalette::Text));
+    const QRect labels(plot.left() + 2, plot.bottom() + 1,
+                       plot.width() - 4, fontMetrics().height());
+    const QString format = span >= 864000000000.0
+            ? "yyyy-MM-dd HH:mm:ss"
+            : "HH:mm:ss.zzz";
+    painter.drawText(labels, Qt::AlignLeft,
+                     unpackDateTime(_from).toString(format));
+    painter.drawText(labels, Qt::AlignRight,
+                     unpackDateTime(_to).toString(format));
+    painter.drawText(labels, Qt::AlignHCenter,
+                     tr("%1 ms per pixel").arg(span / (double)bins / 1e4,
+                                               0, 'g', 3));
+}
+
+void ThreadLanesChart::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBar();
+}
+
+void ThreadLanesChart::wheelEvent(QWheelEvent *event)
+{
+    // lanes are scrolled with shift
+    if (event->modifiers() & Qt::ShiftModifier) {
+        QAbstractScrollArea::wheelEvent(event);
+        return;
+    }
+
+    const QRect plot = plotRect();
+    if (_to <= _from || plot.width() < 2) {
+        return;
+    }
+
+    const double factor = event->angleDelta().y() > 0 ? 0.8 : 1.25;
+    const double span = (double)(_to - _from);
+    const double ratio = qBound(0.0,
+                                (event->position().x() - plot.left())
+                                    / plot.width(),
+                                1.0);
+    const double center = (double)_from + span * ratio;
+
+    setRange(center - span * factor * ratio,
+             center + span * factor * (1.0 - ratio));
+    event->accept();
+}
+
+void ThreadLanesChart::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton) {
+        _dragging = true;
+        _dragged = false;
+        _dragX = event->x();
+        _dragFrom = _from;
+        _dragTo = _to;
+    }
+}
+
+void ThreadLanesChart::mouseMoveEvent(QMouseEvent *event)
+{
+    const QRect plot = plotRect();
+    if (!_dragging) {
+        showToolTip(event->pos());
+        return;
+    }
+
+    // a click may move a pixel or two
+    if (qAbs(event->x() - _dragX) > 3) {
+        _dragged = true;
+    }
+    if (!_dragged || plot.width() < 2) {
+        return;
+    }
+
+    const double span = (double)(_dragTo - _dragFrom);
+    const double shift = (double)(event->x() - _dragX) * span / plot.width();
+    setRange((double)_dragFrom - shift, (double)_dragTo - shift);
+}
+
+void ThreadLanesChart::mouseReleaseEvent(QMouseEvent *event)
+{
+    const bool clicked = _dragging && !_dragged && _to > _from;
+    _dragging = false;
+    if (!clicked || event->x() < plotRect().left()) {
+        return;
+    }
+
+    const p7::p7ThreadLane * lane = laneAt(event->pos());
+    size_t index = 0;
+    if (!lane || !rowAt(lane, event->x(), index)) {
+        return;
+    }
+
+    const p7::p7StreamData & stream = _model->dumpData().stream(lane->stream);
+    emit rowActivated(lane->stream,
+                      stream.firstRowNumber()
+                        + stream.rowIndex(lane->rows[index]));
+}
+
+void ThreadLanesChart::mouseDoubleClickEvent(QMouseEvent *event)
+{
+    Q_UNUSED(event);
+    _zoomed = false;
+    viewport()->update();
+}
+
+void ThreadLanesChart::showToolTip(const QPoint & pos)
+{
+    const QRect plot = plotRect();
+    const p7::p7ThreadLane * lane = laneAt(pos);
+    if (!lane || _to <= _from || plot.width() < 2) {
+        QToolTip::hideText();
+        return;
+    }
+
+    QString text = lane->name.isEmpty()
+            ? "0x" + QString::number(lane->threadId, 16)
+            : lane->name + "(0x" + QString::number(lane->threadId, 16) + ")";
+    text += tr("\n%1 rows").arg(lane->rowsCount());
+
+    if (pos.x() >= plot.left()) {
+        const uint64_t from = timeAt(pos.x());
+        const uint64_t to = timeAt(pos.x() + 1);
+        const size_t rows = lane->rowAtTime(to) - lane->rowAtTime(from);
+        text += tr("\n%1: %2 rows")
+                .arg(unpackDateTime(from).toString("HH:mm:ss.zzz"))
+                .arg(rows);
+
+        size_t index = 0;
+        if (rowAt(lane, pos.x(), index)) {
+            const p7::p7StreamData & stream
+                    = _model->dumpData().stream(lane->stream);
+            const size_t row = stream.rowIndex(lane->rows[index]);
+            if (row < stream.traceDataCount()) {
+                text += "\n" + stream.traceDataAt(row).message;
+            }
+        }
+    }
+
+    QToolTip::showText(mapToGlobal(pos), text, this);
+}
+
+ThreadLanesWindow::ThreadLanesWindow(p7::P7DumpModel * model,
+                                     QWidget *parent)
+    : QDialog(parent)
+    , _model(model)
+{
+    setWindowTitle(tr("Threads"));
+    resize(QSize(1200, 700));
+
+    _lanesInfo = new QLabel();
+
+    _chart = new ThreadLanesChart(_model);
+    connect(_chart, &ThreadLanesChart::rowActivated,
+            this, &ThreadLanesWindow::rowActivated);
+
+    QVBoxLayout * mainLayout = new QVBoxLayout();
+    mainLayout->addWidget(_lanesInfo);
+    mainLayout->addWidget(_chart, 1);
+    setLayout(mainLayout);
+
+    // lanes refer to rows of the dump, drop them before it is replaced
+    connect(_model, &QAbstractItemModel::modelAboutToBeReset,
+            this, &ThreadLanesWindow::onModelAboutToBeReset);
+    connect(_model, &QAbstractItemModel::modelReset,
+            this, &ThreadLanesWindow::showModelData);
+
+    showModelData();
+}
+
+void ThreadLanesWindow::showModelData()
+{
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    _lanes.clear();
+    _lanes.update(_model->dumpData());
+    QApplication::restoreOverrideCursor();
+
+    _chart->setLanes(&_lanes);
+    showLanesInfo();
+}
+
+void ThreadLanesWindow::updateLanes()
+{
+    _lanes.update(_model->dumpData());
+    _chart->updateLanes();
+    showLanesInfo();
+}
+
+void ThreadLanesWindow::onModelAboutToBeReset()
+{
+    _chart->setLanes(nullptr);
+    _lanes.clear();
+}
+
+void ThreadLanesWindow::showLanesInfo()
+{
+    size_t rows = 0;
+    for (const p7::p7ThreadLane * lane : _lanes.lanes()) {
+        rows += lane->rowsCount();
+    }
+
+    _lanesInfo->setText(tr("%1 threads, %2 rows, index %3 MB."
+                           " Wheel zooms, shift + wheel scrolls threads,"
+                           " click a tick to show its row")
+                        .arg(_lanes.lanes().size())
+                        .arg(rows)
+                        .arg((double)_lanes.memoryUsage() / (1024.0 * 1024.0),
+                             0, 'f', 1));
+}
+
+} // namespace ui
+} // namespace p7
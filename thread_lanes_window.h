@@ -0,0 +1,126 @@
+#ifndef UI_THREADLANESWINDOW_H
+#define UI_THREADLANESWINDOW_H
+
+#include <vector>
+#include <QAbstractScrollArea>
+#include <QDialog>
+#include <QImage>
+#include <QLabel>
+#include "p7d_model.h"
+#include "p7d_thread_lanes.h"
+
+namespace p7 {
+namespace ui {
+
+// Lanes of threads one under another, rows as ticks colored by the highest
+// level and as tall as dense they are. Every visible lane asks its index
+// for one bin per pixel (p7ThreadLane::query), so the cost of a repaint
+// depends on the size of the window and not on rows. Wheel zooms, shift +
+// wheel scrolls lanes, drag pans, double click shows all, a click on a
+// tick activates its row.
+class ThreadLanesChart : public QAbstractScrollArea
+{
+    Q_OBJECT
+
+public:
+    explicit ThreadLanesChart(p7::P7DumpModel * model,
+                              QWidget *parent = nullptr);
+
+    // lanes are owned by the caller, nullptr before a reset of them
+    void setLanes(const p7::p7ThreadLanes * lanes);
+    // rows have been added to the lanes
+    void updateLanes();
+
+    // row under a tick is activated: its stream and number
+    Q_SIGNAL void rowActivated(size_t stream, quint64 number);
+
+protected:
+
+    virtual void paintEvent(QPaintEvent *event) override;
+    virtual void resizeEvent(QResizeEvent *event) override;
+    virtual void wheelEvent(QWheelEvent *event) override;
+    virtual void mousePressEvent(QMouseEvent *event) override;
+    virtual void mouseMoveEvent(QMouseEvent *event) override;
+    virtual void mouseReleaseEvent(QMouseEvent *event) override;
+    virtual void mouseDoubleClickEvent(QMouseEvent *event) override;
+
+private:
+
+    static constexpr int laneHeight()
+    {
+        return 20;
+    }
+
+    static constexpr int namesWidth()
+    {
+        return 200;
+    }
+
+    // lanes of the viewport, time labels are below them
+    QRect plotRect() const;
+    bool fullRange(uint64_t & from, uint64_t & to) const;
+    void setRange(double from, double to);
+    uint64_t timeAt(int x) const;
+    void updateScrollBar();
+    // lane under the point or nullptr
+    const p7::p7ThreadLane * laneAt(const QPoint & pos) const;
+    // index of the lane row nearest to x within a few pixels, false if none
+    bool rowAt(const p7::p7ThreadLane * lane, int x, size_t & index) const;
+    void showToolTip(const QPoint & pos);
+
+    p7::P7DumpModel * _model;
+    const p7::p7ThreadLanes * _lanes = nullptr;
+
+    // visible time range, 100ns intervals; all rows until zoomed
+    bool _zoomed = false;
+    uint64_t _from = 0;
+    uint64_t _to = 0;
+
+    bool _dragging = false;
+    bool _dragged = false;
+    int _dragX = 0;
+    uint64_t _dragFrom = 0;
+    uint64_t _dragTo = 0;
+
+    // reused between repaints
+    QImage _image;
+    std::vector<p7::p7LaneBin> _bins;
+};
+
+// Swimlane view of the threads of all channels (the thread table gives
+// names and lifetimes). The index of rows by thread is built when the
+// window is opened and extended with appended rows; it belongs to the
+// window and is dropped with the dump.
+class ThreadLanesWindow : public QDialog
+{
+    Q_OBJECT
+
+public:
+    ThreadLanesWindow(p7::P7DumpModel * model,
+                      QWidget *parent = nullptr);
+
+    void showModelData();
+    // rows have been appended to the dump (follow, live)
+    void updateLanes();
+
+    // a row of a lane is activated: its stream and number
+    Q_SIGNAL void rowActivated(size_t stream, quint64 number);
+
+private:
+
+    Q_SLOT void onModelAboutToBeReset();
+
+    void showLanesInfo();
+
+    QLabel * _lanesInfo;
+    ThreadLanesChart * _chart;
+
+    p7::p7ThreadLanes _lanes;
+
+    p7::P7DumpModel * _model;
+};
+
+} // namespace ui
+} // namespace p7
+
+#endif // UI_THREADLANESWINDOW_H
@@ -0,0 +1,204 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                             /
+// 2022 (c) Ragnar Lodbrok                                                     /
+//                                                                             /
+// This library is free software; you can redistribute it and/or               /
+// modify it under the terms of the GNU Lesser General Public                  /
+// License as published by the Free Software Foundation; either                /
+// version 3.0 of the License, or (at your option) any later version.          /
+//                                                                             /
+// This library is distributed in the hope that it will be useful,             /
+// but WITHOUT ANY WARRANTY; without even the implied warranty of              /
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU           /
+// Lesser General Public License for more details.                             /
+//                                                                             /
+// You should have received a copy of the GNU Lesser General Public            /
+// License along with this library.                                            /
+//                                                                             /
+////////////////////////////////////////////////////////////////////////////////
+
+// p7dgen - writes synthetic *.p7d files, see p7d_generator.h
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "p7d_generator.h"
+
+static void printUsage()
+{
+    printf("Usage: p7dgen [options] <output.p7d>\n"
+           "  --rows N           rows in total (default 100000)\n"
+           "  --size N[K|M|G]    generate until file size is reached\n"
+           "  --descriptions N   descriptions per channel (default 256)\n"
+           "  --threads N        threads per channel (default 8)\n"
+           "  --modules N        modules per channel (default 4)\n"
+           "  --channels N       trace channels, 1..32 (default 1)\n"
+           "  --max-args N       max arguments per description (default 4)\n"
+           "  --arg-mix W,..     weights of int32,int64,double,char,pointer,\n"
+           "                     stra,ustr8,ustr16 arguments\n"
+           "  --levels W,..      weights of trace..critical levels\n"
+           "  --length fixed|uniform|exp\n"
+           "                     text/string argument length distribution\n"
+           "  --length-min N     (default 8)\n"
+           "  --length-mean N    mean for exp distribution (default 48)\n"
+           "  --length-max N     (default 1024)\n"
+           "  --chunk N          max chunk size in bytes (default 65536)\n"
+           "  --drops N          sequence gaps per 1000 rows (default 0)\n"
+           "  --seed N           random seed (default 1)\n");
+}
+
+static uint64_t parseSize(const char * value)
+{
+    char * end = nullptr;
+    uint64_t size = strtoull(value, &end, 10);
+
+    if (end && *end) {
+        switch (*end) {
+        case 'k': case 'K': size <<= 10; break;
+        case 'm': case 'M': size <<= 20; break;
+        case 'g': case 'G': size <<= 30; break;
+        default: break;
+        }
+    }
+
+    return size;
+}
+
+template<size_t N>
+static bool parseWeights(const char * value, uint32_t (&weights)[N])
+{
+    uint32_t parsed[N] = {};
+    size_t count = 0;
+
+    const char * cursor = value;
+    while (*cursor && count < N) {
+        char * end = nullptr;
+        parsed[count++] = (uint32_t)strtoul(cursor, &end, 10);
+        if (end == cursor) {
+            return false;
+        }
+        cursor = (*end == ',') ? end + 1 : end;
+    }
+
+    if (count != N) {
+        return false;
+    }
+
+    memcpy(weights, parsed, sizeof(parsed));
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    p7::p7DumpGeneratorOptions options;
+    std::string output;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const char * value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+        auto needValue = [&]() -> bool {
+            if (!value) {
+                fprintf(stderr, "Missing value for %s\n", arg.c_str());
+                return false;
+            }
+            ++i;
+            return true;
+        };
+
+        if (arg == "-h" || arg == "--help") {
+            printUsage();
+            return 0;
+        } else if (arg == "--rows") {
+            if (!needValue()) return 1;
+            options.rows = parseSize(value);
+        } else if (arg == "--size") {
+            if (!needValue()) return 1;
+            options.targetBytes = parseSize(value);
+        } else if (arg == "--descriptions") {
+            if (!needValue()) return 1;
+            options.descriptions = (uint32_t)atoi(value);
+        } else if (arg == "--threads") {
+            if (!needValue()) return 1;
+            options.threads = (uint32_t)atoi(value);
+        } else if (arg == "--modules") {
+            if (!needValue()) return 1;
+            options.modules = (uint32_t)atoi(value);
+        } else if (arg == "--channels") {
+            if (!needValue()) return 1;
+            options.channels = (uint32_t)atoi(value);
+        } else if (arg == "--max-args") {
+            if (!needValue()) return 1;
+            options.maxArgs = (uint32_t)atoi(value);
+        } else if (arg == "--arg-mix") {
+            if (!needValue()) return 1;
+            if (!parseWeights(value, options.argWeights)) {
+                fprintf(stderr, "--arg-mix expects 8 weights\n");
+                return 1;
+            }
+        } else if (arg == "--levels") {
+            if (!needValue()) return 1;
+            if (!parseWeights(value, options.levelWeights)) {
+                fprintf(stderr, "--levels expects 6 weights\n");
+                return 1;
+            }
+        } else if (arg == "--length") {
+            if (!needValue()) return 1;
+            std::string distribution = value;
+            if (distribution == "fixed") {
+                options.lengthDistribution = p7::p7GenLengthDistribution::Fixed;
+            } else if (distribution == "uniform") {
+                options.lengthDistribution = p7::p7GenLengthDistribution::Uniform;
+            } else if (distribution == "exp") {
+                options.lengthDistribution
+                    = p7::p7GenLengthDistribution::Exponential;
+            } else {
+                fprintf(stderr, "Unknown length distribution %s\n", value);
+                return 1;
+            }
+        } else if (arg == "--length-min") {
+            if (!needValue()) return 1;
+            options.lengthMin = (uint32_t)atoi(value);
+        } else if (arg == "--length-mean") {
+            if (!needValue()) return 1;
+            options.lengthMean = (uint32_t)atoi(value);
+        } else if (arg == "--length-max") {
+            if (!needValue()) return 1;
+            options.lengthMax = (uint32_t)atoi(value);
+        } else if (arg == "--chunk") {
+            if (!needValue()) return 1;
+            options.chunkSize = (uint32_t)parseSize(value);
+        } else if (arg == "--drops") {
+            if (!needValue()) return 1;
+            options.dropsPerMille = (uint32_t)atoi(value);
+        } else if (arg == "--seed") {
+            if (!needValue()) return 1;
+            options.seed = strtoull(value, nullptr, 10);
+        } else if (!arg.empty() && arg[0] == '-') {
+            fprintf(stderr, "Unknown option %s\n", arg.c_str());
+            printUsage();
+            return 1;
+        } else {
+            output = arg;
+        }
+    }
+
+    if (output.empty()) {
+        printUsage();
+        return 1;
+    }
+
+    p7::p7DumpGenerator generator(options);
+    if (!generator.generate(output)) {
+        fprintf(stderr, "Failed to write %s\n", output.c_str());
+        return 1;
+    }
+
+    printf("%s: %llu rows, %llu bytes\n",
+           output.c_str(),
+           (unsigned long long)generator.rowsWritten(),
+           (unsigned long long)generator.bytesWritten());
+
+    return 0;
+}
@@ -0,0 +1,13 @@
+TARGET = p7dgen
+TEMPLATE = app
+
+CONFIG  += console c++14
+CONFIG  -= qt app_bundle
+
+INCLUDEPATH += ../..
+
+SOURCES  += main.cpp
+
+HEADERS  += ../../p7d_generator.h \
+            ../../p7Structs.h \
+            ../../GTypes.h
@@ -0,0 +1,511 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                             /
+// 2022 (c) Ragnar Lodbrok                                                     /
+//                                                                             /
+// This library is free software; you can redistribute it and/or               /
+// modify it under the terms of the GNU Lesser General Public                  /
+// License as published by the Free Software Foundation; either                /
+// version 3.0 of the License, or (at your option) any later version.          /
+//                                                                             /
+// This library is distributed in the hope that it will be useful,             /
+// but WITHOUT ANY WARRANTY; without even the implied warranty of              /
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU           /
+// Lesser General Public License for more details.                             /
+//                                                                             /
+// You should have received a copy of the GNU Lesser General Public            /
+// License along with this library.                                            /
+//                                                                             /
+////////////////////////////////////////////////////////////////////////////////
+
+
+// p7dreplay - sends a *.p7d file to P7ReplayReceiver over UDP (loopback)
+// as a client of p7d_transport.h: a hello with the dump header, then its
+// packets repacked to data packets of whole packets of one channel, sent
+// again until they are acknowledged, and a bye
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+#include "p7Structs.h"
+#include "p7d_transport.h"
+
+static void printUsage()
+{
+    printf("Usage: p7dreplay [options] <input.p7d>\n"
+           "  --port N           receiver port on 127.0.0.1 (default 9009)\n"
+           "  --datagram N       max datagram size in bytes (default 8192)\n"
+           "  --window N         data packets sent before an ack (default 64)\n"
+           "  --timeout-ms N     wait for an ack before sending again\n"
+           "                     (default 50)\n"
+           "  --retries N        timeouts in a row before giving up\n"
+           "                     (default 100)\n");
+}
+
+static bool readFile(const std::string & fileName, std::vector<uint8_t> & data)
+{
+    FILE * file = fopen(fileName.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+
+    // 64-bit offsets, dumps may be over 2 GB
+    if (fseeko(file, 0, SEEK_END) != 0) {
+        fclose(file);
+        return false;
+    }
+    const off_t size = ftello(file);
+    if (    (size < 0)
+         || ((uint64_t)size > SIZE_MAX)
+         || (fseeko(file, 0, SEEK_SET) != 0)
+       )
+    {
+        fclose(file);
+        return false;
+    }
+
+    data.resize((size_t)size);
+    size_t read = fread(data.data(), 1, data.size(), file);
+    fclose(file);
+
+    return read == data.size();
+}
+
+// Client side of p7d_transport.h over a connected UDP socket: up to
+// window data packets wait for an ack, all of them are sent again when
+// none comes in time (go-back-N)
+class p7TransportClient
+{
+public:
+
+    p7TransportClient(int socket, size_t window, int timeoutMs, int retries)
+        : _socket(socket)
+        , _window(window)
+        , _timeoutMs(timeoutMs)
+        , _retries(retries)
+    {}
+
+    bool hello(const sP7File_Header & header)
+    {
+        _nonce = (uint32_t)std::chrono::steady_clock::now()
+                .time_since_epoch().count() ^ (uint32_t)getpid();
+
+        std::vector<uint8_t> datagram(sizeof(p7::p7TransportHeader)
+                                      + sizeof(header));
+        memcpy(datagram.data() + sizeof(p7::p7TransportHeader),
+               &header, sizeof(header));
+        p7::p7SealDatagram(datagram.data(), datagram.size(),
+                           p7::P7_TRANSPORT_HELLO, _nonce, 0);
+
+        for (int attempt = 0; attempt <= _retries; ++attempt) {
+            if (!send(datagram)) {
+                return false;
+            }
+
+            p7::p7TransportHeader reply;
+            while (receive(reply)) {
+                if (    (reply.type == p7::P7_TRANSPORT_WELCOME)
+                     && (reply.id == _nonce)
+                   )
+                {
+                    _session = reply.session;
+                    return true;
+                }
+            }
+        }
+
+        fprintf(stderr, "No answer to hello\n");
+        return false;
+    }
+
+    // Sends chunks as the next data packet, waits while the window is full
+    bool data(const uint8_t * chunks, size_t size)
+    {
+        _unacked.emplace_back(sizeof(p7::p7TransportHeader) + size);
+        std::vector<uint8_t> & datagram = _unacked.back();
+        memcpy(datagram.data() + sizeof(p7::p7TransportHeader), chunks, size);
+        p7::p7SealDatagram(datagram.data(), datagram.size(),
+                           p7::P7_TRANSPORT_DATA, _next++, _session);
+
+        ++_datagrams;
+        _bytes += datagram.size();
+        if (!send(datagram)) {
+            return false;
+        }
+
+        while (_unacked.size() >= _window) {
+            if (!waitForAcks()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Waits until all data is acknowledged, then says bye
+    bool bye()
+    {
+        while (!_unacked.empty()) {
+            if (!waitForAcks()) {
+                return false;
+            }
+        }
+
+        std::vector<uint8_t> datagram(sizeof(p7::p7TransportHeader));
+        p7::p7SealDatagram(datagram.data(), datagram.size(),
+                           p7::P7_TRANSPORT_BYE, _next, _session);
+
+        for (int attempt = 0; attempt <= _retries; ++attempt) {
+            if (!send(datagram)) {
+                return false;
+            }
+
+            p7::p7TransportHeader reply;
+            while (receive(reply)) {
+                if (    (reply.type == p7::P7_TRANSPORT_ACK)
+                     && (reply.session == _session)
+                     && (reply.id == _next)
+                   )
+                {
+                    return true;
+                }
+            }
+        }
+
+        fprintf(stderr, "No answer to bye\n");
+        return false;
+    }
+
+    uint64_t datagrams() const
+    {
+        return _datagrams;
+    }
+
+    uint64_t bytes() const
+    {
+        return _bytes;
+    }
+
+    uint64_t resent() const
+    {
+        return _resent;
+    }
+
+private:
+
+    bool send(const std::vector<uint8_t> & datagram)
+    {
+        ssize_t sent = ::send(_socket, datagram.data(), datagram.size(), 0);
+        if (sent != (ssize_t)datagram.size()) {
+            perror("send");
+            return false;
+        }
+        return true;
+    }
+
+    // false once nothing valid came for the timeout
+    bool receive(p7::p7TransportHeader & reply)
+    {
+        pollfd fd;
+        fd.fd = _socket;
+        fd.events = POLLIN;
+        fd.revents = 0;
+
+        for (;;) {
+            if (poll(&fd, 1, _timeoutMs) <= 0) {
+                return false;
+            }
+
+            uint8_t datagram[sizeof(reply)];
+            // ECONNREFUSED: nobody listens yet, wait as for a lost one
+            ssize_t size = recv(_socket, datagram, sizeof(datagram), 0);
+            if (    (size == (ssize_t)sizeof(reply))
+                 && (p7::p7OpenDatagram(datagram, (size_t)size, reply))
+               )
+            {
+                return true;
+            }
+        }
+    }
+
+    // Drops acknowledged packets; sends all waiting ones again if no ack
+    // came for the timeout, false after retries timeouts in a row
+    bool waitForAcks()
+    {
+        p7::p7TransportHeader reply;
+        if (receive(reply)) {
+            const uint32_t first = _next - (uint32_t)_unacked.size();
+            if (    (reply.type == p7::P7_TRANSPORT_ACK)
+                 && (reply.session == _session)
+                 && (reply.id >= first)
+               )
+            {
+                _timeouts = 0;
+                for (uint32_t id = first; id <= reply.id && !_unacked.empty();
+                     ++id) {
+                    _unacked.pop_front();
+                }
+            }
+            return true;
+        }
+
+        if (++_timeouts > _retries) {
+            fprintf(stderr, "No ack for %d ms\n", _timeoutMs * _retries);
+            return false;
+        }
+
+        for (const std::vector<uint8_t> & datagram : _unacked) {
+            ++_resent;
+            if (!send(datagram)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    int _socket;
+    size_t _window;
+    int _timeoutMs;
+    int _retries;
+
+    uint32_t _nonce = 0;
+    uint16_t _session = 0;
+    uint32_t _next = 1; // id of the next data packet
+    std::deque<std::vector<uint8_t>> _unacked; // ids _next - size() ...
+    int _timeouts = 0;
+
+    uint64_t _datagrams = 0;
+    uint64_t _bytes = 0;
+    uint64_t _resent = 0;
+};
+
+// Repacks packets of the dump to chunks of one channel, a full chunk is
+// sent as one data packet
+class p7ChunkPacker
+{
+public:
+
+    p7ChunkPacker(p7TransportClient & client, size_t maxSize)
+        : _client(client)
+        , _maxSize(maxSize)
+    {}
+
+    bool addPacket(uint32_t channelId, const uint8_t * packet, size_t size)
+    {
+        if (sizeof(sH_User_Data) + size > _maxSize) {
+            ++_skipped;
+            return true;
+        }
+
+        if (    (!_chunk.empty())
+             && (    (channelId != _channelId)
+                  || (_chunk.size() + size > _maxSize)
+                )
+           )
+        {
+            if (!flush()) {
+                return false;
+            }
+        }
+
+        if (_chunk.empty()) {
+            _chunk.resize(sizeof(sH_User_Data));
+            _channelId = channelId;
+        }
+
+        _chunk.insert(_chunk.end(), packet, packet + size);
+        return true;
+    }
+
+    bool flush()
+    {
+        if (_chunk.empty()) {
+            return true;
+        }
+
+        sH_User_Data header;
+        header.dwSize = (uint32_t)_chunk.size();
+        header.dwChannel_ID = _channelId;
+        memcpy(_chunk.data(), &header, sizeof(header));
+
+        bool sent = _client.data(_chunk.data(), _chunk.size());
+        _chunk.clear();
+        return sent;
+    }
+
+    uint64_t skipped() const
+    {
+        return _skipped;
+    }
+
+private:
+
+    p7TransportClient & _client;
+    size_t _maxSize; // of a chunk
+
+    std::vector<uint8_t> _chunk;
+    uint32_t _channelId = 0;
+
+    uint64_t _skipped = 0; // packets bigger than a datagram
+};
+
+int main(int argc, char *argv[])
+{
+    int port = 9009;
+    size_t maxSize = 8192;
+    size_t window = 64;
+    int timeoutMs = 50;
+    int retries = 100;
+    std::string input;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const char * value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+        auto needValue = [&]() -> bool {
+            if (!value) {
+                fprintf(stderr, "Missing value for %s\n", arg.c_str());
+                return false;
+            }
+            ++i;
+            return true;
+        };
+
+        if (arg == "-h" || arg == "--help") {
+            printUsage();
+            return 0;
+        } else if (arg == "--port") {
+            if (!needValue()) return 1;
+            port = atoi(value);
+        } else if (arg == "--datagram") {
+            if (!needValue()) return 1;
+            maxSize = (size_t)strtoul(value, nullptr, 10);
+        } else if (arg == "--window") {
+            if (!needValue()) return 1;
+            window = (size_t)strtoul(value, nullptr, 10);
+        } else if (arg == "--timeout-ms") {
+            if (!needValue()) return 1;
+            timeoutMs = atoi(value);
+        } else if (arg == "--retries") {
+            if (!needValue()) return 1;
+            retries = atoi(value);
+        } else if (!arg.empty() && arg[0] == '-') {
+            fprintf(stderr, "Unknown option %s\n", arg.c_str());
+            printUsage();
+            return 1;
+        } else {
+            input = arg;
+        }
+    }
+
+    if (input.empty()) {
+        printUsage();
+        return 1;
+    }
+
+    // 65507 is the max UDP payload, the hello has to fit too
+    const size_t minSize = sizeof(p7::p7TransportHeader)
+            + sizeof(sP7File_Header);
+    if (maxSize < minSize || maxSize > 65507) {
+        fprintf(stderr, "--datagram must be in %u..65507\n",
+                (unsigned)minSize);
+        return 1;
+    }
+
+    if (window < 1 || timeoutMs < 1 || retries < 0) {
+        fprintf(stderr, "--window and --timeout-ms must be positive\n");
+        return 1;
+    }
+
+    std::vector<uint8_t> data;
+    if (!readFile(input, data) || data.size() < sizeof(sP7File_Header)) {
+        fprintf(stderr, "Failed to read %s\n", input.c_str());
+        return 1;
+    }
+
+    const sP7File_Header * fileHeader = (const sP7File_Header *)data.data();
+    if (fileHeader->qwMarker != P7_DAMP_FILE_MARKER_V1) {
+        fprintf(stderr, "%s is not a P7 dump\n", input.c_str());
+        return 1;
+    }
+
+    int udpSocket = socket(AF_INET, SOCK_DGRAM, 0);
+    if (udpSocket < 0) {
+        perror("socket");
+        return 1;
+    }
+
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons((uint16_t)port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    // replies come from the receiver only
+    if (connect(udpSocket, (const sockaddr *)&address, sizeof(address)) != 0) {
+        perror("connect");
+        close(udpSocket);
+        return 1;
+    }
+
+    p7TransportClient client(udpSocket, window, timeoutMs, retries);
+    p7ChunkPacker packer(client, maxSize - sizeof(p7::p7TransportHeader));
+
+    bool ok = client.hello(*fileHeader);
+
+    size_t offs = sizeof(sP7File_Header);
+    while (ok && offs + sizeof(sH_User_Data) <= data.size()) {
+        const sH_User_Data * chunk = (const sH_User_Data *)(data.data() + offs);
+        if (    (chunk->dwSize < sizeof(sH_User_Data))
+             || (offs + chunk->dwSize > data.size())
+           )
+        {
+            break;
+        }
+
+        size_t packetOffs = offs + sizeof(sH_User_Data);
+        const size_t chunkEnd = offs + chunk->dwSize;
+        while (ok && packetOffs + sizeof(sP7Ext_Header) <= chunkEnd) {
+            const sP7Ext_Header * packet
+                    = (const sP7Ext_Header *)(data.data() + packetOffs);
+            if (    (packet->dwSize < sizeof(sP7Ext_Header))
+                 || (packetOffs + packet->dwSize > chunkEnd)
+               )
+            {
+                break;
+            }
+
+            ok = packer.addPacket(chunk->dwChannel_ID,
+                                  data.data() + packetOffs, packet->dwSize);
+            packetOffs += packet->dwSize;
+        }
+
+        offs = chunkEnd;
+    }
+
+    ok = ok && packer.flush() && client.bye();
+    close(udpSocket);
+
+    printf("%s: %llu data packets, %llu bytes sent to 127.0.0.1:%d",
+           input.c_str(),
+           (unsigned long long)client.datagrams(),
+           (unsigned long long)client.bytes(),
+           port);
+    if (client.resent()) {
+        printf(", %llu sent again", (unsigned long long)client.resent());
+    }
+    if (packer.skipped()) {
+        printf(", %llu packets too big for a datagram skipped",
+               (unsigned long long)packer.skipped());
+    }
+    printf("\n");
+
+    return ok ? 0 : 1;
+}
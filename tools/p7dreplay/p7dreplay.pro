@@ -0,0 +1,13 @@
+TARGET = p7dreplay
+TEMPLATE = app
+
+CONFIG  += console c++14
+CONFIG  -= qt app_bundle
+
+INCLUDEPATH += ../..
+
+SOURCES  += main.cpp
+
+HEADERS  += ../../p7Structs.h \
+            ../../GTypes.h \
+            ../../p7d_transport.h
@@ -0,0 +1,439 @@
+#include "trace_ids_window.h"
+#include <QtWidgets>
+
+namespace p7 {
+namespace ui {
+
+namespace {
+
+enum class GroupColumns {
+    Channel = 0,
+    ID,
+    Rows,
+    First,
+    Last,
+    Rate,
+    Level,
+    Module,
+    Format,
+    Location,
+    Count
+};
+
+// item of a group line, stream and id of the line are in Qt::UserRole
+QTableWidgetItem * groupItem(const QVariant & value)
+{
+    QTableWidgetItem * item = new QTableWidgetItem();
+    item->setData(Qt::DisplayRole, value);
+    item->setFlags(Qt::ItemIsSelectable | Qt::ItemIsEnabled);
+    return item;
+}
+
+}
+
+TraceIdRowsModel::TraceIdRowsModel(p7::P7DumpModel * model, QObject *parent)
+    : QAbstractTableModel(parent)
+    , _model(model)
+{
+}
+
+void TraceIdRowsModel::setRows(size_t stream,
+                               const std::deque<uint32_t> * rows)
+{
+    beginResetModel();
+    _stream = stream;
+    _rows = rows;
+    _count = rows ? rows->size() : 0;
+    endResetModel();
+}
+
+void TraceIdRowsModel::rowsChanged(const std::deque<uint32_t> * rows,
+                                   size_t dropped)
+{
+    if (!_rows) {
+        return;
+    }
+
+    // the list itself may have moved, its rows didn't
+    _rows = rows;
+
+    if (dropped) {
+        beginRemoveRows(QModelIndex(), 0, (int)dropped - 1);
+        _count -= dropped;
+        endRemoveRows();
+    }
+
+    if (_rows->size() > _count) {
+        beginInsertRows(QModelIndex(), (int)_count, (int)_rows->size() - 1);
+        _count = _rows->size();
+        endInsertRows();
+    }
+}
+
+size_t TraceIdRowsModel::stream() const
+{
+    return _stream;
+}
+
+uint64_t TraceIdRowsModel::rowNumber(int row) const
+{
+    const p7::p7StreamData & stream = _model->dumpData().stream(_stream);
+    return stream.firstRowNumber() + stream.rowIndex((*_rows)[(size_t)row]);
+}
+
+QVariant TraceIdRowsModel::data(const QModelIndex &index, int role) const
+{
+    if (!_rows || !index.isValid() || role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    // dropped by retention since the list was made
+    const p7::p7StreamData & stream = _model->dumpData().stream(_stream);
+    const size_t row = stream.rowIndex((*_rows)[(size_t)index.row()]);
+    if (row >= stream.traceDataCount()) {
+        return index.column() == static_cast<int>(Columns::Text)
+                ? QVariant(tr("(dropped)"))
+                : QVariant();
+    }
+
+    const p7::p7TraceDataInfo & data = stream.traceDataAt(row);
+    switch (static_cast<Columns>(index.column())) {
+    case Columns::Time:
+        return data.time.toString("HH:mm:ss.zzz");
+    case Columns::Thread:
+        return data.threadName.isEmpty()
+                ? "0x" + QString::number(data.threadId, 16)
+                : data.threadName
+                    + "(0x" + QString::number(data.threadId, 16) + ")";
+    case Columns::Text:
+        return data.message;
+    default:
+        break;
+    }
+
+    return QVariant();
+}
+
+QVariant TraceIdRowsModel::headerData(int section,
+                                      Qt::Orientation orientation,
+                                      int role) const
+{
+    if (role != Qt::DisplayRole || orientation != Qt::Horizontal) {
+        return QVariant();
+    }
+
+    switch (static_cast<Columns>(section)) {
+    case Columns::Time:
+        return tr("Time");
+    case Columns::Thread:
+        return tr("Thread");
+    case Columns::Text:
+        return tr("Text");
+    default:
+        break;
+    }
+
+    return QVariant();
+}
+
+int TraceIdRowsModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : (int)_count;
+}
+
+int TraceIdRowsModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(Columns::Count);
+}
+
+TraceIdsWindow::TraceIdsWindow(p7::P7DumpModel * model,
+                               QWidget *parent)
+    : QDialog(parent)
+    , _model(model)
+{
+    setWindowTitle(tr("Trace IDs"));
+    resize(QSize(1200, 700));
+
+    _groupsTable = new QTableWidget(0, static_cast<int>(GroupColumns::Count));
+    _groupsTable->setHorizontalHeaderLabels({
+        tr("Channel"), tr("ID"), tr("Rows"), tr("First"), tr("Last"),
+        tr("Rows/s"), tr("Level"), tr("Module"), tr("Format"),
+        tr("Location")
+    });
+    _groupsTable->verticalHeader()->hide();
+    _groupsTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    _groupsTable->setSelectionMode(QAbstractItemView::SingleSelection);
+    _groupsTable->horizontalHeader()->setStretchLastSection(true);
+    connect(_groupsTable, &QTableWidget::itemSelectionChanged,
+            this, &TraceIdsWindow::onGroupSelected);
+
+    _groupValue = new QLabel();
+
+    _rowsModel = new TraceIdRowsModel(_model, this);
+    _rowsTable = new QTableView();
+    _rowsTable->verticalHeader()->hide();
+    _rowsTable->verticalHeader()->setDefaultSectionSize(24);
+    _rowsTable->horizontalHeader()->setStretchLastSection(true);
+    _rowsTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    _rowsTable->setModel(_rowsModel);
+    _rowsTable->setColumnWidth(
+                static_cast<int>(TraceIdRowsModel::Columns::Time), 100);
+    _rowsTable->setColumnWidth(
+                static_cast<int>(TraceIdRowsModel::Columns::Thread), 150);
+    connect(_rowsTable, &QAbstractItemView::doubleClicked,
+            this, &TraceIdsWindow::onRowDoubleClicked);
+
+    QVBoxLayout * rowsLayout = new QVBoxLayout();
+    rowsLayout->setContentsMargins(0, 0, 0, 0);
+    rowsLayout->addWidget(_groupValue);
+    rowsLayout->addWidget(_rowsTable, 1);
+
+    QWidget * rowsWidget = new QWidget();
+    rowsWidget->setLayout(rowsLayout);
+
+    QSplitter * splitter = new QSplitter(Qt::Vertical);
+    splitter->addWidget(_groupsTable);
+    splitter->addWidget(rowsWidget);
+
+    QVBoxLayout * mainLayout = new QVBoxLayout();
+    mainLayout->addWidget(splitter);
+    setLayout(mainLayout);
+
+    // row lists belong to the dump, drop them before it is replaced
+    connect(_model, &QAbstractItemModel::modelAboutToBeReset,
+            this, &TraceIdsWindow::onModelAboutToBeReset);
+    connect(_model, &QAbstractItemModel::modelReset,
+            this, &TraceIdsWindow::showModelData);
+    // appended (follow, live) and dropped (retention) rows
+    connect(_model, &QAbstractItemModel::rowsInserted,
+            this, &TraceIdsWindow::onRowsChanged);
+    connect(_model, &QAbstractItemModel::rowsRemoved,
+            this, &TraceIdsWindow::onRowsChanged);
+
+    showModelData();
+}
+
+void TraceIdsWindow::showModelData()
+{
+    {
+        QSignalBlocker blocker(_groupsTable);
+        _groupsTable->clearContents();
+        _groupsTable->setRowCount(0);
+        _groupItems.clear();
+    }
+
+    updateGroups();
+
+    // log storms first
+    _groupsTable->sortByColumn(static_cast<int>(GroupColumns::Rows),
+                               Qt::DescendingOrder);
+    _groupsTable->resizeColumnsToContents();
+    _groupsTable->setColumnWidth(
+                static_cast<int>(GroupColumns::Format),
+                qMin(_groupsTable->columnWidth(
+                         static_cast<int>(GroupColumns::Format)), 500));
+
+    onGroupSelected();
+}
+
+void TraceIdsWindow::updateGroups()
+{
+    const p7::p7DumpData & data = _model->dumpData();
+
+    // lines don't move while they are set, the sorting is done again
+    // once they are
+    QSignalBlocker blocker(_groupsTable);
+    _groupsTable->setSortingEnabled(false);
+
+    if (_groupItems.size() < data.streamsCount()) {
+        _groupItems.resize(data.streamsCount());
+    }
+
+    for (size_t i = 0; i < data.streamsCount(); ++i) {
+        const p7::p7StreamData & stream = data.stream(i);
+        const std::vector<p7::p7TraceIdStats> & ids = stream.traceIdStats();
+        std::vector<QTableWidgetItem *> & items = _groupItems[i];
+        if (items.size() < ids.size()) {
+            items.resize(ids.size(), nullptr);
+        }
+
+        for (size_t id = 0; id < ids.size(); ++id) {
+            const p7::p7TraceIdStats & stats = ids[id];
+            if (!stats.rows) {
+                continue;
+            }
+
+            const bool added = !items[id];
+            const int row = added ? _groupsTable->rowCount()
+                                  : items[id]->row();
+            if (added) {
+                _groupsTable->insertRow(row);
+            }
+
+            auto set = [this, row](GroupColumns column,
+                                   const QVariant & value) {
+                QTableWidgetItem * item
+                        = _groupsTable->item(row, static_cast<int>(column));
+                if (item) {
+                    item->setData(Qt::DisplayRole, value);
+                } else {
+                    _groupsTable->setItem(row, static_cast<int>(column),
+                                          groupItem(value));
+                }
+            };
+
+            set(GroupColumns::Rows, (qulonglong)stats.rows);
+            set(GroupColumns::First,
+                p7::unpackDateTime(stats.firstTime).toString("HH:mm:ss.zzz"));
+            set(GroupColumns::Last,
+                p7::unpackDateTime(stats.lastTime).toString("HH:mm:ss.zzz"));
+            set(GroupColumns::Rate, qRound(stats.rate() * 10.0) / 10.0);
+            if (!added) {
+                continue;
+            }
+
+            set(GroupColumns::Channel, _model->streamName((int)i));
+            items[id] = _groupsTable->item(
+                        row, static_cast<int>(GroupColumns::Channel));
+            items[id]->setData(Qt::UserRole,
+                               QVariant::fromValue(QPoint((int)i, (int)id)));
+            set(GroupColumns::ID, (uint)id);
+            set(GroupColumns::Level, p7::traceLevelAsString(stats.level));
+
+            const p7::p7DescriptionInfo * desc
+                    = stream.descriptionById((uint16_t)id);
+            if (desc) {
+                set(GroupColumns::Module,
+                    stream.moduleById(desc->moduleId).name);
+                set(GroupColumns::Format, QString::fromUtf8(desc->format));
+                set(GroupColumns::Location, QString("%1:%2 %3")
+                                                .arg(desc->filename)
+                                                .arg(desc->line)
+                                                .arg(desc->function));
+            }
+        }
+    }
+
+    _groupsTable->setSortingEnabled(true);
+}
+
+void TraceIdsWindow::onGroupSelected()
+{
+    const QList<QTableWidgetItem *> items = _groupsTable->selectedItems();
+    if (items.isEmpty()) {
+        _rowsModel->setRows(0, nullptr);
+        _groupValue->setText(tr("Select a trace ID to see its rows"));
+        return;
+    }
+
+    const int row = items.first()->row();
+    const QPoint key = _groupsTable->item(
+                row, static_cast<int>(GroupColumns::Channel))
+            ->data(Qt::UserRole).toPoint();
+
+    const std::deque<uint32_t> & rows = rowList((size_t)key.x(),
+                                                (uint16_t)key.y());
+    _rowsModel->setRows((size_t)key.x(), &rows);
+    showGroupValue(key, rows.size());
+}
+
+void TraceIdsWindow::onRowDoubleClicked(const QModelIndex & index)
+{
+    if (!index.isValid()) {
+        return;
+    }
+
+    emit rowActivated(_rowsModel->stream(),
+                      _rowsModel->rowNumber(index.row()));
+}
+
+void TraceIdsWindow::onModelAboutToBeReset()
+{
+    _rowsModel->setRows(0, nullptr);
+    _rowLists.clear();
+    _rowListsEnd.clear();
+}
+
+void TraceIdsWindow::onRowsChanged()
+{
+    updateGroups();
+
+    // the drill-down follows rows of its trace ID without a reset, so its
+    // scroll position and selection stay
+    const QList<QTableWidgetItem *> items = _groupsTable->selectedItems();
+    if (items.isEmpty()) {
+        return;
+    }
+
+    const QPoint key = _groupsTable->item(
+                items.first()->row(),
+                static_cast<int>(GroupColumns::Channel))
+            ->data(Qt::UserRole).toPoint();
+
+    size_t dropped = 0;
+    const std::deque<uint32_t> & rows = rowList((size_t)key.x(),
+                                                (uint16_t)key.y(),
+                                                &dropped);
+    _rowsModel->rowsChanged(&rows, dropped);
+    showGroupValue(key, rows.size());
+}
+
+void TraceIdsWindow::showGroupValue(const QPoint & key, size_t rows)
+{
+    _groupValue->setText(tr("%1, ID %2: %3 rows in memory")
+                         .arg(_model->streamName(key.x()))
+                         .arg(key.y())
+                         .arg(rows));
+}
+
+const std::deque<uint32_t> & TraceIdsWindow::rowList(size_t stream,
+                                                     uint16_t id,
+                                                     size_t * dropped)
+{
+    const p7::p7StreamData & streamData = _model->dumpData().stream(stream);
+
+    if (_rowLists.size() <= stream) {
+        _rowLists.resize(stream + 1);
+        _rowListsEnd.resize(stream + 1, 0);
+    }
+
+    std::vector<std::deque<uint32_t>> & lists = _rowLists[stream];
+    if (lists.size() < streamData.traceIdStats().size()) {
+        lists.resize(streamData.traceIdStats().size());
+    }
+
+    // rows dropped by retention are the oldest ones of every list
+    const size_t count = streamData.traceDataCount();
+    for (size_t i = 0; i < lists.size(); ++i) {
+        std::deque<uint32_t> & list = lists[i];
+        const size_t size = list.size();
+        while (    (!list.empty())
+                && (streamData.rowIndex(list.front()) >= count)
+              )
+        {
+            list.pop_front();
+        }
+        if (dropped && i == id) {
+            *dropped = size - list.size();
+        }
+    }
+
+    // rows appended since the lists were extended last time
+    const uint64_t from = (std::max)(_rowListsEnd[stream],
+                                     streamData.firstRowNumber());
+    for (uint64_t number = from;
+         number < streamData.endRowNumber();
+         ++number)
+    {
+        const uint16_t rowId = streamData.traceDataAt(
+                    (size_t)(number - streamData.firstRowNumber())).id;
+        lists[rowId].push_back((uint32_t)number);
+    }
+    _rowListsEnd[stream] = streamData.endRowNumber();
+
+    static const std::deque<uint32_t> none;
+    return id < lists.size() ? lists[id] : none;
+}
+
+} // namespace ui
+} // namespace p7
@@ -0,0 +1,108 @@
+#ifndef UI_TRACEIDSWINDOW_H
+#define UI_TRACEIDSWINDOW_H
+
+#include <deque>
+#include <vector>
+#include <QAbstractTableModel>
+#include <QDialog>
+#include <QLabel>
+#include <QTableView>
+#include <QTableWidget>
+#include "p7d_model.h"
+
+namespace p7 {
+namespace ui {
+
+// Rows of one trace ID of a stream: row numbers truncated to 32 bits (see
+// p7RowRef), resolved in the dump on display
+class TraceIdRowsModel : public QAbstractTableModel
+{
+public:
+
+    enum class Columns {
+        Time = 0,
+        Thread,
+        Text,
+        Count
+    };
+
+    explicit TraceIdRowsModel(p7::P7DumpModel * model,
+                              QObject *parent = nullptr);
+
+    void setRows(size_t stream, const std::deque<uint32_t> * rows);
+    // the list lost dropped rows at the front and may have grown
+    void rowsChanged(const std::deque<uint32_t> * rows, size_t dropped);
+
+    size_t stream() const;
+    // Number of the row in its stream
+    uint64_t rowNumber(int row) const;
+
+    QVariant data(const QModelIndex &index, int role) const override;
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+
+private:
+
+    p7::P7DumpModel * _model;
+    size_t _stream = 0;
+    const std::deque<uint32_t> * _rows = nullptr;
+    size_t _count = 0; // rows of the list the view knows of
+};
+
+// One line per trace ID (description) of every stream with its counters
+// from import (p7TraceIdStats): rows, the earliest and the latest time,
+// rate, level, module and format. Sorting by rows finds log storms.
+// Selecting a line shows its rows, double click on one of them shows it
+// in the main table.
+class TraceIdsWindow : public QDialog
+{
+    Q_OBJECT
+
+public:
+    TraceIdsWindow(p7::P7DumpModel * model,
+                   QWidget *parent = nullptr);
+
+    void showModelData();
+
+    // a row of the drill-down is activated: its stream and number
+    Q_SIGNAL void rowActivated(size_t stream, quint64 number);
+
+private:
+
+    Q_SLOT void onGroupSelected();
+    Q_SLOT void onRowDoubleClicked(const QModelIndex & index);
+    Q_SLOT void onModelAboutToBeReset();
+    Q_SLOT void onRowsChanged();
+
+    // adds lines of new trace IDs and updates counters of the others
+    void updateGroups();
+    void showGroupValue(const QPoint & key, size_t rows);
+
+    // row lists of all trace IDs of the stream, extended by rows appended
+    // since the last call and trimmed of dropped ones; dropped: rows
+    // trimmed from the list of the id
+    const std::deque<uint32_t> & rowList(size_t stream, uint16_t id,
+                                         size_t * dropped = nullptr);
+
+    QTableWidget * _groupsTable;
+    QLabel * _groupValue;
+    QTableView * _rowsTable;
+    TraceIdRowsModel * _rowsModel;
+
+    // by stream and trace ID: the first item of its line
+    std::vector<std::vector<QTableWidgetItem *>> _groupItems;
+
+    // by stream: rows of every trace ID and the end row number they
+    // were built up to
+    std::vector<std::vector<std::deque<uint32_t>>> _rowLists;
+    std::vector<uint64_t> _rowListsEnd;
+
+    p7::P7DumpModel * _model;
+};
+
+} // namespace ui
+} // namespace p7
+
+#endif // UI_TRACEIDSWINDOW_H